@@ -10,6 +10,18 @@ def PrintFooter(scriptName):
 def PrintLog(msg):
     print(msg)
 
+# Files that didn't change keep their timestamp, so sources including them aren't rebuilt
+def WriteIfChanged(path, content):
+    if os.path.exists(path):
+        with open(path, 'r') as file:
+            if file.read() == content:
+                return False
+
+    with open(path, 'w') as file:
+        file.write(content)
+
+    return True
+
 def GetSourceFolderPath(srcFolder):
     CurrentPath = os.path.dirname(os.path.abspath(__file__))
     return os.path.normpath(os.path.join(CurrentPath, '../Source/' + srcFolder + '/'))
@@ -1,12 +1,17 @@
 import Common
 import os
 import subprocess
+import sys
 
 SrcPath = Common.GetSourceFolderPath('Shaders')
 DstPath = Common.GetDestinationFolderPath('Shaders')
 
 Common.PrintHeader('Shader compiler')
 
+# SPIR-V isn't committed, a fresh checkout has no output folder
+os.makedirs(DstPath, exist_ok=True)
+Failed = []
+
 Files = os.listdir(SrcPath)
 for File in Files:
     FileName, FileExtension = os.path.splitext(File)
@@ -23,5 +28,11 @@ for File in Files:
     filteredText = list(filter(lambda x : 'error' in x or 'ERROR' in x, output))
 
     if len(filteredText): print('\n'.join(filteredText))
+    if process.returncode != 0: Failed.append(File)
 
 Common.PrintFooter('Shader compiler')
+
+# Fails the pre-build step, so the build doesn't run with missing or stale shaders
+if len(Failed):
+    print('Shader compilation failed: ' + ', '.join(Failed))
+    sys.exit(1)
@@ -0,0 +1,235 @@
+import Common
+import io
+import os
+import struct
+
+Common.PrintHeader('Shader structs generator')
+
+CurrentPath = os.path.dirname(__file__)
+
+SrcPath = Common.GetDestinationFolderPath('Shaders')
+DstPath = os.path.join(CurrentPath, "../Source/Renderer/shader_structs.h")
+Namespace = "ShaderStructs"
+
+# SPIR-V opcodes
+OpName = 5
+OpMemberName = 6
+OpEntryPoint = 15
+OpTypeInt = 21
+OpTypeFloat = 22
+OpTypeVector = 23
+OpTypeMatrix = 24
+OpTypeArray = 28
+OpTypeRuntimeArray = 29
+OpTypeStruct = 30
+OpTypePointer = 32
+OpConstant = 43
+OpVariable = 59
+OpDecorate = 71
+OpMemberDecorate = 72
+
+# SPIR-V decorations
+DecorationArrayStride = 6
+DecorationMatrixStride = 7
+DecorationBinding = 33
+DecorationDescriptorSet = 34
+DecorationOffset = 35
+
+# SPIR-V storage classes
+StorageUniform = 2
+StoragePushConstant = 9
+StorageBuffer = 12
+
+ShaderTypes = { 0: "VERTEX", 4: "FRAGMENT", 5: "COMPUTE" }
+
+
+def ReadString(Words):
+    Bytes = struct.pack('<%dI' % len(Words), *Words)
+    return Bytes[:Bytes.index(b'\0')].decode('utf-8')
+
+
+class Module:
+    def __init__(self, Path):
+        with open(Path, "rb") as File:
+            Data = File.read()
+
+        Words = struct.unpack('<%dI' % (len(Data) // 4), Data)
+
+        self.Names = {}
+        self.MemberNames = {}
+        self.Decorations = {}
+        self.MemberDecorations = {}
+        self.Types = {}
+        self.Constants = {}
+        self.Variables = []
+        self.Stage = None
+
+        Index = 5 # Skip header
+        while Index < len(Words):
+            WordCount = Words[Index] >> 16
+            OpCode = Words[Index] & 0xFFFF
+            Args = Words[Index + 1:Index + WordCount]
+
+            if OpCode == OpName:
+                self.Names[Args[0]] = ReadString(Args[1:])
+            elif OpCode == OpMemberName:
+                self.MemberNames.setdefault(Args[0], {})[Args[1]] = ReadString(Args[2:])
+            elif OpCode == OpEntryPoint:
+                self.Stage = ShaderTypes.get(Args[0])
+            elif OpCode == OpDecorate:
+                self.Decorations.setdefault(Args[0], {})[Args[1]] = Args[2:]
+            elif OpCode == OpMemberDecorate:
+                self.MemberDecorations.setdefault(Args[0], {}).setdefault(Args[1], {})[Args[2]] = Args[3:]
+            elif OpCode in (OpTypeInt, OpTypeFloat, OpTypeVector, OpTypeMatrix, OpTypeArray, OpTypeRuntimeArray, OpTypeStruct, OpTypePointer):
+                self.Types[Args[0]] = (OpCode, Args[1:])
+            elif OpCode == OpConstant:
+                self.Constants[Args[1]] = Args[2]
+            elif OpCode == OpVariable:
+                self.Variables.append((Args[0], Args[1], Args[2]))
+
+            Index += WordCount
+
+    # Returns (C++ type, size in bytes) or raises ValueError for layouts that can't be mirrored
+    def GetCppType(self, TypeId, MatrixStride=None):
+        OpCode, Args = self.Types[TypeId]
+
+        if OpCode == OpTypeFloat and Args[0] == 32:
+            return ("float", 4)
+        if OpCode == OpTypeInt and Args[0] == 32:
+            return ("int32_t" if Args[1] else "uint32_t", 4)
+        if OpCode == OpTypeVector:
+            Prefix = { "float": "", "int32_t": "i", "uint32_t": "u" }[self.GetCppType(Args[0])[0]]
+            return ("glm::%svec%d" % (Prefix, Args[1]), 4 * Args[1])
+        if OpCode == OpTypeMatrix:
+            Columns = Args[1]
+            Rows = self.Types[Args[0]][1][1]
+            Stride = MatrixStride if MatrixStride else 4 * Rows
+            if Stride % 4 != 0 or Stride // 4 < Rows or Stride // 4 > 4:
+                raise ValueError("unsupported matrix stride %d" % Stride)
+            return ("glm::mat%dx%d" % (Columns, Stride // 4), Columns * Stride)
+
+        raise ValueError("unsupported member type")
+
+    def GetBlocks(self):
+        Blocks = []
+        for TypeId, VariableId, StorageClass in self.Variables:
+            if StorageClass not in (StorageUniform, StoragePushConstant, StorageBuffer):
+                continue
+
+            StructId = self.Types[TypeId][1][1]
+            if self.Types[StructId][0] != OpTypeStruct:
+                continue
+
+            Decorations = self.Decorations.get(VariableId, {})
+            Blocks.append({
+                "Name": self.Names.get(StructId, "Block%d" % StructId),
+                "StructId": StructId,
+                "PushConstant": StorageClass == StoragePushConstant,
+                "Set": Decorations.get(DecorationDescriptorSet, [0])[0],
+                "Binding": Decorations.get(DecorationBinding, [0])[0],
+            })
+        return Blocks
+
+    def GetMembers(self, StructId):
+        Members = []
+        for Index, MemberType in enumerate(self.Types[StructId][1]):
+            Decorations = self.MemberDecorations.get(StructId, {}).get(Index, {})
+            Name = self.MemberNames.get(StructId, {}).get(Index, "Member%d" % Index)
+            Offset = Decorations[DecorationOffset][0]
+            MatrixStride = Decorations.get(DecorationMatrixStride, [None])[0]
+
+            Count = 0
+            OpCode, Args = self.Types[MemberType]
+            if OpCode == OpTypeRuntimeArray:
+                raise ValueError("runtime array %s" % Name)
+            if OpCode == OpTypeArray:
+                Count = self.Constants[Args[1]]
+                Stride = self.Decorations.get(MemberType, {}).get(DecorationArrayStride, [0])[0]
+                MemberType = Args[0]
+
+            CppType, Size = self.GetCppType(MemberType, MatrixStride)
+
+            if Count:
+                if Stride != Size:
+                    raise ValueError("array %s has stride %d for element of size %d" % (Name, Stride, Size))
+                Size *= Count
+
+            Members.append((Name, CppType, Offset, Size, Count))
+
+        return sorted(Members, key=lambda Member: Member[2])
+
+
+def WriteBlock(DstFile, Block, Members, Stage):
+    Name = Block["Name"]
+    BaseOffset = Members[0][2]
+    Current = BaseOffset
+    Padding = 0
+
+    DstFile.write("\tstruct %s\n\t{\n" % Name)
+    DstFile.write("\t\tstatic constexpr ShaderType BlockStage = ShaderType::%s;\n" % Stage)
+    DstFile.write("\t\tstatic constexpr bool IsPushConstant = %s;\n" % ("true" if Block["PushConstant"] else "false"))
+    DstFile.write("\t\tstatic constexpr uint32_t BlockSet = %d;\n" % Block["Set"])
+    DstFile.write("\t\tstatic constexpr uint32_t BlockBinding = %d;\n" % Block["Binding"])
+    DstFile.write("\t\tstatic constexpr uint32_t BlockOffset = %d; // Offset of the first member inside the block\n\n" % BaseOffset)
+
+    for MemberName, CppType, Offset, Size, Count in Members:
+        if Offset > Current:
+            DstFile.write("\t\tuint8_t Padding%d[%d];\n" % (Padding, Offset - Current))
+            Padding += 1
+        DstFile.write("\t\t%s %s%s;\n" % (CppType, MemberName, "[%d]" % Count if Count else ""))
+        Current = Offset + Size
+
+    DstFile.write("\t};\n")
+
+    for MemberName, CppType, Offset, Size, Count in Members:
+        DstFile.write("\tstatic_assert(offsetof(%s, %s) == %d, \"Invalid offset of %s::%s\");\n" % (Name, MemberName, Offset - BaseOffset, Name, MemberName))
+    DstFile.write("\tstatic_assert(sizeof(%s) == %d, \"Invalid size of %s\");\n\n" % (Name, Current - BaseOffset, Name))
+
+
+DstFile = io.StringIO()
+
+DstFile.write("// Generated by Scripts/GenerateShaderStructs.py from compiled shaders, do not edit\n")
+DstFile.write("#pragma once\n")
+DstFile.write("#include <cstddef>\n")
+DstFile.write("#include <cstdint>\n")
+DstFile.write("#include \"glm/glm.hpp\"\n")
+DstFile.write("#include \"shader_reflection.h\"\n\n")
+DstFile.write("namespace %s {\n\n" % Namespace)
+
+for File in sorted(os.listdir(SrcPath)):
+    if not File.endswith(".spv"):
+        continue
+
+    ShaderModule = Module(os.path.join(SrcPath, File))
+    Blocks = ShaderModule.GetBlocks()
+
+    if ShaderModule.Stage is None or len(Blocks) == 0:
+        continue
+
+    Common.PrintLog('Processing: %s' % File)
+
+    # StaticBasePass.vert.spv -> StaticBasePassVert
+    Parts = File.split('.')
+    ShaderNamespace = Parts[0] + Parts[1].capitalize()
+
+    DstFile.write("namespace %s {\n\n" % ShaderNamespace)
+
+    for Block in Blocks:
+        try:
+            Members = ShaderModule.GetMembers(Block["StructId"])
+        except ValueError as Error:
+            Common.PrintLog('Skipping %s: %s' % (Block["Name"], Error))
+            DstFile.write("\t// %s skipped: %s\n\n" % (Block["Name"], Error))
+            continue
+
+        if len(Members) > 0:
+            WriteBlock(DstFile, Block, Members, ShaderModule.Stage)
+
+    DstFile.write("}\n\n")
+
+DstFile.write("}\n")
+
+if Common.WriteIfChanged(DstPath, DstFile.getvalue()):
+    Common.PrintLog('Updated: %s' % os.path.normpath(DstPath))
+
+Common.PrintFooter('Shader structs generator')
@@ -60,42 +60,95 @@ def CalculateTangents(Positions, TexCoords, Indicies):
 
 
 
+# Has to match StaticMeshFile in static_mesh.h
+StaticMeshMagic = 0x48534D53 # "SMSH"
+StaticMeshVersion = 2
+
+
+# Meshes cooked by -cook_meshes carry levels of detail and meshlets that this script can't produce
+def IsCookedMesh(path):
+    if not os.path.isfile(path):
+        return False
+    with open(path, "rb") as File:
+        Header = File.read(8)
+    if len(Header) < 8:
+        return False
+    (Magic, Version) = struct.unpack("II", Header)
+    return Magic == StaticMeshMagic and Version > StaticMeshVersion
+
+
+def PackUNorm16(Value):
+    return int(round(min(max(Value, 0.0), 1.0) * 65535.0))
+
+
+def PackSNorm16(Value):
+    return int(round(min(max(Value, -1.0), 1.0) * 32767.0))
+
+
+def SignNotZero(Value):
+    return 1.0 if Value >= 0.0 else -1.0
+
+
+# Has to match VertexPacking::PackOctahedral
+def PackOctahedral(X, Y, Z):
+    Sum = abs(X) + abs(Y) + abs(Z)
+
+    if Sum <= 0.0:
+        return (0, 0)
+
+    OctX = X / Sum
+    OctY = Y / Sum
+
+    # Lower hemisphere is folded over the diagonals
+    if Z < 0.0:
+        (OctX, OctY) = ((1.0 - abs(OctY)) * SignNotZero(OctX), (1.0 - abs(OctX)) * SignNotZero(OctY))
+
+    return (PackSNorm16(OctX), PackSNorm16(OctY))
+
+
 def PostprocessSubobjectAndSave(DstFile, Positions, TexCoords, Normals, Indicies):
         PositionsLength = len(Positions) 
-        TexCoordsLength = len(TexCoords) 
-        NormalsLength = len(Normals) 
         IndiciesLength = len(Indicies)
 
         Tangents = CalculateTangents(Positions, TexCoords, Indicies)
         AttributesCount = int(PositionsLength / 3)
 
-        # Write attrbute count
-        DstFile.write( struct.pack("i",AttributesCount) )
+        # Positions are quantized to the bounds of the subobject
+        Min = [min(Positions[Axis::3]) for Axis in range(0, 3)]
+        Max = [max(Positions[Axis::3]) for Axis in range(0, 3)]
+        Scale = [Max[Axis] - Min[Axis] for Axis in range(0, 3)]
+        Bias = Min
+
+        # Write attrbute count and dequantization of positions
+        DstFile.write( struct.pack("I",AttributesCount) )
+        DstFile.write( struct.pack("fff",Scale[0],Scale[1],Scale[2]) )
+        DstFile.write( struct.pack("fff",Bias[0],Bias[1],Bias[2]) )
 
         for i in range(0, AttributesCount):
             # Write positions
-            DstFile.write( struct.pack("f",Positions[ (i * 3) ]) )
-            DstFile.write( struct.pack("f",Positions[ (i * 3) + 1 ]) )
-            DstFile.write( struct.pack("f",Positions[ (i * 3) + 2 ]) )
+            Quantized = [0, 0, 0]
+            for Axis in range(0, 3):
+                if Scale[Axis] > 0.0:
+                    Quantized[Axis] = PackUNorm16((Positions[ (i * 3) + Axis ] - Bias[Axis]) / Scale[Axis])
+
+            DstFile.write( struct.pack("HHHH",Quantized[0],Quantized[1],Quantized[2],0) )
 
             # Write texture coordinates
-            DstFile.write( struct.pack("f",TexCoords[ (i * 2) ]) )
-            DstFile.write( struct.pack("f",TexCoords[ (i * 2) + 1 ]) )
+            DstFile.write( struct.pack("ee",TexCoords[ (i * 2) ],TexCoords[ (i * 2) + 1 ]) )
 
             # Write normals
-            DstFile.write( struct.pack("f",Normals[ (i * 3) ]) )
-            DstFile.write( struct.pack("f",Normals[ (i * 3) + 1 ]) )
-            DstFile.write( struct.pack("f",Normals[ (i * 3) + 2 ]) )
+            DstFile.write( struct.pack("hh",*PackOctahedral(Normals[ (i * 3) ],Normals[ (i * 3) + 1 ],Normals[ (i * 3) + 2 ])) )
 
             # Write tangents
-            DstFile.write( struct.pack("f",Tangents[ (i * 3) ]) )
-            DstFile.write( struct.pack("f",Tangents[ (i * 3) + 1 ]) )
-            DstFile.write( struct.pack("f",Tangents[ (i * 3) + 2 ]) )
+            DstFile.write( struct.pack("hh",*PackOctahedral(Tangents[ (i * 3) ],Tangents[ (i * 3) + 1 ],Tangents[ (i * 3) + 2 ])) )
+
+        # Write indicies, 16-bit ones are enough for subobjects with at most 65536 vertices
+        IndexFormat = "H" if AttributesCount <= 65536 else "I"
 
-        # Write indicies
-        DstFile.write( struct.pack("i",IndiciesLength) ) # Write size
+        DstFile.write( struct.pack("I",IndiciesLength) ) # Write size
+        DstFile.write( struct.pack("I",struct.calcsize(IndexFormat)) ) # Write index size
         for i in range(0, IndiciesLength):
-            DstFile.write( struct.pack("I",Indicies[i]) )
+            DstFile.write( struct.pack(IndexFormat,Indicies[i]) )
 
 
 def CreateSubobjectObj(DstFile, Indicies, Positions, TexCoords, Normals):
@@ -150,10 +203,16 @@ def PreprocessObj(fileName):
     fileNameWithoutExt = os.path.splitext(fileName)[0]
 
     DstPathWithName = os.path.join(DstPath,fileNameWithoutExt + ".sm")
+
+    if IsCookedMesh(DstPathWithName):
+        Common.PrintLog('Skipping: %s, cooked by -cook_meshes' % fileName)
+        return
     
     SrcFile = open(SrcPathWithName, "r")
     DstFile = open(DstPathWithName, "wb")
 
+    DstFile.write( struct.pack("II",StaticMeshMagic,StaticMeshVersion) )
+
     Positions = []
     TexCoords = []
     Normals = []
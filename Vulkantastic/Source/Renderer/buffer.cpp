@@ -71,9 +71,9 @@ void Buffer::UploadData(const void* Data, uint32_t Size, uint32_t Offset /*= 0*/
 		if (mGPUSide)
 		{
 			uint32_t GraphicsQueueIndex = VulkanCore::Get().GetDevice()->GetQueuesIndicies().GraphicsIndex;
-			Buffer Tmp({ GraphicsQueueIndex }, BufferUsage::TRANSFER_SRC, false, mSize, Data);
+			Buffer Tmp({ GraphicsQueueIndex }, BufferUsage::TRANSFER_SRC, false, Size, Data);
 
-			CopyFromBuffer(&Tmp, mSize, 0, 0);
+			CopyFromBuffer(&Tmp, Size, 0, Offset);
 		}
 		else
 		{
@@ -82,6 +82,12 @@ void Buffer::UploadData(const void* Data, uint32_t Size, uint32_t Offset /*= 0*/
 	}
 }
 
+void Buffer::ReadData(void* Data, uint32_t Size, uint32_t Offset /*= 0*/) const
+{
+	Assert(!mGPUSide);
+	MemoryManager::Get().ReadData(mAllocation, Data, Size, Offset);
+}
+
 void Buffer::CopyFromBuffer(const Buffer* Other, uint64_t Size, uint64_t SrcOffset /*= 0*/, uint64_t DstOffset /*= 0*/)
 {
 	Assert((GetFlags() & BufferUsage::TRANSFER_DST) == BufferUsage::TRANSFER_DST);
@@ -2,26 +2,33 @@
 #include "vulkan/vulkan_core.h"
 #include "memory_manager.h"
 
-enum class BufferUsage : uint8_t
+enum class BufferUsage : uint16_t
 {
 	VERTEX = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
 	INDEX = VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
 	UNIFORM = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 	STORAGE = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
 	TRANSFER_DST = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-	TRANSFER_SRC = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+	TRANSFER_SRC = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+	INDIRECT = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
 };
 
 inline BufferUsage operator|(BufferUsage Left, BufferUsage Right)
 {
-	return static_cast<BufferUsage>(static_cast<uint8_t>(Left) | static_cast<uint8_t>(Right));
+	return static_cast<BufferUsage>(static_cast<uint16_t>(Left) | static_cast<uint16_t>(Right));
 }
 
 inline BufferUsage operator&(BufferUsage Left, BufferUsage Right)
 {
-	return static_cast<BufferUsage>(static_cast<uint8_t>(Left) & static_cast<uint8_t>(Right));
+	return static_cast<BufferUsage>(static_cast<uint16_t>(Left) & static_cast<uint16_t>(Right));
 }
 
+enum class IndexType : uint8_t
+{
+	UINT16 = VK_INDEX_TYPE_UINT16,
+	UINT32 = VK_INDEX_TYPE_UINT32
+};
+
 
 class Buffer
 {
@@ -36,6 +43,9 @@ public:
 	Buffer& operator=(Buffer&& Rhs) noexcept;
 
 	void UploadData(const void* Data, uint32_t Size, uint32_t Offset = 0);
+
+	// Works only for buffers that aren't on the GPU side, the GPU can't be writing to the range
+	void ReadData(void* Data, uint32_t Size, uint32_t Offset = 0) const;
 	void CopyFromBuffer(const Buffer* Other, uint64_t Size, uint64_t SrcOffset = 0, uint64_t DstOffset = 0);
 
 	inline VkBuffer GetBuffer() const { return mBuffer; }
@@ -22,6 +22,7 @@ public:
 	void Submit(bool Wait = false, std::vector<Semaphore*> Signal = {}, std::vector<Semaphore*> WaitFor = {}, std::vector<PipelineStage> WaitStage = {});
 
 	inline VkCommandBuffer GetCommandBuffer() const { return mCommandBuffer; }
+	inline int32_t GetQueueIndex() const { return mQueueIndex; }
 
 private:
 
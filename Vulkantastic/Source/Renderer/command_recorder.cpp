@@ -0,0 +1,222 @@
+#define NOMINMAX
+#include "command_recorder.h"
+#include "command_buffer.h"
+#include "pipeline.h"
+#include "descriptor_manager.h"
+#include "shader_parameters.h"
+#include "buffer.h"
+#include "../Utilities/assert.h"
+#include <cstring>
+
+namespace
+{
+	bool ViewportsEqual(const std::vector<VkViewport>& Lhs, const std::vector<VkViewport>& Rhs)
+	{
+		return Lhs.size() == Rhs.size() && (Lhs.empty() || std::memcmp(Lhs.data(), Rhs.data(), sizeof(VkViewport) * Lhs.size()) == 0);
+	}
+
+	bool ScissorsEqual(const std::vector<VkRect2D>& Lhs, const std::vector<VkRect2D>& Rhs)
+	{
+		return Lhs.size() == Rhs.size() && (Lhs.empty() || std::memcmp(Lhs.data(), Rhs.data(), sizeof(VkRect2D) * Lhs.size()) == 0);
+	}
+}
+
+CommandRecorder::CommandRecorder(CommandBuffer* Cb)
+	: mCommandBuffer(Cb)
+{
+	Assert(mCommandBuffer);
+}
+
+void CommandRecorder::BindGraphicsPipeline(IGraphicsPipeline* Pipeline)
+{
+	if (mGraphicsState.Pipeline == Pipeline->GetPipeline())
+	{
+		++mStats.PipelineBindsSkipped;
+		return;
+	}
+
+	vkCmdBindPipeline(mCommandBuffer->GetCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, Pipeline->GetPipeline());
+
+	mGraphicsState.Pipeline = Pipeline->GetPipeline();
+	++mStats.PipelineBinds;
+}
+
+void CommandRecorder::BindComputePipeline(ComputePipeline* Pipeline)
+{
+	if (mComputeState.Pipeline == Pipeline->GetPipeline())
+	{
+		++mStats.PipelineBindsSkipped;
+		return;
+	}
+
+	vkCmdBindPipeline(mCommandBuffer->GetCommandBuffer(), VK_PIPELINE_BIND_POINT_COMPUTE, Pipeline->GetPipeline());
+
+	mComputeState.Pipeline = Pipeline->GetPipeline();
+	++mStats.PipelineBinds;
+}
+
+void CommandRecorder::BindDescriptorSet(DescriptorInst* DescSet, IPipeline* Pipeline, const uint32_t* DynamicOffsets /*= nullptr*/, uint32_t DynamicOffsetsCount /*= 0*/)
+{
+	VkPipelineBindPoint BindPoint;
+	BindPointState& State = GetBindPointState(Pipeline, BindPoint);
+
+	SetLayout(State, Pipeline->GetPipelineLayout());
+
+	const uint32_t SetIdx = DescSet->GetSetIndex();
+	const VkDescriptorSet Set = DescSet->GetSet();
+
+	Assert(SetIdx < MaxDescriptorSets);
+
+	BoundSet& Bound = State.Sets[SetIdx];
+
+	const bool SameOffsets = Bound.DynamicOffsets.size() == DynamicOffsetsCount &&
+		(DynamicOffsetsCount == 0 || std::memcmp(Bound.DynamicOffsets.data(), DynamicOffsets, sizeof(uint32_t) * DynamicOffsetsCount) == 0);
+
+	if (Bound.Set == Set && SameOffsets)
+	{
+		++mStats.DescriptorSetBindsSkipped;
+		return;
+	}
+
+	vkCmdBindDescriptorSets(mCommandBuffer->GetCommandBuffer(), BindPoint, State.Layout, SetIdx, 1, &Set, DynamicOffsetsCount, DynamicOffsets);
+
+	Bound.Set = Set;
+	Bound.DynamicOffsets.assign(DynamicOffsets, DynamicOffsets + DynamicOffsetsCount);
+	++mStats.DescriptorSetBinds;
+}
+
+void CommandRecorder::BindVertexBuffer(Buffer* VertexBuffer)
+{
+	const VkBuffer NewBuffer = VertexBuffer->GetBuffer();
+
+	if (mVertexBuffer == NewBuffer)
+	{
+		++mStats.VertexBufferBindsSkipped;
+		return;
+	}
+
+	const VkDeviceSize Offsets[] = { 0 };
+	vkCmdBindVertexBuffers(mCommandBuffer->GetCommandBuffer(), 0, 1, &NewBuffer, Offsets);
+
+	mVertexBuffer = NewBuffer;
+	++mStats.VertexBufferBinds;
+}
+
+void CommandRecorder::BindIndexBuffer(Buffer* IndexBuffer, IndexType Type /*= IndexType::UINT32*/)
+{
+	const VkBuffer NewBuffer = IndexBuffer->GetBuffer();
+
+	if (mIndexBuffer == NewBuffer && mIndexType == Type)
+	{
+		++mStats.IndexBufferBindsSkipped;
+		return;
+	}
+
+	vkCmdBindIndexBuffer(mCommandBuffer->GetCommandBuffer(), NewBuffer, 0, static_cast<VkIndexType>(Type));
+
+	mIndexBuffer = NewBuffer;
+	mIndexType = Type;
+	++mStats.IndexBufferBinds;
+}
+
+void CommandRecorder::BindVertexAndIndexBuffer(Buffer* VertexBuffer, Buffer* IndexBuffer, IndexType Type /*= IndexType::UINT32*/)
+{
+	BindVertexBuffer(VertexBuffer);
+	BindIndexBuffer(IndexBuffer, Type);
+}
+
+void CommandRecorder::SetViewports(IGraphicsPipeline* Pipeline)
+{
+	const std::vector<VkViewport>& Viewports = Pipeline->GetViewports();
+	const std::vector<VkRect2D>& Scissors = Pipeline->GetScissors();
+
+	if (ViewportsEqual(mViewports, Viewports) && ScissorsEqual(mScissors, Scissors))
+	{
+		++mStats.ViewportSetsSkipped;
+		return;
+	}
+
+	vkCmdSetViewport(mCommandBuffer->GetCommandBuffer(), 0, static_cast<uint32_t>(Viewports.size()), Viewports.data());
+	vkCmdSetScissor(mCommandBuffer->GetCommandBuffer(), 0, static_cast<uint32_t>(Scissors.size()), Scissors.data());
+
+	mViewports = Viewports;
+	mScissors = Scissors;
+	++mStats.ViewportSets;
+}
+
+void CommandRecorder::PushConstants(IPipeline* Pipeline, VkShaderStageFlags Stages, uint32_t Offset, uint32_t Size, const void* Data)
+{
+	Assert(Offset + Size <= MaxPushConstantsSize);
+
+	const VkPipelineLayout Layout = Pipeline->GetPipelineLayout();
+
+	// Push constants of a different layout can't be compared
+	if (mPushConstantsLayout != Layout)
+	{
+		mPushConstantsLayout = Layout;
+		mPushConstantsValid.fill(false);
+	}
+
+	const bool AllValid = std::all_of(mPushConstantsValid.begin() + Offset, mPushConstantsValid.begin() + Offset + Size, [](bool Valid) { return Valid; });
+
+	if (AllValid && std::memcmp(mPushConstantsData.data() + Offset, Data, Size) == 0)
+	{
+		++mStats.PushConstantsSkipped;
+		return;
+	}
+
+	vkCmdPushConstants(mCommandBuffer->GetCommandBuffer(), Layout, Stages, Offset, Size, Data);
+
+	std::memcpy(mPushConstantsData.data() + Offset, Data, Size);
+	std::fill(mPushConstantsValid.begin() + Offset, mPushConstantsValid.begin() + Offset + Size, true);
+	++mStats.PushConstants;
+}
+
+void CommandRecorder::UpdatePushConstants(ShaderParameters* Data, IPipeline* Pipeline)
+{
+	const UniformRawData* PCVertPtr = Data->GetPushConstantBuffer(ShaderType::VERTEX);
+	if (PCVertPtr)
+	{
+		PushConstants(Pipeline, VK_SHADER_STAGE_VERTEX_BIT, PCVertPtr->GetOffset(), PCVertPtr->GetSize(), PCVertPtr->GetBuffer());
+	}
+
+	const UniformRawData* PCFragPtr = Data->GetPushConstantBuffer(ShaderType::FRAGMENT);
+	if (PCFragPtr)
+	{
+		PushConstants(Pipeline, VK_SHADER_STAGE_FRAGMENT_BIT, PCFragPtr->GetOffset(), PCFragPtr->GetSize(), PCFragPtr->GetBuffer());
+	}
+}
+
+void CommandRecorder::Invalidate()
+{
+	mGraphicsState = {};
+	mComputeState = {};
+	mVertexBuffer = VK_NULL_HANDLE;
+	mIndexBuffer = VK_NULL_HANDLE;
+	mViewports.clear();
+	mScissors.clear();
+	mPushConstantsLayout = VK_NULL_HANDLE;
+	mPushConstantsValid.fill(false);
+}
+
+CommandRecorder::BindPointState& CommandRecorder::GetBindPointState(IPipeline* Pipeline, VkPipelineBindPoint& BindPoint)
+{
+	const bool Compute = Pipeline->GetDescriptorManager()->GetPipelineType() == PipelineType::COMPUTE;
+
+	BindPoint = Compute ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_GRAPHICS;
+	return Compute ? mComputeState : mGraphicsState;
+}
+
+void CommandRecorder::SetLayout(BindPointState& State, VkPipelineLayout Layout)
+{
+	if (State.Layout == Layout) { return; }
+
+	// Sets bound with another layout may be disturbed, so they are bound again
+	State.Layout = Layout;
+
+	for (BoundSet& Set : State.Sets)
+	{
+		Set.Set = VK_NULL_HANDLE;
+		Set.DynamicOffsets.clear();
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <array>
+#include <vector>
+#include "vulkan/vulkan_core.h"
+#include "shader_reflection.h"
+#include "buffer.h"
+
+class CommandBuffer;
+class IPipeline;
+class IGraphicsPipeline;
+class ComputePipeline;
+class DescriptorInst;
+class ShaderParameters;
+
+// Number of recorded and skipped calls of each type
+struct CommandRecorderStats
+{
+	uint32_t PipelineBinds = 0;
+	uint32_t PipelineBindsSkipped = 0;
+	uint32_t DescriptorSetBinds = 0;
+	uint32_t DescriptorSetBindsSkipped = 0;
+	uint32_t VertexBufferBinds = 0;
+	uint32_t VertexBufferBindsSkipped = 0;
+	uint32_t IndexBufferBinds = 0;
+	uint32_t IndexBufferBindsSkipped = 0;
+	uint32_t ViewportSets = 0;
+	uint32_t ViewportSetsSkipped = 0;
+	uint32_t PushConstants = 0;
+	uint32_t PushConstantsSkipped = 0;
+};
+
+// Records commands into a command buffer and skips the ones that wouldn't change its current state
+// Everything recorded into the command buffer has to go through the recorder, otherwise its state gets out of sync
+class CommandRecorder
+{
+public:
+	explicit CommandRecorder(CommandBuffer* Cb);
+
+	CommandRecorder(const CommandRecorder& Rhs) = delete;
+	CommandRecorder& operator=(const CommandRecorder& Rhs) = delete;
+
+	CommandRecorder(CommandRecorder&& Rhs) = delete;
+	CommandRecorder& operator=(CommandRecorder&& Rhs) = delete;
+
+	void BindGraphicsPipeline(IGraphicsPipeline* Pipeline);
+	void BindComputePipeline(ComputePipeline* Pipeline);
+
+	void BindDescriptorSet(DescriptorInst* DescSet, IPipeline* Pipeline, const uint32_t* DynamicOffsets = nullptr, uint32_t DynamicOffsetsCount = 0);
+
+	void BindVertexBuffer(Buffer* VertexBuffer);
+	void BindIndexBuffer(Buffer* IndexBuffer, IndexType Type = IndexType::UINT32);
+	void BindVertexAndIndexBuffer(Buffer* VertexBuffer, Buffer* IndexBuffer, IndexType Type = IndexType::UINT32);
+
+	// Sets viewports and scissors of the pipeline's attachments
+	void SetViewports(IGraphicsPipeline* Pipeline);
+
+	void PushConstants(IPipeline* Pipeline, VkShaderStageFlags Stages, uint32_t Offset, uint32_t Size, const void* Data);
+	void UpdatePushConstants(ShaderParameters* Data, IPipeline* Pipeline);
+
+	// Pushes a block generated by Scripts/GenerateShaderStructs.py
+	template<typename T>
+	void PushConstants(IPipeline* Pipeline, const T& Block)
+	{
+		static_assert(T::IsPushConstant, "Block has to be a push constant");
+		PushConstants(Pipeline, ShaderReflection::InternalShaderTypeToVulkan(T::BlockStage), T::BlockOffset, sizeof(T), &Block);
+	}
+
+	// Forgets the cached state, e.g. after commands were recorded without the recorder
+	void Invalidate();
+
+	inline CommandBuffer* GetCommandBuffer() const { return mCommandBuffer; }
+	inline const CommandRecorderStats& GetStats() const { return mStats; }
+
+private:
+	static constexpr uint32_t MaxDescriptorSets = 8;
+	static constexpr uint32_t MaxPushConstantsSize = 256;
+
+	struct BoundSet
+	{
+		VkDescriptorSet Set = VK_NULL_HANDLE;
+		std::vector<uint32_t> DynamicOffsets;
+	};
+
+	// Descriptor sets are bound separately for graphics and compute
+	struct BindPointState
+	{
+		VkPipeline Pipeline = VK_NULL_HANDLE;
+		VkPipelineLayout Layout = VK_NULL_HANDLE;
+		std::array<BoundSet, MaxDescriptorSets> Sets;
+	};
+
+	BindPointState& GetBindPointState(IPipeline* Pipeline, VkPipelineBindPoint& BindPoint);
+	void SetLayout(BindPointState& State, VkPipelineLayout Layout);
+
+	CommandBuffer* mCommandBuffer = nullptr;
+
+	BindPointState mGraphicsState;
+	BindPointState mComputeState;
+
+	VkBuffer mVertexBuffer = VK_NULL_HANDLE;
+	VkBuffer mIndexBuffer = VK_NULL_HANDLE;
+	IndexType mIndexType = IndexType::UINT32;
+
+	std::vector<VkViewport> mViewports;
+	std::vector<VkRect2D> mScissors;
+
+	VkPipelineLayout mPushConstantsLayout = VK_NULL_HANDLE;
+	std::array<uint8_t, MaxPushConstantsSize> mPushConstantsData = {};
+	std::array<bool, MaxPushConstantsSize> mPushConstantsValid = {}; // Bytes that were pushed with the current layout
+
+	CommandRecorderStats mStats;
+
+};
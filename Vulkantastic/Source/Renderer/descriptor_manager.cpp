@@ -1,9 +1,9 @@
+#define NOMINMAX
 #include "descriptor_manager.h"
 #include "device.h"
 #include "../Utilities/assert.h"
 #include "core.h"
 #include <algorithm>
-#include "uniform_buffer.h"
 #include "pipeline.h"
 #include "swap_chain.h"
 #include "uniform_raw_data.h"
@@ -44,6 +44,19 @@ DescriptorManager::DescriptorManager(std::vector<Shader*> Shaders)
 
 		for (auto& Uniform : Uniforms)
 		{
+			// Binding shared by several stages has only one entry visible from all of them
+			BindingsList& SetBindings = DescLayoutBindings[Uniform.Set];
+			auto SharedBinding = std::find_if(SetBindings.begin(), SetBindings.end(), [&Uniform](const VkDescriptorSetLayoutBinding& Elem) {
+				return Elem.binding == Uniform.Binding;
+			});
+
+			if (SharedBinding != SetBindings.end())
+			{
+				Assert(SharedBinding->descriptorType == ShaderReflection::InternalUniformTypeToVulkan(Uniform.Format));
+				SharedBinding->stageFlags |= ShaderReflection::InternalShaderTypeToVulkan(Shader->GetType());
+				continue;
+			}
+
 			mUniforms[Uniform.Set].push_back(Uniform);
 
 			VkDescriptorSetLayoutBinding Binding = {};
@@ -63,6 +76,33 @@ DescriptorManager::DescriptorManager(std::vector<Shader*> Shaders)
 		}
 	}
 
+	// Precompute dense binding -> slot tables so descriptor instances can index their write lists directly
+	for (const auto& SetUniforms : mUniforms)
+	{
+		const uint32_t SetIdx = SetUniforms.first;
+		std::vector<int32_t>& Slots = mBindingSlots[SetIdx];
+
+		int32_t BuffersCount = 0;
+		int32_t ImagesCount = 0;
+
+		for (const Uniform& Template : SetUniforms.second)
+		{
+			if (Template.Binding >= Slots.size())
+			{
+				Slots.resize(Template.Binding + 1, -1);
+			}
+
+			if (Template.Format == VariableType::STRUCTURE || Template.Format == VariableType::BUFFER)
+			{
+				Slots[Template.Binding] = BuffersCount++;
+			}
+			else if (Template.Format == VariableType::COMBINED || Template.Format == VariableType::IMAGE || Template.Format == VariableType::SAMPLER)
+			{
+				Slots[Template.Binding] = ImagesCount++;
+			}
+		}
+	}
+
 	for (const auto& Binding : DescLayoutBindings)
 	{
 		uint32_t SetIdx = Binding.first;
@@ -101,10 +141,9 @@ std::unique_ptr<DescriptorInst> DescriptorManager::GetDescriptorInstance(uint32_
 	return std::unique_ptr<DescriptorInst>(new DescriptorInst(this, SetIdx));
 }
 
-std::unique_ptr<ShaderParameters> DescriptorManager::GetShaderParametersInstance(uint32_t SetIdx)
+std::unique_ptr<ShaderParameters> DescriptorManager::GetShaderParametersInstance(uint64_t PipelineKey, uint32_t SetIdx)
 {
-	PipelineManager::KeyType Key = PipelineManager::Get().HashShaders(GetShaders());
-	return std::make_unique<ShaderParameters>(Key, GetUniforms(SetIdx), GetPushConstants() );
+	return std::make_unique<ShaderParameters>(PipelineKey, GetUniforms(SetIdx), GetPushConstants() );
 }
 
 std::vector<VkDescriptorSetLayout> DescriptorManager::GetLayouts() const
@@ -132,6 +171,7 @@ DescriptorManager& DescriptorManager::operator=(DescriptorManager&& Rhs) noexcep
 	Rhs.mPools.clear();
 
 	mUniforms = std::move(Rhs.mUniforms);
+	mBindingSlots = std::move(Rhs.mBindingSlots);
 	mPushConstants = std::move(Rhs.mPushConstants);
 	mShaders = std::move(Rhs.mShaders);
 
@@ -162,18 +202,23 @@ DescriptorInst::~DescriptorInst()
 	mOwner->mCurrentInstanceCount--;
 }
 
-DescriptorInst* DescriptorInst::SetBuffer(int32_t Binding, const UniformBuffer* BufferToSet)
+DescriptorInst* DescriptorInst::SetBuffer(int32_t Binding, const Buffer* BufferToSet, VkDeviceSize Range, VkDeviceSize Offset /*= 0*/)
 {
-	
-	auto SetIt = std::find_if(mBuffersInfo.begin(), mBuffersInfo.end(), [&Binding](const auto& Elem) {
-		return Elem.first.dstBinding == Binding;
-	});
+	const int32_t Slot = GetSlot(Binding);
 
-	if (SetIt != mBuffersInfo.end() && BufferToSet)
+	if (Slot >= 0 && BufferToSet)
 	{
-		VkDescriptorBufferInfo& BufferInfo = SetIt->second;
-		BufferInfo.buffer = BufferToSet->GetBuffer()->GetBuffer();
-		BufferInfo.range = BufferToSet->GetAlignmentSize();
+		BufferWriteDesc& Entry = mBuffersInfo[Slot];
+
+		const VkBuffer NewBuffer = BufferToSet->GetBuffer();
+
+		if (Entry.Info.buffer != NewBuffer || Entry.Info.range != Range || Entry.Info.offset != Offset)
+		{
+			Entry.Info.buffer = NewBuffer;
+			Entry.Info.range = Range;
+			Entry.Info.offset = Offset;
+			Entry.Dirty = true;
+		}
 	}
 
 	return this;
@@ -181,62 +226,68 @@ DescriptorInst* DescriptorInst::SetBuffer(int32_t Binding, const UniformBuffer*
 
 DescriptorInst* DescriptorInst::SetImage(int32_t Binding, const ImageView* View, const Sampler* ImageSampler, uint32_t Index)
 {
-	auto SetIt = std::find_if(mImagesInfo.begin(), mImagesInfo.end(), [&Binding](const auto& Elem) {
-		return Elem.first.dstBinding == Binding;
-	});
-
-	if (SetIt != mImagesInfo.end() && View && ImageSampler)
-	{
-		std::vector<VkDescriptorImageInfo>& ImageInfos = SetIt->second;
-		Assert(Index < ImageInfos.size() && Index >= 0);
+	if (!View || !ImageSampler) { return this; }
 
-		VkDescriptorImageInfo& ImageInfo = ImageInfos[Index];
-		ImageInfo.imageLayout = static_cast<VkImageLayout>(View->GetCurrentImageLayout());
-		ImageInfo.imageView = View->GetView();
-		ImageInfo.sampler = ImageSampler->GetSampler();
-	}
+	VkDescriptorImageInfo ImageInfo = {};
+	ImageInfo.imageLayout = static_cast<VkImageLayout>(View->GetCurrentImageLayout());
+	ImageInfo.imageView = View->GetView();
+	ImageInfo.sampler = ImageSampler->GetSampler();
 
-	return this;
+	return SetImageInfo(Binding, Index, ImageInfo);
 }
 
 
 DescriptorInst* DescriptorInst::SetImage(int32_t Binding, const ImageView* View, uint32_t Index)
 {
-	auto SetIt = std::find_if(mImagesInfo.begin(), mImagesInfo.end(), [&Binding](const auto& Elem) {
-		return Elem.first.dstBinding == Binding;
-	});
-
-	if (SetIt != mImagesInfo.end() && View)
-	{
-		std::vector<VkDescriptorImageInfo>& ImageInfos = SetIt->second;
-		Assert(Index < ImageInfos.size() && Index >= 0);
+	if (!View) { return this; }
 
-		VkDescriptorImageInfo& ImageInfo = ImageInfos[Index];
-		ImageInfo.imageLayout = static_cast<VkImageLayout>(View->GetCurrentImageLayout());
-		ImageInfo.imageView = View->GetView();
-		ImageInfo.sampler = VK_NULL_HANDLE;
-	}
+	VkDescriptorImageInfo ImageInfo = {};
+	ImageInfo.imageLayout = static_cast<VkImageLayout>(View->GetCurrentImageLayout());
+	ImageInfo.imageView = View->GetView();
+	ImageInfo.sampler = VK_NULL_HANDLE;
 
-	return this;
+	return SetImageInfo(Binding, Index, ImageInfo);
 }
 
 DescriptorInst* DescriptorInst::SetSampler(int32_t Binding, const Sampler* ImageSampler, uint32_t Index)
 {
-	auto SetIt = std::find_if(mImagesInfo.begin(), mImagesInfo.end(), [&Binding](const auto& Elem) {
-		return Elem.first.dstBinding == Binding;
-	});
+	if (!ImageSampler) { return this; }
 
-	if (SetIt != mImagesInfo.end() && ImageSampler)
+	VkDescriptorImageInfo ImageInfo = {};
+	ImageInfo.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	ImageInfo.imageView = VK_NULL_HANDLE;
+	ImageInfo.sampler = ImageSampler->GetSampler();
+
+	return SetImageInfo(Binding, Index, ImageInfo);
+}
+
+DescriptorInst* DescriptorInst::SetImageInfo(int32_t Binding, uint32_t Index, const VkDescriptorImageInfo& Info)
+{
+	const int32_t Slot = GetSlot(Binding);
+
+	if (Slot < 0) { return this; }
+
+	ImageWriteDesc& Entry = mImagesInfo[Slot];
+	Assert(Index < Entry.Info.size());
+
+	VkDescriptorImageInfo& ImageInfo = Entry.Info[Index];
+
+	if (ImageInfo.imageLayout == Info.imageLayout && ImageInfo.imageView == Info.imageView && ImageInfo.sampler == Info.sampler)
+	{
+		return this;
+	}
+
+	ImageInfo = Info;
+
+	if (!Entry.Dirty[Index])
 	{
-		std::vector<VkDescriptorImageInfo>& ImageInfos = SetIt->second;
-		Assert(Index < ImageInfos.size() && Index >= 0);
+		Entry.Dirty[Index] = true;
 
-		VkDescriptorImageInfo& ImageInfo = ImageInfos[Index];
-		ImageInfo.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		ImageInfo.imageView = VK_NULL_HANDLE;
-		ImageInfo.sampler = ImageSampler->GetSampler();
+		const bool WasClean = Entry.DirtyBegin >= Entry.DirtyEnd;
+		Entry.DirtyBegin = WasClean ? Index : std::min(Entry.DirtyBegin, Index);
+		Entry.DirtyEnd = WasClean ? Index + 1 : std::max(Entry.DirtyEnd, Index + 1);
 	}
-	
+
 	return this;
 }
 
@@ -244,20 +295,48 @@ void DescriptorInst::Update()
 {
 	auto Device = VulkanCore::Get().GetDevice()->GetDevice();
 
-	std::vector<VkWriteDescriptorSet> Sets;
-	Sets.reserve(mBuffersInfo.size() + mImagesInfo.size());
+	mPendingWrites.clear();
 
-	for (const auto& BufferInfo : mBuffersInfo)
+	for (BufferWriteDesc& Entry : mBuffersInfo)
 	{
-		Sets.push_back(BufferInfo.first);
+		if (!Entry.Dirty) { continue; }
+
+		VkWriteDescriptorSet Write = Entry.Set;
+		Write.pBufferInfo = &Entry.Info;
+
+		mPendingWrites.push_back(Write);
+		Entry.Dirty = false;
 	}
 
-	for (const auto& ImageInfo : mImagesInfo)
+	// Emit one write per contiguous run of dirty array elements
+	for (ImageWriteDesc& Entry : mImagesInfo)
 	{
-		Sets.push_back(ImageInfo.first);
+		uint32_t Index = Entry.DirtyBegin;
+
+		while (Index < Entry.DirtyEnd)
+		{
+			if (!Entry.Dirty[Index]) { ++Index; continue; }
+
+			const uint32_t RunBegin = Index;
+			while (Index < Entry.DirtyEnd && Entry.Dirty[Index])
+			{
+				Entry.Dirty[Index++] = false;
+			}
+
+			VkWriteDescriptorSet Write = Entry.Set;
+			Write.dstArrayElement = RunBegin;
+			Write.descriptorCount = Index - RunBegin;
+			Write.pImageInfo = &Entry.Info[RunBegin];
+
+			mPendingWrites.push_back(Write);
+		}
+
+		Entry.DirtyBegin = Entry.DirtyEnd = 0;
 	}
 
-	vkUpdateDescriptorSets(Device, static_cast<uint32_t>(Sets.size()), Sets.data(), 0, nullptr);
+	if (mPendingWrites.empty()) { return; }
+
+	vkUpdateDescriptorSets(Device, static_cast<uint32_t>(mPendingWrites.size()), mPendingWrites.data(), 0, nullptr);
 
 }
 
@@ -278,13 +357,14 @@ DescriptorInst::DescriptorInst(DescriptorManager* DescManager, uint32_t SetIdx)
 	Assert(vkAllocateDescriptorSets(Device, &AllocDescriptorSetInfo, &mSet) == VK_SUCCESS);
 	
 	mUniforms = mOwner->GetUniforms(mSetIdx);
+	mBindingSlots = mOwner->GetBindingSlots(mSetIdx);
 
 	auto BuffersCount = std::count_if(mUniforms.begin(), mUniforms.end(), [](const auto& Elem) {
 		return Elem.Format == VariableType::STRUCTURE || Elem.Format == VariableType::BUFFER;
 	});
 
 	auto ImagesCount = std::count_if(mUniforms.begin(), mUniforms.end(), [](const auto& Elem) {
-		return Elem.Format == VariableType::COMBINED;
+		return Elem.Format == VariableType::COMBINED || Elem.Format == VariableType::IMAGE || Elem.Format == VariableType::SAMPLER;
 	});
 
 	mBuffersInfo.reserve(BuffersCount);
@@ -314,14 +394,13 @@ void DescriptorInst::AddBufferWriteDesc(const Uniform& Template)
 	mBuffersInfo.push_back({});
 
 	auto& Entry = mBuffersInfo.back();
-	auto& Set = Entry.first;
+	auto& Set = Entry.Set;
 	
 	Set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 	Set.dstSet = mSet;
 	Set.dstBinding = Template.Binding;
 	Set.descriptorType = Template.Format == VariableType::STRUCTURE ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 	Set.descriptorCount = 1;
-	Set.pBufferInfo = &Entry.second;
 }
 
 void DescriptorInst::AddImageWriteDesc(const Uniform& Template)
@@ -329,17 +408,16 @@ void DescriptorInst::AddImageWriteDesc(const Uniform& Template)
 	mImagesInfo.push_back({});
 
 	auto& Entry = mImagesInfo.back();
-	auto& Set = Entry.first;
-	auto& Info = Entry.second;
+	auto& Set = Entry.Set;
 
-	Info.resize(Template.Size);
+	Entry.Info.resize(Template.Size);
+	Entry.Dirty.resize(Template.Size, false);
 
 	Set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 	Set.dstSet = mSet;
 	Set.dstBinding = Template.Binding;
 	Set.descriptorType = ShaderReflection::InternalUniformTypeToVulkan(Template.Format);
 	Set.descriptorCount = Template.Size;
-	Set.pImageInfo = Entry.second.data();
 }
 
 DescriptorInst& DescriptorInst::operator=(DescriptorInst&& Rhs) noexcept
@@ -349,6 +427,9 @@ DescriptorInst& DescriptorInst::operator=(DescriptorInst&& Rhs) noexcept
 
 	mBuffersInfo = std::move(Rhs.mBuffersInfo);
 	mImagesInfo = std::move(Rhs.mImagesInfo);
+	mPendingWrites = std::move(Rhs.mPendingWrites);
+	mUniforms = std::move(Rhs.mUniforms);
+	mBindingSlots = std::move(Rhs.mBindingSlots);
 
 	return *this;
 }
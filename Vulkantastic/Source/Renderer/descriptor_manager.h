@@ -4,7 +4,6 @@
 #include "buffer.h"
 #include "image_view.h"
 #include "sampler.h"
-#include "uniform_buffer.h"
 
 enum class PipelineType : uint8_t;
 class DescriptorInst;
@@ -23,7 +22,8 @@ public:
 	DescriptorManager& operator=(DescriptorManager&& Rhs) noexcept;
 
 	std::unique_ptr<class DescriptorInst> GetDescriptorInstance(uint32_t SetIdx = 0);
-	std::unique_ptr<class ShaderParameters> GetShaderParametersInstance(uint32_t SetIdx = 0);
+	// Key of the pipeline the parameters are used with, it has to be created already
+	std::unique_ptr<class ShaderParameters> GetShaderParametersInstance(uint64_t PipelineKey, uint32_t SetIdx = 0);
 
 	inline VkDescriptorSetLayout GetLayout(uint32_t SetIdx = 0) { return mLayouts[SetIdx]; }
 	inline VkDescriptorPool GetPool(uint32_t SetIdx = 0) { return mPools[SetIdx]; }
@@ -32,6 +32,7 @@ public:
 	inline std::map<ShaderType, std::vector<Uniform>> GetPushConstants() const { return mPushConstants;	}
 	inline std::vector<Shader*> GetShaders() const { return mShaders; }
 	inline uint32_t GetLayoutsCount() const { return static_cast<uint32_t>(mLayouts.size()); }
+	inline std::vector<int32_t> GetBindingSlots(uint32_t SetIdx = 0) { return mBindingSlots[SetIdx]; }
 
 	std::vector<VkDescriptorSetLayout> GetLayouts() const;
 	PipelineType GetPipelineType() const;
@@ -40,11 +41,13 @@ private:
 	using DescSetLayouts = std::map<uint32_t, VkDescriptorSetLayout>;
 	using DescPools = std::map<uint32_t, VkDescriptorPool>;
 	using Uniforms = std::map<uint32_t, std::vector<Uniform>>;
+	using BindingSlots = std::map<uint32_t, std::vector<int32_t>>;
 
 	DescSetLayouts mLayouts;
 	DescPools mPools;
 	int32_t mCurrentInstanceCount = 0;
 	Uniforms mUniforms;
+	BindingSlots mBindingSlots; // Binding -> index of the buffer or image write entry in DescriptorInst, -1 if unused
 	std::map<ShaderType, std::vector<Uniform>> mPushConstants;
 	PipelineType mPipelineType;
 	std::vector<Shader*> mShaders;
@@ -66,7 +69,7 @@ public:
 
 	inline VkDescriptorSet GetSet() const { return mSet; }
 
-	DescriptorInst* SetBuffer(int32_t Binding, const UniformBuffer* BufferToSet);
+	DescriptorInst* SetBuffer(int32_t Binding, const Buffer* BufferToSet, VkDeviceSize Range, VkDeviceSize Offset = 0);
 	DescriptorInst* SetImage(int32_t Binding, const ImageView* View, const Sampler* ImageSampler, uint32_t Index = 0);
 	DescriptorInst* SetImage(int32_t Binding, const ImageView* View, uint32_t Index = 0);
 	DescriptorInst* SetSampler(int32_t Binding, const Sampler* ImageSampler, uint32_t Index = 0);
@@ -81,15 +84,40 @@ private:
 	void AddBufferWriteDesc(const Uniform& Template);
 	void AddImageWriteDesc(const Uniform& Template);
 
+	DescriptorInst* SetImageInfo(int32_t Binding, uint32_t Index, const VkDescriptorImageInfo& Info);
+
+	inline int32_t GetSlot(int32_t Binding) const
+	{
+		return (Binding >= 0 && Binding < static_cast<int32_t>(mBindingSlots.size())) ? mBindingSlots[Binding] : -1;
+	}
+
 	VkDescriptorSet mSet = nullptr;
 
-	using BufferWriteDescList = std::vector< std::pair<VkWriteDescriptorSet, VkDescriptorBufferInfo> >;
-	using ImageWriteDescList = std::vector< std::pair<VkWriteDescriptorSet, std::vector<VkDescriptorImageInfo>> >;
+	struct BufferWriteDesc
+	{
+		VkWriteDescriptorSet Set = {};
+		VkDescriptorBufferInfo Info = {};
+		bool Dirty = false;
+	};
+
+	struct ImageWriteDesc
+	{
+		VkWriteDescriptorSet Set = {};
+		std::vector<VkDescriptorImageInfo> Info;
+		std::vector<uint8_t> Dirty;
+		uint32_t DirtyBegin = 0; // Range [DirtyBegin, DirtyEnd) that contains all dirty entries
+		uint32_t DirtyEnd = 0;
+	};
+
+	using BufferWriteDescList = std::vector<BufferWriteDesc>;
+	using ImageWriteDescList = std::vector<ImageWriteDesc>;
 
 	BufferWriteDescList mBuffersInfo;
 	ImageWriteDescList mImagesInfo;
+	std::vector<VkWriteDescriptorSet> mPendingWrites;
 
 	std::vector<Uniform> mUniforms;
+	std::vector<int32_t> mBindingSlots;
 
 	DescriptorManager* mOwner = nullptr;
 	uint32_t mSetIdx = 0;
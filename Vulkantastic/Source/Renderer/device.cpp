@@ -131,11 +131,28 @@ bool Device::CreateDevice(const VkPhysicalDevice& Device)
 	DeviceFeatures.vertexPipelineStoresAndAtomics = VK_TRUE;
 	DeviceFeatures.multiViewport = VK_TRUE;
 
+	// Optional, indirect draws fall back to one draw per command without them
+	DeviceFeatures.multiDrawIndirect = mSupportedFeatures.multiDrawIndirect;
+	DeviceFeatures.drawIndirectFirstInstance = mSupportedFeatures.drawIndirectFirstInstance;
+
+	// Optional, overdraw isn't measured without it
+	DeviceFeatures.occlusionQueryPrecise = mSupportedFeatures.occlusionQueryPrecise;
+
 	DeviceCreateInfo.pEnabledFeatures = &DeviceFeatures;
 
+	mEnabledFeatures = DeviceFeatures;
+
 	// Extensions
-	DeviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(DeviceExt.size());
-	DeviceCreateInfo.ppEnabledExtensionNames = DeviceExt.data();
+	std::vector<const char*> Extensions = DeviceExt;
+
+	// Optional, indirect draws read every command up to the maximum count without it
+	if (mDrawIndirectCountSupported)
+	{
+		Extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+	}
+
+	DeviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(Extensions.size());
+	DeviceCreateInfo.ppEnabledExtensionNames = Extensions.data();
 
 	// Debug layers
 	if (VulkanCore::Get().GetDebugMode())
@@ -145,7 +162,14 @@ bool Device::CreateDevice(const VkPhysicalDevice& Device)
 		DeviceCreateInfo.ppEnabledLayerNames = &DebugLayerName;	
 	}
 
-	return vkCreateDevice(Device, &DeviceCreateInfo, nullptr, &mDevice) == VK_SUCCESS;
+	if (vkCreateDevice(Device, &DeviceCreateInfo, nullptr, &mDevice) != VK_SUCCESS) { return false; }
+
+	if (mDrawIndirectCountSupported)
+	{
+		mDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(mDevice, "vkCmdDrawIndexedIndirectCountKHR"));
+	}
+
+	return true;
 }
 
 bool Device::FindDevice(const VkPhysicalDevice& Device)
@@ -169,6 +193,8 @@ bool Device::FindDevice(const VkPhysicalDevice& Device)
 	}
 
 	mQueuesIndicies = Queues;
+	mSupportedFeatures = Features;
+	mDrawIndirectCountSupported = IsExtensionSupported(Device, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
 
 	if (!CheckDeviceFormatsSupport(Device)) { return false; }
 
@@ -201,9 +227,15 @@ QueueResult Device::FindQueueFamilies(const VkPhysicalDevice& Device)
 		{
 			Result.GraphicsIndex = QueueIndex;
 		}
+		// Family without graphics is preferred, it's usually backed by separate hardware queues
 		if (CurrentQueue.queueFlags & VK_QUEUE_COMPUTE_BIT)
 		{
-			Result.ComputeIndex = QueueIndex;
+			const bool Dedicated = (CurrentQueue.queueFlags & VK_QUEUE_GRAPHICS_BIT) == 0;
+
+			if (Result.ComputeIndex < 0 || Dedicated)
+			{
+				Result.ComputeIndex = QueueIndex;
+			}
 		}
 
 	}
@@ -231,6 +263,19 @@ bool Device::CheckDeviceExtensionSupport(const VkPhysicalDevice& Device)
 	return Result;
 }
 
+bool Device::IsExtensionSupported(const VkPhysicalDevice& Device, const char* Extension)
+{
+	uint32_t ExtCount;
+	vkEnumerateDeviceExtensionProperties(Device, nullptr, &ExtCount, nullptr);
+
+	std::vector<VkExtensionProperties> DeviceExtensions(ExtCount);
+	vkEnumerateDeviceExtensionProperties(Device, nullptr, &ExtCount, DeviceExtensions.data());
+
+	return std::any_of(DeviceExtensions.begin(), DeviceExtensions.end(), [Extension](auto& SupportedExt) {
+		return strcmp(SupportedExt.extensionName, Extension) == 0;
+	});
+}
+
 bool Device::CheckDeviceFormatsSupport(const VkPhysicalDevice& Device)
 {
 	bool Result = true;
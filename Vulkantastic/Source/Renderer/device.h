@@ -3,6 +3,12 @@
 #define VK_USE_PLATFORM_WIN32_KHR 1
 #include "vulkan/vulkan.h"
 
+// Included headers predate VK_KHR_draw_indirect_count, its entry point has the same signature as the AMD one
+#ifndef VK_KHR_draw_indirect_count
+#define VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME "VK_KHR_draw_indirect_count"
+typedef PFN_vkCmdDrawIndexedIndirectCountAMD PFN_vkCmdDrawIndexedIndirectCountKHR;
+#endif
+
 struct QueueResult
 {
 	int32_t GraphicsIndex = -1;
@@ -31,6 +37,19 @@ public:
 	inline QueueResult GetQueuesIndicies() const { return mQueuesIndicies; }
 	inline VkQueue GetGraphicsQueue() const { return mGraphicsQueue; }
 	inline VkQueue GetComputeQueue() const { return mComputeQueue; }
+	inline const VkPhysicalDeviceFeatures& GetEnabledFeatures() const { return mEnabledFeatures; }
+
+	// Compute queue comes from a family without graphics, so its work can run next to the graphics queue
+	inline bool HasAsyncCompute() const { return mQueuesIndicies.ComputeIndex != mQueuesIndicies.GraphicsIndex; }
+	inline bool SupportsTimestamps() const { return mLimits.timestampComputeAndGraphics == VK_TRUE; }
+
+	// Without it occlusion queries may only tell whether any sample passed
+	inline bool SupportsPreciseOcclusionQueries() const { return mEnabledFeatures.occlusionQueryPrecise == VK_TRUE; }
+
+	// VK_KHR_draw_indirect_count, number of indirect draws can be read from a buffer
+	inline bool SupportsDrawIndirectCount() const { return mDrawIndexedIndirectCount != nullptr; }
+	inline PFN_vkCmdDrawIndexedIndirectCountKHR GetDrawIndexedIndirectCount() const { return mDrawIndexedIndirectCount; }
+
 	VkQueue GetQueueByIndex(int32_t QueueIndex) const;
 
 private:
@@ -43,6 +62,10 @@ private:
 	VkSurfaceCapabilitiesKHR mSurfaceCapabilities;
 	VkPhysicalDeviceMemoryProperties mMemoryProperties;
 	VkPhysicalDeviceLimits mLimits;
+	VkPhysicalDeviceFeatures mSupportedFeatures = {};
+	VkPhysicalDeviceFeatures mEnabledFeatures = {};
+	bool mDrawIndirectCountSupported = false;
+	PFN_vkCmdDrawIndexedIndirectCountKHR mDrawIndexedIndirectCount = nullptr;
 
 	void GetQueues();
 	void GetCapabilities(const VkPhysicalDevice& Device);
@@ -51,6 +74,7 @@ private:
 	bool FindDevice(const VkPhysicalDevice& Device);
 	QueueResult FindQueueFamilies(const VkPhysicalDevice& Device);
 	bool CheckDeviceExtensionSupport(const VkPhysicalDevice& Device);
+	bool IsExtensionSupported(const VkPhysicalDevice& Device, const char* Extension);
 	bool CheckDeviceFormatsSupport(const VkPhysicalDevice& Device);
 
 };
\ No newline at end of file
@@ -232,11 +232,13 @@ uint8_t Image::GetNumComponentsByFormat(ImageFormat Format)
 		return 1;
 	case ImageFormat::R8G8:
 	case ImageFormat::R8G8_SRGB:
+	case ImageFormat::R16G16:
 	case ImageFormat::D24S8:
 		return 2;
 	case ImageFormat::R8G8B8A8:
 	case ImageFormat::R8G8B8A8_SRGB:
 	case ImageFormat::B8G8R8A8:
+	case ImageFormat::A2B10G10R10:
 		return 4;
 	}
 	return 0;
@@ -255,6 +257,8 @@ int32_t Image::GetSizeInBytesByFormat(ImageFormat Format)
 	case ImageFormat::R8G8B8A8:
 	case ImageFormat::R8G8B8A8_SRGB:
 	case ImageFormat::B8G8R8A8:
+	case ImageFormat::R16G16:
+	case ImageFormat::A2B10G10R10:
 	case ImageFormat::D24S8:
 		return 4;
 	}
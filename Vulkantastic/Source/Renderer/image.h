@@ -31,6 +31,8 @@ enum class ImageFormat : uint8_t
 	R8G8B8A8 = VK_FORMAT_R8G8B8A8_UNORM,
 	R8G8B8A8_SRGB = VK_FORMAT_R8G8B8A8_SRGB,
 	B8G8R8A8 = VK_FORMAT_B8G8R8A8_UNORM,
+	R16G16 = VK_FORMAT_R16G16_UNORM,
+	A2B10G10R10 = VK_FORMAT_A2B10G10R10_UNORM_PACK32,
 	D24S8 = VK_FORMAT_D24_UNORM_S8_UINT,
 	BC1 = VK_FORMAT_BC1_RGB_UNORM_BLOCK,
 	BC1_SRGB = VK_FORMAT_BC1_RGB_SRGB_BLOCK
@@ -48,6 +50,7 @@ enum class ImageLayout
 	UNDEFINED = VK_IMAGE_LAYOUT_UNDEFINED,
 	COLOR_ATTACHMENT = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
 	DEPTH_STENCIL_ATTACHMENT = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+	DEPTH_STENCIL_READ_ONLY = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
 	SHADER_READ = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
 	TRANSFER_SRC = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
 	TRANSFER_DST = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
@@ -87,6 +90,8 @@ public:
 	inline ImageLayout GetCurrentLayout() const { return mCurrentLayout; }
 	inline uint32_t GetMipMapsCount() const { return mMipMapsCount; }
 	inline ImageFormat GetFormat() const { return mSettings.Format; }
+	inline uint32_t GetWidth() const { return mSettings.Width; }
+	inline uint32_t GetHeight() const { return mSettings.Height; }
 
 	static uint8_t GetNumComponentsByFormat(ImageFormat Format);
 	static int32_t GetSizeInBytesByFormat(ImageFormat Format);
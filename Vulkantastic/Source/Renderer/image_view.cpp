@@ -36,7 +36,11 @@ void ImageView::CreateImageView(const VkImage& RawImage)
 	ViewInfo.subresourceRange.levelCount = mSettings.MipMapLevelCount;
 	ViewInfo.subresourceRange.baseArrayLayer = mSettings.BaseArrayLevel;
 	ViewInfo.subresourceRange.layerCount = mSettings.ArrayLevelCount;
-	ViewInfo.subresourceRange.aspectMask = mSettings.Format == ImageFormat::D24S8 ? VK_IMAGE_ASPECT_STENCIL_BIT | VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+	ViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	if (mSettings.Format == ImageFormat::D24S8)
+	{
+		ViewInfo.subresourceRange.aspectMask = mSettings.DepthOnly ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_STENCIL_BIT | VK_IMAGE_ASPECT_DEPTH_BIT;
+	}
 	ViewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
 	ViewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
 	ViewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
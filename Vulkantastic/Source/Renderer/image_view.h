@@ -9,6 +9,7 @@ struct ImageViewSettings
 	uint32_t BaseArrayLevel = 0;
 	uint32_t ArrayLevelCount = 1;
 	ImageFormat Format = ImageFormat::R8G8B8A8;
+	bool DepthOnly = false; // Views of depth stencil formats that are sampled can't include the stencil aspect
 };
 
 
@@ -178,8 +178,20 @@ void MemoryManager::UploadData(Allocation& Alloc, const void* Data, uint32_t Siz
 	const VkDevice Device = VulkanCore::Get().GetDevice()->GetDevice();
 
 	void* Memory;
-	vkMapMemory(Device, Alloc.GetMemory(), Alloc.GetOffset(), Alloc.GetSize(), 0, &Memory);
-	memcpy(Memory, Data, Alloc.GetSize());
+	vkMapMemory(Device, Alloc.GetMemory(), Alloc.GetOffset() + Offset, Size, 0, &Memory);
+	memcpy(Memory, Data, Size);
+	vkUnmapMemory(Device, Alloc.GetMemory());
+}
+
+void MemoryManager::ReadData(const Allocation& Alloc, void* Data, uint32_t Size, uint32_t Offset /* = 0 */)
+{
+	Assert((Alloc.GetSize() - Offset) >= Size); // Overflow
+
+	const VkDevice Device = VulkanCore::Get().GetDevice()->GetDevice();
+
+	void* Memory;
+	vkMapMemory(Device, Alloc.GetMemory(), Alloc.GetOffset() + Offset, Size, 0, &Memory);
+	memcpy(Data, Memory, Size);
 	vkUnmapMemory(Device, Alloc.GetMemory());
 }
 
@@ -78,6 +78,7 @@ public:
 	bool Free(Allocation& Alloc);
 
 	void UploadData(Allocation& Alloc, const void* Data, uint32_t Size, uint32_t Offset = 0);
+	void ReadData(const Allocation& Alloc, void* Data, uint32_t Size, uint32_t Offset = 0);
 
 private:
 	std::map<uint32_t, MemoryPool*> mLinearPools;
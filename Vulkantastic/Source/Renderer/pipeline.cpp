@@ -33,20 +33,19 @@ ComputePipeline::ComputePipeline(Shader* ComputeShader)
 {
 	auto Device = VulkanCore::Get().GetDevice()->GetDevice();
 
+	Assert(ComputeShader && ComputeShader->GetType() == ShaderType::COMPUTE);
+
+	mWorkgroupSize = ComputeShader->GetWorkgroupSize();
+
 	auto ShadersList = { ComputeShader };
 	mDescriptorManager = std::make_unique<DescriptorManager>(ShadersList);
 
-	VkPipelineLayoutCreateInfo ComputeLayoutCreateInfo = {};
-	ComputeLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	ComputeLayoutCreateInfo.setLayoutCount = 1;
-	auto DescLayout = mDescriptorManager->GetLayout();
-	ComputeLayoutCreateInfo.pSetLayouts = &DescLayout;
-
-	Assert(vkCreatePipelineLayout(Device, &ComputeLayoutCreateInfo, nullptr, &mPipelineLayout) == VK_SUCCESS);
+	// Layout with all descriptor sets and push constants used by the shader
+	mPipelineLayout = std::make_unique<PipelineCreation::PipelineLayout>(mDescriptorManager.get());
 
 	VkComputePipelineCreateInfo ComputePipelineCreateInfo = {};
 	ComputePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-	ComputePipelineCreateInfo.layout = mPipelineLayout;
+	ComputePipelineCreateInfo.layout = mPipelineLayout->GetPipelineLayout();
 
 	VkPipelineShaderStageCreateInfo ComputeShaderStage = {};
 	ComputeShaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -55,7 +54,6 @@ ComputePipeline::ComputePipeline(Shader* ComputeShader)
 	ComputeShaderStage.pName = "main";
 	ComputePipelineCreateInfo.stage = ComputeShaderStage;
 
-	VkPipeline ComputePipeline = nullptr;
 	Assert(vkCreateComputePipelines(Device, VK_NULL_HANDLE, 1, &ComputePipelineCreateInfo, nullptr, &mPipeline) == VK_SUCCESS);
 
 }
@@ -68,10 +66,5 @@ ComputePipeline::~ComputePipeline()
 	{
 		vkDestroyPipeline(Device, mPipeline, nullptr);
 	}
-
-	if (mPipelineLayout)
-	{
-		vkDestroyPipelineLayout(Device, mPipelineLayout, nullptr);
-	}
 }
 
@@ -26,6 +26,31 @@ private:
 
 };
 
+// Fixed function state of a graphics pipeline, pipelines that differ only by it are variants of the same pipeline
+// Lets materials be double-sided, translucent or depth only without their own shaders
+struct PipelineState
+{
+	BlendMode Blend = BlendMode::Opaque; // Of all color attachments
+	bool ColorWrite = true; // Depth only when disabled
+	PipelineCreation::DepthCompareOP DepthCompareOP = PipelineCreation::DepthCompareOP::LESS;
+	bool DepthWrite = true;
+	bool DepthTest = true;
+	PipelineCreation::CullMode Cull = PipelineCreation::CullMode::BACK;
+	PipelineCreation::PrimitiveTopology Topology = PipelineCreation::PrimitiveTopology::TRIANGLE_LIST;
+
+	// Packs all fields into the bits of one integer, part of the pipeline key
+	inline uint32_t GetKey() const
+	{
+		return static_cast<uint32_t>(Blend)
+			| static_cast<uint32_t>(ColorWrite) << 2
+			| static_cast<uint32_t>(DepthCompareOP) << 3
+			| static_cast<uint32_t>(DepthWrite) << 6
+			| static_cast<uint32_t>(DepthTest) << 7
+			| static_cast<uint32_t>(Cull) << 8
+			| static_cast<uint32_t>(Topology) << 10;
+	}
+};
+
 class IPipeline
 {
 public:
@@ -41,7 +66,9 @@ class IGraphicsPipeline : public IPipeline
 {
 public:
 	
-	virtual std::vector<VkViewport> GetViewports() = 0;
+	virtual const std::vector<VkViewport>& GetViewports() const = 0;
+	virtual const std::vector<VkRect2D>& GetScissors() const = 0;
+	virtual const PipelineState& GetState() const = 0;
 	
 };
 
@@ -59,21 +86,28 @@ public:
 
 	virtual VkPipeline GetPipeline() const override { return mPipeline; }
 	virtual DescriptorManager* GetDescriptorManager() override { return mDescriptorManager.get(); }
-	virtual VkPipelineLayout GetPipelineLayout() override { return mPipelineLayout; }
+	virtual VkPipelineLayout GetPipelineLayout() override { return mPipelineLayout->GetPipelineLayout(); }
+
+	inline WorkgroupSize GetWorkgroupSize() const { return mWorkgroupSize; }
+
+	// Workgroups needed to cover the invocations along every axis
+	inline uint32_t GetGroupsCountX(uint32_t Invocations) const { return (Invocations + mWorkgroupSize.X - 1) / mWorkgroupSize.X; }
+	inline uint32_t GetGroupsCountY(uint32_t Invocations) const { return (Invocations + mWorkgroupSize.Y - 1) / mWorkgroupSize.Y; }
 
 private:
 	VkPipeline mPipeline = nullptr;
-	VkPipelineLayout mPipelineLayout = nullptr;
+	std::unique_ptr<PipelineCreation::PipelineLayout> mPipelineLayout;
 	std::unique_ptr<DescriptorManager> mDescriptorManager;
+	WorkgroupSize mWorkgroupSize;
 
 };
 
-
 template<typename ...VertexDef>
 class GraphicsPipeline : public IGraphicsPipeline
 {
 public:
-	GraphicsPipeline(const RenderPass& GraphicsRenderPass, PipelineShaders Shaders);
+	// Pipelines with a base pipeline are created as its derivatives
+	GraphicsPipeline(const RenderPass& GraphicsRenderPass, PipelineShaders Shaders, const PipelineState& State = {}, VkPipeline BasePipeline = VK_NULL_HANDLE);
 	~GraphicsPipeline();
 
 	GraphicsPipeline(const GraphicsPipeline& Rhs) = delete;
@@ -85,10 +119,13 @@ public:
 	virtual VkPipeline GetPipeline() const override { return mPipeline; }
 	virtual DescriptorManager* GetDescriptorManager() override { return mDescriptorManager.get(); }
 	virtual VkPipelineLayout GetPipelineLayout() override { return mPipelineLayout->GetPipelineLayout(); }
-	virtual std::vector<VkViewport> GetViewports() override { return mViewportState->GetViewports(); }
+	virtual const std::vector<VkViewport>& GetViewports() const override { return mViewportState->GetViewports(); }
+	virtual const std::vector<VkRect2D>& GetScissors() const override { return mViewportState->GetScissors(); }
+	virtual const PipelineState& GetState() const override { return mState; }
 
 private:
 	VkPipeline mPipeline = nullptr;
+	PipelineState mState;
 	std::unique_ptr<PipelineCreation::PipelineLayout> mPipelineLayout;
 	std::unique_ptr<PipelineCreation::ViewportState> mViewportState;
 	std::unique_ptr<DescriptorManager> mDescriptorManager;
@@ -96,13 +133,22 @@ private:
 };
 
 template<typename ...VertexDef>
-GraphicsPipeline<VertexDef...>::GraphicsPipeline(const RenderPass& GraphicsRenderPass, PipelineShaders Shaders)
+GraphicsPipeline<VertexDef...>::GraphicsPipeline(const RenderPass& GraphicsRenderPass, PipelineShaders Shaders, const PipelineState& State /*= {}*/, VkPipeline BasePipeline /*= VK_NULL_HANDLE*/)
+	: mState(State)
 {
 	auto Device = VulkanCore::Get().GetDevice()->GetDevice();
 
 	VkGraphicsPipelineCreateInfo GraphicsPipelineInfo = {};
 	GraphicsPipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
 	GraphicsPipelineInfo.renderPass = GraphicsRenderPass.GetRenderPass();
+	GraphicsPipelineInfo.flags = VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT;
+
+	if (BasePipeline)
+	{
+		GraphicsPipelineInfo.flags |= VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+		GraphicsPipelineInfo.basePipelineHandle = BasePipeline;
+		GraphicsPipelineInfo.basePipelineIndex = -1;
+	}
 	
 	const auto& ColorAttachments = GraphicsRenderPass.GetColorAttachments();
 	std::vector<PipelineCreation::ViewportSize> Viewports;
@@ -113,6 +159,13 @@ GraphicsPipeline<VertexDef...>::GraphicsPipeline(const RenderPass& GraphicsRende
 		Viewports.push_back({ Attachment.Width, Attachment.Height });
 	}
 
+	// Depth only passes take the size of their depth attachment
+	if (ColorAttachments.empty() && GraphicsRenderPass.IsDepthEnabled())
+	{
+		const DepthAttachment DepthInfo = GraphicsRenderPass.GetDepthAttachment();
+		Viewports.push_back({ DepthInfo.Width, DepthInfo.Height });
+	}
+
 	mViewportState = std::make_unique<PipelineCreation::ViewportState>(Viewports);
 	GraphicsPipelineInfo.pViewportState = mViewportState->GetViewportState();
 	
@@ -136,27 +189,27 @@ GraphicsPipeline<VertexDef...>::GraphicsPipeline(const RenderPass& GraphicsRende
 
 		auto Flags = static_cast<PipelineCreation::AttachmentFlag>(0);
 
-		for (uint8_t i = 1; i <= NumComp; ++i)
+		for (uint8_t i = 1; i <= NumComp && State.ColorWrite; ++i)
 		{
 			Flags = Flags | static_cast<PipelineCreation::AttachmentFlag>(i);
 		}
 
-		ColorBlends.emplace_back( Flags, Attachment.Blend );
+		ColorBlends.emplace_back( Flags, State.Blend );
 	}
 
 	PipelineCreation::ColorBlendState ColorBlend(ColorBlends);
 	GraphicsPipelineInfo.pColorBlendState = ColorBlend.GetColorBlendState();
 
-	PipelineCreation::DepthStencilState DepthStencil{};
+	PipelineCreation::DepthStencilState DepthStencil{ State.DepthCompareOP, State.DepthWrite, State.DepthTest };
 	GraphicsPipelineInfo.pDepthStencilState = DepthStencil.GetDepthStencilState();
 
 	PipelineCreation::MultisampleState Multisample{};
 	GraphicsPipelineInfo.pMultisampleState = Multisample.GetMultisampleState();
 
-	PipelineCreation::RasterizationState Rasterization{};
+	PipelineCreation::RasterizationState Rasterization{ State.Cull };
 	GraphicsPipelineInfo.pRasterizationState = Rasterization.GetRasterizationState();
 
-	PipelineCreation::InputAssemblyState InputAssembly{};
+	PipelineCreation::InputAssemblyState InputAssembly{ State.Topology };
 	GraphicsPipelineInfo.pInputAssemblyState = InputAssembly.GetInputAssemblyState();
 
 	PipelineCreation::ShaderPipeline ShaderPip(Shaders.GetVertexShader(), Shaders.GetFragmentShader());
@@ -33,11 +33,46 @@ namespace PipelineCreation
 
 		switch (CompareOP)
 		{
+		case DepthCompareOP::NEVER:
+		{
+			mDepthStencil.depthCompareOp = VK_COMPARE_OP_NEVER;
+			break;
+		}
 		case DepthCompareOP::LESS:
 		{
 			mDepthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
 			break;
 		}
+		case DepthCompareOP::EQUAL:
+		{
+			mDepthStencil.depthCompareOp = VK_COMPARE_OP_EQUAL;
+			break;
+		}
+		case DepthCompareOP::LESS_OR_EQUAL:
+		{
+			mDepthStencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+			break;
+		}
+		case DepthCompareOP::GREATER:
+		{
+			mDepthStencil.depthCompareOp = VK_COMPARE_OP_GREATER;
+			break;
+		}
+		case DepthCompareOP::NOT_EQUAL:
+		{
+			mDepthStencil.depthCompareOp = VK_COMPARE_OP_NOT_EQUAL;
+			break;
+		}
+		case DepthCompareOP::GREATER_OR_EQUAL:
+		{
+			mDepthStencil.depthCompareOp = VK_COMPARE_OP_GREATER_OR_EQUAL;
+			break;
+		}
+		case DepthCompareOP::ALWAYS:
+		{
+			mDepthStencil.depthCompareOp = VK_COMPARE_OP_ALWAYS;
+			break;
+		}
 		default:
 		{
 			Assert(false); // Not supported operation
@@ -122,10 +157,10 @@ namespace PipelineCreation
 		mMultisampleState.rasterizationSamples = static_cast<VkSampleCountFlagBits>(SampleCount);
 	}
 
-	InputAssemblyState::InputAssemblyState()
+	InputAssemblyState::InputAssemblyState(PrimitiveTopology Topology /*= PrimitiveTopology::TRIANGLE_LIST*/)
 	{
 		mInputAssemblyState.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		mInputAssemblyState.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		mInputAssemblyState.topology = static_cast<VkPrimitiveTopology>(Topology);
 		mInputAssemblyState.primitiveRestartEnable = VK_FALSE;
 	}
 
@@ -154,7 +189,7 @@ namespace PipelineCreation
 				Assert(ShaderInput != ShaderInputs.end()); // Cannot find shader input
 
 				VkVertexInputAttributeDescription Attribute = {};
-				Attribute.format = ShaderReflection::InternalFormatToVulkan(ShaderInput->Format);
+				Attribute.format = Member.Format != VK_FORMAT_UNDEFINED ? Member.Format : ShaderReflection::InternalFormatToVulkan(ShaderInput->Format);
 				Attribute.location = ShaderInput->Location;
 				Attribute.binding = i;
 				Attribute.offset = Member.Offset;
@@ -253,6 +288,7 @@ namespace PipelineCreation
 	DynamicState::DynamicState()
 	{
 		mDynamicStates.push_back(VK_DYNAMIC_STATE_VIEWPORT);
+		mDynamicStates.push_back(VK_DYNAMIC_STATE_SCISSOR);
 
 		mDynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
 		mDynamicState.dynamicStateCount = static_cast<uint32_t>(mDynamicStates.size());
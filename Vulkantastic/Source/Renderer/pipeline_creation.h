@@ -8,12 +8,16 @@ class DescriptorManager;
 enum class PipelineStage
 {
 	START = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+	DRAW_INDIRECT = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
 	VERTEX_INPUT = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
 	VERTEX = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
 	FRAGMENT = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+	EARLY_FRAGMENT_TESTS = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+	LATE_FRAGMENT_TESTS = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
 	COLOR_ATTACHMENT = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
 	COMPUTE = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
 	TRANSER = VK_PIPELINE_STAGE_TRANSFER_BIT,
+	HOST = VK_PIPELINE_STAGE_HOST_BIT,
 	END = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
 };
 
@@ -39,9 +43,16 @@ namespace PipelineCreation
 
 	};
 
-	enum class DepthCompareOP
+	enum class DepthCompareOP : uint8_t
 	{
-		LESS = 0
+		NEVER = 0,
+		LESS,
+		EQUAL,
+		LESS_OR_EQUAL,
+		GREATER,
+		NOT_EQUAL,
+		GREATER_OR_EQUAL,
+		ALWAYS
 	};
 
 	class DepthStencilState
@@ -92,8 +103,9 @@ namespace PipelineCreation
 		std::vector<VkPipelineColorBlendAttachmentState> mAttachemntStates;
 	};
 
-	enum class CullMode
+	enum class CullMode : uint8_t
 	{
+		NONE = VK_CULL_MODE_NONE,
 		FRONT = VK_CULL_MODE_FRONT_BIT,
 		BACK = VK_CULL_MODE_BACK_BIT,
 		FRONTBACK = VK_CULL_MODE_FRONT_AND_BACK
@@ -128,10 +140,19 @@ namespace PipelineCreation
 	};
 
 
+	enum class PrimitiveTopology : uint8_t
+	{
+		POINT_LIST = VK_PRIMITIVE_TOPOLOGY_POINT_LIST,
+		LINE_LIST = VK_PRIMITIVE_TOPOLOGY_LINE_LIST,
+		LINE_STRIP = VK_PRIMITIVE_TOPOLOGY_LINE_STRIP,
+		TRIANGLE_LIST = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+		TRIANGLE_STRIP = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP
+	};
+
 	class InputAssemblyState
 	{
 	public:
-		InputAssemblyState();
+		InputAssemblyState(PrimitiveTopology Topology = PrimitiveTopology::TRIANGLE_LIST);
 
 		inline VkPipelineInputAssemblyStateCreateInfo* GetInputAssemblyState() { return &mInputAssemblyState; }
 
@@ -165,8 +186,8 @@ namespace PipelineCreation
 		ViewportState(const std::vector<ViewportSize>& Sizes);
 
 		inline VkPipelineViewportStateCreateInfo* GetViewportState() { return &mViewportState; }
-		inline std::vector<VkViewport> GetViewports() const { return mViewports; }
-		inline std::vector<VkRect2D> GetScissors() const { return mScissors; }
+		inline const std::vector<VkViewport>& GetViewports() const { return mViewports; }
+		inline const std::vector<VkRect2D>& GetScissors() const { return mScissors; }
 
 	private:
 		VkPipelineViewportStateCreateInfo mViewportState = {};
@@ -1,5 +1,6 @@
 #include "pipeline_manager.h"
-#include <numeric>
+#include "../Utilities/assert.h"
+#include "../Utilities/hash.h"
 
 bool PipelineManager::Shutdown()
 {
@@ -7,22 +8,131 @@ bool PipelineManager::Shutdown()
 	{
 		delete Pipeline.second;
 	}
+	mPipelines.clear();
+	mPipelineIds.clear();
+	mPipelinesById.clear(); // Destroys the compatible render passes
+	mBasePipelineIds.clear();
+	mComputePipelines.clear();
 	return true;
 }
 
 PipelineManager::KeyType PipelineManager::HashShaders(const std::vector<Shader*>& Shaders) const
 {
-	// For now I take combined names of shaders as a key
-	const std::string KeyResult = std::accumulate(cbegin(Shaders), cend(Shaders), std::string{}, [](std::string CurrentResult, const Shader* CurrentShader) {
-		return CurrentResult += CurrentShader->GetName();
-	});
+	// Names are hashed with their terminators, so the same letters split differently between shaders give another key
+	KeyType KeyResult = Hash::Seed;
+	for (const Shader* CurrentShader : Shaders)
+	{
+		const std::string& Name = CurrentShader->GetName();
+		KeyResult = Hash::Bytes(Name.c_str(), Name.size() + 1, KeyResult);
+	}
 
 	return KeyResult;
 }
 
+ComputePipeline* PipelineManager::GetComputePipeline(Shader* ComputeShader)
+{
+	Assert(ComputeShader);
+
+	const KeyType KeyResult = HashShaders({ ComputeShader });
+	auto It = mComputePipelines.find(KeyResult);
+	if (It != end(mComputePipelines))
+	{
+		Assert(It->second.ComputeShader == ComputeShader);
+		return It->second.Pipeline.get();
+	}
+
+	ComputeEntry& NewEntry = mComputePipelines[KeyResult];
+	NewEntry.ComputeShader = ComputeShader;
+	NewEntry.Pipeline = std::make_unique<ComputePipeline>(ComputeShader);
+
+	return NewEntry.Pipeline.get();
+}
+
 IGraphicsPipeline* PipelineManager::GetPipelineByKey(KeyType Key)
 {
 	auto It = mPipelines.find(Key);
 	return It != mPipelines.end() ? It->second : nullptr;
 }
 
+PipelineManager::KeyType PipelineManager::HashPipeline(const std::vector<Shader*>& Shaders, const RenderPass& GraphicsRenderPass, const PipelineState& State) const
+{
+	return HashState(HashBase(Shaders, GraphicsRenderPass), State);
+}
+
+IGraphicsPipeline* PipelineManager::GetPipelineVariant(uint32_t Id, const PipelineState& State)
+{
+	Assert(Id < mPipelinesById.size());
+
+	const PipelineEntry& Original = mPipelinesById[Id];
+	const KeyType KeyResult = HashState(Original.BaseKey, State);
+
+	auto It = mPipelines.find(KeyResult);
+	if (It != end(mPipelines))
+	{
+		Assert(IsSamePipeline(mPipelinesById[GetPipelineId(KeyResult)], Original.Shaders, *Original.CompatibleRenderPass, State));
+		return It->second;
+	}
+
+	// Copied since adding the variant can move the original's entry
+	const KeyType BaseKey = Original.BaseKey;
+	const std::vector<Shader*> Shaders = Original.Shaders;
+	std::shared_ptr<const RenderPass> CompatibleRenderPass = Original.CompatibleRenderPass;
+	VariantFactory CreateVariant = Original.CreateVariant;
+
+	return CreatePipeline(KeyResult, BaseKey, Shaders, State, std::move(CompatibleRenderPass), std::move(CreateVariant));
+}
+
+uint32_t PipelineManager::GetPipelineId(const KeyType& Key) const
+{
+	auto It = mPipelineIds.find(Key);
+	Assert(It != mPipelineIds.end());
+
+	return It->second;
+}
+
+IGraphicsPipeline* PipelineManager::CreatePipeline(const KeyType& Key, const KeyType& BaseKey, const std::vector<Shader*>& Shaders, const PipelineState& State, std::shared_ptr<const RenderPass> CompatibleRenderPass, VariantFactory CreateVariant)
+{
+	// Variants share shaders and the render pass, the driver can reuse most of the base pipeline when deriving from it
+	VkPipeline BasePipeline = VK_NULL_HANDLE;
+
+	auto Base = mBasePipelineIds.find(BaseKey);
+	if (Base != end(mBasePipelineIds))
+	{
+		const PipelineEntry& BaseEntry = mPipelinesById[Base->second];
+
+		// Base key of other shaders or an incompatible render pass collided with this one
+		Assert(BaseEntry.Shaders == Shaders && BaseEntry.CompatibleRenderPass->IsCompatible(*CompatibleRenderPass));
+
+		BasePipeline = BaseEntry.Pipeline->GetPipeline();
+		++mDerivativesCount;
+	}
+
+	IGraphicsPipeline* NewEntry = CreateVariant(*CompatibleRenderPass, State, BasePipeline);
+	const uint32_t NewId = static_cast<uint32_t>(mPipelinesById.size());
+
+	const bool Inserted = mPipelines.emplace(Key, NewEntry).second;
+	Assert(Inserted);
+
+	mPipelineIds[Key] = NewId;
+	mBasePipelineIds.emplace(BaseKey, NewId);
+	mPipelinesById.push_back({ NewEntry, BaseKey, Shaders, std::move(CompatibleRenderPass), std::move(CreateVariant) });
+
+	return NewEntry;
+}
+
+PipelineManager::KeyType PipelineManager::HashBase(const std::vector<Shader*>& Shaders, const RenderPass& GraphicsRenderPass) const
+{
+	const uint64_t CompatibilityKey = GraphicsRenderPass.GetCompatibilityKey();
+	return Hash::Bytes(&CompatibilityKey, sizeof(CompatibilityKey), HashShaders(Shaders));
+}
+
+PipelineManager::KeyType PipelineManager::HashState(const KeyType& BaseKey, const PipelineState& State) const
+{
+	const uint32_t StateKey = State.GetKey();
+	return Hash::Bytes(&StateKey, sizeof(StateKey), BaseKey);
+}
+
+bool PipelineManager::IsSamePipeline(const PipelineEntry& Entry, const std::vector<Shader*>& Shaders, const RenderPass& GraphicsRenderPass, const PipelineState& State) const
+{
+	return Entry.Shaders == Shaders && Entry.CompatibleRenderPass->IsCompatible(GraphicsRenderPass) && Entry.Pipeline->GetState().GetKey() == State.GetKey();
+}
@@ -2,7 +2,9 @@
 #include "render_pass.h"
 #include "pipeline.h"
 #include <map>
+#include <functional>
 #include "descriptor_manager.h"
+#include "../Utilities/assert.h"
 
 class PipelineManager
 {
@@ -24,57 +26,113 @@ public:
 	bool Startup() { return true; }
 	bool Shutdown();
 
-	using KeyType = std::string;
+	// 64-bit hash, pipelines found by a key are checked against collisions with the shaders, render pass and state they were created with
+	using KeyType = uint64_t;
 
 	KeyType HashShaders(const std::vector<Shader*>& Shaders) const;
 
+	// Shaders, compatibility of the render pass and the fixed function state, pipelines of the same key are interchangeable
+	KeyType HashPipeline(const std::vector<Shader*>& Shaders, const RenderPass& GraphicsRenderPass, const PipelineState& State) const;
+
+	// Creates the pipeline on the first call, derived from a pipeline that differs only by its state when there's one
+	template<typename ...T>
+	IGraphicsPipeline* GetGraphicsPipeline(const RenderPass& GraphicsRenderPass, PipelineShaders Shaders, const PipelineState& State = {});
+
 	template<typename ...T>
-	std::unique_ptr<class DescriptorInst> GetDescriptorInstance(const RenderPass& GraphicsRenderPass, PipelineShaders Shaders, uint32_t SetIdx = 0);
+	std::unique_ptr<class DescriptorInst> GetDescriptorInstance(const RenderPass& GraphicsRenderPass, PipelineShaders Shaders, uint32_t SetIdx = 0, const PipelineState& State = {});
 
 	template<typename ...T>
-	std::unique_ptr<class ShaderParameters> GetShaderParametersInstance(const RenderPass& GraphicsRenderPass, PipelineShaders Shaders, uint32_t SetIdx = 0);
+	std::unique_ptr<class ShaderParameters> GetShaderParametersInstance(const RenderPass& GraphicsRenderPass, PipelineShaders Shaders, uint32_t SetIdx = 0, const PipelineState& State = {});
+
+	// Compute pipelines don't depend on a render pass, one is created per shader and reused afterwards
+	ComputePipeline* GetComputePipeline(Shader* ComputeShader);
 
 	IGraphicsPipeline* GetPipelineByKey(KeyType Key);
 
+	// Small sequential ids of pipelines, used where a sparse key would be too slow
+	uint32_t GetPipelineId(const KeyType& Key) const;
+	inline IGraphicsPipeline* GetPipelineById(uint32_t Id) const { return Id < mPipelinesById.size() ? mPipelinesById[Id].Pipeline : nullptr; }
+
+	// Pipeline with the same shaders, vertex formats and render pass as the pipeline of the id, but another state
+	// Created on the first call, descriptor sets of the original pipeline can be bound with it since their layouts are the same
+	IGraphicsPipeline* GetPipelineVariant(uint32_t Id, const PipelineState& State);
+
+	// Pipelines created as derivatives of another pipeline
+	inline uint32_t GetDerivativesCount() const { return mDerivativesCount; }
+
 private:
+	using VariantFactory = std::function<IGraphicsPipeline*(const RenderPass&, const PipelineState&, VkPipeline)>;
+
+	struct PipelineEntry
+	{
+		IGraphicsPipeline* Pipeline = nullptr;
+		KeyType BaseKey; // Shaders and render pass compatibility, shared by all variants of the pipeline
+		std::vector<Shader*> Shaders;
+		std::shared_ptr<const RenderPass> CompatibleRenderPass; // Owned copy of the render pass the pipeline was created with, variants are created with it
+		VariantFactory CreateVariant;
+	};
+
+	template<typename ...T>
+	IGraphicsPipeline* FindOrCreatePipeline(const KeyType& Key, const RenderPass& GraphicsRenderPass, PipelineShaders Shaders, const PipelineState& State);
+
+	IGraphicsPipeline* CreatePipeline(const KeyType& Key, const KeyType& BaseKey, const std::vector<Shader*>& Shaders, const PipelineState& State, std::shared_ptr<const RenderPass> CompatibleRenderPass, VariantFactory CreateVariant);
+	KeyType HashBase(const std::vector<Shader*>& Shaders, const RenderPass& GraphicsRenderPass) const;
+	KeyType HashState(const KeyType& BaseKey, const PipelineState& State) const;
+
+	// False when another pipeline's key collided with the key of these shaders, render pass and state
+	bool IsSamePipeline(const PipelineEntry& Entry, const std::vector<Shader*>& Shaders, const RenderPass& GraphicsRenderPass, const PipelineState& State) const;
+
+	struct ComputeEntry
+	{
+		Shader* ComputeShader = nullptr;
+		std::unique_ptr<ComputePipeline> Pipeline;
+	};
+
 	std::map<KeyType, IGraphicsPipeline*> mPipelines;
+	std::map<KeyType, uint32_t> mPipelineIds;
+	std::vector<PipelineEntry> mPipelinesById;
+	std::map<KeyType, uint32_t> mBasePipelineIds; // First pipeline of every base key, later variants are derived from it
+	uint32_t mDerivativesCount = 0;
+
+	std::map<KeyType, ComputeEntry> mComputePipelines;
 
 };
 
 template<typename ...T>
-std::unique_ptr<DescriptorInst> PipelineManager::GetDescriptorInstance(const RenderPass& GraphicsRenderPass, PipelineShaders Shaders, uint32_t SetIdx)
+IGraphicsPipeline* PipelineManager::GetGraphicsPipeline(const RenderPass& GraphicsRenderPass, PipelineShaders Shaders, const PipelineState& State)
 {
-	using CurrentPipelineType = GraphicsPipeline<T...>;
-
-	const KeyType KeyResult = HashShaders(Shaders.GetShaders());
-	auto It = mPipelines.find(KeyResult);
-	if (It != end(mPipelines))
-	{
-		CurrentPipelineType* Pipeline = static_cast<CurrentPipelineType*>(It->second);
-		return Pipeline->GetDescriptorManager()->GetDescriptorInstance(SetIdx);
-	}
+	return FindOrCreatePipeline<T...>(HashPipeline(Shaders.GetShaders(), GraphicsRenderPass, State), GraphicsRenderPass, Shaders, State);
+}
 
-	CurrentPipelineType* NewEntry = new CurrentPipelineType(GraphicsRenderPass, Shaders);
-	mPipelines[KeyResult] = NewEntry;
+template<typename ...T>
+std::unique_ptr<DescriptorInst> PipelineManager::GetDescriptorInstance(const RenderPass& GraphicsRenderPass, PipelineShaders Shaders, uint32_t SetIdx, const PipelineState& State)
+{
+	return GetGraphicsPipeline<T...>(GraphicsRenderPass, Shaders, State)->GetDescriptorManager()->GetDescriptorInstance(SetIdx);
+}
 
-	return NewEntry->GetDescriptorManager()->GetDescriptorInstance(SetIdx);
+template<typename ...T>
+std::unique_ptr<ShaderParameters> PipelineManager::GetShaderParametersInstance(const RenderPass& GraphicsRenderPass, PipelineShaders Shaders, uint32_t SetIdx, const PipelineState& State)
+{
+	const KeyType KeyResult = HashPipeline(Shaders.GetShaders(), GraphicsRenderPass, State);
+	return FindOrCreatePipeline<T...>(KeyResult, GraphicsRenderPass, Shaders, State)->GetDescriptorManager()->GetShaderParametersInstance(KeyResult, SetIdx);
 }
 
 template<typename ...T>
-std::unique_ptr<ShaderParameters> PipelineManager::GetShaderParametersInstance(const RenderPass& GraphicsRenderPass, PipelineShaders Shaders, uint32_t SetIdx)
+IGraphicsPipeline* PipelineManager::FindOrCreatePipeline(const KeyType& Key, const RenderPass& GraphicsRenderPass, PipelineShaders Shaders, const PipelineState& State)
 {
 	using CurrentPipelineType = GraphicsPipeline<T...>;
 
-	const KeyType KeyResult = HashShaders(Shaders.GetShaders());
-	auto It = mPipelines.find(KeyResult);
+	auto It = mPipelines.find(Key);
 	if (It != end(mPipelines))
 	{
-		CurrentPipelineType* Pipeline = static_cast<CurrentPipelineType*>(It->second);
-		return Pipeline->GetDescriptorManager()->GetShaderParametersInstance(SetIdx);
+		Assert(IsSamePipeline(mPipelinesById[GetPipelineId(Key)], Shaders.GetShaders(), GraphicsRenderPass, State));
+		return It->second;
 	}
 
-	CurrentPipelineType* NewEntry = new CurrentPipelineType(GraphicsRenderPass, Shaders);
-	mPipelines[KeyResult] = NewEntry;
+	// Caller's render pass may be destroyed before variants of the pipeline are requested
+	std::shared_ptr<const RenderPass> CompatibleRenderPass = GraphicsRenderPass.CreateCompatible();
 
-	return NewEntry->GetDescriptorManager()->GetShaderParametersInstance(SetIdx);
+	return CreatePipeline(Key, HashBase(Shaders.GetShaders(), GraphicsRenderPass), Shaders.GetShaders(), State, std::move(CompatibleRenderPass), [Shaders](const RenderPass& VariantRenderPass, const PipelineState& VariantState, VkPipeline BasePipeline) -> IGraphicsPipeline* {
+		return new CurrentPipelineType(VariantRenderPass, Shaders, VariantState, BasePipeline);
+	});
 }
@@ -0,0 +1,73 @@
+#include "query_pool.h"
+#include "core.h"
+#include "device.h"
+#include "../Utilities/assert.h"
+
+TimestampQueryPool::TimestampQueryPool(uint32_t Count)
+	: mTimestamps(Count, 0)
+{
+	Assert(Count > 0);
+
+	auto Device = VulkanCore::Get().GetDevice()->GetDevice();
+
+	VkQueryPoolCreateInfo QueryPoolInfo = {};
+	QueryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	QueryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	QueryPoolInfo.queryCount = Count;
+
+	Assert(vkCreateQueryPool(Device, &QueryPoolInfo, nullptr, &mQueryPool) == VK_SUCCESS);
+}
+
+TimestampQueryPool::~TimestampQueryPool()
+{
+	auto Device = VulkanCore::Get().GetDevice()->GetDevice();
+
+	vkDestroyQueryPool(Device, mQueryPool, nullptr);
+}
+
+bool TimestampQueryPool::Read(uint32_t Count)
+{
+	Assert(Count <= GetCount());
+
+	auto Device = VulkanCore::Get().GetDevice()->GetDevice();
+
+	return vkGetQueryPoolResults(Device, mQueryPool, 0, Count, sizeof(uint64_t) * Count, mTimestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS;
+}
+
+float TimestampQueryPool::ToMilliseconds(uint64_t Ticks) const
+{
+	const float NanosecondsPerTick = VulkanCore::Get().GetDevice()->GetLimits().timestampPeriod;
+
+	return static_cast<float>(static_cast<double>(Ticks) * NanosecondsPerTick / 1000000.0);
+}
+
+OcclusionQueryPool::OcclusionQueryPool(uint32_t Count)
+	: mSamples(Count, 0)
+{
+	Assert(Count > 0);
+
+	auto Device = VulkanCore::Get().GetDevice()->GetDevice();
+
+	VkQueryPoolCreateInfo QueryPoolInfo = {};
+	QueryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	QueryPoolInfo.queryType = VK_QUERY_TYPE_OCCLUSION;
+	QueryPoolInfo.queryCount = Count;
+
+	Assert(vkCreateQueryPool(Device, &QueryPoolInfo, nullptr, &mQueryPool) == VK_SUCCESS);
+}
+
+OcclusionQueryPool::~OcclusionQueryPool()
+{
+	auto Device = VulkanCore::Get().GetDevice()->GetDevice();
+
+	vkDestroyQueryPool(Device, mQueryPool, nullptr);
+}
+
+bool OcclusionQueryPool::Read(uint32_t Count)
+{
+	Assert(Count <= GetCount());
+
+	auto Device = VulkanCore::Get().GetDevice()->GetDevice();
+
+	return vkGetQueryPoolResults(Device, mQueryPool, 0, Count, sizeof(uint64_t) * Count, mSamples.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS;
+}
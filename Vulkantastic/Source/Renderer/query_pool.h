@@ -0,0 +1,67 @@
+#pragma once
+#include "vulkan/vulkan_core.h"
+#include <memory>
+#include <vector>
+
+// Pool of GPU timestamps, written by Cmd::WriteTimestamp on graphics and compute queues
+// Queries have to be reset by Cmd::ResetQueries before they're written again
+class TimestampQueryPool
+{
+public:
+	explicit TimestampQueryPool(uint32_t Count);
+	~TimestampQueryPool();
+
+	TimestampQueryPool(const TimestampQueryPool& Rhs) = delete;
+	TimestampQueryPool& operator=(const TimestampQueryPool& Rhs) = delete;
+
+	TimestampQueryPool(TimestampQueryPool&& Rhs) = delete;
+	TimestampQueryPool& operator=(TimestampQueryPool&& Rhs) = delete;
+
+	// Fetches the first Count timestamps without waiting, returns false when any of them isn't written yet
+	bool Read(uint32_t Count);
+
+	// Ticks of the last read, compared across queues they rely on the device keeping a single clock for them
+	inline uint64_t GetTimestamp(uint32_t Query) const { return mTimestamps[Query]; }
+	float ToMilliseconds(uint64_t Ticks) const;
+
+	inline VkQueryPool GetQueryPool() const { return mQueryPool; }
+	inline uint32_t GetCount() const { return static_cast<uint32_t>(mTimestamps.size()); }
+
+private:
+	VkQueryPool mQueryPool = nullptr;
+	std::vector<uint64_t> mTimestamps;
+
+};
+
+using upTimestampQueryPool = std::unique_ptr<TimestampQueryPool>;
+
+// Pool of occlusion queries, every query counts samples that passed the depth and stencil tests between Cmd::BeginQuery and Cmd::EndQuery
+// Queries have to be reset by Cmd::ResetQueries before they're written again
+class OcclusionQueryPool
+{
+public:
+	explicit OcclusionQueryPool(uint32_t Count);
+	~OcclusionQueryPool();
+
+	OcclusionQueryPool(const OcclusionQueryPool& Rhs) = delete;
+	OcclusionQueryPool& operator=(const OcclusionQueryPool& Rhs) = delete;
+
+	OcclusionQueryPool(OcclusionQueryPool&& Rhs) = delete;
+	OcclusionQueryPool& operator=(OcclusionQueryPool&& Rhs) = delete;
+
+	// Fetches the first Count results without waiting, returns false when any of them isn't available yet
+	bool Read(uint32_t Count);
+
+	// Samples counted by the query during the last read, exact only when the device supports precise occlusion queries
+	inline uint64_t GetSamples(uint32_t Query) const { return mSamples[Query]; }
+
+	inline VkQueryPool GetQueryPool() const { return mQueryPool; }
+	inline uint32_t GetCount() const { return static_cast<uint32_t>(mSamples.size()); }
+
+private:
+	VkQueryPool mQueryPool = nullptr;
+	std::vector<uint64_t> mSamples;
+
+};
+
+using upOcclusionQueryPool = std::unique_ptr<OcclusionQueryPool>;
@@ -1,5 +1,6 @@
 #include "render_pass.h"
 #include "../Utilities/assert.h"
+#include "../Utilities/hash.h"
 
 
 RenderPass::RenderPass(const std::vector<ColorAttachment>& Colors, DepthAttachment Depth)
@@ -110,6 +111,17 @@ void RenderPass::CreateRenderPass(const std::vector<VkAttachmentDescription>& At
 	SubpassDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 	SubpassDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
 
+	// Depth written by a previous pass, e.g. a depth pre-pass, has to be there before it's tested
+	if (DepthAttachmentRef)
+	{
+		const VkPipelineStageFlags DepthStages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+		SubpassDependency.srcStageMask |= DepthStages;
+		SubpassDependency.srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		SubpassDependency.dstStageMask |= DepthStages;
+		SubpassDependency.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	}
+
 	VkRenderPassCreateInfo RenderPassInfo = {};
 	RenderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 	RenderPassInfo.subpassCount = 1;
@@ -143,3 +155,26 @@ RenderPass::~RenderPass()
 		vkDestroyRenderPass(Device, mRenderPass, nullptr);
 	}
 }
+
+std::unique_ptr<RenderPass> RenderPass::CreateCompatible() const
+{
+	return mDepthEnabled ? std::make_unique<RenderPass>(mColorAttachments, mDepthAttachment) : std::make_unique<RenderPass>(mColorAttachments);
+}
+
+uint64_t RenderPass::GetCompatibilityKey() const
+{
+	// Depth attachments always use the same format
+	uint64_t KeyResult = Hash::Bytes(&mDepthEnabled, sizeof(mDepthEnabled));
+	for (const ColorAttachment& Attachment : mColorAttachments)
+	{
+		KeyResult = Hash::Bytes(&Attachment.Format, sizeof(Attachment.Format), KeyResult);
+	}
+
+	return KeyResult;
+}
+
+bool RenderPass::IsCompatible(const RenderPass& Other) const
+{
+	return mDepthEnabled == Other.mDepthEnabled && std::equal(mColorAttachments.begin(), mColorAttachments.end(), Other.mColorAttachments.begin(), Other.mColorAttachments.end(),
+		[](const ColorAttachment& Lhs, const ColorAttachment& Rhs) { return Lhs.Format == Rhs.Format; });
+}
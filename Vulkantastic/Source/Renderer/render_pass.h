@@ -1,4 +1,5 @@
 #pragma once
+#include <memory>
 #include "image.h"
 #include "pipeline_creation.h"
 
@@ -22,7 +23,6 @@ struct ColorAttachment
 	ImageFormat Format = ImageFormat::R8G8B8A8;
 	AttachmentLoadOp LoadOp = AttachmentLoadOp::CLEAR;
 	AttachmentStoreOp StoreOp = AttachmentStoreOp::STORE;
-	BlendMode Blend = BlendMode::Opaque;
 	float Width = 0.0f;
 	float Height = 0.0f;
 };
@@ -34,6 +34,8 @@ struct DepthAttachment
 	AttachmentStoreOp DepthStoreOp = AttachmentStoreOp::STORE;
 	AttachmentLoadOp StencilLoadOp = AttachmentLoadOp::CLEAR;
 	AttachmentStoreOp StencilStoreOp = AttachmentStoreOp::STORE;
+	float Width = 0.0f; // Size of the viewport of depth only passes
+	float Height = 0.0f;
 };
 
 class RenderPass
@@ -54,6 +56,15 @@ public:
 	inline DepthAttachment GetDepthAttachment() const { return mDepthAttachment; }
 	inline bool IsDepthEnabled() const { return mDepthEnabled; }
 
+	// Hash of the attachments' formats, render passes with the same key are compatible unless the hash collides
+	uint64_t GetCompatibilityKey() const;
+
+	// A pipeline created with one of the render passes can be used with the other
+	bool IsCompatible(const RenderPass& Other) const;
+
+	// New render pass with the same attachments, pipelines created with it can be used with this one
+	std::unique_ptr<RenderPass> CreateCompatible() const;
+
 private:
 	VkAttachmentDescription CreateColorAttachment(const ColorAttachment& AttachmentInfo) const;
 	VkAttachmentDescription CreateDepthAttachment(const DepthAttachment& AttachmentInfo) const;
@@ -26,6 +26,11 @@ void Cmd::BindGraphicsPipeline(CommandBuffer* Cb, IGraphicsPipeline* Pipeline)
 	vkCmdBindPipeline(Cb->GetCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, Pipeline->GetPipeline());
 }
 
+void Cmd::BindComputePipeline(CommandBuffer* Cb, ComputePipeline* Pipeline)
+{
+	vkCmdBindPipeline(Cb->GetCommandBuffer(), VK_PIPELINE_BIND_POINT_COMPUTE, Pipeline->GetPipeline());
+}
+
 void Cmd::BindVertexBuffer(CommandBuffer* Cb, Buffer* VertexBuffer)
 {
 	VkDeviceSize Offsets[] = { 0 };
@@ -33,16 +38,16 @@ void Cmd::BindVertexBuffer(CommandBuffer* Cb, Buffer* VertexBuffer)
 	vkCmdBindVertexBuffers(Cb->GetCommandBuffer(), 0, 1, &BufferTmp, Offsets);
 }
 
-void Cmd::BindVertexAndIndexBuffer(CommandBuffer* Cb, Buffer* VertexBuffer, Buffer* IndexBuffer)
+void Cmd::BindVertexAndIndexBuffer(CommandBuffer* Cb, Buffer* VertexBuffer, Buffer* IndexBuffer, IndexType Type /*= IndexType::UINT32*/)
 {
 	BindVertexBuffer(Cb, VertexBuffer);
 
-	vkCmdBindIndexBuffer(Cb->GetCommandBuffer(), IndexBuffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	vkCmdBindIndexBuffer(Cb->GetCommandBuffer(), IndexBuffer->GetBuffer(), 0, static_cast<VkIndexType>(Type));
 }
 
-void Cmd::DrawIndexed(CommandBuffer* Cb, uint32_t Size, uint32_t InstancesCount /*= 1*/)
+void Cmd::DrawIndexed(CommandBuffer* Cb, uint32_t Size, uint32_t InstancesCount /*= 1*/, uint32_t FirstInstance /*= 0*/, uint32_t FirstIndex /*= 0*/, int32_t VertexOffset /*= 0*/)
 {
-	vkCmdDrawIndexed(Cb->GetCommandBuffer(), Size, InstancesCount, 0, 0, 0);
+	vkCmdDrawIndexed(Cb->GetCommandBuffer(), Size, InstancesCount, FirstIndex, VertexOffset, FirstInstance);
 }
 
 void Cmd::Draw(CommandBuffer* Cb, uint32_t Size, uint32_t InstancesCount /*= 1*/)
@@ -50,6 +55,186 @@ void Cmd::Draw(CommandBuffer* Cb, uint32_t Size, uint32_t InstancesCount /*= 1*/
 	vkCmdDraw(Cb->GetCommandBuffer(), Size, InstancesCount, 0, 0);
 }
 
+void Cmd::DrawIndexedIndirect(CommandBuffer* Cb, Buffer* ArgsBuffer, uint32_t Offset /*= 0*/, uint32_t DrawCount /*= 1*/)
+{
+	vkCmdDrawIndexedIndirect(Cb->GetCommandBuffer(), ArgsBuffer->GetBuffer(), Offset, DrawCount, sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void Cmd::DrawIndexedIndirectCount(CommandBuffer* Cb, Buffer* ArgsBuffer, uint32_t Offset, Buffer* CountBuffer, uint32_t CountOffset, uint32_t MaxDrawCount)
+{
+	const Device* CurrentDevice = VulkanCore::Get().GetDevice();
+
+	Assert(CurrentDevice->SupportsDrawIndirectCount());
+	Assert(CountOffset % 4 == 0);
+
+	CurrentDevice->GetDrawIndexedIndirectCount()(Cb->GetCommandBuffer(), ArgsBuffer->GetBuffer(), Offset, CountBuffer->GetBuffer(), CountOffset, MaxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void Cmd::Dispatch(CommandBuffer* Cb, uint32_t GroupsX, uint32_t GroupsY /*= 1*/, uint32_t GroupsZ /*= 1*/)
+{
+	vkCmdDispatch(Cb->GetCommandBuffer(), GroupsX, GroupsY, GroupsZ);
+}
+
+void Cmd::DispatchIndirect(CommandBuffer* Cb, Buffer* ArgsBuffer, uint32_t Offset /*= 0*/)
+{
+	Assert(Offset % 4 == 0);
+
+	vkCmdDispatchIndirect(Cb->GetCommandBuffer(), ArgsBuffer->GetBuffer(), Offset);
+}
+
+void Cmd::CopyBuffer(CommandBuffer* Cb, Buffer* Src, Buffer* Dst, uint32_t Size, uint32_t SrcOffset /*= 0*/, uint32_t DstOffset /*= 0*/)
+{
+	VkBufferCopy Region = {};
+	Region.srcOffset = SrcOffset;
+	Region.dstOffset = DstOffset;
+	Region.size = Size;
+
+	vkCmdCopyBuffer(Cb->GetCommandBuffer(), Src->GetBuffer(), Dst->GetBuffer(), 1, &Region);
+}
+
+void Cmd::FillBuffer(CommandBuffer* Cb, Buffer* Dst, uint32_t Value, VkDeviceSize Size /*= VK_WHOLE_SIZE*/, uint32_t Offset /*= 0*/)
+{
+	vkCmdFillBuffer(Cb->GetCommandBuffer(), Dst->GetBuffer(), Offset, Size, Value);
+}
+
+void Cmd::BufferBarrier(CommandBuffer* Cb, Buffer* Buf, PipelineStage SrcStage, VkAccessFlags SrcAccess, PipelineStage DstStage, VkAccessFlags DstAccess)
+{
+	VkBufferMemoryBarrier Barrier = {};
+	Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	Barrier.buffer = Buf->GetBuffer();
+	Barrier.offset = 0;
+	Barrier.size = VK_WHOLE_SIZE;
+	Barrier.srcAccessMask = SrcAccess;
+	Barrier.dstAccessMask = DstAccess;
+	Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+	vkCmdPipelineBarrier(Cb->GetCommandBuffer(), static_cast<VkPipelineStageFlags>(SrcStage), static_cast<VkPipelineStageFlags>(DstStage), 0, 0, nullptr, 1, &Barrier, 0, nullptr);
+}
+
+void Cmd::ReleaseBuffer(CommandBuffer* Cb, Buffer* Buf, PipelineStage SrcStage, VkAccessFlags SrcAccess, int32_t DstQueueIndex)
+{
+	VkBufferMemoryBarrier Barrier = {};
+	Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	Barrier.buffer = Buf->GetBuffer();
+	Barrier.offset = 0;
+	Barrier.size = VK_WHOLE_SIZE;
+	Barrier.srcAccessMask = SrcAccess;
+	Barrier.dstAccessMask = 0;
+	Barrier.srcQueueFamilyIndex = Cb->GetQueueIndex();
+	Barrier.dstQueueFamilyIndex = DstQueueIndex;
+
+	vkCmdPipelineBarrier(Cb->GetCommandBuffer(), static_cast<VkPipelineStageFlags>(SrcStage), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &Barrier, 0, nullptr);
+}
+
+void Cmd::AcquireBuffer(CommandBuffer* Cb, Buffer* Buf, int32_t SrcQueueIndex, PipelineStage DstStage, VkAccessFlags DstAccess)
+{
+	VkBufferMemoryBarrier Barrier = {};
+	Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	Barrier.buffer = Buf->GetBuffer();
+	Barrier.offset = 0;
+	Barrier.size = VK_WHOLE_SIZE;
+	Barrier.srcAccessMask = 0;
+	Barrier.dstAccessMask = DstAccess;
+	Barrier.srcQueueFamilyIndex = SrcQueueIndex;
+	Barrier.dstQueueFamilyIndex = Cb->GetQueueIndex();
+
+	vkCmdPipelineBarrier(Cb->GetCommandBuffer(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, static_cast<VkPipelineStageFlags>(DstStage), 0, 0, nullptr, 1, &Barrier, 0, nullptr);
+}
+
+void Cmd::ImageBarrier(CommandBuffer* Cb, Image* Img, ImageLayout OldLayout, ImageLayout NewLayout, PipelineStage SrcStage, VkAccessFlags SrcAccess, PipelineStage DstStage, VkAccessFlags DstAccess)
+{
+	VkImageMemoryBarrier Barrier = {};
+	Barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	Barrier.image = Img->GetImage();
+	Barrier.oldLayout = static_cast<VkImageLayout>(OldLayout);
+	Barrier.newLayout = static_cast<VkImageLayout>(NewLayout);
+	Barrier.srcAccessMask = SrcAccess;
+	Barrier.dstAccessMask = DstAccess;
+	Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	Barrier.subresourceRange.aspectMask = Img->GetFormat() == ImageFormat::D24S8 ? VK_IMAGE_ASPECT_STENCIL_BIT | VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+	Barrier.subresourceRange.baseArrayLayer = 0;
+	Barrier.subresourceRange.baseMipLevel = 0;
+	Barrier.subresourceRange.layerCount = 1;
+	Barrier.subresourceRange.levelCount = Img->GetMipMapsCount();
+
+	vkCmdPipelineBarrier(Cb->GetCommandBuffer(), static_cast<VkPipelineStageFlags>(SrcStage), static_cast<VkPipelineStageFlags>(DstStage), 0, 0, nullptr, 0, nullptr, 1, &Barrier);
+}
+
+void Cmd::ImageBarrier(CommandBuffer* Cb, VkImage Img, ImageLayout OldLayout, ImageLayout NewLayout, PipelineStage SrcStage, VkAccessFlags SrcAccess, PipelineStage DstStage, VkAccessFlags DstAccess)
+{
+	VkImageMemoryBarrier Barrier = {};
+	Barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	Barrier.image = Img;
+	Barrier.oldLayout = static_cast<VkImageLayout>(OldLayout);
+	Barrier.newLayout = static_cast<VkImageLayout>(NewLayout);
+	Barrier.srcAccessMask = SrcAccess;
+	Barrier.dstAccessMask = DstAccess;
+	Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	Barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	Barrier.subresourceRange.baseArrayLayer = 0;
+	Barrier.subresourceRange.baseMipLevel = 0;
+	Barrier.subresourceRange.layerCount = 1;
+	Barrier.subresourceRange.levelCount = 1;
+
+	vkCmdPipelineBarrier(Cb->GetCommandBuffer(), static_cast<VkPipelineStageFlags>(SrcStage), static_cast<VkPipelineStageFlags>(DstStage), 0, 0, nullptr, 0, nullptr, 1, &Barrier);
+}
+
+void Cmd::CopyImageToBuffer(CommandBuffer* Cb, Image* Src, Buffer* Dst)
+{
+	VkBufferImageCopy Region = {};
+	Region.imageExtent.width = Src->GetWidth();
+	Region.imageExtent.height = Src->GetHeight();
+	Region.imageExtent.depth = 1;
+	Region.imageSubresource.aspectMask = Src->GetFormat() == ImageFormat::D24S8 ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+	Region.imageSubresource.mipLevel = 0;
+	Region.imageSubresource.baseArrayLayer = 0;
+	Region.imageSubresource.layerCount = 1;
+
+	vkCmdCopyImageToBuffer(Cb->GetCommandBuffer(), Src->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, Dst->GetBuffer(), 1, &Region);
+}
+
+void Cmd::BlitImage(CommandBuffer* Cb, Image* Src, VkImage Dst, VkExtent2D Extent)
+{
+	VkImageBlit Region = {};
+	Region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	Region.srcSubresource.mipLevel = 0;
+	Region.srcSubresource.baseArrayLayer = 0;
+	Region.srcSubresource.layerCount = 1;
+	Region.srcOffsets[1] = { static_cast<int32_t>(Extent.width), static_cast<int32_t>(Extent.height), 1 };
+	Region.dstSubresource = Region.srcSubresource;
+	Region.dstOffsets[1] = Region.srcOffsets[1];
+
+	vkCmdBlitImage(Cb->GetCommandBuffer(), Src->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, Dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &Region, VK_FILTER_NEAREST);
+}
+
+void Cmd::ResetQueries(CommandBuffer* Cb, TimestampQueryPool* Pool)
+{
+	vkCmdResetQueryPool(Cb->GetCommandBuffer(), Pool->GetQueryPool(), 0, Pool->GetCount());
+}
+
+void Cmd::ResetQueries(CommandBuffer* Cb, OcclusionQueryPool* Pool)
+{
+	vkCmdResetQueryPool(Cb->GetCommandBuffer(), Pool->GetQueryPool(), 0, Pool->GetCount());
+}
+
+void Cmd::BeginQuery(CommandBuffer* Cb, OcclusionQueryPool* Pool, uint32_t Query, bool Precise /*= false*/)
+{
+	vkCmdBeginQuery(Cb->GetCommandBuffer(), Pool->GetQueryPool(), Query, Precise ? VK_QUERY_CONTROL_PRECISE_BIT : 0);
+}
+
+void Cmd::EndQuery(CommandBuffer* Cb, OcclusionQueryPool* Pool, uint32_t Query)
+{
+	vkCmdEndQuery(Cb->GetCommandBuffer(), Pool->GetQueryPool(), Query);
+}
+
+void Cmd::WriteTimestamp(CommandBuffer* Cb, TimestampQueryPool* Pool, PipelineStage Stage, uint32_t Query)
+{
+	vkCmdWriteTimestamp(Cb->GetCommandBuffer(), static_cast<VkPipelineStageFlagBits>(Stage), Pool->GetQueryPool(), Query);
+}
+
 void Cmd::UpdatePushConstants(CommandBuffer* Cb, ShaderParameters* Data, IPipeline* Pipeline)
 {
 	auto PCVertPtr = Data->GetPushConstantBuffer(ShaderType::VERTEX);
@@ -63,18 +248,28 @@ void Cmd::UpdatePushConstants(CommandBuffer* Cb, ShaderParameters* Data, IPipeli
 	{
 		vkCmdPushConstants(Cb->GetCommandBuffer(), Pipeline->GetPipelineLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, PCFragPtr->GetOffset(), PCFragPtr->GetSize(), PCFragPtr->GetBuffer());
 	}
+
+	auto PCCompPtr = Data->GetPushConstantBuffer(ShaderType::COMPUTE);
+	if (PCCompPtr)
+	{
+		vkCmdPushConstants(Cb->GetCommandBuffer(), Pipeline->GetPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, PCCompPtr->GetOffset(), PCCompPtr->GetSize(), PCCompPtr->GetBuffer());
+	}
 }
 
-void Cmd::UpdateDescriptorData(CommandBuffer* Cb, DescriptorInst* DescSet, IPipeline* Pipeline, std::vector<uint32_t> DynamicOffsets)
+void Cmd::UpdateDescriptorData(CommandBuffer* Cb, DescriptorInst* DescSet, IPipeline* Pipeline, const std::vector<uint32_t>& DynamicOffsets /*= {}*/)
 {
 	auto Set = DescSet->GetSet();
-	vkCmdBindDescriptorSets(Cb->GetCommandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, Pipeline->GetPipelineLayout(), DescSet->GetSetIndex(), 1, &Set, static_cast<uint32_t>(DynamicOffsets.size()), DynamicOffsets.data());
+	const VkPipelineBindPoint BindPoint = Pipeline->GetDescriptorManager()->GetPipelineType() == PipelineType::COMPUTE ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_GRAPHICS;
+	vkCmdBindDescriptorSets(Cb->GetCommandBuffer(), BindPoint, Pipeline->GetPipelineLayout(), DescSet->GetSetIndex(), 1, &Set, static_cast<uint32_t>(DynamicOffsets.size()), DynamicOffsets.data());
 }
 
 void Cmd::SetViewports(CommandBuffer* Cb, IGraphicsPipeline* Pipeline)
 {
-	auto Viewports = Pipeline->GetViewports();
+	const std::vector<VkViewport>& Viewports = Pipeline->GetViewports();
+	const std::vector<VkRect2D>& Scissors = Pipeline->GetScissors();
+
 	vkCmdSetViewport(Cb->GetCommandBuffer(), 0, static_cast<uint32_t>(Viewports.size()), Viewports.data());
+	vkCmdSetScissor(Cb->GetCommandBuffer(), 0, static_cast<uint32_t>(Scissors.size()), Scissors.data());
 }
 
 void Cmd::ChangeLayout(CommandBuffer* Cb, Image* Img, ImageLayout DstLayout)
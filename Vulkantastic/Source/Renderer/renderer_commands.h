@@ -6,6 +6,8 @@
 #include "../Renderer/swap_chain.h"
 #include "../Renderer/pipeline.h"
 #include "../Renderer/uniform_raw_data.h"
+#include "../Renderer/buffer.h"
+#include "../Renderer/query_pool.h"
 
 
 namespace Cmd
@@ -16,18 +18,77 @@ namespace Cmd
 
 	void BindGraphicsPipeline(CommandBuffer* Cb, IGraphicsPipeline* Pipeline);
 
+	void BindComputePipeline(CommandBuffer* Cb, ComputePipeline* Pipeline);
+
 	void BindVertexBuffer(CommandBuffer* Cb, Buffer* VertexBuffer);
 
-	void BindVertexAndIndexBuffer(CommandBuffer* Cb, Buffer* VertexBuffer, Buffer* IndexBuffer);
+	void BindVertexAndIndexBuffer(CommandBuffer* Cb, Buffer* VertexBuffer, Buffer* IndexBuffer, IndexType Type = IndexType::UINT32);
 
-	void DrawIndexed(CommandBuffer* Cb, uint32_t Size, uint32_t InstancesCount = 1);
+	void DrawIndexed(CommandBuffer* Cb, uint32_t Size, uint32_t InstancesCount = 1, uint32_t FirstInstance = 0, uint32_t FirstIndex = 0, int32_t VertexOffset = 0);
 
 	void Draw(CommandBuffer* Cb, uint32_t Size, uint32_t InstancesCount = 1);
 
+	// Reads DrawCount VkDrawIndexedIndirectCommands from the buffer starting at Offset
+	void DrawIndexedIndirect(CommandBuffer* Cb, Buffer* ArgsBuffer, uint32_t Offset = 0, uint32_t DrawCount = 1);
+
+	// Reads the number of commands from CountBuffer at CountOffset, at most MaxDrawCount, needs Device::SupportsDrawIndirectCount
+	void DrawIndexedIndirectCount(CommandBuffer* Cb, Buffer* ArgsBuffer, uint32_t Offset, Buffer* CountBuffer, uint32_t CountOffset, uint32_t MaxDrawCount);
+
+	void Dispatch(CommandBuffer* Cb, uint32_t GroupsX, uint32_t GroupsY = 1, uint32_t GroupsZ = 1);
+
+	// Reads a VkDispatchIndirectCommand from the buffer at Offset, the buffer needs the indirect usage
+	void DispatchIndirect(CommandBuffer* Cb, Buffer* ArgsBuffer, uint32_t Offset = 0);
+
+	void CopyBuffer(CommandBuffer* Cb, Buffer* Src, Buffer* Dst, uint32_t Size, uint32_t SrcOffset = 0, uint32_t DstOffset = 0);
+
+	// Fills Size bytes starting at Offset with the value repeated every 4 bytes, Size can be VK_WHOLE_SIZE
+	void FillBuffer(CommandBuffer* Cb, Buffer* Dst, uint32_t Value, VkDeviceSize Size = VK_WHOLE_SIZE, uint32_t Offset = 0);
+
+	// Makes writes to the whole buffer done in SrcStage visible to DstStage
+	void BufferBarrier(CommandBuffer* Cb, Buffer* Buf, PipelineStage SrcStage, VkAccessFlags SrcAccess, PipelineStage DstStage, VkAccessFlags DstAccess);
+
+	// Hands the whole buffer from the queue of the command buffer over to DstQueueIndex, writes done in SrcStage are made available
+	// Has to be matched by AcquireBuffer recorded on the other queue after a semaphore wait
+	void ReleaseBuffer(CommandBuffer* Cb, Buffer* Buf, PipelineStage SrcStage, VkAccessFlags SrcAccess, int32_t DstQueueIndex);
+
+	// Takes over the whole buffer released by the queue of SrcQueueIndex and makes it visible to DstStage
+	void AcquireBuffer(CommandBuffer* Cb, Buffer* Buf, int32_t SrcQueueIndex, PipelineStage DstStage, VkAccessFlags DstAccess);
+
+	// Moves all mip levels of the image between layouts inside of the command buffer, the image's tracked layout isn't changed
+	void ImageBarrier(CommandBuffer* Cb, Image* Img, ImageLayout OldLayout, ImageLayout NewLayout, PipelineStage SrcStage, VkAccessFlags SrcAccess, PipelineStage DstStage, VkAccessFlags DstAccess);
+
+	// Same as above for images not owned by the renderer (e.g. swapchain's images), only the first mip level of the color aspect is moved
+	void ImageBarrier(CommandBuffer* Cb, VkImage Img, ImageLayout OldLayout, ImageLayout NewLayout, PipelineStage SrcStage, VkAccessFlags SrcAccess, PipelineStage DstStage, VkAccessFlags DstAccess);
+
+	// Copies the first mip level of an image in the transfer source layout, only depth is copied from depth stencil images
+	void CopyImageToBuffer(CommandBuffer* Cb, Image* Src, Buffer* Dst);
+
+	// Blits the first mip level of a color image in the transfer source layout to an image in the transfer destination layout, Extent is shared by both
+	void BlitImage(CommandBuffer* Cb, Image* Src, VkImage Dst, VkExtent2D Extent);
+
+	void ResetQueries(CommandBuffer* Cb, TimestampQueryPool* Pool);
+	void ResetQueries(CommandBuffer* Cb, OcclusionQueryPool* Pool);
+
+	// Precise counting has to be supported by the device, otherwise the query may only tell whether any sample passed
+	void BeginQuery(CommandBuffer* Cb, OcclusionQueryPool* Pool, uint32_t Query, bool Precise = false);
+	void EndQuery(CommandBuffer* Cb, OcclusionQueryPool* Pool, uint32_t Query);
+
+	// Timestamp is written once all previous commands finish the stage
+	void WriteTimestamp(CommandBuffer* Cb, TimestampQueryPool* Pool, PipelineStage Stage, uint32_t Query);
+
 	void UpdatePushConstants(CommandBuffer* Cb, ShaderParameters* Data, IPipeline* Pipeline);
 
-	void UpdateDescriptorData(CommandBuffer* Cb, DescriptorInst* DescSet, IPipeline* Pipeline, std::vector<uint32_t> DynamicOffsets = {});
+	// Pushes a block generated by Scripts/GenerateShaderStructs.py without going through ShaderParameters
+	template<typename T>
+	void PushConstants(CommandBuffer* Cb, IPipeline* Pipeline, const T& Block)
+	{
+		static_assert(T::IsPushConstant, "Block has to be a push constant");
+		vkCmdPushConstants(Cb->GetCommandBuffer(), Pipeline->GetPipelineLayout(), ShaderReflection::InternalShaderTypeToVulkan(T::BlockStage), T::BlockOffset, sizeof(T), &Block);
+	}
+
+	void UpdateDescriptorData(CommandBuffer* Cb, DescriptorInst* DescSet, IPipeline* Pipeline, const std::vector<uint32_t>& DynamicOffsets = {});
 
+	// Sets viewports and scissors of the pipeline's attachments
 	void SetViewports(CommandBuffer* Cb, IGraphicsPipeline* Pipeline);
 
 	void ChangeLayout(CommandBuffer* Cb, Image* Img, ImageLayout DstLayout);
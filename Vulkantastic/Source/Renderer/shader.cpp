@@ -35,6 +35,7 @@ Shader::Shader(const std::string& Name)
 	mOutputs = Reflection.GetOutputs();
 	mUniforms = Reflection.GetUniforms();
 	mPushConstants = Reflection.GetPushConstants();
+	mWorkgroupSize = Reflection.GetWorkgroupSize();
 
 }
 
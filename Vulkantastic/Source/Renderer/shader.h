@@ -20,6 +20,7 @@ public:
 	inline std::vector<Output> GetOutputs() const { return mOutputs; }
 	inline std::vector<Uniform> GetUniforms() const { return mUniforms; }
 	inline std::vector<Uniform> GetPushConstants() const { return mPushConstants; }
+	inline WorkgroupSize GetWorkgroupSize() const { return mWorkgroupSize; } // Compute shaders only
 
 private:
 	std::string mName;
@@ -30,6 +31,7 @@ private:
 	std::vector<Output> mOutputs;
 	std::vector<Uniform> mUniforms;
 	std::vector<Uniform> mPushConstants;
+	WorkgroupSize mWorkgroupSize;
 
 };
 
@@ -1,9 +1,11 @@
+#define NOMINMAX
 #include "shader_parameters.h"
 #include "../Utilities/assert.h"
 #include "uniform_raw_data.h"
+#include <limits>
 
 ShaderParameters::ShaderParameters(PipelineManager::KeyType Key, const std::vector<Uniform>& Uniforms, const std::map<ShaderType, std::vector<Uniform>>& PushConstants)
-	: mPipelineKey(Key)
+	: mPipelineKey(Key), mPipelineId(PipelineManager::Get().GetPipelineId(Key))
 {
 
 	for (const Uniform& Template : Uniforms)
@@ -12,6 +14,25 @@ ShaderParameters::ShaderParameters(PipelineManager::KeyType Key, const std::vect
 		{
 			mUniformData.emplace_back(Template);
 		}
+		else if (Template.Format == VariableType::BUFFER)
+		{
+			// Storage buffer that holds a runtime array of per-object structures
+			if (Template.Members.size() == 1 && Template.Members[0].Format == VariableType::STRUCTURE && Template.Members[0].Size == std::numeric_limits<uint32_t>::max())
+			{
+				Assert(mObjectData.empty()); // Only one object buffer is supported
+
+				const UniformMember& Element = Template.Members[0];
+
+				Uniform ElementTemplate = {};
+				ElementTemplate.Format = VariableType::STRUCTURE;
+				ElementTemplate.Binding = Template.Binding;
+				ElementTemplate.Set = Template.Set;
+				ElementTemplate.Name = Element.Name;
+				ElementTemplate.Members = Element.Members;
+
+				mObjectData.emplace_back(ElementTemplate);
+			}
+		}
 		else if (Template.Format == VariableType::COMBINED)
 		{
 
@@ -70,3 +91,8 @@ UniformRawData* ShaderParameters::GetUniformBufferByBinding(uint32_t Binding)
 
 	return Data != mUniformData.end() ? &(*Data) : nullptr;
 }
+
+UniformRawData* ShaderParameters::GetObjectData()
+{
+	return mObjectData.empty() ? nullptr : &mObjectData.front();
+}
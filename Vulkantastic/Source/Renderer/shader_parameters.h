@@ -17,13 +17,33 @@ public:
 	UniformRawData* GetPushConstantBuffer(ShaderType Type);
 	UniformRawData* GetUniformBufferByBinding(uint32_t Binding);
 
+	// Data of a single element of the object buffer, nullptr if shaders don't read per-object data from a storage buffer
+	UniformRawData* GetObjectData();
+
+	// Sets a uniform block or push constant block from a struct generated by Scripts/GenerateShaderStructs.py
+	template<typename T>
+	bool Set(const T& Block);
+
 	inline PipelineManager::KeyType GetPipelineKey() const { return mPipelineKey; }
+	inline uint32_t GetPipelineId() const { return mPipelineId; }
 
 private:
 	std::vector<UniformRawData> mUniformData;
 	std::map<ShaderType, std::vector<UniformRawData>> mPushConstantData;
+	std::vector<UniformRawData> mObjectData; // At most one element
 
-	PipelineManager::KeyType mPipelineKey; // PipelineManager::KeyType 
+	PipelineManager::KeyType mPipelineKey = 0;
+	uint32_t mPipelineId = 0;
 };
 
-using upShaderParameters = std::unique_ptr<ShaderParameters>;
\ No newline at end of file
+using upShaderParameters = std::unique_ptr<ShaderParameters>;
+
+template<typename T>
+bool ShaderParameters::Set(const T& Block)
+{
+	UniformRawData* RawData = T::IsPushConstant ? GetPushConstantBuffer(T::BlockStage) : GetUniformBufferByBinding(T::BlockBinding);
+
+	Assert(RawData);
+
+	return RawData ? RawData->SetBlock(Block) : false;
+}
\ No newline at end of file
@@ -169,6 +169,11 @@ bool ShaderReflection::ParseInstruction()
 		GetEntryPoint(mCurrentInstruction);
 		break;
 	}
+	case SpvOpExecutionMode:
+	{
+		GetExecutionMode(mCurrentInstruction);
+		break;
+	}
 	case SpvOpName:
 	{
 		GetName(mCurrentInstruction);
@@ -282,6 +287,19 @@ void ShaderReflection::GetEntryPoint(uint32_t InstructionIndex)
 	mEntryPoint = reinterpret_cast<const char*>(&mSource[mCurrentInstruction + 3]);
 }
 
+void ShaderReflection::GetExecutionMode(uint32_t InstructionIndex)
+{
+	const uint32_t Mode = mSource[InstructionIndex + 2];
+
+	// #TODO: LocalSizeId and sizes overridden by specialization constants aren't supported
+	if (Mode == SpvExecutionModeLocalSize)
+	{
+		mWorkgroupSize.X = mSource[InstructionIndex + 3];
+		mWorkgroupSize.Y = mSource[InstructionIndex + 4];
+		mWorkgroupSize.Z = mSource[InstructionIndex + 5];
+	}
+}
+
 void ShaderReflection::GetName(uint32_t InstructionIndex)
 {
 	const uint32_t Id = mSource[InstructionIndex + 1];
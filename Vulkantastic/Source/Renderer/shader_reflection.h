@@ -62,6 +62,14 @@ struct UniformMember
 	std::vector<UniformMember> Members;
 };
 
+// Invocations of one compute workgroup, declared with local_size_x/y/z
+struct WorkgroupSize
+{
+	uint32_t X = 1;
+	uint32_t Y = 1;
+	uint32_t Z = 1;
+};
+
 struct Uniform
 {
 	VariableType Format = VariableType::MAX;
@@ -84,6 +92,7 @@ public:
 	std::vector<Uniform> GetUniforms() const { return mUniforms; }
 	std::vector<Uniform> GetPushConstants() const { return mPushConstants; }
 	inline ShaderType GetShaderType() const { return mType; }
+	inline WorkgroupSize GetWorkgroupSize() const { return mWorkgroupSize; }
 
 	static VkFormat InternalFormatToVulkan(VariableType Format);
 	static VkShaderStageFlags InternalShaderTypeToVulkan(ShaderType Type);
@@ -96,6 +105,7 @@ private:
 	bool ParseHeader();
 	bool ParseInstruction();
 	void GetEntryPoint(uint32_t InstructionIndex);
+	void GetExecutionMode(uint32_t InstructionIndex);
 	void GetName(uint32_t InstructionIndex);
 	void GetMemberName(uint32_t InstructionIndex);
 	void GetDecorate(uint32_t InstructionIndex);
@@ -133,5 +143,6 @@ private:
 
 	std::string mEntryPoint;
 	ShaderType mType = ShaderType::MAX;
+	WorkgroupSize mWorkgroupSize;
 
 };
@@ -23,7 +23,9 @@ SwapChain::SwapChain(const Device* VulkanDevice)
 	SwapchainInfo.imageFormat = mFormat.format;
 	SwapchainInfo.imageExtent = SurfaceCapabilities.currentExtent;
 	SwapchainInfo.minImageCount = min(SurfaceCapabilities.minImageCount,3);
-	SwapchainInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	// Transfer destination lets the renderer blit into swapchain's images instead of drawing a screen pass
+	mImageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | (SurfaceCapabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+	SwapchainInfo.imageUsage = mImageUsage;
 	SwapchainInfo.surface = VulkanSurface;
 	SwapchainInfo.presentMode = mPresentMode;
 	SwapchainInfo.oldSwapchain = VK_NULL_HANDLE;
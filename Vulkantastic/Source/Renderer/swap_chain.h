@@ -15,11 +15,13 @@ public:
 	inline std::vector<VkImage> GetImages() const { return mImages; }
 	inline uint32_t GetImagesCount() const { return static_cast<uint32_t>(mImages.size()); }
 	inline VkSwapchainKHR GetSwapChain() const { return mSwapChain; }
+	inline bool IsTransferDstSupported() const { return (mImageUsage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0; }
 
 private:
 	const Device* mVulkanDevice;
 	VkSurfaceFormatKHR mFormat;
 	VkPresentModeKHR mPresentMode;
+	VkImageUsageFlags mImageUsage = 0;
 	VkSwapchainKHR mSwapChain;
 	std::vector<VkImage> mImages;
 
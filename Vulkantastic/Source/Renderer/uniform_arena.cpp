@@ -0,0 +1,135 @@
+#define NOMINMAX
+#include "uniform_arena.h"
+#include "buffer.h"
+#include "device.h"
+#include "core.h"
+#include "uniform_raw_data.h"
+
+UniformArena::UniformArena(const std::vector<uint32_t>& QueueIndicies, uint32_t Size, BufferUsage Usage, uint32_t Alignment /*= 0*/)
+	: mQueueIndicies(QueueIndicies), mUsage(Usage)
+{
+	const VkPhysicalDeviceLimits& Limits = VulkanCore::Get().GetDevice()->GetLimits();
+
+	if (mUsage == BufferUsage::STORAGE)
+	{
+		mAlignment = static_cast<uint32_t>(Limits.minStorageBufferOffsetAlignment);
+		mMaxRange = Limits.maxStorageBufferRange;
+	}
+	else
+	{
+		mAlignment = static_cast<uint32_t>(Limits.minUniformBufferOffsetAlignment);
+		mMaxRange = Limits.maxUniformBufferRange;
+	}
+
+	if (Alignment > 0)
+	{
+		mAlignment = Alignment;
+	}
+
+	CreateBuffer(Size);
+}
+
+UniformArena::~UniformArena()
+{
+
+}
+
+void UniformArena::Reset()
+{
+	mHead = 0;
+	mEntries = 0;
+	mUpdatedEntries = 0;
+	mSkippedEntries = 0;
+}
+
+bool UniformArena::Reserve(uint32_t Size)
+{
+	if (Size <= mSize) { return false; }
+
+	uint32_t NewSize = std::max(mSize, 1u);
+	while (NewSize < Size)
+	{
+		NewSize *= 2;
+	}
+
+	CreateBuffer(NewSize);
+
+	return true;
+}
+
+uint32_t UniformArena::Push(const UniformRawData* Data)
+{
+	const uint32_t Size = static_cast<uint32_t>(Data->GetSize());
+	const uint32_t Offset = mHead;
+
+	Assert(Size <= mMaxRange); // Block can't be addressed by a single descriptor
+	Assert(Offset + Size <= mSize); // Reserve should be called with the size of all blocks pushed in a frame
+
+	mHead = Offset + GetAlignedSize(Size);
+
+	if (mEntries >= mSlots.size())
+	{
+		mSlots.resize(mEntries + 1);
+	}
+
+	Slot& CurrentSlot = mSlots[mEntries++];
+
+	// Block was already written at the same place during one of the previous frames
+	if (CurrentSlot.SourceId == Data->GetId() && CurrentSlot.Generation == Data->GetGeneration() && CurrentSlot.Offset == Offset)
+	{
+		++mSkippedEntries;
+		return Offset;
+	}
+
+	CurrentSlot.SourceId = Data->GetId();
+	CurrentSlot.Generation = Data->GetGeneration();
+	CurrentSlot.Offset = Offset;
+
+	memcpy(&mCPUData[Offset], Data->GetBuffer(), Size);
+
+	if (mDirtyBegin == mDirtyEnd)
+	{
+		mDirtyBegin = Offset;
+		mDirtyEnd = Offset + Size;
+	}
+	else
+	{
+		mDirtyBegin = std::min(mDirtyBegin, Offset);
+		mDirtyEnd = std::max(mDirtyEnd, Offset + Size);
+	}
+
+	++mUpdatedEntries;
+
+	return Offset;
+}
+
+uint32_t UniformArena::Update()
+{
+	const uint32_t Size = mDirtyEnd - mDirtyBegin;
+
+	if (Size > 0)
+	{
+		mBuffer->UploadData(&mCPUData[mDirtyBegin], Size, mDirtyBegin);
+	}
+
+	mDirtyBegin = mDirtyEnd = 0;
+
+	return Size;
+}
+
+uint32_t UniformArena::GetAlignedSize(uint32_t Size) const
+{
+	return ((Size + mAlignment - 1) / mAlignment) * mAlignment;
+}
+
+void UniformArena::CreateBuffer(uint32_t Size)
+{
+	mSize = Size;
+
+	mCPUData.assign(mSize, 0);
+	mBuffer = std::make_unique<Buffer>(mQueueIndicies, mUsage, false, mSize, mCPUData.data());
+
+	// Content of the new buffer has to be written again
+	mSlots.clear();
+	mDirtyBegin = mDirtyEnd = 0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "../Utilities/assert.h"
+
+class Buffer;
+enum class BufferUsage : uint16_t;
+class UniformRawData;
+
+// Single uniform buffer shared by all pipelines, every draw's uniform blocks are packed into it and addressed with dynamic offsets
+// With storage usage and the alignment equal to the block size it works as an array of per-object data
+class UniformArena
+{
+public:
+	// Alignment equal to 0 means the minimal offset alignment required by the device for the given usage
+	UniformArena(const std::vector<uint32_t>& QueueIndicies, uint32_t Size, BufferUsage Usage, uint32_t Alignment = 0);
+	~UniformArena();
+
+	UniformArena(const UniformArena& Rhs) = delete;
+	UniformArena& operator=(const UniformArena& Rhs) = delete;
+
+	UniformArena(UniformArena&& Rhs) noexcept = delete;
+	UniformArena& operator=(UniformArena&& Rhs) noexcept = delete;
+
+	// Starts packing from the beginning of the arena, should be called once per frame
+	void Reset();
+
+	// Makes sure that Size bytes fit into the arena, recreates the buffer when they don't and returns true in that case
+	bool Reserve(uint32_t Size);
+
+	// Places the block after the previously pushed one and returns its dynamic offset
+	uint32_t Push(const UniformRawData* Data);
+
+	// Uploads only the range modified since the last update, returns number of uploaded bytes
+	uint32_t Update();
+
+	uint32_t GetAlignedSize(uint32_t Size) const;
+
+	inline Buffer* GetBuffer() const { return mBuffer.get(); }
+	inline uint32_t GetSize() const { return mSize; }
+	inline uint32_t GetUpdatedEntries() const { return mUpdatedEntries; }
+	inline uint32_t GetSkippedEntries() const { return mSkippedEntries; }
+
+private:
+	// Block stored at the given position during the previous frames, identified by UniformRawData::GetId instead of its address which can be reused
+	struct Slot
+	{
+		uint64_t SourceId = 0;
+		uint32_t Generation = 0;
+		uint32_t Offset = 0;
+	};
+
+	void CreateBuffer(uint32_t Size);
+
+	std::vector<uint32_t> mQueueIndicies;
+	BufferUsage mUsage;
+	std::unique_ptr<Buffer> mBuffer;
+	std::vector<uint8_t> mCPUData;
+	std::vector<Slot> mSlots;
+
+	uint32_t mSize = 0;
+	uint32_t mAlignment = 0;
+	uint32_t mMaxRange = 0;
+	uint32_t mHead = 0;
+	uint32_t mEntries = 0;
+
+	uint32_t mUpdatedEntries = 0;
+	uint32_t mSkippedEntries = 0;
+
+	// Range of mCPUData that has to be uploaded
+	uint32_t mDirtyBegin = 0;
+	uint32_t mDirtyEnd = 0;
+};
+
+using upUniformArena = std::unique_ptr<UniformArena>;
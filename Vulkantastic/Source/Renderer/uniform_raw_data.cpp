@@ -1,5 +1,6 @@
 #include "uniform_raw_data.h"
 #include "../Utilities/assert.h"
+#include <atomic>
 
 UniformRawData::UniformRawData(const Uniform& Data)
 	: mUniformData(Data)
@@ -12,9 +13,69 @@ UniformRawData::UniformRawData(const Uniform& Data)
 
 }
 
+UniformRawData::UniformRawData(const UniformRawData& Rhs)
+	: mUniformData(Rhs.mUniformData), mData(Rhs.mData), mGeneration(Rhs.mGeneration)
+{
+
+}
+
+UniformRawData& UniformRawData::operator=(const UniformRawData& Rhs)
+{
+	mUniformData = Rhs.mUniformData;
+	mData = Rhs.mData;
+	mGeneration = Rhs.mGeneration;
+	mId = NextId();
+
+	return *this;
+}
+
+UniformRawData::UniformRawData(UniformRawData&& Rhs) noexcept
+	: mUniformData(std::move(Rhs.mUniformData)), mData(std::move(Rhs.mData)), mGeneration(Rhs.mGeneration), mId(Rhs.mId)
+{
+	Rhs.mId = NextId();
+}
+
+UniformRawData& UniformRawData::operator=(UniformRawData&& Rhs) noexcept
+{
+	mUniformData = std::move(Rhs.mUniformData);
+	mData = std::move(Rhs.mData);
+	mGeneration = Rhs.mGeneration;
+	mId = Rhs.mId;
+
+	Rhs.mId = NextId();
+
+	return *this;
+}
+
+uint64_t UniformRawData::NextId()
+{
+	// Zero is never returned, so it can mark slots that weren't written yet
+	static std::atomic<uint64_t> Counter{ 0 };
+
+	return ++Counter;
+}
+
 int32_t UniformRawData::GetOffset() const
 {
 	Assert(mUniformData.Members.size() > 0);
 
 	return mUniformData.Members[0].Offset;
 }
+
+UniformHandle UniformRawData::GetHandle(const std::string& Name) const
+{
+	UniformHandle Handle;
+
+	for (const auto& Member : mUniformData.Members)
+	{
+		if (Member.Name == Name)
+		{
+			Handle.Offset = Member.Offset - GetOffset();
+			Handle.Size = ShaderReflection::GetSizeForFormat(Member.Format);
+			Handle.Format = Member.Format;
+			break;
+		}
+	}
+
+	return Handle;
+}
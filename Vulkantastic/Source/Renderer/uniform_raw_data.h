@@ -1,22 +1,44 @@
 #pragma once
 #include "shader_reflection.h"
+#include "../Utilities/assert.h"
 
+// Member of a uniform block resolved once by name, valid for every UniformRawData created from the same block
+struct UniformHandle
+{
+	int32_t Offset = -1; // Relative to the beginning of the block's data
+	int32_t Size = 0;
+	VariableType Format = VariableType::MAX;
+
+	inline bool IsValid() const { return Offset >= 0; }
+};
 
 class UniformRawData
 {
 public:
 	UniformRawData(const Uniform& Data);
 
-	UniformRawData(const UniformRawData& Rhs) = default;
-	UniformRawData& operator=(const UniformRawData& Rhs) = default;
+	// Copies get a new id, moves take the id over and leave a new one to the moved from instance
+	UniformRawData(const UniformRawData& Rhs);
+	UniformRawData& operator=(const UniformRawData& Rhs);
 
-	UniformRawData(UniformRawData&& Rhs) = default;
-	UniformRawData& operator=(UniformRawData&& Rhs) = default;
+	UniformRawData(UniformRawData&& Rhs) noexcept;
+	UniformRawData& operator=(UniformRawData&& Rhs) noexcept;
 
 	template<typename T>
 	bool Set(const std::string& Name, T Param);
 
+	template<typename T>
+	bool Set(const UniformHandle& Handle, const T& Param);
+
+	// Copies a whole block generated by Scripts/GenerateShaderStructs.py
+	template<typename T>
+	bool SetBlock(const T& Block);
+
+	UniformHandle GetHandle(const std::string& Name) const;
+
 	inline const uint8_t* GetBuffer() const { return mData.data(); }
+	inline uint32_t GetGeneration() const { return mGeneration; } // Changes every time the data is modified
+	inline uint64_t GetId() const { return mId; } // Never shared by two instances, even when one is allocated at the address of a destroyed one
 	inline int32_t GetSize() const { return static_cast<int32_t>(mData.size()); }
 	inline std::string GetName() const { return mUniformData.Name; }
 	inline uint32_t GetBinding() const { return mUniformData.Binding; }
@@ -27,7 +49,10 @@ public:
 private:
 	Uniform mUniformData;
 	std::vector<uint8_t> mData;
+	uint32_t mGeneration = 0;
+	uint64_t mId = NextId();
 
+	static uint64_t NextId();
 };
 
 
@@ -35,19 +60,42 @@ private:
 template<typename T>
 bool UniformRawData::Set(const std::string& Name, T Param)
 {
-	for (const auto& Member : mUniformData.Members)
+	return Set(GetHandle(Name), Param);
+}
+
+template<typename T>
+bool UniformRawData::Set(const UniformHandle& Handle, const T& Param)
+{
+	if (!Handle.IsValid()) { return false; }
+
+	Assert(Handle.Size == sizeof(Param));
+
+	if (Handle.Size != sizeof(Param) || Handle.Offset + Handle.Size > GetSize()) { return false; }
+
+	// Writing the same value shouldn't cause a reupload
+	if (memcmp(&mData[Handle.Offset], &Param, Handle.Size) != 0)
 	{
-		if (Member.Name == Name)
-		{
-			const auto Offset = Member.Offset - GetOffset();
-			const auto Size = ShaderReflection::GetSizeForFormat(Member.Format);
+		memcpy(reinterpret_cast<void*>(&mData[Handle.Offset]), &Param, Handle.Size);
+		++mGeneration;
+	}
 
-			Assert(Size == sizeof(Param));
+	return true;
+}
 
-			memcpy(reinterpret_cast<void*>(&mData[Offset]), &Param, Size);
+template<typename T>
+bool UniformRawData::SetBlock(const T& Block)
+{
+	const bool Compatible = static_cast<int32_t>(T::BlockOffset) == GetOffset() && sizeof(T) <= mData.size();
+
+	Assert(Compatible);
+
+	if (!Compatible) { return false; }
 
-			return true;
-		}
+	if (memcmp(mData.data(), &Block, sizeof(T)) != 0)
+	{
+		memcpy(reinterpret_cast<void*>(mData.data()), &Block, sizeof(T));
+		++mGeneration;
 	}
-	return false;
+
+	return true;
 }
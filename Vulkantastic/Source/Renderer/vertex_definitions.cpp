@@ -6,16 +6,15 @@ VERTEX_MEMBER(Simple, glm::vec3, Color)
 VERTEX_MEMBER(Simple, glm::vec2, TexCoord)
 END_VERTEX_FORMAT(Simple)
 BEGIN_VERTEX_FORMAT(StaticMesh, false)
-VERTEX_MEMBER(StaticMesh, glm::vec3, Position)
-VERTEX_MEMBER(StaticMesh, glm::vec2, TexCoord)
-VERTEX_MEMBER(StaticMesh, glm::vec3, Normal)
-VERTEX_MEMBER(StaticMesh, glm::vec3, Tangent)
+VERTEX_MEMBER(StaticMesh, UNorm16x4, Position)
+VERTEX_MEMBER(StaticMesh, Half2, TexCoord)
+VERTEX_MEMBER(StaticMesh, SNorm16x2, Normal)
+VERTEX_MEMBER(StaticMesh, SNorm16x2, Tangent)
 END_VERTEX_FORMAT(StaticMesh)
+BEGIN_VERTEX_FORMAT(StaticMeshPosition, false)
+VERTEX_MEMBER(StaticMeshPosition, UNorm16x4, Position)
+END_VERTEX_FORMAT(StaticMeshPosition)
 BEGIN_VERTEX_FORMAT(SimpleInstanced, true)
 VERTEX_MEMBER(SimpleInstanced, glm::vec3, Offset)
 END_VERTEX_FORMAT(SimpleInstanced)
-BEGIN_VERTEX_FORMAT(SimpleScreen, false)
-VERTEX_MEMBER(SimpleScreen, glm::vec2, Position)
-VERTEX_MEMBER(SimpleScreen, glm::vec2, TexCoord)
-END_VERTEX_FORMAT(SimpleScreen)
 }
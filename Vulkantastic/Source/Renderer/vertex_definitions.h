@@ -12,26 +12,27 @@ namespace VertexDefinition
 		glm::vec2 TexCoord;
 	};
 
+	// Position is quantized to the submesh's bounds, normal and tangent are octahedral encoded
 	struct StaticMesh
 	{
 		DECLARE_VERTEX_FORMAT()
-		glm::vec3 Position;
-		glm::vec2 TexCoord;
-		glm::vec3 Normal;
-		glm::vec3 Tangent;
+		UNorm16x4 Position;
+		Half2 TexCoord;
+		SNorm16x2 Normal;
+		SNorm16x2 Tangent;
 	};
 
-	struct SimpleInstanced
+	// Position stream of StaticMesh kept separately by its geometry pool, read by depth only passes
+	struct StaticMeshPosition
 	{
-		DECLARE_VERTEX_FORMAT_INST()
-		glm::vec3 Offset;
+		DECLARE_VERTEX_FORMAT()
+		UNorm16x4 Position;
 	};
 
-	struct SimpleScreen
+	struct SimpleInstanced
 	{
-		DECLARE_VERTEX_FORMAT()
-		glm::vec2 Position;
-		glm::vec2 TexCoord;
+		DECLARE_VERTEX_FORMAT_INST()
+		glm::vec3 Offset;
 	};
 
 }
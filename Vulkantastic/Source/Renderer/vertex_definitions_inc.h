@@ -1,9 +1,10 @@
 #pragma once
+#include "vertex_packing.h"
 
 #define DECLARE_VERTEX_FORMAT_INST() static VertexFormatDeclaration VertexFormatInfo;
 #define DECLARE_VERTEX_FORMAT() static VertexFormatDeclaration VertexFormatInfo;
 #define BEGIN_VERTEX_FORMAT(name, instance) VertexFormatDeclaration name::VertexFormatInfo = { #name, instance, {
-#define VERTEX_MEMBER(name, type, member) {#member, #type ,sizeof(name::member),offsetof(name,member)},
+#define VERTEX_MEMBER(name, type, member) {#member, #type ,sizeof(name::member),offsetof(name,member), VertexMemberFormat<type>::Value},
 #define END_VERTEX_FORMAT(name) }, sizeof(name)}; 
 
 struct VertexAttribute
@@ -12,6 +13,7 @@ struct VertexAttribute
 	const char* Type;
 	uint32_t Size;
 	uint32_t Offset;
+	VkFormat Format; // VK_FORMAT_UNDEFINED when the shader's input format is used
 };
 
 struct VertexFormatDeclaration
@@ -0,0 +1,84 @@
+#define NOMINMAX
+#include "vertex_packing.h"
+
+namespace
+{
+	uint16_t PackUNorm16(float Value)
+	{
+		return static_cast<uint16_t>(glm::round(glm::clamp(Value, 0.0f, 1.0f) * 65535.0f));
+	}
+
+	int16_t PackSNorm16(float Value)
+	{
+		return static_cast<int16_t>(glm::round(glm::clamp(Value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	float UnpackSNorm16(int16_t Value)
+	{
+		return glm::max(static_cast<float>(Value) / 32767.0f, -1.0f);
+	}
+
+	// Sign which is positive for zero
+	float SignNotZero(float Value)
+	{
+		return Value >= 0.0f ? 1.0f : -1.0f;
+	}
+}
+
+UNorm16x4 VertexPacking::PackPosition(const glm::vec3& Position, const glm::vec3& Scale, const glm::vec3& Bias)
+{
+	UNorm16x4 Result = {};
+
+	// Flat bounds keep all positions at the bias
+	Result.X = Scale.x > 0.0f ? PackUNorm16((Position.x - Bias.x) / Scale.x) : 0;
+	Result.Y = Scale.y > 0.0f ? PackUNorm16((Position.y - Bias.y) / Scale.y) : 0;
+	Result.Z = Scale.z > 0.0f ? PackUNorm16((Position.z - Bias.z) / Scale.z) : 0;
+
+	return Result;
+}
+
+glm::vec3 VertexPacking::UnpackPosition(const UNorm16x4& Packed, const glm::vec3& Scale, const glm::vec3& Bias)
+{
+	const glm::vec3 Normalized = glm::vec3(Packed.X, Packed.Y, Packed.Z) / 65535.0f;
+	return Normalized * Scale + Bias;
+}
+
+SNorm16x2 VertexPacking::PackOctahedral(const glm::vec3& Direction)
+{
+	const float Sum = glm::abs(Direction.x) + glm::abs(Direction.y) + glm::abs(Direction.z);
+
+	if (Sum <= 0.0f) { return { 0, 0 }; }
+
+	glm::vec2 Octahedral = glm::vec2(Direction.x, Direction.y) / Sum;
+
+	// Lower hemisphere is folded over the diagonals
+	if (Direction.z < 0.0f)
+	{
+		Octahedral = glm::vec2((1.0f - glm::abs(Octahedral.y)) * SignNotZero(Octahedral.x), (1.0f - glm::abs(Octahedral.x)) * SignNotZero(Octahedral.y));
+	}
+
+	return { PackSNorm16(Octahedral.x), PackSNorm16(Octahedral.y) };
+}
+
+glm::vec3 VertexPacking::UnpackOctahedral(const SNorm16x2& Packed)
+{
+	glm::vec3 Direction(UnpackSNorm16(Packed.X), UnpackSNorm16(Packed.Y), 0.0f);
+	Direction.z = 1.0f - glm::abs(Direction.x) - glm::abs(Direction.y);
+
+	const float Fold = glm::max(-Direction.z, 0.0f);
+	Direction.x += Direction.x >= 0.0f ? -Fold : Fold;
+	Direction.y += Direction.y >= 0.0f ? -Fold : Fold;
+
+	return glm::normalize(Direction);
+}
+
+Half2 VertexPacking::PackHalf2(const glm::vec2& Value)
+{
+	const uint32_t Packed = glm::packHalf2x16(Value);
+	return { static_cast<uint16_t>(Packed & 0xFFFF), static_cast<uint16_t>(Packed >> 16) };
+}
+
+glm::vec2 VertexPacking::UnpackHalf2(const Half2& Packed)
+{
+	return glm::unpackHalf2x16(static_cast<uint32_t>(Packed.X) | (static_cast<uint32_t>(Packed.Y) << 16));
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include "vulkan/vulkan_core.h"
+#include "glm/glm.hpp"
+
+// Packed vertex attributes, shaders read them as floats converted by the input assembler
+
+struct UNorm16x4
+{
+	uint16_t X, Y, Z, W;
+};
+
+struct SNorm16x2
+{
+	int16_t X, Y;
+};
+
+struct Half2
+{
+	uint16_t X, Y;
+};
+
+// Format of a vertex member, members of other types use the format of the shader's input
+template<typename T>
+struct VertexMemberFormat
+{
+	static constexpr VkFormat Value = VK_FORMAT_UNDEFINED;
+};
+
+template<>
+struct VertexMemberFormat<UNorm16x4>
+{
+	static constexpr VkFormat Value = VK_FORMAT_R16G16B16A16_UNORM;
+};
+
+template<>
+struct VertexMemberFormat<SNorm16x2>
+{
+	static constexpr VkFormat Value = VK_FORMAT_R16G16_SNORM;
+};
+
+template<>
+struct VertexMemberFormat<Half2>
+{
+	static constexpr VkFormat Value = VK_FORMAT_R16G16_SFLOAT;
+};
+
+// Has to match decoding in the vertex shaders
+namespace VertexPacking
+{
+	// Position is stored relative to bounds, Position = Packed * Scale + Bias
+	UNorm16x4 PackPosition(const glm::vec3& Position, const glm::vec3& Scale, const glm::vec3& Bias);
+	glm::vec3 UnpackPosition(const UNorm16x4& Packed, const glm::vec3& Scale, const glm::vec3& Bias);
+
+	// Unit vector projected onto an octahedron unfolded into a square
+	SNorm16x2 PackOctahedral(const glm::vec3& Direction);
+	glm::vec3 UnpackOctahedral(const SNorm16x2& Packed);
+
+	Half2 PackHalf2(const glm::vec2& Value);
+	glm::vec2 UnpackHalf2(const Half2& Packed);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#define GLM_FORCE_RADIANS
+#include "glm/glm.hpp"
+
+struct AABB
+{
+	glm::vec3 Min = { 0.0f, 0.0f, 0.0f };
+	glm::vec3 Max = { 0.0f, 0.0f, 0.0f };
+
+	inline glm::vec3 GetCenter() const { return (Min + Max) * 0.5f; }
+	inline glm::vec3 GetExtent() const { return (Max - Min) * 0.5f; }
+};
+
+struct BoundingSphere
+{
+	glm::vec3 Center = { 0.0f, 0.0f, 0.0f };
+	float Radius = 0.0f;
+
+	// Sphere that contains the sphere after transformation, non-uniform scale makes it bigger than needed
+	BoundingSphere Transform(const glm::mat4& Matrix) const
+	{
+		const float ScaleX = glm::length(glm::vec3(Matrix[0]));
+		const float ScaleY = glm::length(glm::vec3(Matrix[1]));
+		const float ScaleZ = glm::length(glm::vec3(Matrix[2]));
+		const float MaxScale = ScaleX > ScaleY ? (ScaleX > ScaleZ ? ScaleX : ScaleZ) : (ScaleY > ScaleZ ? ScaleY : ScaleZ);
+
+		return { glm::vec3(Matrix * glm::vec4(Center, 1.0f)), Radius * MaxScale };
+	}
+};
+
+// Planes extracted from a view projection matrix with depth in range [0, 1], normals point inside
+struct Frustum
+{
+	enum PlaneIndex { LEFT_PLANE = 0, RIGHT_PLANE, BOTTOM_PLANE, TOP_PLANE, NEAR_PLANE, FAR_PLANE, PLANES_COUNT };
+
+	glm::vec4 Planes[PLANES_COUNT];
+
+	Frustum() = default;
+
+	explicit Frustum(const glm::mat4& ViewProjection)
+	{
+		const glm::vec4 Row0 = { ViewProjection[0][0], ViewProjection[1][0], ViewProjection[2][0], ViewProjection[3][0] };
+		const glm::vec4 Row1 = { ViewProjection[0][1], ViewProjection[1][1], ViewProjection[2][1], ViewProjection[3][1] };
+		const glm::vec4 Row2 = { ViewProjection[0][2], ViewProjection[1][2], ViewProjection[2][2], ViewProjection[3][2] };
+		const glm::vec4 Row3 = { ViewProjection[0][3], ViewProjection[1][3], ViewProjection[2][3], ViewProjection[3][3] };
+
+		Planes[LEFT_PLANE] = Row3 + Row0;
+		Planes[RIGHT_PLANE] = Row3 - Row0;
+		Planes[BOTTOM_PLANE] = Row3 + Row1;
+		Planes[TOP_PLANE] = Row3 - Row1;
+		Planes[NEAR_PLANE] = Row2;
+		Planes[FAR_PLANE] = Row3 - Row2;
+
+		for (glm::vec4& CurrentPlane : Planes)
+		{
+			CurrentPlane /= glm::length(glm::vec3(CurrentPlane));
+		}
+	}
+
+	bool Intersects(const BoundingSphere& Sphere) const
+	{
+		for (const glm::vec4& CurrentPlane : Planes)
+		{
+			if (glm::dot(glm::vec3(CurrentPlane), Sphere.Center) + CurrentPlane.w < -Sphere.Radius) { return false; }
+		}
+
+		return true;
+	}
+};
@@ -1,7 +1,9 @@
 #define NOMINMAX
 #include <limits>
+#include <chrono>
 #include "deferred_renderer.h"
 #include "static_mesh.h"
+#include "geometry_pool.h"
 #include "../Renderer/render_pass.h"
 #include "../Renderer/core.h"
 #include "../Renderer/swap_chain.h"
@@ -9,43 +11,79 @@
 #include "../Renderer/descriptor_manager.h"
 #include "../Renderer/buffer.h"
 #include "../Renderer/renderer_commands.h"
+#include "../Renderer/shader_structs.h"
 
 DeferredRenderer::~DeferredRenderer()
 {
 
 }
 
-bool DeferredRenderer::Startup()
+bool DeferredRenderer::Startup(const GBufferSettings& Settings)
 {
 	const uint32_t GraphicsQueueIndex = VulkanCore::Get().GetDevice()->GetQueuesIndicies().GraphicsIndex;
 
 	const VkExtent2D Extend = VulkanCore::Get().GetExtend();
 
+	mGBufferSettings = Settings;
+
+	// Attachments of the base pass in the order of the base pass shaders' outputs
+	struct GBufferTarget
+	{
+		upImage& TargetImage;
+		upImageView& TargetView;
+		ImageFormat Format;
+	};
+
+	const std::vector<GBufferTarget> GBufferTargets = {
+		{ mColorBuffer, mColorView, Settings.ColorFormat },
+		{ mNormalBuffer, mNormalView, Settings.NormalFormat }
+	};
+
 	// Render pass for base pass
 	{
-		ColorAttachment Color = {};
-		Color.EndLayout = ImageLayout::COLOR_ATTACHMENT;
-		Color.Format = ImageFormat::R8G8B8A8;
-		Color.Width = static_cast<float>(Extend.width);
-		Color.Height = static_cast<float>(Extend.height);
+		std::vector<ColorAttachment> ColorAttachments;
 
-		ColorAttachment Normal = {};
-		Normal.EndLayout = ImageLayout::COLOR_ATTACHMENT;
-		Normal.Format = ImageFormat::R8G8B8A8;
-		Normal.Width = static_cast<float>(Extend.width);
-		Normal.Height = static_cast<float>(Extend.height);
+		for (const GBufferTarget& Target : GBufferTargets)
+		{
+			ColorAttachment Attachment = {};
+			Attachment.EndLayout = ImageLayout::COLOR_ATTACHMENT;
+			Attachment.Format = Target.Format;
+			Attachment.Width = static_cast<float>(Extend.width);
+			Attachment.Height = static_cast<float>(Extend.height);
 
-		ColorAttachment Position = {};
-		Position.EndLayout = ImageLayout::COLOR_ATTACHMENT;
-		Position.Format = ImageFormat::R8G8B8A8;
-		Position.Width = static_cast<float>(Extend.width);
-		Position.Height = static_cast<float>(Extend.height);
+			ColorAttachments.push_back(Attachment);
+		}
 
 		DepthAttachment Depth = {};
 
-		std::vector<ColorAttachment> ColorAttachments = { Color, Normal, Position };
-
 		mBasePassRenderPass = std::make_unique<RenderPass>(ColorAttachments, Depth);
+
+		// Depth only pre-pass clears the depth that the base pass after it keeps
+		DepthAttachment PrePassDepth = {};
+		PrePassDepth.Width = static_cast<float>(Extend.width);
+		PrePassDepth.Height = static_cast<float>(Extend.height);
+
+		mDepthPrePassRenderPass = std::make_unique<RenderPass>(std::vector<ColorAttachment>{}, PrePassDepth);
+
+		DepthAttachment KeptDepth = {};
+		KeptDepth.StartLayout = ImageLayout::DEPTH_STENCIL_ATTACHMENT;
+		KeptDepth.DepthLoadOp = AttachmentLoadOp::LOAD;
+		KeptDepth.StencilLoadOp = AttachmentLoadOp::LOAD;
+
+		mGBufferRenderPass = std::make_unique<RenderPass>(ColorAttachments, KeptDepth);
+
+		// Same attachments, kept from the first part of the base pass
+		for (ColorAttachment& Attachment : ColorAttachments)
+		{
+			Attachment.StartLayout = ImageLayout::COLOR_ATTACHMENT;
+			Attachment.LoadOp = AttachmentLoadOp::LOAD;
+		}
+
+		Depth.StartLayout = ImageLayout::DEPTH_STENCIL_ATTACHMENT;
+		Depth.DepthLoadOp = AttachmentLoadOp::LOAD;
+		Depth.StencilLoadOp = AttachmentLoadOp::LOAD;
+
+		mBasePassLoadRenderPass = std::make_unique<RenderPass>(ColorAttachments, Depth);
 	}
 
 	// Depth buffer for base pass
@@ -59,73 +97,66 @@ bool DeferredRenderer::Startup()
 		DepthSettings.Mipmaps = false;
 
 		std::vector<uint32_t> Queues = { GraphicsQueueIndex };
-		mDepthBuffer = std::make_unique<Image>(Queues, ImageUsage::DEPTH_ATTACHMENT, true, DepthSettings);
+		mDepthBuffer = std::make_unique<Image>(Queues, ImageUsage::DEPTH_ATTACHMENT | ImageUsage::TRANSFER_SRC | ImageUsage::SAMPLED, true, DepthSettings);
 		mDepthBuffer->ChangeLayout(ImageLayout::DEPTH_STENCIL_ATTACHMENT);
 
 		ImageViewSettings DepthViewSettings = {};
 		DepthViewSettings.Format = ImageFormat::D24S8;
 
 		mDepthView = std::make_unique<ImageView>(mDepthBuffer.get(), DepthViewSettings);
-	}
 
-	// GBuffer setup
-	{
-		ImageSettings BasePassColorSettings = {};
-		BasePassColorSettings.Depth = 1;
-		BasePassColorSettings.Height = Extend.height;
-		BasePassColorSettings.Width = Extend.width;
-		BasePassColorSettings.Format = ImageFormat::R8G8B8A8;
-		BasePassColorSettings.Type = ImageType::TWODIM;
-		BasePassColorSettings.Mipmaps = false;
+		DepthViewSettings.DepthOnly = true;
 
-		std::vector<uint32_t> Queues = { GraphicsQueueIndex };
-		mColorBuffer = std::make_unique<Image>(Queues, ImageUsage::COLOR_ATTACHMENT | ImageUsage::SAMPLED, true, BasePassColorSettings);
-		mColorBuffer->ChangeLayout(ImageLayout::COLOR_ATTACHMENT);
+		mDepthSampleView = std::make_unique<ImageView>(mDepthBuffer.get(), DepthViewSettings);
 
-		ImageViewSettings BasePassColorViewSettings = {};
-		BasePassColorViewSettings.Format = ImageFormat::R8G8B8A8;
+		mHiZBuffer = std::make_unique<HiZBuffer>(Extend.width, Extend.height);
+	}
 
-		mColorView = std::make_unique<ImageView>(mColorBuffer.get(), BasePassColorViewSettings);
+	// Depth pre-pass' pipeline, reads only the position stream of the static meshes' geometry pool
+	{
+		Shader* VertexShader = ShaderManager::Get().Find("DepthPrePass.vert");
+		Shader* FragmentShader = ShaderManager::Get().Find("DepthPrePass.frag");
 
-		ImageSettings BasePassNormalSettings = {};
-		BasePassNormalSettings.Depth = 1;
-		BasePassNormalSettings.Height = Extend.height;
-		BasePassNormalSettings.Width = Extend.width;
-		BasePassNormalSettings.Format = ImageFormat::R8G8B8A8;
-		BasePassNormalSettings.Type = ImageType::TWODIM;
-		BasePassNormalSettings.Mipmaps = false;
+		Assert(VertexShader && FragmentShader);
 
-		mNormalBuffer = std::make_unique<Image>(Queues, ImageUsage::COLOR_ATTACHMENT | ImageUsage::SAMPLED, true, BasePassNormalSettings);
-		mNormalBuffer->ChangeLayout(ImageLayout::COLOR_ATTACHMENT);
+		PipelineShaders Shaders{ VertexShader, FragmentShader };
 
-		ImageViewSettings BasePassNormalViewSettings = {};
-		BasePassNormalViewSettings.Format = ImageFormat::R8G8B8A8;
+		mDepthPrePassPipeline = PipelineManager::Get().GetGraphicsPipeline<VertexDefinition::StaticMeshPosition>(*mDepthPrePassRenderPass, Shaders);
+		mDepthPrePassPipelineId = PipelineManager::Get().GetPipelineId(PipelineManager::Get().HashPipeline(Shaders.GetShaders(), *mDepthPrePassRenderPass, mDepthPrePassPipeline->GetState()));
+		mDepthPrePassDescriptorInst = mDepthPrePassPipeline->GetDescriptorManager()->GetDescriptorInstance(0);
+	}
 
-		mNormalView = std::make_unique<ImageView>(mNormalBuffer.get(), BasePassNormalViewSettings);
+	// GBuffer setup
+	{
+		std::vector<uint32_t> Queues = { GraphicsQueueIndex };
 
-		ImageSettings BasePassPositionSettings = {};
-		BasePassPositionSettings.Depth = 1;
-		BasePassPositionSettings.Height = Extend.height;
-		BasePassPositionSettings.Width = Extend.width;
-		BasePassPositionSettings.Format = ImageFormat::R8G8B8A8;
-		BasePassPositionSettings.Type = ImageType::TWODIM;
-		BasePassPositionSettings.Mipmaps = false;
+		for (const GBufferTarget& Target : GBufferTargets)
+		{
+			ImageSettings TargetSettings = {};
+			TargetSettings.Depth = 1;
+			TargetSettings.Height = Extend.height;
+			TargetSettings.Width = Extend.width;
+			TargetSettings.Format = Target.Format;
+			TargetSettings.Type = ImageType::TWODIM;
+			TargetSettings.Mipmaps = false;
 
-		mPositionBuffer = std::make_unique<Image>(Queues, ImageUsage::COLOR_ATTACHMENT | ImageUsage::SAMPLED, true, BasePassPositionSettings);
-		mPositionBuffer->ChangeLayout(ImageLayout::COLOR_ATTACHMENT);
+			Target.TargetImage = std::make_unique<Image>(Queues, ImageUsage::COLOR_ATTACHMENT | ImageUsage::SAMPLED, true, TargetSettings);
+			Target.TargetImage->ChangeLayout(ImageLayout::COLOR_ATTACHMENT);
 
-		ImageViewSettings BasePassPositionViewSettings = {};
-		BasePassPositionViewSettings.Format = ImageFormat::R8G8B8A8;
+			ImageViewSettings TargetViewSettings = {};
+			TargetViewSettings.Format = Target.Format;
 
-		mPositionView = std::make_unique<ImageView>(mPositionBuffer.get(), BasePassPositionViewSettings);
-		
+			Target.TargetView = std::make_unique<ImageView>(Target.TargetImage.get(), TargetViewSettings);
+		}
 	}
 
+	const ImageFormat SwapChainFormat = static_cast<ImageFormat>(VulkanCore::Get().GetSwapChain()->GetFormat().format);
+
 	// Render pass for light pass
 	{
 		ColorAttachment Color = {};
 		Color.EndLayout = ImageLayout::COLOR_ATTACHMENT;
-		Color.Format = ImageFormat::R8G8B8A8;
+		Color.Format = SwapChainFormat;
 		Color.Width = static_cast<float>(Extend.width);
 		Color.Height = static_cast<float>(Extend.height);
 
@@ -138,17 +169,37 @@ bool DeferredRenderer::Startup()
 	{
 		std::vector<uint32_t> Queues = { GraphicsQueueIndex };
 
-		Shader* VertexShader = ShaderManager::Get().Find("LightPass.vert");
+		Shader* VertexShader = ShaderManager::Get().Find("FullscreenTriangle.vert");
 		Shader* FragmentShader = ShaderManager::Get().Find("DirectionalLightPass.frag");
 
 		Assert(VertexShader && FragmentShader);
 
 		PipelineShaders Shaders{ VertexShader, FragmentShader };
 
-		mDirectionalLightPassShaderParams = PipelineManager::Get().GetShaderParametersInstance<VertexDefinition::SimpleScreen>(*mLightPassRenderPass, Shaders);
+		mDirectionalLightPassShaderParams = PipelineManager::Get().GetShaderParametersInstance<>(*mLightPassRenderPass, Shaders);
+
+		mDirectionalLightPassDescriporInst = PipelineManager::Get().GetDescriptorInstance<>(*mLightPassRenderPass, Shaders);
+
+		Shader* TiledFragmentShader = ShaderManager::Get().Find("TiledLightPass.frag");
+		Shader* LocalFragmentShader = ShaderManager::Get().Find("LocalLightPass.frag");
+
+		Assert(TiledFragmentShader && LocalFragmentShader);
 
-		mDirectionalLightPassDescriporInst = PipelineManager::Get().GetDescriptorInstance<VertexDefinition::SimpleScreen>(*mLightPassRenderPass, Shaders);
+		PipelineShaders TiledShaders{ VertexShader, TiledFragmentShader };
 
+		mTiledLightPassShaderParams = PipelineManager::Get().GetShaderParametersInstance<>(*mLightPassRenderPass, TiledShaders);
+		mTiledLightPassDescriporInst = PipelineManager::Get().GetDescriptorInstance<>(*mLightPassRenderPass, TiledShaders);
+
+		PipelineShaders LocalShaders{ VertexShader, LocalFragmentShader };
+
+		// Local lights are blended over the directional light
+		PipelineState LocalState = {};
+		LocalState.Blend = BlendMode::Additive;
+
+		mLocalLightPassShaderParams = PipelineManager::Get().GetShaderParametersInstance<>(*mLightPassRenderPass, LocalShaders, 0, LocalState);
+		mLocalLightPassDescriporInst = PipelineManager::Get().GetDescriptorInstance<>(*mLightPassRenderPass, LocalShaders, 0, LocalState);
+
+		mTiledLighting = std::make_unique<TiledLighting>(Extend.width, Extend.height);
 	}
 
 	// Scene texture
@@ -157,16 +208,16 @@ bool DeferredRenderer::Startup()
 		SceneSettings.Depth = 1;
 		SceneSettings.Height = Extend.height;
 		SceneSettings.Width = Extend.width;
-		SceneSettings.Format = ImageFormat::R8G8B8A8;
+		SceneSettings.Format = SwapChainFormat;
 		SceneSettings.Type = ImageType::TWODIM;
 		SceneSettings.Mipmaps = false;
 
 		std::vector<uint32_t> Queues = { GraphicsQueueIndex };
-		mSceneBuffer = std::make_unique<Image>(Queues, ImageUsage::COLOR_ATTACHMENT | ImageUsage::SAMPLED, true, SceneSettings);
+		mSceneBuffer = std::make_unique<Image>(Queues, ImageUsage::COLOR_ATTACHMENT | ImageUsage::SAMPLED | ImageUsage::TRANSFER_SRC, true, SceneSettings);
 		mSceneBuffer->ChangeLayout(ImageLayout::COLOR_ATTACHMENT);
 
 		ImageViewSettings SceneViewSettings = {};
-		SceneViewSettings.Format = ImageFormat::R8G8B8A8;
+		SceneViewSettings.Format = SwapChainFormat;
 
 		mSceneView = std::make_unique<ImageView>(mSceneBuffer.get(), SceneViewSettings);
 		
@@ -176,7 +227,7 @@ bool DeferredRenderer::Startup()
 	{
 		ColorAttachment Color = {};
 		Color.EndLayout = ImageLayout::PRESENT_SRC;
-		Color.Format = static_cast<ImageFormat>(VulkanCore::Get().GetSwapChain()->GetFormat().format);
+		Color.Format = SwapChainFormat;
 		Color.Width = static_cast<float>(Extend.width);
 		Color.Height = static_cast<float>(Extend.height);
 
@@ -186,28 +237,42 @@ bool DeferredRenderer::Startup()
 
 	}
 
-	// Prepare screen's mesh and descriptor
+	// Prepare screen's descriptor
 	{
-		Shader* VertexShader = ShaderManager::Get().Find("Screen.vert");
+		Shader* VertexShader = ShaderManager::Get().Find("FullscreenTriangle.vert");
 		Shader* FragmentShader = ShaderManager::Get().Find("Screen.frag");
 
 		Assert(VertexShader && FragmentShader);
 
 		PipelineShaders Shaders{ VertexShader, FragmentShader };
 		
-		mScreenShaderParams = PipelineManager::Get().GetShaderParametersInstance<VertexDefinition::SimpleScreen>(*mScreenRenderPass, Shaders);
-		mScreenDescriporInst = PipelineManager::Get().GetDescriptorInstance<VertexDefinition::SimpleScreen>(*mScreenRenderPass, Shaders);
+		mScreenShaderParams = PipelineManager::Get().GetShaderParametersInstance<>(*mScreenRenderPass, Shaders);
+		mScreenDescriporInst = PipelineManager::Get().GetDescriptorInstance<>(*mScreenRenderPass, Shaders);
+	}
 
-		std::vector<uint32_t> QueueIndicies = { GraphicsQueueIndex };
+	// Arena that holds uniform buffers of all materials, grows when needed
+	mUniformArena = std::make_unique<UniformArena>(std::vector<uint32_t>{ GraphicsQueueIndex }, 64 * 1024, BufferUsage::UNIFORM);
 
-		VertexDefinition::SimpleScreen LeftBottom = { {-1.0f, -1.0f}, {0.0f,0.0f} };
-		VertexDefinition::SimpleScreen RightBottom = { {1.0f, -1.0f}, {1.0f,0.0f} };
-		VertexDefinition::SimpleScreen LeftTop = { {-1.0f, 1.0f}, {0.0f, 1.0f} };
-		VertexDefinition::SimpleScreen RightTop = { {1.0f, 1.0f}, {1.0f, 1.0f} };
+	// Timestamps of the frame in flight and of the one before it, whose async compute may still be running
+	if (VulkanCore::Get().GetDevice()->SupportsTimestamps())
+	{
+		mFrameTimestamps.resize(2);
 
-		std::vector<VertexDefinition::SimpleScreen> Verticies = { LeftBottom, LeftTop, RightBottom, RightBottom, LeftTop, RightTop };
+		for (FrameTimestamps& Timestamps : mFrameTimestamps)
+		{
+			Timestamps.Pool = std::make_unique<TimestampQueryPool>(TIMESTAMPS_COUNT);
+		}
+	}
+
+	// Overdraw is measured the same way, only exact counts are useful for it
+	if (VulkanCore::Get().GetDevice()->SupportsPreciseOcclusionQueries())
+	{
+		mFrameOverdraw.resize(2);
 
-		mScreenVertexBuffer = std::make_unique<Buffer>(QueueIndicies, BufferUsage::VERTEX | BufferUsage::TRANSFER_DST, true, static_cast<uint32_t>(sizeof(VertexDefinition::SimpleScreen) * Verticies.size()), Verticies.data());
+		for (FrameOverdraw& Overdraw : mFrameOverdraw)
+		{
+			Overdraw.Pool = std::make_unique<OcclusionQueryPool>(1);
+		}
 	}
 
 	PrepareFramebuffers();
@@ -218,40 +283,57 @@ bool DeferredRenderer::Startup()
 
 bool DeferredRenderer::Shutdown()
 {
+	mGPUScene.reset();
 	mImageArrayManagers.clear();
-	mMaterialUniformBuffers.clear();
 	mDescriptorInstances.clear();
+	mUniformBindings.clear();
+	mUniformArena.reset();
+	mObjectBuffers.clear();
 
 	mBasePassCommandBuffer.reset();
 	mLightPassCommandBuffer.reset();
 	mScreenCommandBuffer.reset();
+	mAsyncComputeCommandBuffer.reset();
+	mFrameTimestamps.clear();
+	mFrameOverdraw.clear();
 
 	mBasePassRenderPass.reset();
+	mBasePassLoadRenderPass.reset();
+	mGBufferRenderPass.reset();
+	mDepthPrePassRenderPass.reset();
 	mLightPassRenderPass.reset();
 	mScreenRenderPass.reset();
 
 	mDepthBuffer.reset();
 	mDepthView.reset();
+	mDepthSampleView.reset();
+	mHiZBuffer.reset();
 
 	mColorBuffer.reset();
 	mColorView.reset();
 	mNormalBuffer.reset();
 	mNormalView.reset();
-	mPositionBuffer.reset();
-	mPositionView.reset();
 
 	mSceneBuffer.reset();
 	mSceneView.reset();
 
-	mScreenVertexBuffer.reset();
 	mScreenDescriporInst.reset();
+	mDepthPrePassDescriptorInst.reset();
+	mDepthPrePassObjectBuffer.reset();
+	mTiledLightPassDescriporInst.reset();
+	mLocalLightPassDescriporInst.reset();
+	mTiledLighting.reset();
 
 	mBasePassFramebuffer.reset();
+	mDepthPrePassFramebuffer.reset();
 	mLightPassFramebuffer.reset();
 
 	mFrameFence.reset();
 	mBasePassReady.reset();
 	mLightPassReady.reset();
+	mAsyncComputeFence.reset();
+	mAsyncComputeStart.reset();
+	mAsyncComputeDone.reset();
 
 	for (auto& Semaphore : mImageReadyToDraw) {	Semaphore.reset();	}
 	for (auto& Semaphore : mImageReadyToPresent) { Semaphore.reset(); }
@@ -261,6 +343,110 @@ bool DeferredRenderer::Shutdown()
 	return true;
 }
 
+GPUScene* DeferredRenderer::GetGPUScene()
+{
+	if (!mGPUScene)
+	{
+		mGPUScene = std::make_unique<GPUScene>(*mBasePassRenderPass);
+	}
+
+	return mGPUScene.get();
+}
+
+void DeferredRenderer::SetOcclusionCullingEnabled(bool Enabled)
+{
+	if (mOcclusionCullingEnabled == Enabled) { return; }
+
+	mOcclusionCullingEnabled = Enabled;
+
+	// Depth of the frames rendered in the meantime isn't in the pyramid
+	mHiZBuffer->Invalidate();
+}
+
+bool DeferredRenderer::IsAsyncComputeEnabled() const
+{
+	return mAsyncComputeEnabled && VulkanCore::Get().GetDevice()->HasAsyncCompute();
+}
+
+void DeferredRenderer::ReadGPUTimings(FrameTimestamps& Timestamps)
+{
+	TimestampQueryPool* Pool = Timestamps.Pool.get();
+
+	const uint32_t Count = Timestamps.AsyncComputeWritten ? TIMESTAMPS_COUNT : LIGHT_PASS_END + 1;
+
+	if (!Timestamps.Written || !Pool->Read(Count)) { return; }
+
+	auto Elapsed = [Pool](uint64_t Begin, uint64_t End) {
+		return End > Begin ? Pool->ToMilliseconds(End - Begin) : 0.0f;
+	};
+
+	mFrameStats.GPUBasePassTime = Elapsed(Pool->GetTimestamp(BASE_PASS_BEGIN), Pool->GetTimestamp(BASE_PASS_END));
+	mFrameStats.GPULightPassTime = Elapsed(Pool->GetTimestamp(LIGHT_PASS_BEGIN), Pool->GetTimestamp(LIGHT_PASS_END));
+
+	if (Timestamps.AsyncComputeWritten)
+	{
+		mFrameStats.GPUAsyncComputeTime = Elapsed(Pool->GetTimestamp(ASYNC_COMPUTE_BEGIN), Pool->GetTimestamp(ASYNC_COMPUTE_END));
+
+		const uint64_t OverlapBegin = std::max(Pool->GetTimestamp(LIGHT_PASS_BEGIN), Pool->GetTimestamp(ASYNC_COMPUTE_BEGIN));
+		const uint64_t OverlapEnd = std::min(Pool->GetTimestamp(LIGHT_PASS_END), Pool->GetTimestamp(ASYNC_COMPUTE_END));
+		mFrameStats.GPUAsyncComputeOverlap = Elapsed(OverlapBegin, OverlapEnd);
+	}
+}
+
+bool DeferredRenderer::IsDrawnByDepthPrePass(const PipelineState& State)
+{
+	const bool LessDepth = State.DepthCompareOP == PipelineCreation::DepthCompareOP::LESS || State.DepthCompareOP == PipelineCreation::DepthCompareOP::LESS_OR_EQUAL;
+	return State.Blend == BlendMode::Opaque && State.DepthTest && State.DepthWrite && LessDepth;
+}
+
+bool DeferredRenderer::IsDepthPrePassActive() const
+{
+	switch (mDepthPrePassMode)
+	{
+	case DepthPrePassMode::ENABLED:
+	{
+		return true;
+	}
+	case DepthPrePassMode::AUTO:
+	{
+		return mDepthPrePassAutoEnabled;
+	}
+	default:
+	{
+		return false;
+	}
+	}
+}
+
+void DeferredRenderer::ReadOverdraw(FrameOverdraw& Overdraw)
+{
+	if (!Overdraw.Written || !Overdraw.Pool->Read(1)) { return; }
+
+	const VkExtent2D Extend = VulkanCore::Get().GetExtend();
+
+	mMeasuredOverdraw = static_cast<float>(static_cast<double>(Overdraw.Pool->GetSamples(0)) / (static_cast<double>(Extend.width) * Extend.height));
+
+	// Scenes close to the threshold don't switch every frame
+	if (mDepthPrePassAutoEnabled)
+	{
+		mDepthPrePassAutoEnabled = mMeasuredOverdraw >= mDepthPrePassThreshold * DepthPrePassHysteresis;
+	}
+	else
+	{
+		mDepthPrePassAutoEnabled = mMeasuredOverdraw > mDepthPrePassThreshold;
+	}
+}
+
+void DeferredRenderer::SetPresentMode(PresentMode Mode)
+{
+	if (Mode == PresentMode::BLIT && !VulkanCore::Get().GetSwapChain()->IsTransferDstSupported())
+	{
+		Mode = PresentMode::SCREEN_PASS;
+	}
+
+	mPresentMode = Mode;
+}
+
 void DeferredRenderer::PrepareFramebuffers()
 {
 	const auto Format = VulkanCore::Get().GetSwapChain()->GetFormat().format;
@@ -274,9 +460,13 @@ void DeferredRenderer::PrepareFramebuffers()
 		float Width = static_cast<float>(Extend.width);
 		float Height = static_cast<float>(Extend.height);
 
-		std::vector<ImageView*> Tmp = { mColorView.get(), mNormalView.get(), mPositionView.get() , mDepthView.get() };
+		std::vector<ImageView*> Tmp = { mColorView.get(), mNormalView.get(), mDepthView.get() };
 
 		mBasePassFramebuffer = std::make_unique<Framebuffer>(Tmp, *mBasePassRenderPass, Width, Height);
+
+		std::vector<ImageView*> DepthOnly = { mDepthView.get() };
+
+		mDepthPrePassFramebuffer = std::make_unique<Framebuffer>(DepthOnly, *mDepthPrePassRenderPass, Width, Height);
 	}
 
 	// Light pass
@@ -328,6 +518,10 @@ void DeferredRenderer::PrepareSynchronizationPrimitives()
 	mFrameFence = std::make_unique<Fence>();
 	mBasePassReady = std::make_unique<Semaphore>();
 	mLightPassReady = std::make_unique<Semaphore>();
+
+	mAsyncComputeFence = std::make_unique<Fence>();
+	mAsyncComputeStart = std::make_unique<Semaphore>();
+	mAsyncComputeDone = std::make_unique<Semaphore>();
 }
 
 void DeferredRenderer::Render(SceneData& Data)
@@ -340,226 +534,411 @@ void DeferredRenderer::Render(SceneData& Data)
 	mFrameFence->Wait();
 	mFrameFence->Reset();
 
+	// Previous frame is done, geometry of the meshes destroyed since it was recorded isn't read anymore
+	GeometryPoolManager::Get().ApplyRemovals();
+
+	const auto FrameStart = std::chrono::high_resolution_clock::now();
+
 	uint32_t ImageIndex = AcquireNextImage(mImageReadyToDraw[CurrentImageIndex].get());
 
-	struct RenderableData
-	{
-		StaticMeshHandle* MeshHandle;
-		glm::mat4 Transform;
-		int32_t Id = -1;
-	};
+	const float Aspect = Extend.width / float(Extend.height);
+	const glm::mat4 Projection = glm::perspective(3.14f / 4.0f, Aspect, 1.0f, 100.0f);
+	const glm::mat4 Correction = glm::mat4(glm::vec4(1, 0, 0, 0), glm::vec4(0, -1, 0, 0), glm::vec4(0, 0, 1.0f / 2.0f, 1.0f / 2.0f), glm::vec4(0, 0, 0, 1));
+	const glm::mat4 Camera = glm::lookAt(Data.CameraPosition, Data.CameraPosition + Data.CameraForward, glm::vec3(0, 1, 0));
+	const glm::mat4 ViewProjection = Correction * Projection * Camera;
 
-	using RenderableDataList = std::vector<RenderableData>;
+	// Gather world bounds of all submeshes, they are culled together before partitioning
+	mCullingCandidates.clear();
+	mWorldBounds.Clear();
 
-	std::map<PipelineManager::KeyType, RenderableDataList> PartitionedRendererData;
+	const float NearPlane = 1.0f;
 
-	// Sort meshes based on materials that they use
 	for (StaticMeshComponent* Mesh : Data.StaticMeshComponents)
 	{
 		auto CurrentMeshHandle = Mesh->GetMeshHandle();
 
 		if(!CurrentMeshHandle) { continue;}
 
+		const glm::mat4 Transform = Mesh->GetTransform();
+		const StaticMesh* CurrentMesh = CurrentMeshHandle->GetStaticMesh();
+
+		const uint32_t FirstCandidate = static_cast<uint32_t>(mCullingCandidates.size());
+
+		// Screen size of the component is the largest one of its submeshes, radius over the distance scaled by the projection
+		float ScreenSize = 0.0f;
+
 		for (int32_t i = 0; i < CurrentMeshHandle->GetMaterialsCount(); ++i)
 		{
-			const StaticSurfaceMaterial* Material = CurrentMeshHandle->GetMaterial(i);
-			const PipelineManager::KeyType Key = Material->GetShaderParameters()->GetPipelineKey();
-			
 			RenderableData NewData = {};
 			NewData.Id = i;
 			NewData.MeshHandle = CurrentMeshHandle;
-			NewData.Transform = Mesh->GetTransform();
+			NewData.Transform = Transform;
+
+			const BoundingSphere WorldSphere = CurrentMesh->GetBoundingSphere(i).Transform(Transform);
+			const float Distance = glm::max(glm::length(WorldSphere.Center - Data.CameraPosition), NearPlane);
 
-			PartitionedRendererData[Key].emplace_back(std::move(NewData));
+			ScreenSize = glm::max(ScreenSize, WorldSphere.Radius * Projection[1][1] / Distance);
+
+			mCullingCandidates.emplace_back(std::move(NewData));
+			mWorldBounds.Add(WorldSphere);
+		}
+
+		// One level for the whole component, so its submeshes don't switch separately
+		const int32_t Lod = mLodEnabled ? CurrentMeshHandle->UpdateLod(ScreenSize, mLodHysteresis) : glm::max(CurrentMeshHandle->GetForcedLod(), 0);
+
+		for (uint32_t i = FirstCandidate; i < mCullingCandidates.size(); ++i)
+		{
+			mCullingCandidates[i].Lod = Lod;
 		}
 	}
 
-	// Update mvp
-	for (auto& PartitionedData : PartitionedRendererData)
+	uint32_t RenderablesCulled = 0;
+
+	if (mFrustumCullingEnabled)
+	{
+		const uint32_t VisibleCount = mWorldBounds.Cull(Frustum(ViewProjection), mCandidatesVisibility, mCullingPath);
+		RenderablesCulled = mWorldBounds.GetCount() - VisibleCount;
+	}
+	else
+	{
+		mCandidatesVisibility.assign(mCullingCandidates.size(), 1);
+	}
+
+	uint32_t RenderablesOccluded = 0;
+	uint32_t OccluderTriangles = 0;
+
+	if (mSoftwareOcclusionEnabled && !Data.Occluders.empty())
 	{
-		const PipelineManager::KeyType PipelineKey = PartitionedData.first;
-		std::vector<RenderableData>& RenderableDataList = PartitionedData.second;
+		mSoftwareOcclusion.Begin(ViewProjection);
 
-		for (RenderableData& DataToRender : RenderableDataList)
+		for (StaticMeshComponent* Occluder : Data.Occluders)
 		{
-			StaticMeshHandle* const MeshHandle = DataToRender.MeshHandle;
-			const int32_t Id = DataToRender.Id;
-			ShaderParameters* Params = MeshHandle->GetMaterial(Id)->GetShaderParameters();
+			const StaticMeshHandle* OccluderHandle = Occluder->GetMeshHandle();
 
-			const float Aspect = Extend.width / float(Extend.height);
-			const glm::mat4 Projection = glm::perspective(3.14f / 4.0f, Aspect, 1.0f, 100.0f);
-			const glm::mat4 Correction = glm::mat4(glm::vec4(1, 0, 0, 0), glm::vec4(0, -1, 0, 0), glm::vec4(0, 0, 1.0f / 2.0f, 1.0f / 2.0f), glm::vec4(0, 0, 0, 1));
+			if (!OccluderHandle) { continue; }
 
-			glm::mat4 Camera = glm::lookAt(Data.CameraPosition, Data.CameraPosition + Data.CameraForward, glm::vec3(0, 1, 0));
-			glm::mat4 MV = Camera * DataToRender.Transform;
-			glm::mat4 MVP = Correction * Projection * MV;
+			const StaticMesh* OccluderMesh = OccluderHandle->GetStaticMesh();
+			const glm::mat4 Transform = Occluder->GetTransform();
+			const int32_t Lod = OccluderMesh->GetLodsCount() - 1;
 
-			MeshHandle->GetMaterial(Id)->SetMVP(MVP);
-			MeshHandle->GetMaterial(Id)->SetMV(MV);
+			for (int32_t i = 0; i < OccluderMesh->GetVertexBufferCount(); ++i)
+			{
+				OccluderMesh->GetPositions(mOccluderPositions, i, Lod);
+				mSoftwareOcclusion.AddOccluder(mOccluderPositions, OccluderMesh->GetIndices(i, Lod), Transform);
+			}
 		}
-	}
 
+		mSoftwareOcclusion.Rasterize(mCullingPath);
 
-	// Create uniform buffers that will hold renderable's data
+		RenderablesOccluded = mSoftwareOcclusion.Cull(mWorldBounds, mCandidatesVisibility);
+		OccluderTriangles = mSoftwareOcclusion.GetTrianglesCount();
+	}
 
-	const uint32_t UniformSetIndex = 1;
+	// Draw packets of visible submeshes, sorted only by pipeline and depth until materials are known
+	mDrawPackets.clear();
 
-	mMaterialUniformBuffers.clear(); // #TODO: Maybe there should be considered keeping uniform buffers for pipelines that are going to be used
-	mDescriptorInstances.clear(); // #TODO: Same as with uniform buffers
+	const float FarPlane = 100.0f;
 
-	for (const auto& RendererData : PartitionedRendererData)
+	for (uint32_t i = 0; i < mCullingCandidates.size(); ++i)
 	{
-		const PipelineManager::KeyType& Key = RendererData.first;
-		const RenderableDataList& DataList = RendererData.second;
+		if (!mCandidatesVisibility[i]) { continue; }
 
-		UBTemplates& ubList = mMaterialUniformBuffers[Key];
+		const RenderableData& Candidate = mCullingCandidates[i];
+		const ShaderParameters* Params = Candidate.MeshHandle->GetMaterial(Candidate.Id)->GetShaderParameters();
+		const float Depth = glm::dot(mWorldBounds.GetCenter(i) - Data.CameraPosition, Data.CameraForward) / FarPlane;
 
-		const int32_t Elements = static_cast<int32_t>(DataList.size());
-		const int32_t NeededNum = (Elements / mMaxElementsInUB) + 1;
+		DrawPacket NewPacket;
+		NewPacket.SortKey = DrawKey::Make(Params->GetPipelineId(), 0, Candidate.MeshHandle->GetStaticMesh()->GetId(), Candidate.Id, Candidate.Lod, Depth);
+		NewPacket.RenderableIdx = i;
 
-		DescriptorManager* DescManager = PipelineManager::Get().GetPipelineByKey(Key)->GetDescriptorManager();
+		mDrawPackets.push_back(NewPacket);
+	}
 
-		auto Uniforms = DescManager->GetUniforms(UniformSetIndex);
+	SortDrawPackets(mDrawPackets, mDrawPacketsScratch);
 
-		// Create dynamic uniform buffers that are needed by materials
-		for (const Uniform& Template : Uniforms)
-		{
-			if (Template.Format == VariableType::STRUCTURE) // Uniform buffer
-			{
-				uint32_t QueueIndex = VulkanCore::Get().GetDevice()->GetQueuesIndicies().GraphicsIndex;
-				std::vector<uint32_t> QueueIndicies = { QueueIndex };
+	// Ranges of packets that use the same pipeline, they stay valid after the second sort because pipeline takes the highest bits
+	mPipelineRanges.clear();
 
-				upUniformBufferList NewList(NeededNum);
-				for (auto& Elem : NewList)
-				{
-					Elem = std::make_unique<UniformBuffer>(Template, QueueIndicies, mMaxElementsInUB);
-				}
+	for (uint32_t i = 0; i < mDrawPackets.size(); ++i)
+	{
+		const uint32_t PipelineId = DrawKey::GetPipeline(mDrawPackets[i].SortKey);
 
-				ubList.emplace_back(Template.Binding, std::move(NewList));
-			}
+		if (mPipelineRanges.empty() || mPipelineRanges.back().PipelineId != PipelineId)
+		{
+			mPipelineRanges.push_back({ PipelineId, i, i });
 		}
 
-		// Update uniform buffers
-		for (int32_t i = 0; i < DataList.size(); ++i)
-		{
-			const RenderableData& Renderable = DataList[i];
-			ShaderParameters* const Params = Renderable.MeshHandle->GetMaterial(Renderable.Id)->GetShaderParameters();
+		++mPipelineRanges.back().End;
+	}
 
-			const int32_t BufferID = GetBufferIDByIndex(i);
-			const int32_t EntryID = GetEntryIDByIndex(i);
+	// Update mvp
+	for (const DrawPacket& Packet : mDrawPackets)
+	{
+		RenderableData& DataToRender = mCullingCandidates[Packet.RenderableIdx];
+		StaticSurfaceMaterial* Material = DataToRender.MeshHandle->GetMaterial(DataToRender.Id);
 
-			for (auto& Template : ubList)
-			{
-				uint32_t Binding = Template.first;
-				auto& Buffers = Template.second;
+		glm::mat4 MV = Camera * DataToRender.Transform;
+		DataToRender.MVP = Correction * Projection * MV;
 
-				UniformRawData* UB = Params->GetUniformBufferByBinding(Binding);
+		Material->SetMVP(DataToRender.MVP);
+		Material->SetMV(MV);
 
-				Assert(UB);
+		const StaticMesh* Mesh = DataToRender.MeshHandle->GetStaticMesh();
+		Material->SetPositionDequantization(Mesh->GetPositionScale(DataToRender.Id, DataToRender.Lod), Mesh->GetPositionBias(DataToRender.Id, DataToRender.Lod));
+	}
+
+
+	mFrameStats = {};
+	mFrameStats.RenderablesCulled = RenderablesCulled;
+	mFrameStats.RenderablesOccluded = RenderablesOccluded;
+	mFrameStats.OccluderTriangles = OccluderTriangles;
+	mFrameStats.LightsVisible = mTiledLighting->UploadLights(Data.Lights, Camera, Frustum(ViewProjection));
+	mFrameStats.LightOverflow = mTiledLighting->GetOverflowStats();
+
+	// Pack uniform blocks of all renderables into the shared arena, blocks that didn't change since the previous frame aren't copied again
 
-				Buffers[BufferID]->Set(UB, i);
+	const uint32_t UniformSetIndex = 1;
+
+
+	// Release descriptor instances and image arrays of pipelines that aren't used anymore
+	auto IsPipelineUsed = [this](uint32_t PipelineId) {
+		return std::any_of(mPipelineRanges.begin(), mPipelineRanges.end(), [PipelineId](const PipelineRange& Range) {
+			return Range.PipelineId == PipelineId;
+		});
+	};
 
-			}	
+	for (auto It = mDescriptorInstances.begin(); It != mDescriptorInstances.end();)
+	{
+		if (!IsPipelineUsed(It->first))
+		{
+			mObjectBuffers.erase(It->first);
+			It = mDescriptorInstances.erase(It);
+		}
+		else
+		{
+			++It;
 		}
+	}
 
-		// Upload data to uniform buffers
-		for (auto& UniformBuffersForOneBinding : ubList)
+	for (auto It = mImageArrayManagers.begin(); It != mImageArrayManagers.end();)
+	{
+		It = IsPipelineUsed(It->first) ? std::next(It) : mImageArrayManagers.erase(It);
+	}
+
+	// Collect uniform buffers used by pipelines and the space needed by all renderables
+	uint32_t ArenaSize = 0;
+
+	for (const PipelineRange& Range : mPipelineRanges)
+	{
+		auto Bindings = mUniformBindings.find(Range.PipelineId);
+
+		if (Bindings == mUniformBindings.end())
 		{
-			auto& Buffers = UniformBuffersForOneBinding.second;
-			
-			for (auto& Buffer : Buffers)
+			DescriptorManager* DescManager = PipelineManager::Get().GetPipelineById(Range.PipelineId)->GetDescriptorManager();
+
+			std::vector<UniformBinding> NewBindings;
+
+			for (const Uniform& Template : DescManager->GetUniforms(UniformSetIndex))
 			{
-				Buffer->Update();
+				if (Template.Format == VariableType::STRUCTURE) // Uniform buffer
+				{
+					NewBindings.push_back({ Template.Binding, static_cast<uint32_t>(ShaderReflection::GetSizeForStructure(Template)) });
+				}
 			}
-		}
 
-		// Create descriptor instances
-		upDescriptorInstList& dsList = mDescriptorInstances[Key];
+			// Dynamic offsets are consumed in the order of bindings
+			std::sort(NewBindings.begin(), NewBindings.end(), [](const UniformBinding& Lhs, const UniformBinding& Rhs) {
+				return Lhs.Binding < Rhs.Binding;
+			});
 
-		for (int32_t i = 0; i < NeededNum; ++i)
-		{
-			upDescriptorInst NewDS = DescManager->GetDescriptorInstance(UniformSetIndex);
+			Bindings = mUniformBindings.emplace(Range.PipelineId, std::move(NewBindings)).first;
+		}
 
-			dsList.push_back(std::move(NewDS));
+		for (const UniformBinding& Binding : Bindings->second)
+		{
+			ArenaSize += mUniformArena->GetAlignedSize(Binding.Size) * (Range.End - Range.Begin);
 		}
+	}
+
+	if (mUniformArena->Reserve(ArenaSize))
+	{
+		mDescriptorInstances.clear(); // Descriptors that point to the previous buffer can't be used anymore
+	}
 
-		// Update descriptor instances
-		for (int32_t i = 0; i < dsList.size(); ++i)
+	mUniformArena->Reset();
+
+	std::vector<uint32_t> DynamicOffsets;
+
+	for (const PipelineRange& Range : mPipelineRanges)
+	{
+		const std::vector<UniformBinding>& Bindings = mUniformBindings[Range.PipelineId];
+
+		for (uint32_t i = Range.Begin; i < Range.End; ++i)
 		{
-			upDescriptorInst& DS = dsList[i];
+			RenderableData& Renderable = mCullingCandidates[mDrawPackets[i].RenderableIdx];
+			ShaderParameters* const Params = Renderable.MeshHandle->GetMaterial(Renderable.Id)->GetShaderParameters();
+
+			Renderable.DynamicOffsetsIdx = static_cast<int32_t>(DynamicOffsets.size());
 
-			for (const UBTemplate& Template : ubList)
+			for (const UniformBinding& Binding : Bindings)
 			{
-				DS->SetBuffer(Template.first, Template.second[i].get());
+				UniformRawData* UB = Params->GetUniformBufferByBinding(Binding.Binding);
+
+				Assert(UB);
+
+				DynamicOffsets.push_back(mUniformArena->Push(UB));
 			}
 		}
 
-		for (auto& DS : dsList)
+		// One descriptor instance per pipeline, each draw binds it with its own dynamic offsets
+		upDescriptorInst& DS = mDescriptorInstances[Range.PipelineId];
+
+		if (!DS)
 		{
-			DS->Update();
+			DescriptorManager* DescManager = PipelineManager::Get().GetPipelineById(Range.PipelineId)->GetDescriptorManager();
+			DS = DescManager->GetDescriptorInstance(UniformSetIndex);
 		}
 
+		for (const UniformBinding& Binding : Bindings)
+		{
+			DS->SetBuffer(Binding.Binding, mUniformArena->GetBuffer(), Binding.Size);
+		}
+
+		DS->Update();
 	}
 
+	mFrameStats.UniformBytesUploaded = mUniformArena->Update();
+	mFrameStats.UniformEntriesUpdated = mUniformArena->GetUpdatedEntries();
+	mFrameStats.UniformEntriesSkipped = mUniformArena->GetSkippedEntries();
+
 	// Update image manager
 
 	const uint32_t ImageArraySetIndex = 0;
 
-	mImageArrayManagers.clear();
-
-	for (const auto& RendererData : PartitionedRendererData)
-	{
-		const PipelineManager::KeyType& Key = RendererData.first;
-		const RenderableDataList& DataList = RendererData.second;
+	mMaterialIds.clear();
 
-		DescriptorManager* DescManager = PipelineManager::Get().GetPipelineByKey(Key)->GetDescriptorManager();
+	// Renderables that can't be merged into instanced draws share the first id, so ids are used up only by distinct texture keys
+	const uint32_t SharedMaterialId = 0;
+	uint32_t NextMaterialId = SharedMaterialId + 1;
 
-		mImageArrayManagers[Key] = std::make_unique<ImageArrayManager>(DescManager, ImageArraySetIndex);
+	for (const PipelineRange& Range : mPipelineRanges)
+	{
+		// Kept between frames, so only the slots whose image or sampler changed are written again
+		upImageArrayManager& ImgArrManager = mImageArrayManagers[Range.PipelineId];
 
-		upImageArrayManager& ImgArrManager = mImageArrayManagers[Key];
+		if (!ImgArrManager)
+		{
+			DescriptorManager* DescManager = PipelineManager::Get().GetPipelineById(Range.PipelineId)->GetDescriptorManager();
+			ImgArrManager = std::make_unique<ImageArrayManager>(DescManager, ImageArraySetIndex);
+		}
 
-		for (const RenderableData& DataToRender : DataList)
+		for (uint32_t i = Range.Begin; i < Range.End; ++i)
 		{
+			RenderableData& DataToRender = mCullingCandidates[mDrawPackets[i].RenderableIdx];
 			StaticMeshHandle* const MeshHandle = DataToRender.MeshHandle;
 			const int32_t Id = DataToRender.Id;
 			StaticSurfaceMaterial* Material = MeshHandle->GetMaterial(Id);
-			ShaderParameters* Params = Material->GetShaderParameters();
 
-			// #TODO: Add support for vertex shader
-			UniformRawData* RawData = Params->GetPushConstantBuffer(ShaderType::FRAGMENT);
-			
 			const auto& UsedImages = Material->GetUsedImages();
 			const auto& UsedSamplers = Material->GetUsedSamplers();
 
+			// Texture key keeps 16 bits per index
+			DataToRender.TextureKey = 0;
+			DataToRender.Instanceable = UsedImages.size() + UsedSamplers.size() <= 4;
+
 			for (auto& Image : UsedImages)
 			{
-				const std::string& PushConstantName = Image.first;
-				const std::string& ImageName = Image.second;
+				const MaterialImageParam& Param = Image.second;
 				
-				const int32_t Id = ImgArrManager->SetImage(ImageName);
+				const int32_t Id = ImgArrManager->SetImage(Param.ImageName);
 
-				RawData->Set(PushConstantName, Id);
+				Material->GetTextureParameters(Param.Stage)->Set(Param.Handle, Id);
+
+				DataToRender.TextureKey = (DataToRender.TextureKey << 16) | static_cast<uint16_t>(Id + 1);
 			}
 
 			for (auto& Smp : UsedSamplers)
 			{
-				const std::string& PushConstantName = Smp.first;
-				const SamplerSettings& SmpSettings = Smp.second;
+				const MaterialSamplerParam& Param = Smp.second;
+
+				const int32_t Id = ImgArrManager->SetSampler(Param.Settings);
+
+				Material->GetTextureParameters(Param.Stage)->Set(Param.Handle, Id);
+
+				DataToRender.TextureKey = (DataToRender.TextureKey << 16) | static_cast<uint16_t>(Id + 1);
+			}
+
+			// Textures are the material's state, renderables with the same texture key share the material id
+			uint32_t MaterialId = SharedMaterialId;
 
-				const int32_t Id = ImgArrManager->SetSampler(SmpSettings);
+			if (DataToRender.Instanceable)
+			{
+				MaterialId = mMaterialIds.emplace(DataToRender.TextureKey, NextMaterialId).first->second;
 
-				RawData->Set(PushConstantName, Id);
+				if (MaterialId == NextMaterialId) { ++NextMaterialId; }
 			}
 
+			mDrawPackets[i].SortKey = DrawKey::SetMaterial(mDrawPackets[i].SortKey, MaterialId);
 		}
 
 		ImgArrManager->Update();
 
 	}
 
+	// Group draws by material and mesh, draws of the same submesh with the same textures become neighbours and can be merged into instanced draws
+	SortDrawPackets(mDrawPackets, mDrawPacketsScratch);
+
+	// Pipelines whose shaders read per-object data from a storage buffer get all of it in one buffer indexed by the instance index
+	for (const PipelineRange& Range : mPipelineRanges)
+	{
+		const RenderableData& FirstRenderable = mCullingCandidates[mDrawPackets[Range.Begin].RenderableIdx];
+		const UniformRawData* FirstObjectData = FirstRenderable.MeshHandle->GetMaterial(FirstRenderable.Id)->GetShaderParameters()->GetObjectData();
+
+		if (!FirstObjectData) { continue; }
+
+		const uint32_t Stride = static_cast<uint32_t>(FirstObjectData->GetSize());
+		const uint32_t NeededSize = Stride * (Range.End - Range.Begin);
+
+		upUniformArena& ObjectBuffer = mObjectBuffers[Range.PipelineId];
+		upDescriptorInst& DS = mDescriptorInstances[Range.PipelineId];
+
+		if (!ObjectBuffer)
+		{
+			ObjectBuffer = std::make_unique<UniformArena>(std::vector<uint32_t>{ GraphicsQueueIndex }, NeededSize, BufferUsage::STORAGE, Stride);
+		}
+		else if (ObjectBuffer->Reserve(NeededSize))
+		{
+			DS.reset(); // Descriptor that points to the previous buffer can't be used anymore
+		}
 
-	Image::ChangeMultipleLayouts(	{ mColorBuffer.get(),				mNormalBuffer.get(),			mPositionBuffer.get() }, 
-									{ ImageLayout::COLOR_ATTACHMENT,	ImageLayout::COLOR_ATTACHMENT,	ImageLayout::COLOR_ATTACHMENT });
+		if (!DS)
+		{
+			DescriptorManager* DescManager = PipelineManager::Get().GetPipelineById(Range.PipelineId)->GetDescriptorManager();
+			DS = DescManager->GetDescriptorInstance(UniformSetIndex);
+		}
+
+		ObjectBuffer->Reset();
+
+		// Objects are pushed in the draw order so instances of one draw are next to each other
+		for (uint32_t i = Range.Begin; i < Range.End; ++i)
+		{
+			RenderableData& Renderable = mCullingCandidates[mDrawPackets[i].RenderableIdx];
+			const UniformRawData* ObjectData = Renderable.MeshHandle->GetMaterial(Renderable.Id)->GetShaderParameters()->GetObjectData();
+
+			Assert(ObjectData && ObjectData->GetSize() == Stride);
+
+			Renderable.ObjectIdx = ObjectBuffer->Push(ObjectData) / Stride;
+		}
+
+		mFrameStats.ObjectBytesUploaded += ObjectBuffer->Update();
+
+		DS->SetBuffer(FirstObjectData->GetBinding(), ObjectBuffer->GetBuffer(), VK_WHOLE_SIZE);
+		DS->Update();
+	}
+
+
+	Image::ChangeMultipleLayouts(	{ mColorBuffer.get(),				mNormalBuffer.get(),			mDepthBuffer.get() }, 
+									{ ImageLayout::COLOR_ATTACHMENT,	ImageLayout::COLOR_ATTACHMENT,	ImageLayout::DEPTH_STENCIL_ATTACHMENT });
 
 
 
@@ -568,70 +947,395 @@ void DeferredRenderer::Render(SceneData& Data)
 
 	mBasePassCommandBuffer->Begin(CBUsage::ONE_TIME);
 
-	const std::vector<VkClearValue> ClearColors = { { 0, 0, 0, 1 }, { 0, 0, 0, 1 }, { 0, 0, 0, 1 }, { 1.0f, 0.0f } };
-	Cmd::BeginRenderPass(mBasePassCommandBuffer.get(), mBasePassFramebuffer.get(), mBasePassRenderPass.get(), ClearColors, Extend);
+	// Pool used two frames ago, both queues are done with it since the previous frame's base pass waited for its async compute
+	FrameTimestamps* Timestamps = mFrameTimestamps.empty() ? nullptr : &mFrameTimestamps[mFrameTimestampsIdx];
+
+	if (Timestamps)
+	{
+		ReadGPUTimings(*Timestamps);
+
+		Cmd::ResetQueries(mBasePassCommandBuffer.get(), Timestamps->Pool.get());
+		Cmd::WriteTimestamp(mBasePassCommandBuffer.get(), Timestamps->Pool.get(), PipelineStage::START, BASE_PASS_BEGIN);
+
+		Timestamps->Written = true;
+		Timestamps->AsyncComputeWritten = false;
+
+		mFrameTimestampsIdx = (mFrameTimestampsIdx + 1) % static_cast<uint32_t>(mFrameTimestamps.size());
+	}
+
+	// Pyramid built by the previous frame's async compute comes back to the graphics queue
+	const int32_t ComputeQueueIndex = VulkanCore::Get().GetDevice()->GetQueuesIndicies().ComputeIndex;
+	const bool WaitForAsyncCompute = mAsyncComputePending;
+
+	if (WaitForAsyncCompute)
+	{
+		mHiZBuffer->AcquireOwnership(mBasePassCommandBuffer.get(), ComputeQueueIndex);
+		mAsyncComputePending = false;
+	}
+
+	// Culling of the GPU scene fills its indirect draws before the base pass starts
+	const bool DrawGPUScene = mGPUScene && mGPUScene->GetInstancesCount() > 0;
+
+	if (DrawGPUScene)
+	{
+		mGPUScene->SetOcclusionCullingEnabled(mOcclusionCullingEnabled);
+		mGPUScene->SetLodSelectionEnabled(mLodEnabled);
+
+		mFrameStats.GPUSceneBytesUploaded = mGPUScene->Cull(mBasePassCommandBuffer.get(), ViewProjection, Camera, Data.CameraPosition, *mHiZBuffer, mHiZViewProjection);
+		mFrameStats.GPUSceneInstances = mGPUScene->GetInstancesCount();
+		mFrameStats.GPUSceneMeshlets = mGPUScene->GetMeshletStats();
+		mFrameStats.GPUSceneOcclusion = mGPUScene->GetOcclusionStats();
+	}
+
+	// Overdraw of the frame before the previous one decides whether drawing the geometry twice pays off
+	FrameOverdraw* Overdraw = mFrameOverdraw.empty() ? nullptr : &mFrameOverdraw[mFrameOverdrawIdx];
+
+	if (Overdraw)
+	{
+		ReadOverdraw(*Overdraw);
+
+		Cmd::ResetQueries(mBasePassCommandBuffer.get(), Overdraw->Pool.get());
+		Overdraw->Written = false;
+
+		mFrameOverdrawIdx = (mFrameOverdrawIdx + 1) % static_cast<uint32_t>(mFrameOverdraw.size());
+	}
+
+	const bool DepthPrePass = IsDepthPrePassActive() && !mDrawPackets.empty();
+
+	mFrameStats.DepthPrePass = DepthPrePass;
+	mFrameStats.Overdraw = mMeasuredOverdraw;
+
+	// Samples are counted in whichever pass tests SceneData's components first, both count the same fragments
+	auto BeginOverdrawQuery = [this, Overdraw]() {
+		if (Overdraw) { Cmd::BeginQuery(mBasePassCommandBuffer.get(), Overdraw->Pool.get(), 0, true); }
+	};
+
+	auto EndOverdrawQuery = [this, Overdraw]() {
+		if (!Overdraw) { return; }
+
+		Cmd::EndQuery(mBasePassCommandBuffer.get(), Overdraw->Pool.get(), 0);
+		Overdraw->Written = true;
+	};
+
+	if (DepthPrePass)
+	{
+		// Same MVP as the base pass, the equal depth test needs exactly the same depth
+		// Only opaque packets that write depth are drawn, in the order of their pipeline ranges
+		mDepthPrePassObjects.clear();
+
+		for (const PipelineRange& Range : mPipelineRanges)
+		{
+			if (!IsDrawnByDepthPrePass(PipelineManager::Get().GetPipelineById(Range.PipelineId)->GetState())) { continue; }
+
+			for (uint32_t i = Range.Begin; i < Range.End; ++i)
+			{
+				const RenderableData& DataToRender = mCullingCandidates[mDrawPackets[i].RenderableIdx];
+				const StaticMesh* const Mesh = DataToRender.MeshHandle->GetStaticMesh();
+
+				DepthObjectData Object = {};
+				Object.MVP = DataToRender.MVP;
+				Object.PositionScale = glm::vec4(Mesh->GetPositionScale(DataToRender.Id, DataToRender.Lod), 0.0f);
+				Object.PositionBias = glm::vec4(Mesh->GetPositionBias(DataToRender.Id, DataToRender.Lod), 0.0f);
+
+				mDepthPrePassObjects.push_back(Object);
+			}
+		}
+
+		// Buffer grows to the next power of two, the previous frame has finished reading it
+		const uint32_t RequiredCapacity = static_cast<uint32_t>(mDepthPrePassObjects.size());
+
+		if (RequiredCapacity > mDepthPrePassObjectsCapacity)
+		{
+			while (mDepthPrePassObjectsCapacity < RequiredCapacity)
+			{
+				mDepthPrePassObjectsCapacity = std::max(mDepthPrePassObjectsCapacity * 2, 64u);
+			}
+
+			mDepthPrePassObjectBuffer = std::make_unique<Buffer>(std::vector<uint32_t>{ GraphicsQueueIndex }, BufferUsage::STORAGE, false, static_cast<uint32_t>(sizeof(DepthObjectData) * mDepthPrePassObjectsCapacity));
+
+			mDepthPrePassDescriptorInst->SetBuffer(0, mDepthPrePassObjectBuffer.get(), VK_WHOLE_SIZE);
+			mDepthPrePassDescriptorInst->Update();
+		}
+
+		if (!mDepthPrePassObjects.empty())
+		{
+			mDepthPrePassObjectBuffer->UploadData(mDepthPrePassObjects.data(), static_cast<uint32_t>(sizeof(DepthObjectData) * mDepthPrePassObjects.size()));
+		}
+
+		const std::vector<VkClearValue> DepthClear = { { 1.0f, 0.0f } };
+		Cmd::BeginRenderPass(mBasePassCommandBuffer.get(), mDepthPrePassFramebuffer.get(), mDepthPrePassRenderPass.get(), DepthClear, Extend);
+
+		CommandRecorder PrePassRecorder(mBasePassCommandBuffer.get());
+
+		BeginOverdrawQuery();
+
+		uint32_t ObjectIdx = 0;
+
+		for (const PipelineRange& Range : mPipelineRanges)
+		{
+			const PipelineState& State = PipelineManager::Get().GetPipelineById(Range.PipelineId)->GetState();
+
+			if (!IsDrawnByDepthPrePass(State)) { continue; }
+
+			// Faces the material doesn't cull have to reach the depth buffer, or they fail the base pass' equal test
+			PipelineState PrePassState = mDepthPrePassPipeline->GetState();
+			PrePassState.Cull = State.Cull;
+
+			IGraphicsPipeline* PrePassPipeline = PipelineManager::Get().GetPipelineVariant(mDepthPrePassPipelineId, PrePassState);
+
+			PrePassRecorder.BindGraphicsPipeline(PrePassPipeline);
+			PrePassRecorder.BindDescriptorSet(mDepthPrePassDescriptorInst.get(), PrePassPipeline);
+			PrePassRecorder.SetViewports(PrePassPipeline);
+
+			// Packets are sorted by mesh inside of each material, following packets of the same submesh become instances of one draw
+			// Textures don't matter for depth, so neighbours of different materials are merged as well
+			for (uint32_t i = Range.Begin; i < Range.End;)
+			{
+				const RenderableData& DataToRender = mCullingCandidates[mDrawPackets[i].RenderableIdx];
+				const StaticMesh* const Mesh = DataToRender.MeshHandle->GetStaticMesh();
+				const int32_t Id = DataToRender.Id;
+				const int32_t Lod = DataToRender.Lod;
+
+				uint32_t InstancesCount = 1;
+
+				while (i + InstancesCount < Range.End)
+				{
+					const RenderableData& Next = mCullingCandidates[mDrawPackets[i + InstancesCount].RenderableIdx];
+
+					if (Next.MeshHandle->GetStaticMesh() != Mesh || Next.Id != Id || Next.Lod != Lod) { break; }
+
+					++InstancesCount;
+				}
+
+				const GeometryRange& Geometry = Mesh->GetGeometryRange(Id, Lod);
+
+				PrePassRecorder.BindVertexAndIndexBuffer(Mesh->GetPositionBuffer(Id), Mesh->GetIndexBuffer(Id, Lod), Geometry.Type);
+
+				Cmd::DrawIndexed(mBasePassCommandBuffer.get(), Geometry.IndexCount, InstancesCount, ObjectIdx, Geometry.FirstIndex, Geometry.VertexOffset);
+
+				++mFrameStats.DepthPrePassDrawCalls;
+
+				i += InstancesCount;
+				ObjectIdx += InstancesCount;
+			}
+		}
+
+		EndOverdrawQuery();
+
+		Cmd::EndRenderPass(mBasePassCommandBuffer.get());
+	}
+
+	const std::vector<VkClearValue> ClearColors = { { 0, 0, 0, 1 }, { 0, 0, 0, 1 }, { 1.0f, 0.0f } };
+	RenderPass* BasePassRenderPass = DepthPrePass ? mGBufferRenderPass.get() : mBasePassRenderPass.get();
+
+	Cmd::BeginRenderPass(mBasePassCommandBuffer.get(), mBasePassFramebuffer.get(), BasePassRenderPass, ClearColors, Extend);
+
+	// State bound inside the render pass goes through the recorder, which drops calls that wouldn't change anything
+	CommandRecorder Recorder(mBasePassCommandBuffer.get());
+
+	if (!DepthPrePass)
+	{
+		BeginOverdrawQuery();
+	}
 	
-	for (auto& PartitionedData : PartitionedRendererData)
+	for (const PipelineRange& Range : mPipelineRanges)
 	{
-		const PipelineManager::KeyType PipelineKey = PartitionedData.first;
-		std::vector<RenderableData>& RenderableDataList = PartitionedData.second;
+		IGraphicsPipeline* Pipeline = PipelineManager::Get().GetPipelineById(Range.PipelineId);
+
+		// After the pre-pass only the closest fragments are shaded, their depth is already there
+		// Packets the pre-pass skipped keep their own depth test against the depth it wrote
+		if (DepthPrePass && IsDrawnByDepthPrePass(Pipeline->GetState()))
+		{
+			PipelineState EqualDepth = Pipeline->GetState();
+			EqualDepth.DepthCompareOP = PipelineCreation::DepthCompareOP::EQUAL;
+			EqualDepth.DepthWrite = false;
+
+			Pipeline = PipelineManager::Get().GetPipelineVariant(Range.PipelineId, EqualDepth);
+		}
+
+		upDescriptorInst& DS = mDescriptorInstances[Range.PipelineId];
+		const std::vector<UniformBinding>& Bindings = mUniformBindings[Range.PipelineId];
 
-		IGraphicsPipeline* Pipeline = PipelineManager::Get().GetPipelineByKey(PipelineKey);
+		upImageArrayManager& ImgArrManager = mImageArrayManagers[Range.PipelineId];
 
-		upDescriptorInstList& DSList = mDescriptorInstances[PipelineKey];
-		UBTemplates& UBList = mMaterialUniformBuffers[PipelineKey];
+		Recorder.BindGraphicsPipeline(Pipeline);
 
-		upImageArrayManager& ImgArrManager = mImageArrayManagers[PipelineKey];
+		Recorder.BindDescriptorSet(ImgArrManager->GetDescInst(), Pipeline);
 
-		Cmd::BindGraphicsPipeline(mBasePassCommandBuffer.get(), Pipeline);
+		// Per-object data is read from the object buffer so its descriptor is bound once for the whole pipeline
+		const bool UsesObjectBuffer = mObjectBuffers.find(Range.PipelineId) != mObjectBuffers.end();
+
+		if (UsesObjectBuffer)
+		{
+			Recorder.BindDescriptorSet(DS.get(), Pipeline);
+		}
 
-		Cmd::UpdateDescriptorData(mBasePassCommandBuffer.get(), ImgArrManager->GetDescInst(), Pipeline);
+		Recorder.SetViewports(Pipeline);
 
-		for (int32_t i = 0; i < RenderableDataList.size(); ++i)
+		for (uint32_t i = Range.Begin; i < Range.End; ++i)
 		{
 
-			RenderableData& DataToRender = RenderableDataList[i];
+			RenderableData& DataToRender = mCullingCandidates[mDrawPackets[i].RenderableIdx];
 			StaticMeshHandle* const MeshHandle = DataToRender.MeshHandle;
 			const StaticMesh* const Mesh = MeshHandle->GetStaticMesh();
 			const int32_t Id = DataToRender.Id;
+			const int32_t Lod = DataToRender.Lod;
 			ShaderParameters* Params = MeshHandle->GetMaterial(Id)->GetShaderParameters();
 
-			const int32_t BufferID = GetBufferIDByIndex(i);
-			const int32_t EntryID = GetEntryIDByIndex(i);
+			// Following draws of the same submesh with the same textures become instances of this one
+			uint32_t InstancesCount = 1;
 
-			// Calculate a dynamic offset for each dynamic uniform buffer in a descriptor set
-			std::vector<uint32_t> DynamicOffsets;
-			DynamicOffsets.reserve(UBList.size());
-			for (int32_t j = 0; j < UBList.size(); ++j)
+			if (UsesObjectBuffer && mInstancingEnabled)
 			{
-				const auto& FirstBuffer = UBList[j].second[0];
-				const int32_t dynamicOffset = i * FirstBuffer->GetAlignmentSize();
+				while (i + InstancesCount < Range.End)
+				{
+					const RenderableData& Next = mCullingCandidates[mDrawPackets[i + InstancesCount].RenderableIdx];
+
+					const bool SameDraw = Next.MeshHandle->GetStaticMesh() == Mesh && Next.Id == Id && Next.Lod == Lod && Next.TextureKey == DataToRender.TextureKey && Next.Instanceable && DataToRender.Instanceable;
+					const bool NextObject = Next.ObjectIdx == DataToRender.ObjectIdx + InstancesCount;
 
-				DynamicOffsets.push_back(dynamicOffset);
+					if (!SameDraw || !NextObject) { break; }
+
+					++InstancesCount;
+				}
 			}
 
-			upDescriptorInst& CurrentDS = DSList[BufferID];
+			Recorder.UpdatePushConstants(Params, Pipeline);
+
+			if (!UsesObjectBuffer)
+			{
+				// Dynamic offsets of the renderable's uniform buffers inside the arena
+				Recorder.BindDescriptorSet(DS.get(), Pipeline, DynamicOffsets.data() + DataToRender.DynamicOffsetsIdx, static_cast<uint32_t>(Bindings.size()));
+			}
 
-			Cmd::UpdatePushConstants(mBasePassCommandBuffer.get(), Params, Pipeline);
-			Cmd::UpdateDescriptorData(mBasePassCommandBuffer.get(), CurrentDS.get(), Pipeline, DynamicOffsets);
+			const GeometryRange& Geometry = Mesh->GetGeometryRange(Id, Lod);
 
-			Cmd::BindVertexAndIndexBuffer(mBasePassCommandBuffer.get(), Mesh->GetVertexBuffer(Id), Mesh->GetIndexBuffer(Id));
-			Cmd::SetViewports(mBasePassCommandBuffer.get(), Pipeline);
-			Cmd::DrawIndexed(mBasePassCommandBuffer.get(), Mesh->GetIndiciesSize(Id));
+			// Meshes share the geometry pool's buffers, so they are bound again only when a mesh of another vertex format or index type shows up
+			Recorder.BindVertexAndIndexBuffer(Mesh->GetVertexBuffer(Id), Mesh->GetIndexBuffer(Id, Lod), Geometry.Type);
+
+			Cmd::DrawIndexed(mBasePassCommandBuffer.get(), Geometry.IndexCount, InstancesCount, DataToRender.ObjectIdx, Geometry.FirstIndex, Geometry.VertexOffset);
+
+			++mFrameStats.DrawCalls;
+			mFrameStats.InstancesDrawn += InstancesCount;
+			mFrameStats.TrianglesSubmitted += static_cast<uint64_t>(Geometry.IndexCount / 3) * InstancesCount;
+
+			i += InstancesCount - 1;
 
 		}
 	}
 
+	if (!DepthPrePass)
+	{
+		EndOverdrawQuery();
+	}
+
+	// Instances of the GPU scene aren't in the pre-pass, they are depth tested and written as usual
+	if (DrawGPUScene)
+	{
+		mFrameStats.IndirectDrawCalls = mGPUScene->Draw(Recorder);
+	}
+
+	mFrameStats.BasePassCommands = Recorder.GetStats();
+	mFrameStats.GeometryBinds = Recorder.GetStats().VertexBufferBinds + Recorder.GetStats().IndexBufferBinds;
+
 	Cmd::EndRenderPass(mBasePassCommandBuffer.get());
 
+	// Instances hidden by the previous frame's depth are tested again against the depth drawn so far and the visible ones are added to the base pass
+	if (DrawGPUScene && mGPUScene->NeedsOccludedPass())
+	{
+		mHiZBuffer->Build(mBasePassCommandBuffer.get(), mDepthBuffer.get());
+		mGPUScene->CullOccluded(mBasePassCommandBuffer.get(), *mHiZBuffer);
+
+		Cmd::BeginRenderPass(mBasePassCommandBuffer.get(), mBasePassFramebuffer.get(), mBasePassLoadRenderPass.get(), ClearColors, Extend);
+
+		CommandRecorder OccludedRecorder(mBasePassCommandBuffer.get());
+		mFrameStats.IndirectDrawCalls += mGPUScene->Draw(OccludedRecorder);
+
+		Cmd::EndRenderPass(mBasePassCommandBuffer.get());
+	}
+
+	// Pyramid of the whole base pass is used by the first phase of the next frame
+	const bool AsyncHiZ = DrawGPUScene && mOcclusionCullingEnabled && IsAsyncComputeEnabled();
+
+	if (DrawGPUScene && mOcclusionCullingEnabled)
+	{
+		if (AsyncHiZ)
+		{
+			// Only the copy needs the depth buffer, the downsample runs on the async compute queue during the light pass
+			mHiZBuffer->CopyDepth(mBasePassCommandBuffer.get(), mDepthBuffer.get());
+			mHiZBuffer->ReleaseOwnership(mBasePassCommandBuffer.get(), ComputeQueueIndex);
+		}
+		else
+		{
+			mHiZBuffer->Build(mBasePassCommandBuffer.get(), mDepthBuffer.get());
+		}
+
+		mHiZViewProjection = ViewProjection;
+	}
+	else
+	{
+		mHiZBuffer->Invalidate();
+	}
+
+	if (Timestamps)
+	{
+		Cmd::WriteTimestamp(mBasePassCommandBuffer.get(), Timestamps->Pool.get(), PipelineStage::END, BASE_PASS_END);
+	}
+
 	mBasePassCommandBuffer->End();
 
-	mBasePassCommandBuffer->Submit(false, { mBasePassReady.get() }, { mImageReadyToDraw[CurrentImageIndex].get() }, { PipelineStage::COLOR_ATTACHMENT, PipelineStage::FRAGMENT });
+	std::vector<Semaphore*> BasePassSignal = { mBasePassReady.get() };
+	std::vector<Semaphore*> BasePassWaitFor = { mImageReadyToDraw[CurrentImageIndex].get() };
+	std::vector<PipelineStage> BasePassWaitStage = { PipelineStage::COLOR_ATTACHMENT };
+
+	if (AsyncHiZ)
+	{
+		BasePassSignal.push_back(mAsyncComputeStart.get());
+	}
+
+	// Only culling reads the pyramid, draws of SceneData's components don't wait for the async compute
+	if (WaitForAsyncCompute)
+	{
+		BasePassWaitFor.push_back(mAsyncComputeDone.get());
+		BasePassWaitStage.push_back(PipelineStage::COMPUTE);
+	}
+
+	mBasePassCommandBuffer->Submit(false, BasePassSignal, BasePassWaitFor, BasePassWaitStage);
+
+	// Async compute
+	if (AsyncHiZ)
+	{
+		mAsyncComputeFence->Wait();
+		mAsyncComputeFence->Reset();
+
+		mAsyncComputeCommandBuffer = std::make_unique<CommandBuffer>(ComputeQueueIndex);
+		mAsyncComputeCommandBuffer->Begin(CBUsage::ONE_TIME);
 
+		if (Timestamps)
+		{
+			Cmd::WriteTimestamp(mAsyncComputeCommandBuffer.get(), Timestamps->Pool.get(), PipelineStage::START, ASYNC_COMPUTE_BEGIN);
+		}
+
+		mHiZBuffer->AcquireOwnership(mAsyncComputeCommandBuffer.get(), GraphicsQueueIndex);
+		mHiZBuffer->Downsample(mAsyncComputeCommandBuffer.get());
+		mHiZBuffer->ReleaseOwnership(mAsyncComputeCommandBuffer.get(), GraphicsQueueIndex);
+
+		if (Timestamps)
+		{
+			Cmd::WriteTimestamp(mAsyncComputeCommandBuffer.get(), Timestamps->Pool.get(), PipelineStage::END, ASYNC_COMPUTE_END);
+			Timestamps->AsyncComputeWritten = true;
+		}
+
+		mAsyncComputeCommandBuffer->End();
+		mAsyncComputeCommandBuffer->Submit(mAsyncComputeFence.get(), { mAsyncComputeDone.get() }, { mAsyncComputeStart.get() }, { PipelineStage::COMPUTE });
+
+		mAsyncComputePending = true;
+	}
 
 
-	Image::ChangeMultipleLayouts(	{ mColorBuffer.get(),		mNormalBuffer.get(),		mPositionBuffer.get(),		mSceneBuffer.get() },
-									{ ImageLayout::SHADER_READ,	ImageLayout::SHADER_READ,	ImageLayout::SHADER_READ,	ImageLayout::COLOR_ATTACHMENT });
+
+	Image::ChangeMultipleLayouts(	{ mColorBuffer.get(),		mNormalBuffer.get(),		mDepthBuffer.get(),						mSceneBuffer.get() },
+									{ ImageLayout::SHADER_READ,	ImageLayout::SHADER_READ,	ImageLayout::DEPTH_STENCIL_READ_ONLY,	ImageLayout::COLOR_ATTACHMENT });
 
 
 
@@ -640,54 +1344,168 @@ void DeferredRenderer::Render(SceneData& Data)
 		mLightPassCommandBuffer = std::make_unique<CommandBuffer>(GraphicsQueueIndex);
 		mLightPassCommandBuffer->Begin(CBUsage::ONE_TIME);
 
-		const std::vector<VkClearValue> SceneClearColor = { { 0, 0, 0, 1 } };
-		Cmd::BeginRenderPass(mLightPassCommandBuffer.get(), mLightPassFramebuffer.get(), mLightPassRenderPass.get(), SceneClearColor, Extend);
-
-		IGraphicsPipeline* Pipeline = PipelineManager::Get().GetPipelineByKey(mDirectionalLightPassShaderParams->GetPipelineKey());
+		if (Timestamps)
+		{
+			Cmd::WriteTimestamp(mLightPassCommandBuffer.get(), Timestamps->Pool.get(), PipelineStage::START, LIGHT_PASS_BEGIN);
+		}
 
 		SamplerSettings SamplerInstSettings = {};
 		SamplerInstSettings.MaxAnisotropy = 16;
 
 		Sampler* DefaultSampler = TextureManager::Get().GetSampler(SamplerInstSettings);
 
-		mDirectionalLightPassDescriporInst->SetImage(0, mColorView.get(), DefaultSampler);
-		mDirectionalLightPassDescriporInst->SetImage(1, mNormalView.get(), DefaultSampler);
-		mDirectionalLightPassDescriporInst->SetImage(2, mPositionView.get(), DefaultSampler);
-		mDirectionalLightPassDescriporInst->Update();
+		// Depth can't be filtered
+		SamplerSettings DepthSamplerSettings = {};
+		DepthSamplerSettings.MinFilter = FilterMode::NEAREST;
+		DepthSamplerSettings.MagFilter = FilterMode::NEAREST;
+		DepthSamplerSettings.MipMapFilter = FilterMode::NEAREST;
+		DepthSamplerSettings.MaxAnisotropy = 0;
 
-		auto PCFragPtr = mDirectionalLightPassShaderParams->GetPushConstantBuffer(ShaderType::FRAGMENT);
-		PCFragPtr->Set("Direction", glm::normalize(glm::vec3(-1, -1, -1)));
-		PCFragPtr->Set("LightColor", glm::vec3(1,1,1));
-		
-		Cmd::UpdatePushConstants(mLightPassCommandBuffer.get(), mDirectionalLightPassShaderParams.get(), Pipeline);
-		Cmd::UpdateDescriptorData(mLightPassCommandBuffer.get(), mDirectionalLightPassDescriporInst.get(), Pipeline);
+		Sampler* DepthSampler = TextureManager::Get().GetSampler(DepthSamplerSettings);
+
+		const glm::mat4 InverseProjection = glm::inverse(Correction * Projection);
+		const glm::vec3 LightDirection = glm::normalize(glm::vec3(-1, -1, -1));
+		const glm::vec3 LightColor = glm::vec3(1, 1, 1);
+
+		const bool Tiled = mLightingMode == LightingMode::TILED;
+
+		// Pipelines of the light pass are compatible with the screen's render pass, both use swapchain's format
+		const bool Direct = mPresentMode == PresentMode::DIRECT;
+		Framebuffer* LightPassFramebuffer = Direct ? mFramebuffers[ImageIndex].get() : mLightPassFramebuffer.get();
+		RenderPass* LightPassRenderPass = Direct ? mScreenRenderPass.get() : mLightPassRenderPass.get();
+
+		if (Tiled)
+		{
+			mTiledLighting->Cull(mLightPassCommandBuffer.get(), mDepthSampleView.get(), DepthSampler, InverseProjection);
+		}
+
+		const std::vector<VkClearValue> SceneClearColor = { { 0, 0, 0, 1 } };
+		Cmd::BeginRenderPass(mLightPassCommandBuffer.get(), LightPassFramebuffer, LightPassRenderPass, SceneClearColor, Extend);
+
+		if (Tiled)
+		{
+			IGraphicsPipeline* Pipeline = PipelineManager::Get().GetPipelineByKey(mTiledLightPassShaderParams->GetPipelineKey());
+
+			mTiledLightPassDescriporInst->SetImage(0, mColorView.get(), DefaultSampler);
+			mTiledLightPassDescriporInst->SetImage(1, mNormalView.get(), DefaultSampler);
+			mTiledLightPassDescriporInst->SetImage(2, mDepthSampleView.get(), DepthSampler);
+			mTiledLightPassDescriporInst->SetBuffer(3, mTiledLighting->GetLightBuffer(), VK_WHOLE_SIZE);
+			mTiledLightPassDescriporInst->SetBuffer(4, mTiledLighting->GetTileBuffer(), VK_WHOLE_SIZE);
+			mTiledLightPassDescriporInst->Update();
+
+			ShaderStructs::TiledLightPassFrag::TiledLightInfo LightInfo = {};
+			LightInfo.Direction = LightDirection;
+			LightInfo.LightColor = LightColor;
+			LightInfo.InverseProjection = InverseProjection;
+			LightInfo.TilesX = mTiledLighting->GetTilesX();
+			mTiledLightPassShaderParams->Set(LightInfo);
+
+			Cmd::UpdatePushConstants(mLightPassCommandBuffer.get(), mTiledLightPassShaderParams.get(), Pipeline);
+			Cmd::UpdateDescriptorData(mLightPassCommandBuffer.get(), mTiledLightPassDescriporInst.get(), Pipeline);
+
+			Cmd::BindGraphicsPipeline(mLightPassCommandBuffer.get(), Pipeline);
+			Cmd::SetViewports(mLightPassCommandBuffer.get(), Pipeline);
+			Cmd::Draw(mLightPassCommandBuffer.get(), 3);
+		}
+		else
+		{
+			IGraphicsPipeline* Pipeline = PipelineManager::Get().GetPipelineByKey(mDirectionalLightPassShaderParams->GetPipelineKey());
 
-		Cmd::BindGraphicsPipeline(mLightPassCommandBuffer.get(), Pipeline);
-		Cmd::BindVertexBuffer(mLightPassCommandBuffer.get(), mScreenVertexBuffer.get());
-		Cmd::SetViewports(mLightPassCommandBuffer.get(), Pipeline);
-		Cmd::Draw(mLightPassCommandBuffer.get(), 6);
+			mDirectionalLightPassDescriporInst->SetImage(0, mColorView.get(), DefaultSampler);
+			mDirectionalLightPassDescriporInst->SetImage(1, mNormalView.get(), DefaultSampler);
+			mDirectionalLightPassDescriporInst->SetImage(2, mDepthSampleView.get(), DepthSampler);
+			mDirectionalLightPassDescriporInst->Update();
+
+			ShaderStructs::DirectionalLightPassFrag::LightInfo LightInfo = {};
+			LightInfo.Direction = LightDirection;
+			LightInfo.LightColor = LightColor;
+			LightInfo.InverseProjection = InverseProjection;
+			mDirectionalLightPassShaderParams->Set(LightInfo);
+
+			Cmd::UpdatePushConstants(mLightPassCommandBuffer.get(), mDirectionalLightPassShaderParams.get(), Pipeline);
+			Cmd::UpdateDescriptorData(mLightPassCommandBuffer.get(), mDirectionalLightPassDescriporInst.get(), Pipeline);
+
+			Cmd::BindGraphicsPipeline(mLightPassCommandBuffer.get(), Pipeline);
+			Cmd::SetViewports(mLightPassCommandBuffer.get(), Pipeline);
+			Cmd::Draw(mLightPassCommandBuffer.get(), 3);
+
+			// Every light reads the whole G-buffer again and is blended over the previous ones
+			IGraphicsPipeline* LocalPipeline = PipelineManager::Get().GetPipelineByKey(mLocalLightPassShaderParams->GetPipelineKey());
+
+			mLocalLightPassDescriporInst->SetImage(0, mColorView.get(), DefaultSampler);
+			mLocalLightPassDescriporInst->SetImage(1, mNormalView.get(), DefaultSampler);
+			mLocalLightPassDescriporInst->SetImage(2, mDepthSampleView.get(), DepthSampler);
+			mLocalLightPassDescriporInst->Update();
+
+			Cmd::BindGraphicsPipeline(mLightPassCommandBuffer.get(), LocalPipeline);
+			Cmd::UpdateDescriptorData(mLightPassCommandBuffer.get(), mLocalLightPassDescriporInst.get(), LocalPipeline);
+
+			ShaderStructs::LocalLightPassFrag::LocalLightInfo LocalLightInfo = {};
+			LocalLightInfo.InverseProjection = InverseProjection;
+
+			for (const TiledLighting::LightData& CurrentLight : mTiledLighting->GetLights())
+			{
+				LocalLightInfo.Position = CurrentLight.Position;
+				LocalLightInfo.Radius = CurrentLight.Radius;
+				LocalLightInfo.LightColor = CurrentLight.Color;
+				LocalLightInfo.Type = CurrentLight.Type;
+				LocalLightInfo.Direction = CurrentLight.Direction;
+				LocalLightInfo.CosOuterCone = CurrentLight.CosOuterCone;
+				LocalLightInfo.CosInnerCone = CurrentLight.CosInnerCone;
+
+				Cmd::PushConstants(mLightPassCommandBuffer.get(), LocalPipeline, LocalLightInfo);
+				Cmd::Draw(mLightPassCommandBuffer.get(), 3);
+			}
+		}
 
 		Cmd::EndRenderPass(mLightPassCommandBuffer.get());
 
-		mLightPassCommandBuffer->End();
+		if (mPresentMode == PresentMode::BLIT)
+		{
+			VkImage SwapChainImage = VulkanCore::Get().GetSwapChain()->GetImages()[ImageIndex];
 
-		mLightPassCommandBuffer->Submit(false, { mLightPassReady.get() }, { mBasePassReady.get() }, { PipelineStage::COLOR_ATTACHMENT, PipelineStage::FRAGMENT });
-	}
+			Cmd::ImageBarrier(mLightPassCommandBuffer.get(), mSceneBuffer.get(), ImageLayout::COLOR_ATTACHMENT, ImageLayout::TRANSFER_SRC, PipelineStage::COLOR_ATTACHMENT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, PipelineStage::TRANSER, VK_ACCESS_TRANSFER_READ_BIT);
+			Cmd::ImageBarrier(mLightPassCommandBuffer.get(), SwapChainImage, ImageLayout::UNDEFINED, ImageLayout::TRANSFER_DST, PipelineStage::START, 0, PipelineStage::TRANSER, VK_ACCESS_TRANSFER_WRITE_BIT);
 
+			Cmd::BlitImage(mLightPassCommandBuffer.get(), mSceneBuffer.get(), SwapChainImage, Extend);
 
+			// Scene buffer goes back to the layout it's tracked in
+			Cmd::ImageBarrier(mLightPassCommandBuffer.get(), SwapChainImage, ImageLayout::TRANSFER_DST, ImageLayout::PRESENT_SRC, PipelineStage::TRANSER, VK_ACCESS_TRANSFER_WRITE_BIT, PipelineStage::END, 0);
+			Cmd::ImageBarrier(mLightPassCommandBuffer.get(), mSceneBuffer.get(), ImageLayout::TRANSFER_SRC, ImageLayout::COLOR_ATTACHMENT, PipelineStage::TRANSER, VK_ACCESS_TRANSFER_READ_BIT, PipelineStage::COLOR_ATTACHMENT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+		}
 
-	Image::ChangeMultipleLayouts(	{ mSceneBuffer.get() }, 
-									{ ImageLayout::SHADER_READ });
+		if (Timestamps)
+		{
+			Cmd::WriteTimestamp(mLightPassCommandBuffer.get(), Timestamps->Pool.get(), PipelineStage::END, LIGHT_PASS_END);
+		}
 
+		mLightPassCommandBuffer->End();
 
+		// Tile culling is the first to read the base pass' output
+		const std::vector<PipelineStage> LightPassWaitStage = { Tiled ? PipelineStage::COMPUTE : PipelineStage::FRAGMENT };
+
+		if (mPresentMode == PresentMode::SCREEN_PASS)
+		{
+			mLightPassCommandBuffer->Submit(false, { mLightPassReady.get() }, { mBasePassReady.get() }, LightPassWaitStage);
+		}
+		else
+		{
+			// Swapchain's image is already written, the light pass ends the frame
+			mLightPassCommandBuffer->Submit(mFrameFence.get(), { mImageReadyToPresent[CurrentImageIndex].get() }, { mBasePassReady.get() }, LightPassWaitStage);
+		}
+	}
 
 	// Screen pass
+	if (mPresentMode == PresentMode::SCREEN_PASS)
 	{
+		Image::ChangeMultipleLayouts(	{ mSceneBuffer.get() }, 
+										{ ImageLayout::SHADER_READ });
+
 		mScreenCommandBuffer = std::make_unique<CommandBuffer>(GraphicsQueueIndex);
 		mScreenCommandBuffer->Begin(CBUsage::ONE_TIME);
 	
 		const std::vector<VkClearValue> ClearColor = { { 0, 0, 0, 1 } };
-		Cmd::BeginRenderPass(mScreenCommandBuffer.get(), mFramebuffers[CurrentImageIndex].get(), mScreenRenderPass.get(), ClearColor, Extend);
+		Cmd::BeginRenderPass(mScreenCommandBuffer.get(), mFramebuffers[ImageIndex].get(), mScreenRenderPass.get(), ClearColor, Extend);
 
 		IGraphicsPipeline* Pipeline = PipelineManager::Get().GetPipelineByKey(mScreenShaderParams->GetPipelineKey());
 
@@ -700,14 +1518,12 @@ void DeferredRenderer::Render(SceneData& Data)
 		mScreenDescriporInst->Update();
 
 		Cmd::BindGraphicsPipeline(mScreenCommandBuffer.get(), Pipeline);
-
-		Cmd::BindVertexBuffer(mScreenCommandBuffer.get(), mScreenVertexBuffer.get());
 		
 		Cmd::UpdatePushConstants(mScreenCommandBuffer.get(), mScreenShaderParams.get(), Pipeline);
 		Cmd::UpdateDescriptorData(mScreenCommandBuffer.get(), mScreenDescriporInst.get(), Pipeline);
 
 		Cmd::SetViewports(mScreenCommandBuffer.get(), Pipeline);
-		Cmd::Draw(mScreenCommandBuffer.get(), 6);
+		Cmd::Draw(mScreenCommandBuffer.get(), 3);
 
 		Cmd::EndRenderPass(mScreenCommandBuffer.get());
 
@@ -717,6 +1533,9 @@ void DeferredRenderer::Render(SceneData& Data)
 
 	QueuePresent(ImageIndex, mImageReadyToPresent[CurrentImageIndex].get());
 
+	const std::chrono::duration<float, std::milli> FrameTime = std::chrono::high_resolution_clock::now() - FrameStart;
+	mFrameStats.CPUFrameTime = FrameTime.count();
+
 
 
 }
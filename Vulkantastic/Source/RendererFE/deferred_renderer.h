@@ -2,14 +2,23 @@
 #include "../Renderer/synchronization.h"
 #include "../Renderer/framebuffer.h"
 #include "../Renderer/command_buffer.h"
+#include "../Renderer/query_pool.h"
 #define GLM_FORCE_RADIANS
 #include "glm/glm.hpp"
 #include <glm/gtc/matrix_transform.hpp>
 #include "static_mesh_component.h"
 #include "../Renderer/pipeline_manager.h"
-#include "../Renderer/uniform_buffer.h"
+#include "../Renderer/uniform_arena.h"
 #include "../Renderer/shader_parameters.h"
+#include "../Renderer/command_recorder.h"
 #include "image_array_manager.h"
+#include "gpu_scene.h"
+#include "hiz_buffer.h"
+#include "frustum_culling.h"
+#include "software_occlusion.h"
+#include "tiled_lighting.h"
+#include "draw_packet.h"
+#include <unordered_map>
 
 class StaticMesh;
 class DescriptorInst;
@@ -20,6 +29,76 @@ struct SceneData
 	glm::vec3 CameraPosition = { 0.0f,0.0f,0.0f };
 	glm::vec3 CameraForward = { 0.0f, 0.0f, -1.0f };
 	std::vector<StaticMeshComponent*> StaticMeshComponents;
+
+	// Rasterized on the CPU with their coarsest level of detail when software occlusion culling is enabled
+	// They aren't drawn unless they are also in StaticMeshComponents
+	std::vector<StaticMeshComponent*> Occluders;
+
+	// Lit by the light pass together with the directional light
+	std::vector<Light> Lights;
+};
+
+enum class LightingMode : uint8_t
+{
+	TILED = 0, // Lights are binned into screen tiles by a compute pass, one full-screen pass evaluates the lights of every pixel's tile
+	PER_LIGHT // Every light is added by its own full-screen pass
+};
+
+// How the lit scene gets to the swapchain's image
+enum class PresentMode : uint8_t
+{
+	SCREEN_PASS = 0, // Light pass shades into the scene texture that is sampled by a separate screen pass
+	BLIT, // Light pass shades into the scene texture that is blitted to the swapchain's image in the same command buffer
+	DIRECT // Light pass shades straight into the swapchain's image, only usable while nothing reads the scene texture
+};
+
+// Whether depth of SceneData's components is drawn by a depth only pass before the base pass
+enum class DepthPrePassMode : uint8_t
+{
+	DISABLED = 0,
+	ENABLED, // Base pass then shades only the closest fragments, tested for equal depth without writing it
+	AUTO // Enabled while the measured overdraw is above the threshold
+};
+
+// Counters gathered during the last rendered frame
+struct RendererStats
+{
+	uint64_t UniformBytesUploaded = 0;
+	uint32_t UniformEntriesUpdated = 0;
+	uint32_t UniformEntriesSkipped = 0; // Entries whose data didn't change since the previous frame
+	uint64_t ObjectBytesUploaded = 0;
+	uint32_t DrawCalls = 0; // Base pass only
+	uint32_t InstancesDrawn = 0;
+	uint64_t TrianglesSubmitted = 0; // Base pass draws of SceneData's components, after the levels of detail are chosen
+	uint32_t GeometryBinds = 0; // Vertex and index buffer binds of the base pass
+	uint32_t RenderablesCulled = 0; // Submeshes rejected by the CPU frustum culling
+	uint32_t RenderablesOccluded = 0; // Submeshes inside of the frustum hidden by SceneData's occluders
+	uint32_t OccluderTriangles = 0; // Rasterized by the software occlusion culling
+	uint32_t LightsVisible = 0; // Lights of SceneData inside of the view frustum
+	LightOverflowStats LightOverflow; // Read back from the previous frame when tiled lighting was used
+	uint32_t DepthPrePassDrawCalls = 0;
+	bool DepthPrePass = false; // Depth of SceneData's components was drawn by the depth pre-pass
+	float Overdraw = 0.0f; // Samples of SceneData's components that passed the depth test per pixel of the screen, from the frame before the previous one
+	uint32_t IndirectDrawCalls = 0; // Indirect draw calls of the GPU scene, their instances are counted on the GPU
+	uint32_t GPUSceneInstances = 0; // Instances culled by the GPU scene's compute pass
+	uint64_t GPUSceneBytesUploaded = 0;
+	MeshletCullingStats GPUSceneMeshlets; // Read back from the previous frame when meshlet culling is enabled
+	OcclusionCullingStats GPUSceneOcclusion; // Read back from the previous frame when occlusion culling is enabled
+	CommandRecorderStats BasePassCommands; // Recorded and redundant state changes of the base pass
+	float CPUFrameTime = 0.0f; // In milliseconds, without waiting for the previous frame
+
+	// GPU timestamps of the frame before the previous one in milliseconds, zero when the device doesn't support them
+	float GPUBasePassTime = 0.0f;
+	float GPULightPassTime = 0.0f;
+	float GPUAsyncComputeTime = 0.0f; // Work of the async compute queue, zero when nothing was scheduled on it
+	float GPUAsyncComputeOverlap = 0.0f; // Part of the async compute work that ran together with the light pass
+};
+
+// Formats of the G-buffer's attachments, position isn't stored and is reconstructed from depth in the light pass
+struct GBufferSettings
+{
+	ImageFormat ColorFormat = ImageFormat::R8G8B8A8;
+	ImageFormat NormalFormat = ImageFormat::R16G16; // Octahedral encoded view space normal, R16G16 or A2B10G10R10
 };
 
 class DeferredRenderer
@@ -33,7 +112,7 @@ public:
 
 	~DeferredRenderer();
 
-	bool Startup();
+	bool Startup(const GBufferSettings& Settings = GBufferSettings());
 	bool Shutdown();
 
 	inline RenderPass* GetBasePassRenderPass() const { return mBasePassRenderPass.get(); }
@@ -42,7 +121,91 @@ public:
 
 	void Render(SceneData& Data);
 
+	inline const RendererStats& GetFrameStats() const { return mFrameStats; }
+
+	// Default materials read per-object data from a storage buffer instead of uniform buffers and push constants
+	// Has to be set before static mesh handles are created
+	inline void SetObjectBufferEnabled(bool Enabled) { mObjectBufferEnabled = Enabled; }
+	inline bool IsObjectBufferEnabled() const { return mObjectBufferEnabled; }
+
+	// Draws of the same submesh with the same textures are merged into instanced draws, works only with the object buffer
+	inline void SetInstancingEnabled(bool Enabled) { mInstancingEnabled = Enabled; }
+	inline bool IsInstancingEnabled() const { return mInstancingEnabled; }
+
+	// Submeshes of SceneData's components outside of the view frustum aren't drawn
+	inline void SetFrustumCullingEnabled(bool Enabled) { mFrustumCullingEnabled = Enabled; }
+	inline bool IsFrustumCullingEnabled() const { return mFrustumCullingEnabled; }
+
+	// Defaults to the widest path supported by the CPU
+	inline void SetCullingPath(CullingPath Path) { mCullingPath = Path; }
+	inline CullingPath GetCullingPath() const { return mCullingPath; }
+
+	// Submeshes of SceneData's components hidden behind SceneData's occluders aren't drawn, doesn't read anything back from the GPU
+	// Uses the same SIMD path as the frustum culling
+	inline void SetSoftwareOcclusionEnabled(bool Enabled) { mSoftwareOcclusionEnabled = Enabled; }
+	inline bool IsSoftwareOcclusionEnabled() const { return mSoftwareOcclusionEnabled; }
+
+	// Components are drawn with the level of detail matching their screen size, otherwise with the first one unless a level is forced on the handle
+	inline void SetLodEnabled(bool Enabled) { mLodEnabled = Enabled; }
+	inline bool IsLodEnabled() const { return mLodEnabled; }
+
+	// Fraction of a level's screen size by which the screen size has to cross it before the level changes
+	inline void SetLodHysteresis(float Hysteresis) { mLodHysteresis = Hysteresis; }
+	inline float GetLodHysteresis() const { return mLodHysteresis; }
+
+	// Instances culled and drawn by the GPU, rendered every frame together with SceneData's components
+	// Created on the first call
+	GPUScene* GetGPUScene();
+
+	// Instances of the GPU scene are also tested against the depth of the previous frame and of SceneData's components
+	// Instances that become visible are drawn in a second part of the base pass
+	void SetOcclusionCullingEnabled(bool Enabled);
+	inline bool IsOcclusionCullingEnabled() const { return mOcclusionCullingEnabled; }
+
+	// Hi-Z pyramid for the next frame is downsampled on the async compute queue while the light pass runs on the graphics queue
+	// Ignored when the device has no compute queue separate from the graphics one
+	inline void SetAsyncComputeEnabled(bool Enabled) { mAsyncComputeEnabled = Enabled; }
+	bool IsAsyncComputeEnabled() const;
+
+	inline void SetLightingMode(LightingMode Mode) { mLightingMode = Mode; }
+	inline LightingMode GetLightingMode() const { return mLightingMode; }
+
+	// Auto mode needs precise occlusion queries to measure the overdraw, without them it acts as disabled
+	inline void SetDepthPrePassMode(DepthPrePassMode Mode) { mDepthPrePassMode = Mode; }
+	inline DepthPrePassMode GetDepthPrePassMode() const { return mDepthPrePassMode; }
+	bool IsDepthPrePassActive() const;
+
+	// Overdraw above which the auto mode enables the pre-pass, it's disabled again once the overdraw drops below DepthPrePassHysteresis of it
+	inline void SetDepthPrePassThreshold(float Overdraw) { mDepthPrePassThreshold = Overdraw; }
+	inline float GetDepthPrePassThreshold() const { return mDepthPrePassThreshold; }
+
+	// Blit falls back to the screen pass when swapchain's images can't be a transfer destination
+	void SetPresentMode(PresentMode Mode);
+	inline PresentMode GetPresentMode() const { return mPresentMode; }
+
 private:
+	struct RenderableData
+	{
+		StaticMeshHandle* MeshHandle;
+		glm::mat4 Transform;
+		glm::mat4 MVP; // Of the visible renderables, computed once for the base pass and the pre-pass
+		int32_t Id = -1;
+		int32_t Lod = 0;
+		int32_t DynamicOffsetsIdx = -1; // First of the renderable's dynamic offsets inside the arena
+		uint32_t ObjectIdx = 0; // Index of the renderable's data inside the object buffer
+		uint64_t TextureKey = 0; // Image and sampler indices that have to be the same for all instances of one draw
+		bool Instanceable = true; // False when the indices don't fit into the texture key
+	};
+
+	using RenderableDataList = std::vector<RenderableData>;
+
+	// Draw packets [Begin, End) that use the pipeline
+	struct PipelineRange
+	{
+		uint32_t PipelineId = 0;
+		uint32_t Begin = 0;
+		uint32_t End = 0;
+	};
 
 	std::vector<upSemaphore> mImageReadyToDraw;
 	std::vector<upSemaphore> mImageReadyToPresent;
@@ -55,31 +218,129 @@ private:
 	std::unique_ptr<CommandBuffer> mBasePassCommandBuffer;
 	std::unique_ptr<Framebuffer> mBasePassFramebuffer;
 	std::unique_ptr<RenderPass> mBasePassRenderPass;
+	std::unique_ptr<RenderPass> mBasePassLoadRenderPass; // Continues the base pass after the second phase of occlusion culling
+	std::unique_ptr<RenderPass> mGBufferRenderPass; // Base pass after the depth pre-pass, clears the colors and keeps the depth
+
+	// Depth pre-pass, draws positions of SceneData's components into the base pass' depth buffer
+	static constexpr float DepthPrePassHysteresis = 0.75f;
+
+	std::unique_ptr<RenderPass> mDepthPrePassRenderPass; // Depth only
+	std::unique_ptr<Framebuffer> mDepthPrePassFramebuffer;
+	IGraphicsPipeline* mDepthPrePassPipeline = nullptr;
+	uint32_t mDepthPrePassPipelineId = 0; // Its variants match cull modes of the materials
+
+	// Mirror of the structure in DepthPrePass.vert
+	struct DepthObjectData
+	{
+		glm::mat4 MVP;
+		glm::vec4 PositionScale;
+		glm::vec4 PositionBias;
+	};
+	static_assert(sizeof(DepthObjectData) == 96, "Invalid size of DepthObjectData");
+
+	// Pre-pass data of the packets it draws in their order, draws of the same submesh become instances of one draw
+	std::vector<DepthObjectData> mDepthPrePassObjects;
+	std::unique_ptr<Buffer> mDepthPrePassObjectBuffer;
+	uint32_t mDepthPrePassObjectsCapacity = 0;
+	upDescriptorInst mDepthPrePassDescriptorInst;
+	DepthPrePassMode mDepthPrePassMode = DepthPrePassMode::AUTO;
+	float mDepthPrePassThreshold = 2.0f;
+	bool mDepthPrePassAutoEnabled = false; // Decision of the auto mode from the last measured overdraw
+	float mMeasuredOverdraw = 0.0f;
+
+	// Samples that passed the depth test in the first depth tested pass of SceneData's components, one pool per frame in flight
+	struct FrameOverdraw
+	{
+		upOcclusionQueryPool Pool;
+		bool Written = false;
+	};
 
+	std::vector<FrameOverdraw> mFrameOverdraw;
+	uint32_t mFrameOverdrawIdx = 0;
+
+	void ReadOverdraw(FrameOverdraw& Overdraw);
+
+	// Opaque states that write depth with a less test, packets of other states aren't drawn by the depth pre-pass
+	static bool IsDrawnByDepthPrePass(const PipelineState& State);
+
+	GBufferSettings mGBufferSettings;
 	upImage mDepthBuffer;
 	upImageView mDepthView;
+	upImageView mDepthSampleView; // Without the stencil aspect, read by the light pass
 	upImage mColorBuffer;
 	upImageView mColorView;
 	upImage mNormalBuffer;
 	upImageView mNormalView;
-	upImage mPositionBuffer;
-	upImageView mPositionView;
 
 	upSemaphore mBasePassReady;
 
 	// Materials
-	using UBTemplate = std::pair<uint32_t, upUniformBufferList>;
-	using UBTemplates = std::vector<UBTemplate>;
-	
-	std::map<PipelineManager::KeyType, upImageArrayManager> mImageArrayManagers;
-	std::map<PipelineManager::KeyType, UBTemplates> mMaterialUniformBuffers;
-	std::map<PipelineManager::KeyType, upDescriptorInstList> mDescriptorInstances;
-	int32_t mMaxElementsInUB = 32;
+	struct UniformBinding
+	{
+		uint32_t Binding = 0;
+		uint32_t Size = 0;
+	};
+
+	// Keyed by pipeline id
+	std::map<uint32_t, upImageArrayManager> mImageArrayManagers;
+	std::map<uint32_t, std::vector<UniformBinding>> mUniformBindings;
+	std::map<uint32_t, upDescriptorInst> mDescriptorInstances;
+	upUniformArena mUniformArena;
+	std::map<uint32_t, upUniformArena> mObjectBuffers;
+	bool mObjectBufferEnabled = false;
+	bool mInstancingEnabled = true;
 
 	std::map<PipelineManager::KeyType, upDescriptorInst> mImageArraysDescriptorInstances;
 
-	inline int32_t GetBufferIDByIndex(int32_t Index) { return Index / mMaxElementsInUB; }
-	inline int32_t GetEntryIDByIndex(int32_t Index) { return Index % mMaxElementsInUB; }
+	upGPUScene mGPUScene;
+
+	// Occlusion culling
+	upHiZBuffer mHiZBuffer;
+	glm::mat4 mHiZViewProjection = glm::mat4(1.0f); // View projection the pyramid was rendered with
+	bool mOcclusionCullingEnabled = false;
+
+	// Async compute, its work of one frame has to finish before the next frame's base pass reads the results
+	bool mAsyncComputeEnabled = false;
+	bool mAsyncComputePending = false; // Results of the last submission weren't acquired by the graphics queue yet
+	std::unique_ptr<CommandBuffer> mAsyncComputeCommandBuffer;
+	upFence mAsyncComputeFence; // Guards the command buffer before it's recorded again
+	upSemaphore mAsyncComputeStart;
+	upSemaphore mAsyncComputeDone;
+
+	// Timestamps, one pool per frame in flight so a pool is read only after both queues are done with it
+	enum TimestampQuery : uint32_t { BASE_PASS_BEGIN = 0, BASE_PASS_END, LIGHT_PASS_BEGIN, LIGHT_PASS_END, ASYNC_COMPUTE_BEGIN, ASYNC_COMPUTE_END, TIMESTAMPS_COUNT };
+
+	struct FrameTimestamps
+	{
+		upTimestampQueryPool Pool;
+		bool Written = false;
+		bool AsyncComputeWritten = false;
+	};
+
+	std::vector<FrameTimestamps> mFrameTimestamps;
+	uint32_t mFrameTimestampsIdx = 0;
+
+	void ReadGPUTimings(FrameTimestamps& Timestamps);
+
+	// Frustum culling, kept between frames to reuse the memory
+	RenderableDataList mCullingCandidates;
+	SphereBoundsList mWorldBounds; // Parallel to mCullingCandidates
+	std::vector<uint8_t> mCandidatesVisibility;
+
+	// Draw packets of visible candidates, sorted by their keys every frame
+	std::vector<DrawPacket> mDrawPackets;
+	std::vector<DrawPacket> mDrawPacketsScratch;
+	std::vector<PipelineRange> mPipelineRanges;
+	std::unordered_map<uint64_t, uint32_t> mMaterialIds; // Texture key -> material id of the current frame
+	bool mFrustumCullingEnabled = true;
+	CullingPath mCullingPath = FrustumCulling::GetSupportedPath();
+
+	SoftwareOcclusionBuffer mSoftwareOcclusion;
+	std::vector<glm::vec3> mOccluderPositions; // Kept between occluders to reuse the memory
+	bool mSoftwareOcclusionEnabled = false;
+
+	bool mLodEnabled = true;
+	float mLodHysteresis = 0.1f;
 
 	// Light pass
 	std::unique_ptr<CommandBuffer> mLightPassCommandBuffer;
@@ -89,7 +350,17 @@ private:
 	upShaderParameters mDirectionalLightPassShaderParams;
 	upDescriptorInst mDirectionalLightPassDescriporInst;
 
-	upImage mSceneBuffer;
+	LightingMode mLightingMode = LightingMode::TILED;
+	upTiledLighting mTiledLighting;
+	upShaderParameters mTiledLightPassShaderParams;
+	upDescriptorInst mTiledLightPassDescriporInst;
+
+	upShaderParameters mLocalLightPassShaderParams;
+	upDescriptorInst mLocalLightPassDescriporInst;
+
+	PresentMode mPresentMode = PresentMode::SCREEN_PASS;
+
+	upImage mSceneBuffer; // In swapchain's format, so the light pass' pipelines are also compatible with the screen's render pass
 	upImageView mSceneView;
 
 	upSemaphore mLightPassReady;
@@ -101,7 +372,7 @@ private:
 	upShaderParameters mScreenShaderParams;
 	upDescriptorInst mScreenDescriporInst;
 
-	std::unique_ptr<Buffer> mScreenVertexBuffer;
+	RendererStats mFrameStats;
 
 
 };
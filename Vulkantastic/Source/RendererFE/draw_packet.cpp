@@ -0,0 +1,57 @@
+#include "draw_packet.h"
+
+void SortDrawPackets(std::vector<DrawPacket>& Packets, std::vector<DrawPacket>& Scratch)
+{
+	const uint32_t PassesCount = sizeof(uint64_t);
+	const uint32_t BucketsCount = 256;
+
+	// Histograms of all passes are gathered at once
+	uint32_t Histograms[PassesCount][BucketsCount] = {};
+
+	for (const DrawPacket& Packet : Packets)
+	{
+		for (uint32_t Pass = 0; Pass < PassesCount; ++Pass)
+		{
+			++Histograms[Pass][(Packet.SortKey >> (Pass * 8)) & 0xFF];
+		}
+	}
+
+	const uint32_t PacketsCount = static_cast<uint32_t>(Packets.size());
+
+	Scratch.resize(PacketsCount);
+
+	DrawPacket* Source = Packets.data();
+	DrawPacket* Destination = Scratch.data();
+
+	for (uint32_t Pass = 0; Pass < PassesCount; ++Pass)
+	{
+		uint32_t* Histogram = Histograms[Pass];
+		const uint32_t Shift = Pass * 8;
+
+		// All keys have the same byte so the pass wouldn't change the order
+		if (PacketsCount == 0 || Histogram[(Source[0].SortKey >> Shift) & 0xFF] == PacketsCount) { continue; }
+
+		uint32_t Offset = 0;
+
+		for (uint32_t Bucket = 0; Bucket < BucketsCount; ++Bucket)
+		{
+			const uint32_t Count = Histogram[Bucket];
+			Histogram[Bucket] = Offset;
+			Offset += Count;
+		}
+
+		for (uint32_t i = 0; i < PacketsCount; ++i)
+		{
+			Destination[Histogram[(Source[i].SortKey >> Shift) & 0xFF]++] = Source[i];
+		}
+
+		DrawPacket* Temp = Source;
+		Source = Destination;
+		Destination = Temp;
+	}
+
+	if (Source != Packets.data())
+	{
+		Packets.swap(Scratch);
+	}
+}
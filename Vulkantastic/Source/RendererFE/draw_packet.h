@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "../Utilities/assert.h"
+
+// One submesh to draw, sorted by its key so draws come out grouped by state and front to back inside of a group
+struct DrawPacket
+{
+	uint64_t SortKey = 0;
+	uint32_t RenderableIdx = 0;
+};
+
+// Layout of the sort key, from the most significant bits:
+// pipeline (10) | material (14) | mesh (10) | submesh (6) | level of detail (3) | quantized depth (21)
+namespace DrawKey
+{
+	constexpr uint32_t DepthBits = 21;
+	constexpr uint32_t LodBits = 3;
+	constexpr uint32_t SubmeshBits = 6;
+	constexpr uint32_t MeshBits = 10;
+	constexpr uint32_t MaterialBits = 14;
+	constexpr uint32_t PipelineBits = 10;
+
+	constexpr uint32_t DepthShift = 0;
+	constexpr uint32_t LodShift = DepthShift + DepthBits;
+	constexpr uint32_t SubmeshShift = LodShift + LodBits;
+	constexpr uint32_t MeshShift = SubmeshShift + SubmeshBits;
+	constexpr uint32_t MaterialShift = MeshShift + MeshBits;
+	constexpr uint32_t PipelineShift = MaterialShift + MaterialBits;
+
+	static_assert(PipelineShift + PipelineBits == 64, "Sort key has to use all 64 bits");
+
+	constexpr uint64_t Mask(uint32_t Bits) { return (uint64_t(1) << Bits) - 1; }
+
+	// Depth is the distance along the camera's forward vector divided by the far plane distance
+	inline uint64_t Make(uint32_t PipelineId, uint32_t MaterialId, uint32_t MeshId, uint32_t SubmeshId, uint32_t Lod, float NormalizedDepth)
+	{
+		const float ClampedDepth = NormalizedDepth < 0.0f ? 0.0f : (NormalizedDepth > 1.0f ? 1.0f : NormalizedDepth);
+		const uint64_t Depth = static_cast<uint64_t>(ClampedDepth * Mask(DepthBits));
+
+		return	((PipelineId & Mask(PipelineBits)) << PipelineShift) |
+				((MaterialId & Mask(MaterialBits)) << MaterialShift) |
+				((MeshId & Mask(MeshBits)) << MeshShift) |
+				((SubmeshId & Mask(SubmeshBits)) << SubmeshShift) |
+				((Lod & Mask(LodBits)) << LodShift) |
+				(Depth << DepthShift);
+	}
+
+	inline uint64_t SetMaterial(uint64_t Key, uint32_t MaterialId)
+	{
+		Assert(MaterialId <= Mask(MaterialBits));
+
+		return (Key & ~(Mask(MaterialBits) << MaterialShift)) | ((MaterialId & Mask(MaterialBits)) << MaterialShift);
+	}
+
+	inline uint32_t GetPipeline(uint64_t Key) { return static_cast<uint32_t>(Key >> PipelineShift); }
+}
+
+// Stable LSD radix sort by the sort key, 8 bits per pass
+// Passes over bytes that are the same in all keys are skipped, Scratch is resized to the number of packets
+void SortDrawPackets(std::vector<DrawPacket>& Packets, std::vector<DrawPacket>& Scratch);
@@ -0,0 +1,234 @@
+#define NOMINMAX
+#include "frustum_culling.h"
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CULLING_TARGET_AVX2
+#define CULLING_TARGET_XSAVE
+#else
+#include <cpuid.h>
+#define CULLING_TARGET_AVX2 __attribute__((target("avx2")))
+#define CULLING_TARGET_XSAVE __attribute__((target("xsave")))
+#endif
+
+namespace
+{
+	struct SphereStreams
+	{
+		const float* X;
+		const float* Y;
+		const float* Z;
+		const float* Radius;
+	};
+
+	uint32_t CullScalar(const Frustum& ViewFrustum, const SphereStreams& Spheres, uint32_t Begin, uint32_t End, uint8_t* Visible)
+	{
+		uint32_t VisibleCount = 0;
+
+		for (uint32_t i = Begin; i < End; ++i)
+		{
+			bool Inside = true;
+
+			for (const glm::vec4& Plane : ViewFrustum.Planes)
+			{
+				Inside &= Plane.x * Spheres.X[i] + Plane.y * Spheres.Y[i] + Plane.z * Spheres.Z[i] + Plane.w >= -Spheres.Radius[i];
+			}
+
+			Visible[i] = Inside ? 1 : 0;
+			VisibleCount += Visible[i];
+		}
+
+		return VisibleCount;
+	}
+
+	uint32_t CullSSE(const Frustum& ViewFrustum, const SphereStreams& Spheres, uint32_t Count, uint8_t* Visible)
+	{
+		__m128 PlaneX[Frustum::PLANES_COUNT];
+		__m128 PlaneY[Frustum::PLANES_COUNT];
+		__m128 PlaneZ[Frustum::PLANES_COUNT];
+		__m128 PlaneW[Frustum::PLANES_COUNT];
+
+		for (int32_t p = 0; p < Frustum::PLANES_COUNT; ++p)
+		{
+			PlaneX[p] = _mm_set1_ps(ViewFrustum.Planes[p].x);
+			PlaneY[p] = _mm_set1_ps(ViewFrustum.Planes[p].y);
+			PlaneZ[p] = _mm_set1_ps(ViewFrustum.Planes[p].z);
+			PlaneW[p] = _mm_set1_ps(ViewFrustum.Planes[p].w);
+		}
+
+		const __m128 Zero = _mm_setzero_ps();
+		uint32_t VisibleCount = 0;
+		uint32_t i = 0;
+
+		for (; i + 4 <= Count; i += 4)
+		{
+			const __m128 X = _mm_loadu_ps(Spheres.X + i);
+			const __m128 Y = _mm_loadu_ps(Spheres.Y + i);
+			const __m128 Z = _mm_loadu_ps(Spheres.Z + i);
+			const __m128 NegRadius = _mm_sub_ps(Zero, _mm_loadu_ps(Spheres.Radius + i));
+
+			__m128 Inside = _mm_cmpeq_ps(Zero, Zero);
+
+			for (int32_t p = 0; p < Frustum::PLANES_COUNT; ++p)
+			{
+				// Same order of operations as the scalar path, so all paths give the same results
+				__m128 Distance = _mm_add_ps(_mm_mul_ps(PlaneX[p], X), _mm_mul_ps(PlaneY[p], Y));
+				Distance = _mm_add_ps(Distance, _mm_mul_ps(PlaneZ[p], Z));
+				Distance = _mm_add_ps(Distance, PlaneW[p]);
+
+				Inside = _mm_and_ps(Inside, _mm_cmpge_ps(Distance, NegRadius));
+			}
+
+			const int32_t Mask = _mm_movemask_ps(Inside);
+
+			for (uint32_t j = 0; j < 4; ++j)
+			{
+				Visible[i + j] = (Mask >> j) & 1;
+				VisibleCount += Visible[i + j];
+			}
+		}
+
+		return VisibleCount + CullScalar(ViewFrustum, Spheres, i, Count, Visible);
+	}
+
+	CULLING_TARGET_AVX2 uint32_t CullAVX2(const Frustum& ViewFrustum, const SphereStreams& Spheres, uint32_t Count, uint8_t* Visible)
+	{
+		__m256 PlaneX[Frustum::PLANES_COUNT];
+		__m256 PlaneY[Frustum::PLANES_COUNT];
+		__m256 PlaneZ[Frustum::PLANES_COUNT];
+		__m256 PlaneW[Frustum::PLANES_COUNT];
+
+		for (int32_t p = 0; p < Frustum::PLANES_COUNT; ++p)
+		{
+			PlaneX[p] = _mm256_set1_ps(ViewFrustum.Planes[p].x);
+			PlaneY[p] = _mm256_set1_ps(ViewFrustum.Planes[p].y);
+			PlaneZ[p] = _mm256_set1_ps(ViewFrustum.Planes[p].z);
+			PlaneW[p] = _mm256_set1_ps(ViewFrustum.Planes[p].w);
+		}
+
+		const __m256 Zero = _mm256_setzero_ps();
+		uint32_t VisibleCount = 0;
+		uint32_t i = 0;
+
+		for (; i + 8 <= Count; i += 8)
+		{
+			const __m256 X = _mm256_loadu_ps(Spheres.X + i);
+			const __m256 Y = _mm256_loadu_ps(Spheres.Y + i);
+			const __m256 Z = _mm256_loadu_ps(Spheres.Z + i);
+			const __m256 NegRadius = _mm256_sub_ps(Zero, _mm256_loadu_ps(Spheres.Radius + i));
+
+			__m256 Inside = _mm256_cmp_ps(Zero, Zero, _CMP_EQ_OQ);
+
+			for (int32_t p = 0; p < Frustum::PLANES_COUNT; ++p)
+			{
+				// Fused multiply-add rounds once, so it could disagree with the other paths for spheres touching a plane
+				__m256 Distance = _mm256_add_ps(_mm256_mul_ps(PlaneX[p], X), _mm256_mul_ps(PlaneY[p], Y));
+				Distance = _mm256_add_ps(Distance, _mm256_mul_ps(PlaneZ[p], Z));
+				Distance = _mm256_add_ps(Distance, PlaneW[p]);
+
+				Inside = _mm256_and_ps(Inside, _mm256_cmp_ps(Distance, NegRadius, _CMP_GE_OQ));
+			}
+
+			const int32_t Mask = _mm256_movemask_ps(Inside);
+
+			for (uint32_t j = 0; j < 8; ++j)
+			{
+				Visible[i + j] = (Mask >> j) & 1;
+				VisibleCount += Visible[i + j];
+			}
+		}
+
+		return VisibleCount + CullScalar(ViewFrustum, Spheres, i, Count, Visible);
+	}
+
+	void CPUID(int32_t Info[4], int32_t Function, int32_t SubFunction)
+	{
+#if defined(_MSC_VER)
+		__cpuidex(Info, Function, SubFunction);
+#else
+		uint32_t Regs[4] = {};
+		__get_cpuid_count(Function, SubFunction, &Regs[0], &Regs[1], &Regs[2], &Regs[3]);
+		for (int32_t i = 0; i < 4; ++i) { Info[i] = static_cast<int32_t>(Regs[i]); }
+#endif
+	}
+
+	CULLING_TARGET_XSAVE bool IsAVX2Supported()
+	{
+		int32_t Info[4] = {};
+
+		CPUID(Info, 0, 0);
+		if (Info[0] < 7) { return false; }
+
+		CPUID(Info, 1, 0);
+		const bool OSXSave = (Info[2] & (1 << 27)) != 0;
+		const bool AVX = (Info[2] & (1 << 28)) != 0;
+
+		if (!OSXSave || !AVX) { return false; }
+
+		// OS has to save the upper halves of the YMM registers
+		const uint64_t XCR0 = _xgetbv(0);
+		if ((XCR0 & 6) != 6) { return false; }
+
+		CPUID(Info, 7, 0);
+		return (Info[1] & (1 << 5)) != 0;
+	}
+}
+
+CullingPath FrustumCulling::GetSupportedPath()
+{
+	// SSE2 is a part of x64 so only AVX2 has to be checked
+	static const CullingPath SupportedPath = IsAVX2Supported() ? CullingPath::AVX2 : CullingPath::SSE;
+	return SupportedPath;
+}
+
+void SphereBoundsList::Clear()
+{
+	mCenterX.clear();
+	mCenterY.clear();
+	mCenterZ.clear();
+	mRadius.clear();
+}
+
+void SphereBoundsList::Reserve(uint32_t Count)
+{
+	mCenterX.reserve(Count);
+	mCenterY.reserve(Count);
+	mCenterZ.reserve(Count);
+	mRadius.reserve(Count);
+}
+
+uint32_t SphereBoundsList::Add(const BoundingSphere& Sphere)
+{
+	mCenterX.push_back(Sphere.Center.x);
+	mCenterY.push_back(Sphere.Center.y);
+	mCenterZ.push_back(Sphere.Center.z);
+	mRadius.push_back(Sphere.Radius);
+
+	return GetCount() - 1;
+}
+
+uint32_t SphereBoundsList::Cull(const Frustum& ViewFrustum, std::vector<uint8_t>& Visible, CullingPath Path) const
+{
+	const uint32_t Count = GetCount();
+
+	Visible.resize(Count);
+
+	if (Count == 0) { return 0; }
+
+	const SphereStreams Spheres = { mCenterX.data(), mCenterY.data(), mCenterZ.data(), mRadius.data() };
+
+	if (Path == CullingPath::AVX2 && FrustumCulling::GetSupportedPath() != CullingPath::AVX2)
+	{
+		Path = CullingPath::SSE;
+	}
+
+	switch (Path)
+	{
+	case CullingPath::AVX2:
+		return CullAVX2(ViewFrustum, Spheres, Count, Visible.data());
+	case CullingPath::SSE:
+		return CullSSE(ViewFrustum, Spheres, Count, Visible.data());
+	default:
+		return CullScalar(ViewFrustum, Spheres, 0, Count, Visible.data());
+	}
+}
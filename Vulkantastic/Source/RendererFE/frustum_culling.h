@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+#include "bounds.h"
+
+enum class CullingPath : uint8_t
+{
+	SCALAR = 0,
+	SSE, // 4 spheres per iteration
+	AVX2 // 8 spheres per iteration
+};
+
+namespace FrustumCulling
+{
+	// The widest path supported by the CPU and the OS
+	CullingPath GetSupportedPath();
+}
+
+// World bounding spheres kept as a struct of arrays so several of them can be tested against the frustum at once
+class SphereBoundsList
+{
+public:
+	void Clear();
+	void Reserve(uint32_t Count);
+
+	// Returns index of the added sphere
+	uint32_t Add(const BoundingSphere& Sphere);
+
+	inline uint32_t GetCount() const { return static_cast<uint32_t>(mRadius.size()); }
+	inline glm::vec3 GetCenter(uint32_t Index) const { return { mCenterX[Index], mCenterY[Index], mCenterZ[Index] }; }
+	inline float GetRadius(uint32_t Index) const { return mRadius[Index]; }
+
+	// Writes 1 for spheres that intersect the frustum and 0 for the rest, returns the number of visible spheres
+	// Paths that aren't supported by the CPU fall back to the widest supported one
+	uint32_t Cull(const Frustum& ViewFrustum, std::vector<uint8_t>& Visible, CullingPath Path) const;
+
+private:
+	std::vector<float> mCenterX;
+	std::vector<float> mCenterY;
+	std::vector<float> mCenterZ;
+	std::vector<float> mRadius;
+
+};
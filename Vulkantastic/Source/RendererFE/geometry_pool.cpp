@@ -0,0 +1,262 @@
+#define NOMINMAX
+#include <cstring>
+#include "geometry_pool.h"
+#include "../Renderer/buffer.h"
+#include "../Renderer/core.h"
+#include "../Renderer/device.h"
+#include "../Utilities/assert.h"
+
+FreeRangeList::FreeRangeList(uint32_t Size /*= 0*/)
+{
+	Grow(Size);
+}
+
+uint32_t FreeRangeList::Allocate(uint32_t Size)
+{
+	for (auto It = mRanges.begin(); It != mRanges.end(); ++It)
+	{
+		if (It->Size < Size) { continue; }
+
+		const uint32_t Offset = It->Offset;
+
+		It->Offset += Size;
+		It->Size -= Size;
+
+		if (It->Size == 0)
+		{
+			mRanges.erase(It);
+		}
+
+		mFreeSize -= Size;
+
+		return Offset;
+	}
+
+	return InvalidOffset;
+}
+
+void FreeRangeList::Free(uint32_t Offset, uint32_t Size)
+{
+	if (Size == 0) { return; }
+
+	Assert(Offset + Size <= mSize);
+
+	auto Next = std::lower_bound(mRanges.begin(), mRanges.end(), Offset, [](const Range& Lhs, uint32_t Value) {
+		return Lhs.Offset < Value;
+	});
+
+	Assert(Next == mRanges.end() || Offset + Size <= Next->Offset);
+
+	mFreeSize += Size;
+
+	const bool MergeWithPrevious = Next != mRanges.begin() && std::prev(Next)->Offset + std::prev(Next)->Size == Offset;
+	const bool MergeWithNext = Next != mRanges.end() && Offset + Size == Next->Offset;
+
+	if (MergeWithPrevious && MergeWithNext)
+	{
+		std::prev(Next)->Size += Size + Next->Size;
+		mRanges.erase(Next);
+	}
+	else if (MergeWithPrevious)
+	{
+		std::prev(Next)->Size += Size;
+	}
+	else if (MergeWithNext)
+	{
+		Next->Offset = Offset;
+		Next->Size += Size;
+	}
+	else
+	{
+		mRanges.insert(Next, { Offset, Size });
+	}
+}
+
+void FreeRangeList::Grow(uint32_t NewSize)
+{
+	if (NewSize <= mSize) { return; }
+
+	const uint32_t PreviousSize = mSize;
+	mSize = NewSize;
+
+	Free(PreviousSize, NewSize - PreviousSize);
+}
+
+GeometryPool::GeometryPool(const VertexFormatDeclaration& Format, uint32_t VerticesCapacity, uint32_t IndicesCapacity)
+	: mVertexStride(static_cast<uint32_t>(Format.Size))
+{
+	auto Position = std::find_if(Format.Members.begin(), Format.Members.end(), [](const VertexAttribute& Member) {
+		return strcmp(Member.Name, "Position") == 0;
+	});
+
+	if (Position != Format.Members.end() && Position->Size < mVertexStride)
+	{
+		mPositionStride = Position->Size;
+		mPositionOffset = Position->Offset;
+	}
+
+	GrowVertices(VerticesCapacity);
+
+	GrowBuffer(mIndexBuffer16, 0, IndicesCapacity, sizeof(uint16_t), false);
+	mIndexRanges16.Grow(IndicesCapacity);
+
+	GrowBuffer(mIndexBuffer32, 0, IndicesCapacity / 4, sizeof(uint32_t), false);
+	mIndexRanges32.Grow(IndicesCapacity / 4);
+}
+
+GeometryPool::~GeometryPool()
+{
+
+}
+
+GeometryRange GeometryPool::Add(const void* Vertices, uint32_t VerticesCount, const uint32_t* Indices, uint32_t IndicesCount)
+{
+	GeometryRange Result = {};
+
+	if (VerticesCount == 0 || IndicesCount == 0) { return Result; }
+
+	uint32_t VertexOffset = mVertexRanges.Allocate(VerticesCount);
+
+	if (VertexOffset == FreeRangeList::InvalidOffset)
+	{
+		GrowVertices(mVertexRanges.GetSize() + VerticesCount);
+		VertexOffset = mVertexRanges.Allocate(VerticesCount);
+	}
+
+	// Indices are relative to the vertex offset, so only the submesh's own vertex count matters
+	const IndexType Type = VerticesCount <= 65536 ? IndexType::UINT16 : IndexType::UINT32;
+	const uint32_t FirstIndex = AllocateIndices(Type, IndicesCount);
+
+	Assert(VertexOffset != FreeRangeList::InvalidOffset && FirstIndex != FreeRangeList::InvalidOffset);
+
+	mVertexBuffer->UploadData(Vertices, VerticesCount * mVertexStride, VertexOffset * mVertexStride);
+
+	if (mPositionBuffer)
+	{
+		std::vector<uint8_t> Positions(VerticesCount * mPositionStride);
+		const uint8_t* Source = static_cast<const uint8_t*>(Vertices) + mPositionOffset;
+
+		for (uint32_t i = 0; i < VerticesCount; ++i)
+		{
+			memcpy(Positions.data() + i * mPositionStride, Source + i * mVertexStride, mPositionStride);
+		}
+
+		mPositionBuffer->UploadData(Positions.data(), VerticesCount * mPositionStride, VertexOffset * mPositionStride);
+	}
+
+	if (Type == IndexType::UINT16)
+	{
+		const std::vector<uint16_t> NarrowIndices(Indices, Indices + IndicesCount);
+		mIndexBuffer16->UploadData(NarrowIndices.data(), IndicesCount * sizeof(uint16_t), FirstIndex * sizeof(uint16_t));
+	}
+	else
+	{
+		mIndexBuffer32->UploadData(Indices, IndicesCount * sizeof(uint32_t), FirstIndex * sizeof(uint32_t));
+	}
+
+	Result.FirstIndex = FirstIndex;
+	Result.IndexCount = IndicesCount;
+	Result.VertexOffset = static_cast<int32_t>(VertexOffset);
+	Result.VertexCount = VerticesCount;
+	Result.Type = Type;
+
+	return Result;
+}
+
+void GeometryPool::Remove(const GeometryRange& Range)
+{
+	if (!Range.IsValid()) { return; }
+
+	// New geometry uploaded into the range right away could overwrite it while the frame in flight reads it
+	mPendingRemovals.push_back(Range);
+}
+
+void GeometryPool::ApplyRemovals()
+{
+	for (const GeometryRange& Range : mPendingRemovals)
+	{
+		mVertexRanges.Free(static_cast<uint32_t>(Range.VertexOffset), Range.VertexCount);
+		(Range.Type == IndexType::UINT16 ? mIndexRanges16 : mIndexRanges32).Free(Range.FirstIndex, Range.IndexCount);
+	}
+
+	mPendingRemovals.clear();
+}
+
+uint64_t GeometryPool::GetUsedBytes() const
+{
+	return static_cast<uint64_t>(GetUsedVertices()) * (mVertexStride + mPositionStride) + GetUsedIndices(IndexType::UINT16) * sizeof(uint16_t) + GetUsedIndices(IndexType::UINT32) * sizeof(uint32_t);
+}
+
+uint32_t GeometryPool::AllocateIndices(IndexType Type, uint32_t IndicesCount)
+{
+	std::unique_ptr<Buffer>& IndexBuffer = Type == IndexType::UINT16 ? mIndexBuffer16 : mIndexBuffer32;
+	FreeRangeList& Ranges = Type == IndexType::UINT16 ? mIndexRanges16 : mIndexRanges32;
+	const uint32_t Stride = Type == IndexType::UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+
+	uint32_t FirstIndex = Ranges.Allocate(IndicesCount);
+
+	if (FirstIndex == FreeRangeList::InvalidOffset)
+	{
+		const uint32_t NewSize = std::max(Ranges.GetSize() * 2, Ranges.GetSize() + IndicesCount);
+
+		GrowBuffer(IndexBuffer, Ranges.GetSize(), NewSize, Stride, false);
+		Ranges.Grow(NewSize);
+
+		FirstIndex = Ranges.Allocate(IndicesCount);
+	}
+
+	return FirstIndex;
+}
+
+void GeometryPool::GrowVertices(uint32_t MinSize)
+{
+	// Both vertex streams keep the same capacity, so the vertex ranges hold for both of them
+	const uint32_t NewSize = std::max(mVertexRanges.GetSize() * 2, MinSize);
+
+	GrowBuffer(mVertexBuffer, mVertexRanges.GetSize(), NewSize, mVertexStride, true);
+
+	if (mPositionStride > 0)
+	{
+		GrowBuffer(mPositionBuffer, mVertexRanges.GetSize(), NewSize, mPositionStride, true);
+	}
+
+	mVertexRanges.Grow(NewSize);
+}
+
+void GeometryPool::GrowBuffer(std::unique_ptr<Buffer>& BufferToGrow, uint32_t Size, uint32_t NewSize, uint32_t Stride, bool Vertex)
+{
+	const uint32_t GraphicsQueueIndex = VulkanCore::Get().GetDevice()->GetQueuesIndicies().GraphicsIndex;
+
+	const BufferUsage Usage = (Vertex ? BufferUsage::VERTEX : BufferUsage::INDEX) | BufferUsage::TRANSFER_DST | BufferUsage::TRANSFER_SRC;
+
+	auto NewBuffer = std::make_unique<Buffer>(std::vector<uint32_t>{ GraphicsQueueIndex }, Usage, true, NewSize * Stride);
+
+	if (BufferToGrow)
+	{
+		// Previous buffer can still be used by the frame in flight
+		VulkanCore::Get().WaitForGPU();
+
+		NewBuffer->CopyFromBuffer(BufferToGrow.get(), Size * Stride);
+	}
+
+	BufferToGrow = std::move(NewBuffer);
+}
+
+bool GeometryPoolManager::Startup()
+{
+	return true;
+}
+
+void GeometryPoolManager::ApplyRemovals()
+{
+	for (auto& Pool : mPools)
+	{
+		Pool.second->ApplyRemovals();
+	}
+}
+
+bool GeometryPoolManager::Shutdown()
+{
+	mPools.clear();
+	return true;
+}
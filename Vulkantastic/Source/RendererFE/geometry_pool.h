@@ -0,0 +1,157 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <map>
+#include "../Renderer/vertex_definitions.h"
+#include "../Renderer/buffer.h"
+
+// Free ranges of elements inside of a fixed size storage, allocation takes the first range that fits
+class FreeRangeList
+{
+public:
+	static constexpr uint32_t InvalidOffset = ~0u;
+
+	explicit FreeRangeList(uint32_t Size = 0);
+
+	// Returns InvalidOffset when no free range is big enough
+	uint32_t Allocate(uint32_t Size);
+
+	// Neighbouring free ranges are merged
+	void Free(uint32_t Offset, uint32_t Size);
+
+	// Adds the space between the previous and the new size at the end
+	void Grow(uint32_t NewSize);
+
+	inline uint32_t GetSize() const { return mSize; }
+	inline uint32_t GetFreeSize() const { return mFreeSize; }
+
+private:
+	struct Range
+	{
+		uint32_t Offset = 0;
+		uint32_t Size = 0;
+	};
+
+	std::vector<Range> mRanges; // Sorted by offset
+	uint32_t mSize = 0;
+	uint32_t mFreeSize = 0;
+
+};
+
+// Part of a geometry pool that holds one submesh
+struct GeometryRange
+{
+	uint32_t FirstIndex = 0;
+	uint32_t IndexCount = 0;
+	int32_t VertexOffset = 0;
+	uint32_t VertexCount = 0;
+	IndexType Type = IndexType::UINT32; // Selects the pool's index buffer FirstIndex points into
+
+	inline bool IsValid() const { return IndexCount > 0; }
+};
+
+// Vertex and index buffers shared by all meshes of one vertex format, so they can be bound once and drawn with offsets
+class GeometryPool
+{
+public:
+	GeometryPool(const VertexFormatDeclaration& Format, uint32_t VerticesCapacity, uint32_t IndicesCapacity);
+	~GeometryPool();
+
+	GeometryPool(const GeometryPool& Rhs) = delete;
+	GeometryPool& operator=(const GeometryPool& Rhs) = delete;
+
+	GeometryPool(GeometryPool&& Rhs) = delete;
+	GeometryPool& operator=(GeometryPool&& Rhs) = delete;
+
+	// Buffers grow when the geometry doesn't fit, which waits for the GPU
+	// Indices of geometry with at most 65536 vertices are stored as 16-bit
+	GeometryRange Add(const void* Vertices, uint32_t VerticesCount, const uint32_t* Indices, uint32_t IndicesCount);
+
+	// Range is freed by the next ApplyRemovals, frames that are still in flight can keep drawing it
+	void Remove(const GeometryRange& Range);
+
+	// Frees the removed ranges, has to be called when no frame that was submitted before their removal is in flight
+	void ApplyRemovals();
+
+	inline Buffer* GetVertexBuffer() const { return mVertexBuffer.get(); }
+
+	// Positions of the vertices packed tightly at the same vertex offsets, nullptr when the format has no other members
+	// Depth only passes fetch less memory through it
+	inline Buffer* GetPositionBuffer() const { return mPositionBuffer.get(); }
+	inline uint32_t GetPositionStride() const { return mPositionStride; }
+	inline Buffer* GetIndexBuffer(IndexType Type) const { return Type == IndexType::UINT16 ? mIndexBuffer16.get() : mIndexBuffer32.get(); }
+	inline uint32_t GetVertexStride() const { return mVertexStride; }
+
+	inline uint32_t GetUsedVertices() const { return mVertexRanges.GetSize() - mVertexRanges.GetFreeSize(); }
+	inline uint32_t GetUsedIndices(IndexType Type) const { return GetIndexRanges(Type).GetSize() - GetIndexRanges(Type).GetFreeSize(); }
+
+	// Memory taken by the vertices and indices of all ranges
+	uint64_t GetUsedBytes() const;
+
+private:
+	void GrowBuffer(std::unique_ptr<Buffer>& BufferToGrow, uint32_t Size, uint32_t NewSize, uint32_t Stride, bool Vertex);
+	void GrowVertices(uint32_t MinSize);
+	uint32_t AllocateIndices(IndexType Type, uint32_t IndicesCount);
+
+	inline const FreeRangeList& GetIndexRanges(IndexType Type) const { return Type == IndexType::UINT16 ? mIndexRanges16 : mIndexRanges32; }
+
+	uint32_t mVertexStride = 0;
+	uint32_t mPositionStride = 0;
+	uint32_t mPositionOffset = 0; // Inside of a vertex
+
+	std::unique_ptr<Buffer> mVertexBuffer;
+	std::unique_ptr<Buffer> mPositionBuffer;
+	std::unique_ptr<Buffer> mIndexBuffer16;
+	std::unique_ptr<Buffer> mIndexBuffer32;
+
+	FreeRangeList mVertexRanges;
+	FreeRangeList mIndexRanges16;
+	FreeRangeList mIndexRanges32;
+
+	std::vector<GeometryRange> mPendingRemovals;
+
+};
+
+using upGeometryPool = std::unique_ptr<GeometryPool>;
+
+class GeometryPoolManager
+{
+public:
+	static GeometryPoolManager& Get()
+	{
+		static GeometryPoolManager* instance = new GeometryPoolManager();
+		return *instance;
+	}
+
+	bool Startup();
+	bool Shutdown();
+
+	// One pool per vertex format, created on the first call
+	template<typename VertexType>
+	GeometryPool* GetPool();
+
+	// Called after the frame fence is waited for, see GeometryPool::ApplyRemovals
+	void ApplyRemovals();
+
+private:
+	GeometryPoolManager() = default;
+
+	std::map<std::string, upGeometryPool> mPools;
+
+};
+
+template<typename VertexType>
+GeometryPool* GeometryPoolManager::GetPool()
+{
+	const VertexFormatDeclaration& Format = VertexType::VertexFormatInfo;
+
+	upGeometryPool& Pool = mPools[Format.Name];
+
+	if (!Pool)
+	{
+		// Enough for a few meshes, pools grow when needed
+		Pool = std::make_unique<GeometryPool>(Format, 64 * 1024, 256 * 1024);
+	}
+
+	return Pool.get();
+}
@@ -0,0 +1,772 @@
+#define NOMINMAX
+#include "gpu_scene.h"
+#include "static_mesh.h"
+#include "bounds.h"
+#include "hiz_buffer.h"
+#include "../Renderer/buffer.h"
+#include "../Renderer/core.h"
+#include "../Renderer/device.h"
+#include "../Renderer/pipeline_manager.h"
+#include "../Renderer/renderer_commands.h"
+#include "../Renderer/command_recorder.h"
+#include "../Renderer/shader_structs.h"
+#include "../Renderer/vertex_definitions.h"
+#include "../Utilities/assert.h"
+
+namespace
+{
+	// Bindings of GPUCulling.comp
+	constexpr int32_t CullingInstancesBinding = 0;
+	constexpr int32_t CullingDrawGroupsBinding = 1;
+	constexpr int32_t CullingCommandsBinding = 2;
+	constexpr int32_t CullingVisibleInstancesBinding = 3;
+	constexpr int32_t CullingFrameBinding = 4;
+
+	// Bindings of GPUMeshletCulling.comp, the first three and the frame match GPUCulling.comp
+	constexpr int32_t MeshletCullingMeshletsBinding = 3;
+	constexpr int32_t MeshletCullingCountersBinding = 5;
+
+	// Bindings of occlusion culling, the meshlet culling shader has them one slot later
+	constexpr int32_t CullingHiZPyramidBinding = 5;
+	constexpr int32_t CullingHiZInfoBinding = 6;
+	constexpr int32_t CullingInstanceStatesBinding = 7;
+	constexpr int32_t CullingOcclusionCountersBinding = 8;
+	constexpr int32_t CullingDrawCountsBinding = 9;
+	constexpr int32_t MeshletCullingBindingsOffset = 1;
+
+	// Bindings of GPUDrivenBasePass.vert
+	constexpr int32_t DrawInstancesBinding = 0;
+	constexpr int32_t DrawDrawGroupsBinding = 1;
+	constexpr int32_t DrawVisibleInstancesBinding = 2;
+	constexpr int32_t DrawFrameBinding = 3;
+
+	constexpr uint32_t ImageArraySetIndex = 0;
+	constexpr uint32_t SceneSetIndex = 1;
+}
+
+GPUScene::GPUScene(const RenderPass& BasePassRenderPass)
+{
+	Shader* CullingShader = ShaderManager::Get().Find("GPUCulling.comp");
+	Shader* MeshletCullingShader = ShaderManager::Get().Find("GPUMeshletCulling.comp");
+	Shader* VertexShader = ShaderManager::Get().Find("GPUDrivenBasePass.vert");
+	Shader* FragmentShader = ShaderManager::Get().Find("GPUDrivenBasePass.frag");
+
+	Assert(CullingShader && MeshletCullingShader && VertexShader && FragmentShader);
+
+	mCullingPipeline = PipelineManager::Get().GetComputePipeline(CullingShader);
+	mMeshletCullingPipeline = PipelineManager::Get().GetComputePipeline(MeshletCullingShader);
+
+	Assert(mCullingPipeline->GetWorkgroupSize().X == CullingGroupSize);
+	Assert(mMeshletCullingPipeline->GetWorkgroupSize().X == MeshletCullingGroupSize);
+
+	PipelineShaders Shaders{ VertexShader, FragmentShader };
+
+	mDrawDescriptorInst = PipelineManager::Get().GetDescriptorInstance<VertexDefinition::StaticMesh>(BasePassRenderPass, Shaders, SceneSetIndex);
+	mDrawPipeline = PipelineManager::Get().GetGraphicsPipeline<VertexDefinition::StaticMesh>(BasePassRenderPass, Shaders);
+
+	mImageArrayManager = std::make_unique<ImageArrayManager>(mDrawPipeline->GetDescriptorManager(), ImageArraySetIndex);
+
+	PrepareBuffers();
+}
+
+GPUScene::~GPUScene()
+{
+
+}
+
+uint32_t GPUScene::AddObject(StaticMeshHandle* MeshHandle, const glm::mat4& Transform, const glm::vec3& Color /*= { 1.0f, 1.0f, 1.0f }*/)
+{
+	Assert(MeshHandle);
+
+	const StaticMesh* Mesh = MeshHandle->GetStaticMesh();
+
+	ObjectRange Range = {};
+	Range.FirstInstance = GetInstancesCount();
+
+	for (int32_t i = 0; i < MeshHandle->GetMaterialsCount(); ++i)
+	{
+		const StaticSurfaceMaterial* Material = MeshHandle->GetMaterial(i);
+
+		// GPU-driven base pass reads only the albedo texture with the repeat sampler
+		const auto& UsedImages = Material->GetUsedImages();
+		const auto& UsedSamplers = Material->GetUsedSamplers();
+
+		const auto Albedo = UsedImages.find("AlbedoIdx");
+		const auto Repeat = UsedSamplers.find("RepeatIdx");
+
+		const std::string AlbedoName = Albedo != UsedImages.end() ? Albedo->second.ImageName : "error";
+		const SamplerSettings SamplerToUse = Repeat != UsedSamplers.end() ? Repeat->second.Settings : RepeatSampler;
+
+		InstanceData Instance = {};
+		Instance.Model = Transform;
+		Instance.Color = glm::vec4(Color, 1.0f);
+		Instance.DrawGroup = FindDrawGroup(Mesh, i, AlbedoName, SamplerToUse);
+
+		const DrawGroup& FirstLodGroup = mDrawGroups[Instance.DrawGroup];
+
+		for (int32_t Lod = 0; Lod < Mesh->GetLodsCount(); ++Lod)
+		{
+			++mDrawGroups[Instance.DrawGroup + Lod].InstancesCount;
+		}
+
+		mVisibleSlotsCount += Mesh->GetLodsCount();
+
+		mMeshletCommandsCount[0] += FirstLodGroup.MeshletsPerInstance[0];
+		mMeshletCommandsCount[1] += FirstLodGroup.MeshletsPerInstance[1];
+		mMeshletStats.TrianglesTotal += Mesh->GetGeometryRange(i).IndexCount / 3;
+
+		mInstances.push_back(Instance);
+	}
+
+	Range.InstancesCount = GetInstancesCount() - Range.FirstInstance;
+
+	Assert(GetInstancesCount() <= (1u << LodShift));
+
+	MarkInstancesDirty(Range.FirstInstance, GetInstancesCount());
+
+	// Visible instances of the following draw groups start further
+	mDrawGroupsDirty = true;
+
+	mObjects.push_back(Range);
+
+	return static_cast<uint32_t>(mObjects.size()) - 1;
+}
+
+void GPUScene::SetTransform(uint32_t ObjectIdx, const glm::mat4& Transform)
+{
+	Assert(ObjectIdx < mObjects.size());
+
+	const ObjectRange& Range = mObjects[ObjectIdx];
+
+	for (uint32_t i = Range.FirstInstance; i < Range.FirstInstance + Range.InstancesCount; ++i)
+	{
+		mInstances[i].Model = Transform;
+	}
+
+	MarkInstancesDirty(Range.FirstInstance, Range.FirstInstance + Range.InstancesCount);
+}
+
+void GPUScene::Clear()
+{
+	mInstances.clear();
+	mObjects.clear();
+	mDrawGroups.clear();
+	mDrawGroupsData.clear();
+	mCommandTemplates.clear();
+	mMeshlets.clear();
+	mDrawRuns.clear();
+
+	mMeshletCommandsCount[0] = mMeshletCommandsCount[1] = 0;
+	mVisibleSlotsCount = 0;
+	mMeshletStats = MeshletCullingStats();
+	mOcclusionStats = OcclusionCullingStats();
+	mOcclusionTested = false;
+
+	mDirtyBegin = mDirtyEnd = 0;
+	mDrawGroupsDirty = true;
+}
+
+uint32_t GPUScene::Cull(CommandBuffer* Cb, const glm::mat4& ViewProjection, const glm::mat4& View, const glm::vec3& CameraPosition, 
+	const HiZBuffer& Occluders, const glm::mat4& OccludersViewProjection)
+{
+	PrepareBuffers();
+
+	uint32_t UploadedBytes = 0;
+
+	// Indices inside the image arrays are assigned again every frame
+	for (uint32_t i = 0; i < GetDrawGroupsCount(); ++i)
+	{
+		const int32_t AlbedoIdx = mImageArrayManager->SetImage(mDrawGroups[i].Albedo);
+		const int32_t SamplerIdx = mImageArrayManager->SetSampler(mDrawGroups[i].Sampler);
+
+		DrawGroupData& Data = mDrawGroupsData[i];
+
+		if (Data.AlbedoIdx != AlbedoIdx || Data.SamplerIdx != SamplerIdx)
+		{
+			Data.AlbedoIdx = AlbedoIdx;
+			Data.SamplerIdx = SamplerIdx;
+			mDrawGroupsDirty = true;
+		}
+	}
+
+	mImageArrayManager->Update();
+
+	if (mDrawGroupsDirty && !mDrawGroups.empty())
+	{
+		// Each draw group gets a range of the visible instances big enough for all of its instances
+		uint32_t FirstVisible = 0;
+
+		// Draws start at the group's first visible instance when the device allows it, otherwise it's passed as a push constant
+		const bool FirstInstanceSupported = VulkanCore::Get().GetDevice()->GetEnabledFeatures().drawIndirectFirstInstance == VK_TRUE;
+
+		mDrawRuns.clear();
+
+		for (uint32_t i = 0; i < GetDrawGroupsCount(); ++i)
+		{
+			const IndexType Type = mDrawGroups[i].Mesh->GetGeometryRange(mDrawGroups[i].Id, mDrawGroups[i].Lod).Type;
+
+			if (mDrawRuns.empty() || mDrawRuns.back().Type != Type)
+			{
+				DrawRun Run = {};
+				Run.Begin = i;
+				Run.Type = Type;
+				mDrawRuns.push_back(Run);
+			}
+
+			mDrawRuns.back().End = i + 1;
+
+			mDrawGroupsData[i].FirstVisible = FirstVisible;
+			mDrawGroupsData[i].DrawRun = static_cast<uint32_t>(mDrawRuns.size()) - 1;
+			mDrawGroupsData[i].DrawRunBegin = mDrawRuns.back().Begin;
+			mCommandTemplates[i].firstInstance = FirstInstanceSupported ? FirstVisible : 0;
+			FirstVisible += mDrawGroups[i].InstancesCount;
+		}
+
+		const uint32_t DrawGroupsSize = static_cast<uint32_t>(sizeof(DrawGroupData) * mDrawGroupsData.size());
+		const uint32_t CommandsSize = static_cast<uint32_t>(sizeof(VkDrawIndexedIndirectCommand) * mCommandTemplates.size());
+
+		mDrawGroupBuffer->UploadData(mDrawGroupsData.data(), DrawGroupsSize);
+		mCommandTemplateBuffer->UploadData(mCommandTemplates.data(), CommandsSize);
+
+		UploadedBytes += DrawGroupsSize + CommandsSize;
+
+		if (UseMeshletCulling() && !mMeshlets.empty())
+		{
+			const uint32_t MeshletsSize = static_cast<uint32_t>(sizeof(MeshletData) * mMeshlets.size());
+
+			mMeshletBuffer->UploadData(mMeshlets.data(), MeshletsSize);
+
+			UploadedBytes += MeshletsSize;
+		}
+	}
+
+	mDrawGroupsDirty = false;
+
+	if (mDirtyEnd > mDirtyBegin)
+	{
+		const uint32_t Offset = static_cast<uint32_t>(sizeof(InstanceData) * mDirtyBegin);
+		const uint32_t Size = static_cast<uint32_t>(sizeof(InstanceData) * (mDirtyEnd - mDirtyBegin));
+
+		mInstanceBuffer->UploadData(&mInstances[mDirtyBegin], Size, Offset);
+
+		UploadedBytes += Size;
+	}
+
+	mDirtyBegin = mDirtyEnd = 0;
+
+	const Frustum ViewFrustum(ViewProjection);
+
+	ShaderStructs::GPUCullingComp::FrameBuffer Frame = {};
+	Frame.ViewProjection = ViewProjection;
+	Frame.View = View;
+	Frame.CameraPosition = glm::vec4(CameraPosition, 1.0f);
+	Frame.InstancesCount = GetInstancesCount();
+	Frame.MeshletCommandsCapacity16 = mMeshletCommandsCount[0];
+	Frame.MeshletCommandsCapacity32 = mMeshletCommandsCount[1];
+
+	// Projected size is the radius over the distance scaled by the projection, like in the CPU selection
+	const glm::mat4 Projection = ViewProjection * glm::inverse(View);
+	Frame.LodScale = mLodSelectionEnabled ? glm::abs(Projection[1][1]) : 0.0f;
+
+	for (int32_t i = 0; i < Frustum::PLANES_COUNT; ++i)
+	{
+		Frame.FrustumPlanes[i] = ViewFrustum.Planes[i];
+	}
+
+	mFrameBuffer->UploadData(&Frame, sizeof(Frame));
+
+	UploadedBytes += sizeof(Frame);
+
+	mDrawDescriptorInst->SetBuffer(DrawInstancesBinding, mInstanceBuffer.get(), VK_WHOLE_SIZE);
+	mDrawDescriptorInst->SetBuffer(DrawDrawGroupsBinding, mDrawGroupBuffer.get(), VK_WHOLE_SIZE);
+	mDrawDescriptorInst->SetBuffer(DrawVisibleInstancesBinding, mVisibleInstanceBuffer.get(), VK_WHOLE_SIZE);
+	mDrawDescriptorInst->SetBuffer(DrawFrameBinding, mFrameBuffer.get(), VK_WHOLE_SIZE);
+	mDrawDescriptorInst->Update();
+
+	mViewProjection = ViewProjection;
+	mOcclusionTested = false;
+
+	if (mInstances.empty()) { return UploadedBytes; }
+
+	UpdateCullingDescriptors(Occluders);
+	ReadCounters();
+
+	// Counters are accumulated by both phases
+	Cmd::FillBuffer(Cb, mOcclusionCounterBuffer.get(), 0);
+	Cmd::BufferBarrier(Cb, mOcclusionCounterBuffer.get(), PipelineStage::TRANSER, VK_ACCESS_TRANSFER_WRITE_BIT, PipelineStage::COMPUTE, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+	if (UseMeshletCulling())
+	{
+		Cmd::FillBuffer(Cb, mMeshletCounterBuffer.get(), 0);
+		Cmd::BufferBarrier(Cb, mMeshletCounterBuffer.get(), PipelineStage::TRANSER, VK_ACCESS_TRANSFER_WRITE_BIT, PipelineStage::COMPUTE, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+	}
+
+	mOcclusionTested = mOcclusionCullingEnabled && Occluders.IsValid();
+
+	DispatchCulling(Cb, 0, OccludersViewProjection, mOcclusionTested);
+
+	return UploadedBytes;
+}
+
+void GPUScene::CullOccluded(CommandBuffer* Cb, const HiZBuffer& Occluders)
+{
+	Assert(mOcclusionTested && Occluders.IsValid());
+
+	// Pyramid of this frame is built from the same view, so the current view projection is used
+	UpdateCullingDescriptors(Occluders);
+	DispatchCulling(Cb, 1, mViewProjection, true);
+}
+
+uint32_t GPUScene::Draw(CommandRecorder& Recorder)
+{
+	if (mInstances.empty()) { return 0; }
+
+	CommandBuffer* Cb = Recorder.GetCommandBuffer();
+	const VkPhysicalDeviceFeatures& Features = VulkanCore::Get().GetDevice()->GetEnabledFeatures();
+	const bool DrawCountSupported = VulkanCore::Get().GetDevice()->SupportsDrawIndirectCount();
+
+	Recorder.BindGraphicsPipeline(mDrawPipeline);
+	Recorder.SetViewports(mDrawPipeline);
+	Recorder.BindDescriptorSet(mImageArrayManager->GetDescInst(), mDrawPipeline);
+	Recorder.BindDescriptorSet(mDrawDescriptorInst.get(), mDrawPipeline);
+
+	// All static meshes live in one geometry pool, its index buffer depends on the index type of the group
+	const DrawGroup& FirstGroup = mDrawGroups.front();
+	Recorder.BindVertexBuffer(FirstGroup.Mesh->GetVertexBuffer(FirstGroup.Id));
+
+	ShaderStructs::GPUDrivenBasePassVert::DrawInfo Info = {};
+
+	uint32_t DrawCalls = 0;
+
+	if (UseMeshletCulling())
+	{
+		Info.DirectInstance = 1;
+		Recorder.PushConstants(mDrawPipeline, Info);
+
+		const uint32_t MaxDrawCount = VulkanCore::Get().GetDevice()->GetLimits().maxDrawIndirectCount;
+
+		// Commands of meshlets with 16-bit indices are followed by the ones with 32-bit indices
+		const IndexType Types[] = { IndexType::UINT16, IndexType::UINT32 };
+		uint32_t FirstCommand = 0;
+
+		for (uint32_t i = 0; i < 2; ++i)
+		{
+			const uint32_t CommandsCount = mMeshletCommandsCount[i];
+
+			const auto Group = std::find_if(mDrawGroups.begin(), mDrawGroups.end(), [&](const DrawGroup& Candidate) { return Candidate.Mesh->GetGeometryRange(Candidate.Id, Candidate.Lod).Type == Types[i]; });
+
+			if (CommandsCount > 0 && Group != mDrawGroups.end())
+			{
+				Recorder.BindIndexBuffer(Group->Mesh->GetIndexBuffer(Group->Id, Group->Lod), Types[i]);
+
+				// Counters of visible meshlets are the draw counts, commands behind them aren't read
+				if (DrawCountSupported && CommandsCount <= MaxDrawCount)
+				{
+					const uint32_t CountOffset = static_cast<uint32_t>(sizeof(uint32_t) * i);
+
+					Cmd::DrawIndexedIndirectCount(Cb, mMeshletCommandBuffer.get(), static_cast<uint32_t>(sizeof(VkDrawIndexedIndirectCommand) * FirstCommand), mMeshletCounterBuffer.get(), CountOffset, CommandsCount);
+					++DrawCalls;
+				}
+				else
+				{
+					for (uint32_t Offset = 0; Offset < CommandsCount; Offset += MaxDrawCount)
+					{
+						const uint32_t DrawCount = std::min(CommandsCount - Offset, MaxDrawCount);
+
+						Cmd::DrawIndexedIndirect(Cb, mMeshletCommandBuffer.get(), static_cast<uint32_t>(sizeof(VkDrawIndexedIndirectCommand) * (FirstCommand + Offset)), DrawCount);
+						++DrawCalls;
+					}
+				}
+			}
+
+			FirstCommand += CommandsCount;
+		}
+
+		return DrawCalls;
+	}
+
+	if (Features.drawIndirectFirstInstance && Features.multiDrawIndirect)
+	{
+		Recorder.PushConstants(mDrawPipeline, Info);
+
+		// One call for every run of groups with the same index type
+		for (uint32_t i = 0; i < mDrawRuns.size(); ++i)
+		{
+			const DrawRun& Run = mDrawRuns[i];
+			const uint32_t Offset = static_cast<uint32_t>(sizeof(VkDrawIndexedIndirectCommand) * Run.Begin);
+
+			const DrawGroup& FirstRunGroup = mDrawGroups[Run.Begin];
+
+			Recorder.BindIndexBuffer(FirstRunGroup.Mesh->GetIndexBuffer(FirstRunGroup.Id, FirstRunGroup.Lod), Run.Type);
+
+			// Culling pass counts the run up to its last group with visible instances
+			if (DrawCountSupported)
+			{
+				Cmd::DrawIndexedIndirectCount(Cb, mCommandBuffer.get(), Offset, mCommandBuffer.get(), mDrawCountsOffset + static_cast<uint32_t>(sizeof(uint32_t) * i), Run.End - Run.Begin);
+			}
+			else
+			{
+				Cmd::DrawIndexedIndirect(Cb, mCommandBuffer.get(), Offset, Run.End - Run.Begin);
+			}
+
+			++DrawCalls;
+		}
+
+		return DrawCalls;
+	}
+
+	for (uint32_t i = 0; i < GetDrawGroupsCount(); ++i)
+	{
+		const DrawGroup& Group = mDrawGroups[i];
+
+		Assert(Group.Mesh->GetVertexBuffer(Group.Id) == FirstGroup.Mesh->GetVertexBuffer(FirstGroup.Id));
+
+		Info.FirstVisible = Features.drawIndirectFirstInstance ? 0 : mDrawGroupsData[i].FirstVisible;
+
+		Recorder.BindIndexBuffer(Group.Mesh->GetIndexBuffer(Group.Id, Group.Lod), Group.Mesh->GetGeometryRange(Group.Id, Group.Lod).Type);
+		Recorder.PushConstants(mDrawPipeline, Info);
+		Cmd::DrawIndexedIndirect(Cb, mCommandBuffer.get(), static_cast<uint32_t>(sizeof(VkDrawIndexedIndirectCommand) * i));
+
+		++DrawCalls;
+	}
+
+	return DrawCalls;
+}
+
+void GPUScene::SetMeshletCullingEnabled(bool Enabled)
+{
+	if (mMeshletCullingEnabled == Enabled) { return; }
+
+	mMeshletCullingEnabled = Enabled;
+
+	// Meshlets are uploaded together with the draw groups
+	mDrawGroupsDirty = true;
+	mMeshletStats.MeshletsVisible = 0;
+	mMeshletStats.TrianglesVisible = 0;
+}
+
+bool GPUScene::IsMeshletCullingSupported() const
+{
+	const VkPhysicalDeviceFeatures& Features = VulkanCore::Get().GetDevice()->GetEnabledFeatures();
+	return Features.multiDrawIndirect && Features.drawIndirectFirstInstance;
+}
+
+void GPUScene::ReadCounters()
+{
+	// Previous frame has finished before this one started recording, so its counters can be read
+	ShaderStructs::GPUCullingComp::OcclusionCounterBuffer OcclusionCounters = {};
+	mOcclusionCounterBuffer->ReadData(&OcclusionCounters, sizeof(OcclusionCounters));
+
+	mOcclusionStats.Occluded = OcclusionCounters.OccludedCount;
+	mOcclusionStats.Disoccluded = OcclusionCounters.DisoccludedCount;
+
+	if (!UseMeshletCulling()) { return; }
+
+	ShaderStructs::GPUMeshletCullingComp::CounterBuffer Counters = {};
+	mMeshletCounterBuffer->ReadData(&Counters, sizeof(Counters));
+
+	mMeshletStats.MeshletsVisible = Counters.CommandsCount[0] + Counters.CommandsCount[1];
+	mMeshletStats.TrianglesVisible = Counters.TrianglesCount;
+}
+
+void GPUScene::UpdateCullingDescriptors(const HiZBuffer& Occluders)
+{
+	mCullingDescriptorInst->SetBuffer(CullingInstancesBinding, mInstanceBuffer.get(), VK_WHOLE_SIZE);
+	mCullingDescriptorInst->SetBuffer(CullingDrawGroupsBinding, mDrawGroupBuffer.get(), VK_WHOLE_SIZE);
+	mCullingDescriptorInst->SetBuffer(CullingCommandsBinding, mCommandBuffer.get(), VK_WHOLE_SIZE);
+	mCullingDescriptorInst->SetBuffer(CullingVisibleInstancesBinding, mVisibleInstanceBuffer.get(), VK_WHOLE_SIZE);
+	mCullingDescriptorInst->SetBuffer(CullingFrameBinding, mFrameBuffer.get(), VK_WHOLE_SIZE);
+	mCullingDescriptorInst->SetBuffer(CullingHiZPyramidBinding, Occluders.GetPyramidBuffer(), VK_WHOLE_SIZE);
+	mCullingDescriptorInst->SetBuffer(CullingHiZInfoBinding, Occluders.GetInfoBuffer(), VK_WHOLE_SIZE);
+	mCullingDescriptorInst->SetBuffer(CullingInstanceStatesBinding, mInstanceStateBuffer.get(), VK_WHOLE_SIZE);
+	mCullingDescriptorInst->SetBuffer(CullingOcclusionCountersBinding, mOcclusionCounterBuffer.get(), VK_WHOLE_SIZE);
+	mCullingDescriptorInst->SetBuffer(CullingDrawCountsBinding, mCommandBuffer.get(), VK_WHOLE_SIZE, mDrawCountsOffset);
+	mCullingDescriptorInst->Update();
+
+	if (!UseMeshletCulling()) { return; }
+
+	mMeshletCullingDescriptorInst->SetBuffer(CullingInstancesBinding, mInstanceBuffer.get(), VK_WHOLE_SIZE);
+	mMeshletCullingDescriptorInst->SetBuffer(CullingDrawGroupsBinding, mDrawGroupBuffer.get(), VK_WHOLE_SIZE);
+	mMeshletCullingDescriptorInst->SetBuffer(CullingCommandsBinding, mMeshletCommandBuffer.get(), VK_WHOLE_SIZE);
+	mMeshletCullingDescriptorInst->SetBuffer(MeshletCullingMeshletsBinding, mMeshletBuffer.get(), VK_WHOLE_SIZE);
+	mMeshletCullingDescriptorInst->SetBuffer(CullingFrameBinding, mFrameBuffer.get(), VK_WHOLE_SIZE);
+	mMeshletCullingDescriptorInst->SetBuffer(MeshletCullingCountersBinding, mMeshletCounterBuffer.get(), VK_WHOLE_SIZE);
+	mMeshletCullingDescriptorInst->SetBuffer(CullingHiZPyramidBinding + MeshletCullingBindingsOffset, Occluders.GetPyramidBuffer(), VK_WHOLE_SIZE);
+	mMeshletCullingDescriptorInst->SetBuffer(CullingHiZInfoBinding + MeshletCullingBindingsOffset, Occluders.GetInfoBuffer(), VK_WHOLE_SIZE);
+	mMeshletCullingDescriptorInst->SetBuffer(CullingInstanceStatesBinding + MeshletCullingBindingsOffset, mInstanceStateBuffer.get(), VK_WHOLE_SIZE);
+	mMeshletCullingDescriptorInst->SetBuffer(CullingOcclusionCountersBinding + MeshletCullingBindingsOffset, mOcclusionCounterBuffer.get(), VK_WHOLE_SIZE);
+	mMeshletCullingDescriptorInst->Update();
+}
+
+void GPUScene::DispatchCulling(CommandBuffer* Cb, uint32_t Phase, const glm::mat4& OcclusionViewProjection, bool OcclusionEnabled)
+{
+	if (UseMeshletCulling())
+	{
+		// Draws of the first phase have to finish reading the commands and their counts before they are overwritten
+		if (Phase != 0)
+		{
+			Cmd::BufferBarrier(Cb, mMeshletCommandBuffer.get(), PipelineStage::DRAW_INDIRECT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, PipelineStage::TRANSER, VK_ACCESS_TRANSFER_WRITE_BIT);
+			Cmd::BufferBarrier(Cb, mMeshletCounterBuffer.get(), PipelineStage::DRAW_INDIRECT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, PipelineStage::COMPUTE, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+		}
+
+		// Commands of meshlets that aren't visible stay zeroed and draw nothing
+		// Counters keep growing through both phases, so the second one writes behind the commands of the first one
+		// and the count of the second draw includes the zeroed commands of the first phase
+		Cmd::FillBuffer(Cb, mMeshletCommandBuffer.get(), 0);
+		Cmd::BufferBarrier(Cb, mMeshletCommandBuffer.get(), PipelineStage::TRANSER, VK_ACCESS_TRANSFER_WRITE_BIT, PipelineStage::COMPUTE, VK_ACCESS_SHADER_WRITE_BIT);
+
+		ShaderStructs::GPUMeshletCullingComp::CullingInfo Info = {};
+		Info.OcclusionViewProjection = OcclusionViewProjection;
+		Info.Phase = Phase;
+		Info.OcclusionEnabled = OcclusionEnabled ? 1 : 0;
+
+		Cmd::BindComputePipeline(Cb, mMeshletCullingPipeline);
+		Cmd::UpdateDescriptorData(Cb, mMeshletCullingDescriptorInst.get(), mMeshletCullingPipeline);
+		Cmd::PushConstants(Cb, mMeshletCullingPipeline, Info);
+
+		// One workgroup per instance
+		const uint32_t GroupsX = std::min(GetInstancesCount(), MaxMeshletCullingGroupsX);
+		Cmd::Dispatch(Cb, GroupsX, (GetInstancesCount() + GroupsX - 1) / GroupsX);
+
+		Cmd::BufferBarrier(Cb, mMeshletCommandBuffer.get(), PipelineStage::COMPUTE, VK_ACCESS_SHADER_WRITE_BIT, PipelineStage::DRAW_INDIRECT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+		Cmd::BufferBarrier(Cb, mMeshletCounterBuffer.get(), PipelineStage::COMPUTE, VK_ACCESS_SHADER_WRITE_BIT, PipelineStage::DRAW_INDIRECT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+		Cmd::BufferBarrier(Cb, mMeshletCounterBuffer.get(), PipelineStage::COMPUTE, VK_ACCESS_SHADER_WRITE_BIT, PipelineStage::HOST, VK_ACCESS_HOST_READ_BIT);
+	}
+	else
+	{
+		if (Phase != 0)
+		{
+			Cmd::BufferBarrier(Cb, mCommandBuffer.get(), PipelineStage::DRAW_INDIRECT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, PipelineStage::TRANSER, VK_ACCESS_TRANSFER_WRITE_BIT);
+			Cmd::BufferBarrier(Cb, mVisibleInstanceBuffer.get(), PipelineStage::VERTEX, VK_ACCESS_SHADER_READ_BIT, PipelineStage::COMPUTE, VK_ACCESS_SHADER_WRITE_BIT);
+		}
+
+		// Commands with zero instances are restored before the culling pass counts visible instances again
+		const uint32_t CommandsSize = static_cast<uint32_t>(sizeof(VkDrawIndexedIndirectCommand) * mCommandTemplates.size());
+
+		Cmd::CopyBuffer(Cb, mCommandTemplateBuffer.get(), mCommandBuffer.get(), CommandsSize);
+		Cmd::FillBuffer(Cb, mCommandBuffer.get(), 0, sizeof(uint32_t) * mDrawRuns.size(), mDrawCountsOffset);
+		Cmd::BufferBarrier(Cb, mCommandBuffer.get(), PipelineStage::TRANSER, VK_ACCESS_TRANSFER_WRITE_BIT, PipelineStage::COMPUTE, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+		ShaderStructs::GPUCullingComp::CullingInfo Info = {};
+		Info.OcclusionViewProjection = OcclusionViewProjection;
+		Info.Phase = Phase;
+		Info.OcclusionEnabled = OcclusionEnabled ? 1 : 0;
+
+		Cmd::BindComputePipeline(Cb, mCullingPipeline);
+		Cmd::UpdateDescriptorData(Cb, mCullingDescriptorInst.get(), mCullingPipeline);
+		Cmd::PushConstants(Cb, mCullingPipeline, Info);
+		Cmd::Dispatch(Cb, mCullingPipeline->GetGroupsCountX(GetInstancesCount()));
+
+		Cmd::BufferBarrier(Cb, mCommandBuffer.get(), PipelineStage::COMPUTE, VK_ACCESS_SHADER_WRITE_BIT, PipelineStage::DRAW_INDIRECT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+		Cmd::BufferBarrier(Cb, mVisibleInstanceBuffer.get(), PipelineStage::COMPUTE, VK_ACCESS_SHADER_WRITE_BIT, PipelineStage::VERTEX, VK_ACCESS_SHADER_READ_BIT);
+	}
+
+	// Second phase reads the states written by the first one
+	Cmd::BufferBarrier(Cb, mInstanceStateBuffer.get(), PipelineStage::COMPUTE, VK_ACCESS_SHADER_WRITE_BIT, PipelineStage::COMPUTE, VK_ACCESS_SHADER_READ_BIT);
+	Cmd::BufferBarrier(Cb, mOcclusionCounterBuffer.get(), PipelineStage::COMPUTE, VK_ACCESS_SHADER_WRITE_BIT, PipelineStage::HOST, VK_ACCESS_HOST_READ_BIT);
+}
+
+uint32_t GPUScene::FindDrawGroup(const StaticMesh* Mesh, int32_t Id, const std::string& Albedo, const SamplerSettings& Sampler)
+{
+	for (uint32_t i = 0; i < GetDrawGroupsCount(); ++i)
+	{
+		const DrawGroup& Group = mDrawGroups[i];
+
+		if (Group.Mesh == Mesh && Group.Id == Id && Group.Lod == 0 && Group.Albedo == Albedo && Group.Sampler == Sampler)
+		{
+			return i;
+		}
+	}
+
+	const uint32_t FirstLodGroup = GetDrawGroupsCount();
+	const BoundingSphere& Sphere = Mesh->GetBoundingSphere(Id);
+
+	// Levels share the bounding sphere of the submesh, the culling pass reads the thresholds from the first level
+	DrawGroupData LodData = {};
+	LodData.BoundingSphere = glm::vec4(Sphere.Center, Sphere.Radius);
+	LodData.AlbedoIdx = -1;
+	LodData.SamplerIdx = -1;
+	LodData.LodsCount = static_cast<uint32_t>(Mesh->GetLodsCount());
+
+	for (int32_t Lod = 0; Lod < Mesh->GetLodsCount(); ++Lod)
+	{
+		LodData.LodScreenSizes[Lod / 4][Lod % 4] = Mesh->GetLodScreenSize(Lod);
+	}
+
+	uint32_t MeshletsPerInstance[2] = {};
+
+	for (int32_t Lod = 0; Lod < Mesh->GetLodsCount(); ++Lod)
+	{
+		DrawGroup NewGroup = {};
+		NewGroup.Mesh = Mesh;
+		NewGroup.Id = Id;
+		NewGroup.Lod = Lod;
+		NewGroup.Albedo = Albedo;
+		NewGroup.Sampler = Sampler;
+
+		mDrawGroups.push_back(NewGroup);
+
+		const GeometryRange& Geometry = Mesh->GetGeometryRange(Id, Lod);
+		const std::vector<Meshlet>& SubmeshMeshlets = Mesh->GetMeshlets(Id, Lod);
+
+		DrawGroupData NewData = LodData;
+		NewData.PositionScale = glm::vec4(Mesh->GetPositionScale(Id, Lod), 0.0f);
+		NewData.PositionBias = glm::vec4(Mesh->GetPositionBias(Id, Lod), 0.0f);
+		NewData.FirstMeshlet = static_cast<uint32_t>(mMeshlets.size());
+		NewData.MeshletsCount = static_cast<uint32_t>(SubmeshMeshlets.size());
+
+		mDrawGroupsData.push_back(NewData);
+
+		// Instance emits the meshlets of one level, levels can differ in their index type
+		uint32_t& MaxMeshlets = MeshletsPerInstance[Geometry.Type == IndexType::UINT32 ? 1 : 0];
+		MaxMeshlets = std::max(MaxMeshlets, NewData.MeshletsCount);
+
+		for (const Meshlet& Cluster : SubmeshMeshlets)
+		{
+			MeshletData Data = {};
+			Data.BoundingSphere = glm::vec4(Cluster.Center, Cluster.Radius);
+			Data.Cone = glm::vec4(Cluster.ConeAxis, Cluster.ConeCutoff);
+			Data.FirstIndex = Geometry.FirstIndex + Cluster.FirstIndex;
+			Data.IndexCount = Cluster.IndexCount;
+			Data.VertexOffset = Geometry.VertexOffset;
+			Data.Is32Bit = Geometry.Type == IndexType::UINT32 ? 1 : 0;
+
+			mMeshlets.push_back(Data);
+		}
+
+		VkDrawIndexedIndirectCommand Command = {};
+		Command.indexCount = Geometry.IndexCount;
+		Command.firstIndex = Geometry.FirstIndex;
+		Command.vertexOffset = Geometry.VertexOffset;
+
+		mCommandTemplates.push_back(Command);
+	}
+
+	mDrawGroups[FirstLodGroup].MeshletsPerInstance[0] = MeshletsPerInstance[0];
+	mDrawGroups[FirstLodGroup].MeshletsPerInstance[1] = MeshletsPerInstance[1];
+
+	return FirstLodGroup;
+}
+
+void GPUScene::PrepareBuffers()
+{
+	const uint32_t GraphicsQueueIndex = VulkanCore::Get().GetDevice()->GetQueuesIndicies().GraphicsIndex;
+	const std::vector<uint32_t> Queues = { GraphicsQueueIndex };
+
+	bool Recreated = false;
+
+	if (GetInstancesCount() > mCapacity || !mInstanceBuffer)
+	{
+		mCapacity = std::max({ mCapacity * 2, GetInstancesCount(), 1u });
+
+		mInstanceBuffer = std::make_unique<Buffer>(Queues, BufferUsage::STORAGE, false, static_cast<uint32_t>(sizeof(InstanceData) * mCapacity));
+		mInstanceStateBuffer = std::make_unique<Buffer>(Queues, BufferUsage::STORAGE, true, static_cast<uint32_t>(sizeof(uint32_t) * mCapacity));
+
+		MarkInstancesDirty(0, GetInstancesCount());
+		Recreated = true;
+	}
+
+	// Every level of detail has its own range of visible instances
+	if (mVisibleSlotsCount > mVisibleCapacity || !mVisibleInstanceBuffer)
+	{
+		mVisibleCapacity = std::max({ mVisibleCapacity * 2, mVisibleSlotsCount, 1u });
+
+		mVisibleInstanceBuffer = std::make_unique<Buffer>(Queues, BufferUsage::STORAGE, true, static_cast<uint32_t>(sizeof(uint32_t) * mVisibleCapacity));
+
+		Recreated = true;
+	}
+
+	if (GetDrawGroupsCount() > mGroupsCapacity || !mDrawGroupBuffer)
+	{
+		mGroupsCapacity = std::max({ mGroupsCapacity * 2, GetDrawGroupsCount(), 1u });
+
+		const uint32_t CommandsSize = static_cast<uint32_t>(sizeof(VkDrawIndexedIndirectCommand) * mGroupsCapacity);
+
+		// Draw counts are bound to the culling pass on their own, so they start at an aligned offset, there is at most one run per group
+		const uint32_t Alignment = static_cast<uint32_t>(VulkanCore::Get().GetDevice()->GetLimits().minStorageBufferOffsetAlignment);
+		mDrawCountsOffset = (CommandsSize + Alignment - 1) / Alignment * Alignment;
+
+		mDrawGroupBuffer = std::make_unique<Buffer>(Queues, BufferUsage::STORAGE, false, static_cast<uint32_t>(sizeof(DrawGroupData) * mGroupsCapacity));
+		mCommandBuffer = std::make_unique<Buffer>(Queues, BufferUsage::INDIRECT | BufferUsage::STORAGE | BufferUsage::TRANSFER_DST, true, mDrawCountsOffset + static_cast<uint32_t>(sizeof(uint32_t) * mGroupsCapacity));
+		mCommandTemplateBuffer = std::make_unique<Buffer>(Queues, BufferUsage::TRANSFER_SRC, false, CommandsSize);
+
+		mDrawGroupsDirty = true;
+		Recreated = true;
+	}
+
+	if (!mFrameBuffer)
+	{
+		mFrameBuffer = std::make_unique<Buffer>(Queues, BufferUsage::STORAGE, false, static_cast<uint32_t>(sizeof(ShaderStructs::GPUCullingComp::FrameBuffer)));
+	}
+
+	if (!mOcclusionCounterBuffer)
+	{
+		const ShaderStructs::GPUCullingComp::OcclusionCounterBuffer Counters = {};
+		mOcclusionCounterBuffer = std::make_unique<Buffer>(Queues, BufferUsage::STORAGE | BufferUsage::TRANSFER_DST, false, static_cast<uint32_t>(sizeof(Counters)), &Counters);
+
+		Recreated = true;
+	}
+
+	if (UseMeshletCulling())
+	{
+		const uint32_t MeshletsCount = static_cast<uint32_t>(mMeshlets.size());
+		const uint32_t CommandsCount = mMeshletCommandsCount[0] + mMeshletCommandsCount[1];
+
+		if (MeshletsCount > mMeshletsCapacity || !mMeshletBuffer)
+		{
+			mMeshletsCapacity = std::max({ mMeshletsCapacity * 2, MeshletsCount, 1u });
+
+			mMeshletBuffer = std::make_unique<Buffer>(Queues, BufferUsage::STORAGE, false, static_cast<uint32_t>(sizeof(MeshletData) * mMeshletsCapacity));
+
+			mDrawGroupsDirty = true;
+			Recreated = true;
+		}
+
+		if (CommandsCount > mMeshletCommandsCapacity || !mMeshletCommandBuffer)
+		{
+			mMeshletCommandsCapacity = std::max({ mMeshletCommandsCapacity * 2, CommandsCount, 1u });
+
+			const uint32_t CommandsSize = static_cast<uint32_t>(sizeof(VkDrawIndexedIndirectCommand) * mMeshletCommandsCapacity);
+			mMeshletCommandBuffer = std::make_unique<Buffer>(Queues, BufferUsage::INDIRECT | BufferUsage::STORAGE | BufferUsage::TRANSFER_DST, true, CommandsSize);
+
+			Recreated = true;
+		}
+
+		if (!mMeshletCounterBuffer)
+		{
+			const ShaderStructs::GPUMeshletCullingComp::CounterBuffer Counters = {};
+			mMeshletCounterBuffer = std::make_unique<Buffer>(Queues, BufferUsage::INDIRECT | BufferUsage::STORAGE | BufferUsage::TRANSFER_DST, false, static_cast<uint32_t>(sizeof(Counters)), &Counters);
+
+			Recreated = true;
+		}
+	}
+
+	// Descriptors that point to the previous buffers can't be used anymore
+	if (Recreated)
+	{
+		mCullingDescriptorInst.reset();
+		mCullingDescriptorInst = mCullingPipeline->GetDescriptorManager()->GetDescriptorInstance(0);
+
+		mMeshletCullingDescriptorInst.reset();
+		mMeshletCullingDescriptorInst = mMeshletCullingPipeline->GetDescriptorManager()->GetDescriptorInstance(0);
+
+		mDrawDescriptorInst.reset();
+		mDrawDescriptorInst = mDrawPipeline->GetDescriptorManager()->GetDescriptorInstance(SceneSetIndex);
+	}
+}
+
+void GPUScene::MarkInstancesDirty(uint32_t Begin, uint32_t End)
+{
+	if (Begin >= End) { return; }
+
+	if (mDirtyBegin == mDirtyEnd)
+	{
+		mDirtyBegin = Begin;
+		mDirtyEnd = End;
+	}
+	else
+	{
+		mDirtyBegin = std::min(mDirtyBegin, Begin);
+		mDirtyEnd = std::max(mDirtyEnd, End);
+	}
+}
@@ -0,0 +1,238 @@
+#pragma once
+#include <memory>
+#include <vector>
+#define GLM_FORCE_RADIANS
+#include "glm/glm.hpp"
+#include "../Renderer/pipeline.h"
+#include "../Renderer/sampler.h"
+#include "image_array_manager.h"
+
+class Buffer;
+class CommandBuffer;
+class CommandRecorder;
+class HiZBuffer;
+class RenderPass;
+class StaticMesh;
+class StaticMeshHandle;
+
+// Results of the meshlet culling pass, read back one frame later
+struct MeshletCullingStats
+{
+	uint32_t MeshletsVisible = 0;
+	uint32_t TrianglesVisible = 0;
+	uint64_t TrianglesTotal = 0; // Of all instances before culling
+};
+
+// Results of both phases of occlusion culling, read back one frame later
+struct OcclusionCullingStats
+{
+	uint32_t Occluded = 0; // Instances inside of the frustum hidden in both phases
+	uint32_t Disoccluded = 0; // Instances hidden by the previous frame's depth but not by the current one
+};
+
+// Instances whose visibility and draw arguments are computed on the GPU
+// Every frame a compute pass frustum culls all instances and fills one indirect draw command per draw group (submesh with its textures),
+// so the CPU cost of a frame depends only on the number of draw groups and modified instances
+// With meshlet culling every visible instance is split into meshlets, the ones outside of the frustum or facing away are dropped
+// and each of the rest gets its own indirect draw command
+// Occlusion culling tests instances against the depth pyramid of the previous frame first, the base pass draws the ones that passed,
+// then instances that were hidden are tested again against the pyramid of those draws and the ones that became visible are drawn in the same frame
+// Every level of detail of a submesh has its own draw group, the culling pass picks the level of each instance from its projected size
+class GPUScene
+{
+public:
+	// Has to match GroupSize in GPUCulling.comp
+	static constexpr uint32_t CullingGroupSize = 64;
+
+	// Has to match GroupSize in GPUMeshletCulling.comp
+	static constexpr uint32_t MeshletCullingGroupSize = 64;
+
+	// Instances of the meshlet culling dispatch that fit into its first dimension
+	static constexpr uint32_t MaxMeshletCullingGroupsX = 65535;
+
+	// Has to match LodShift in the culling shaders and GPUDrivenBasePass.vert
+	// Visible instance entries and first instances of meshlet draws keep the level of detail above it
+	static constexpr uint32_t LodShift = 28;
+
+	GPUScene(const RenderPass& BasePassRenderPass);
+	~GPUScene();
+
+	GPUScene(const GPUScene& Rhs) = delete;
+	GPUScene& operator=(const GPUScene& Rhs) = delete;
+
+	GPUScene(GPUScene&& Rhs) = delete;
+	GPUScene& operator=(GPUScene&& Rhs) = delete;
+
+	// Adds one instance per submesh of the mesh, returns index of the object
+	uint32_t AddObject(StaticMeshHandle* MeshHandle, const glm::mat4& Transform, const glm::vec3& Color = { 1.0f, 1.0f, 1.0f });
+	void SetTransform(uint32_t ObjectIdx, const glm::mat4& Transform);
+	void Clear();
+
+	inline uint32_t GetInstancesCount() const { return static_cast<uint32_t>(mInstances.size()); }
+	inline uint32_t GetDrawGroupsCount() const { return static_cast<uint32_t>(mDrawGroups.size()); }
+
+	// Uploads modified data and records the culling pass, has to be recorded outside of a render pass
+	// Occluders are used only when occlusion culling is enabled and the pyramid is valid, OccludersViewProjection is the one it was rendered with
+	// Returns number of uploaded bytes
+	uint32_t Cull(CommandBuffer* Cb, const glm::mat4& ViewProjection, const glm::mat4& View, const glm::vec3& CameraPosition, 
+		const HiZBuffer& Occluders, const glm::mat4& OccludersViewProjection);
+
+	// Second phase of occlusion culling, tests instances hidden in Cull against the pyramid of the draws recorded since then
+	// Has to be recorded outside of a render pass after the pyramid is built, instances that passed are drawn by the next Draw
+	void CullOccluded(CommandBuffer* Cb, const HiZBuffer& Occluders);
+
+	// True when the last Cull tested against a pyramid, so CullOccluded has to follow it
+	inline bool NeedsOccludedPass() const { return mOcclusionTested; }
+
+	// Records indirect draws of all draw groups, has to be recorded inside of the base pass after Cull
+	// Groups with the same index type are drawn with a single call when the device supports multi draw indirect and first instance in indirect draws
+	// With VK_KHR_draw_indirect_count the number of commands is written by the culling pass, so commands of culled groups at the end of a run and of culled meshlets aren't read
+	// Returns number of recorded indirect draw calls
+	uint32_t Draw(CommandRecorder& Recorder);
+
+	// Meshlet culling needs multi draw indirect and first instance in indirect draws, without them instances are culled as a whole
+	void SetMeshletCullingEnabled(bool Enabled);
+	inline bool IsMeshletCullingEnabled() const { return mMeshletCullingEnabled; }
+	bool IsMeshletCullingSupported() const;
+
+	inline const MeshletCullingStats& GetMeshletStats() const { return mMeshletStats; }
+
+	void SetOcclusionCullingEnabled(bool Enabled) { mOcclusionCullingEnabled = Enabled; }
+	inline bool IsOcclusionCullingEnabled() const { return mOcclusionCullingEnabled; }
+
+	inline const OcclusionCullingStats& GetOcclusionStats() const { return mOcclusionStats; }
+
+	// Without it every instance draws its first level of detail
+	void SetLodSelectionEnabled(bool Enabled) { mLodSelectionEnabled = Enabled; }
+	inline bool IsLodSelectionEnabled() const { return mLodSelectionEnabled; }
+
+private:
+	// Mirrors of the structures in GPUCulling.comp and GPUDrivenBasePass.vert
+	struct InstanceData
+	{
+		glm::mat4 Model;
+		glm::vec4 Color;
+		uint32_t DrawGroup;
+		uint32_t Padding[3];
+	};
+	static_assert(sizeof(InstanceData) == 96, "Invalid size of InstanceData");
+
+	struct DrawGroupData
+	{
+		glm::vec4 BoundingSphere;
+		int32_t AlbedoIdx;
+		int32_t SamplerIdx;
+		uint32_t FirstVisible;
+		uint32_t MeshletsCount;
+		glm::vec4 PositionScale;
+		glm::vec4 PositionBias;
+		uint32_t FirstMeshlet;
+		uint32_t DrawRun; // Run of groups with the same index type drawn by one call
+		uint32_t DrawRunBegin; // First group of the run
+		uint32_t LodsCount; // Groups of the other levels follow the first one
+		glm::vec4 LodScreenSizes[2]; // Level N is used when the projected size is below LodScreenSizes[N / 4][N % 4]
+	};
+	static_assert(sizeof(DrawGroupData) == 112, "Invalid size of DrawGroupData");
+
+	// Mirror of the structure in GPUMeshletCulling.comp
+	struct MeshletData
+	{
+		glm::vec4 BoundingSphere;
+		glm::vec4 Cone;
+		uint32_t FirstIndex; // Inside of the geometry pool's index buffer
+		uint32_t IndexCount;
+		int32_t VertexOffset;
+		uint32_t Is32Bit;
+	};
+	static_assert(sizeof(MeshletData) == 48, "Invalid size of MeshletData");
+
+	struct DrawGroup
+	{
+		const StaticMesh* Mesh = nullptr;
+		int32_t Id = -1;
+		std::string Albedo;
+		SamplerSettings Sampler;
+		int32_t Lod = 0;
+		uint32_t InstancesCount = 0; // Every instance of the submesh can pick any level, so all of its groups count it
+		uint32_t MeshletsPerInstance[2] = {}; // Most meshlets with 16-bit and 32-bit indices an instance can emit, set on the first level
+	};
+
+	// Groups [Begin, End) share the index type, so they are drawn with one multi draw
+	struct DrawRun
+	{
+		uint32_t Begin = 0;
+		uint32_t End = 0;
+		IndexType Type = IndexType::UINT32;
+	};
+
+	struct ObjectRange
+	{
+		uint32_t FirstInstance = 0;
+		uint32_t InstancesCount = 0;
+	};
+
+	uint32_t FindDrawGroup(const StaticMesh* Mesh, int32_t Id, const std::string& Albedo, const SamplerSettings& Sampler);
+	void PrepareBuffers();
+	inline bool UseMeshletCulling() const { return mMeshletCullingEnabled && IsMeshletCullingSupported(); }
+	void ReadCounters();
+	void DispatchCulling(CommandBuffer* Cb, uint32_t Phase, const glm::mat4& OcclusionViewProjection, bool OcclusionEnabled);
+	void UpdateCullingDescriptors(const HiZBuffer& Occluders);
+	void MarkInstancesDirty(uint32_t Begin, uint32_t End);
+
+	std::vector<InstanceData> mInstances;
+	std::vector<ObjectRange> mObjects;
+	std::vector<DrawGroup> mDrawGroups;
+	std::vector<DrawGroupData> mDrawGroupsData;
+	std::vector<VkDrawIndexedIndirectCommand> mCommandTemplates; // Commands with zero instances, copied over the commands before culling
+	std::vector<MeshletData> mMeshlets; // Every draw group has its own copy of its submesh's meshlets
+	std::vector<DrawRun> mDrawRuns;
+
+	// Range of mInstances that has to be uploaded
+	uint32_t mDirtyBegin = 0;
+	uint32_t mDirtyEnd = 0;
+	bool mDrawGroupsDirty = false;
+
+	uint32_t mCapacity = 0; // Number of instances that fit into the buffers
+	uint32_t mVisibleSlotsCount = 0; // Instances of all draw groups
+	uint32_t mVisibleCapacity = 0;
+	uint32_t mGroupsCapacity = 0;
+	uint32_t mDrawCountsOffset = 0; // Draw counts of the runs follow the commands in mCommandBuffer
+
+	bool mMeshletCullingEnabled = false;
+	uint32_t mMeshletCommandsCount[2] = {}; // Meshlets of all instances with 16-bit and 32-bit indices, each of them can be visible
+	uint32_t mMeshletsCapacity = 0;
+	uint32_t mMeshletCommandsCapacity = 0;
+	MeshletCullingStats mMeshletStats;
+
+	bool mLodSelectionEnabled = true;
+
+	bool mOcclusionCullingEnabled = false;
+	bool mOcclusionTested = false;
+	glm::mat4 mViewProjection = glm::mat4(1.0f); // Of the last Cull, the second phase tests with it
+	OcclusionCullingStats mOcclusionStats;
+
+	std::unique_ptr<Buffer> mInstanceBuffer;
+	std::unique_ptr<Buffer> mVisibleInstanceBuffer;
+	std::unique_ptr<Buffer> mDrawGroupBuffer;
+	std::unique_ptr<Buffer> mCommandBuffer; // Commands of the groups and the draw count of every run
+	std::unique_ptr<Buffer> mCommandTemplateBuffer;
+	std::unique_ptr<Buffer> mFrameBuffer;
+	std::unique_ptr<Buffer> mMeshletBuffer;
+	std::unique_ptr<Buffer> mMeshletCommandBuffer;
+	std::unique_ptr<Buffer> mMeshletCounterBuffer; // Host visible, so the counters can be read back
+	std::unique_ptr<Buffer> mInstanceStateBuffer; // Instances hidden in the first phase of occlusion culling
+	std::unique_ptr<Buffer> mOcclusionCounterBuffer; // Host visible
+
+	ComputePipeline* mCullingPipeline = nullptr; // Owned by the pipeline manager
+	upDescriptorInst mCullingDescriptorInst;
+
+	ComputePipeline* mMeshletCullingPipeline = nullptr;
+	upDescriptorInst mMeshletCullingDescriptorInst;
+
+	IGraphicsPipeline* mDrawPipeline = nullptr;
+	upDescriptorInst mDrawDescriptorInst;
+	upImageArrayManager mImageArrayManager;
+
+};
+
+using upGPUScene = std::unique_ptr<GPUScene>;
@@ -0,0 +1,140 @@
+#define NOMINMAX
+#include "hiz_buffer.h"
+#include "../Renderer/buffer.h"
+#include "../Renderer/core.h"
+#include "../Renderer/device.h"
+#include "../Renderer/image.h"
+#include "../Renderer/pipeline_manager.h"
+#include "../Renderer/renderer_commands.h"
+#include "../Renderer/shader_structs.h"
+#include "../Utilities/assert.h"
+
+namespace
+{
+	// Bindings of HiZDownsample.comp
+	constexpr int32_t DownsampleDepthBinding = 0;
+	constexpr int32_t DownsamplePyramidBinding = 1;
+}
+
+HiZBuffer::HiZBuffer(uint32_t Width, uint32_t Height)
+	: mWidth(Width), mHeight(Height)
+{
+	Assert(Width > 0 && Height > 0);
+
+	Shader* DownsampleShader = ShaderManager::Get().Find("HiZDownsample.comp");
+	Assert(DownsampleShader);
+
+	mDownsamplePipeline = PipelineManager::Get().GetComputePipeline(DownsampleShader);
+	Assert(mDownsamplePipeline->GetWorkgroupSize().X == GroupSize && mDownsamplePipeline->GetWorkgroupSize().Y == GroupSize);
+
+	// Levels are halved until a single texel is left
+	uint32_t LevelWidth = std::max(Width / 2, 1u);
+	uint32_t LevelHeight = std::max(Height / 2, 1u);
+	uint32_t TexelsCount = 0;
+
+	while (mLevels.size() < MaxLevelsCount)
+	{
+		mLevels.push_back({ TexelsCount, LevelWidth, LevelHeight });
+		TexelsCount += LevelWidth * LevelHeight;
+
+		if (LevelWidth == 1 && LevelHeight == 1) { break; }
+
+		LevelWidth = std::max(LevelWidth / 2, 1u);
+		LevelHeight = std::max(LevelHeight / 2, 1u);
+	}
+
+	ShaderStructs::GPUCullingComp::HiZInfoBuffer Info = {};
+	Info.HiZLevelsCount = GetLevelsCount();
+
+	for (uint32_t i = 0; i < GetLevelsCount(); ++i)
+	{
+		Info.HiZLevels[i] = glm::uvec4(mLevels[i].Offset, mLevels[i].Width, mLevels[i].Height, 0);
+	}
+
+	const uint32_t GraphicsQueueIndex = VulkanCore::Get().GetDevice()->GetQueuesIndicies().GraphicsIndex;
+	const std::vector<uint32_t> Queues = { GraphicsQueueIndex };
+
+	mDepthBuffer = std::make_unique<Buffer>(Queues, BufferUsage::STORAGE | BufferUsage::TRANSFER_DST, true, static_cast<uint32_t>(sizeof(uint32_t) * Width * Height));
+	mPyramidBuffer = std::make_unique<Buffer>(Queues, BufferUsage::STORAGE, true, static_cast<uint32_t>(sizeof(float) * TexelsCount));
+	mInfoBuffer = std::make_unique<Buffer>(Queues, BufferUsage::STORAGE, false, static_cast<uint32_t>(sizeof(Info)), &Info);
+
+	mDownsampleDescriptorInst = mDownsamplePipeline->GetDescriptorManager()->GetDescriptorInstance(0);
+	mDownsampleDescriptorInst->SetBuffer(DownsampleDepthBinding, mDepthBuffer.get(), VK_WHOLE_SIZE);
+	mDownsampleDescriptorInst->SetBuffer(DownsamplePyramidBinding, mPyramidBuffer.get(), VK_WHOLE_SIZE);
+	mDownsampleDescriptorInst->Update();
+}
+
+HiZBuffer::~HiZBuffer()
+{
+
+}
+
+void HiZBuffer::Build(CommandBuffer* Cb, Image* DepthBuffer)
+{
+	CopyDepth(Cb, DepthBuffer);
+	Downsample(Cb);
+}
+
+void HiZBuffer::CopyDepth(CommandBuffer* Cb, Image* DepthBuffer)
+{
+	Assert(DepthBuffer && DepthBuffer->GetWidth() == mWidth && DepthBuffer->GetHeight() == mHeight);
+
+	// Culling passes of this frame may still read the copy and the pyramid
+	Cmd::BufferBarrier(Cb, mDepthBuffer.get(), PipelineStage::COMPUTE, VK_ACCESS_SHADER_READ_BIT, PipelineStage::TRANSER, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+	Cmd::ImageBarrier(Cb, DepthBuffer, ImageLayout::DEPTH_STENCIL_ATTACHMENT, ImageLayout::TRANSFER_SRC,
+		PipelineStage::LATE_FRAGMENT_TESTS, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, PipelineStage::TRANSER, VK_ACCESS_TRANSFER_READ_BIT);
+
+	Cmd::CopyImageToBuffer(Cb, DepthBuffer, mDepthBuffer.get());
+
+	Cmd::ImageBarrier(Cb, DepthBuffer, ImageLayout::TRANSFER_SRC, ImageLayout::DEPTH_STENCIL_ATTACHMENT,
+		PipelineStage::TRANSER, VK_ACCESS_TRANSFER_READ_BIT, PipelineStage::EARLY_FRAGMENT_TESTS, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+
+	Cmd::BufferBarrier(Cb, mDepthBuffer.get(), PipelineStage::TRANSER, VK_ACCESS_TRANSFER_WRITE_BIT, PipelineStage::COMPUTE, VK_ACCESS_SHADER_READ_BIT);
+}
+
+void HiZBuffer::Downsample(CommandBuffer* Cb)
+{
+	Cmd::BufferBarrier(Cb, mPyramidBuffer.get(), PipelineStage::COMPUTE, VK_ACCESS_SHADER_READ_BIT, PipelineStage::COMPUTE, VK_ACCESS_SHADER_WRITE_BIT);
+
+	Cmd::BindComputePipeline(Cb, mDownsamplePipeline);
+	Cmd::UpdateDescriptorData(Cb, mDownsampleDescriptorInst.get(), mDownsamplePipeline);
+
+	ShaderStructs::HiZDownsampleComp::DownsampleInfo Info = {};
+	Info.SourceWidth = mWidth;
+	Info.SourceHeight = mHeight;
+	Info.SourceIsDepth = 1;
+
+	// Every level reads the previous one
+	for (const Level& Destination : mLevels)
+	{
+		Info.DestinationOffset = Destination.Offset;
+		Info.DestinationWidth = Destination.Width;
+		Info.DestinationHeight = Destination.Height;
+
+		Cmd::PushConstants(Cb, mDownsamplePipeline, Info);
+		Cmd::Dispatch(Cb, mDownsamplePipeline->GetGroupsCountX(Destination.Width), mDownsamplePipeline->GetGroupsCountY(Destination.Height));
+
+		Cmd::BufferBarrier(Cb, mPyramidBuffer.get(), PipelineStage::COMPUTE, VK_ACCESS_SHADER_WRITE_BIT, PipelineStage::COMPUTE, VK_ACCESS_SHADER_READ_BIT);
+
+		Info.SourceOffset = Destination.Offset;
+		Info.SourceWidth = Destination.Width;
+		Info.SourceHeight = Destination.Height;
+		Info.SourceIsDepth = 0;
+	}
+
+	mValid = true;
+}
+
+void HiZBuffer::ReleaseOwnership(CommandBuffer* Cb, int32_t DstQueueIndex)
+{
+	// Last accesses on either queue are compute reads and writes, transfers of the copy are already chained to the compute stage
+	Cmd::ReleaseBuffer(Cb, mDepthBuffer.get(), PipelineStage::COMPUTE, VK_ACCESS_SHADER_WRITE_BIT, DstQueueIndex);
+	Cmd::ReleaseBuffer(Cb, mPyramidBuffer.get(), PipelineStage::COMPUTE, VK_ACCESS_SHADER_WRITE_BIT, DstQueueIndex);
+}
+
+void HiZBuffer::AcquireOwnership(CommandBuffer* Cb, int32_t SrcQueueIndex)
+{
+	Cmd::AcquireBuffer(Cb, mDepthBuffer.get(), SrcQueueIndex, PipelineStage::COMPUTE, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+	Cmd::AcquireBuffer(Cb, mPyramidBuffer.get(), SrcQueueIndex, PipelineStage::COMPUTE, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+}
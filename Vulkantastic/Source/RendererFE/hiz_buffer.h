@@ -0,0 +1,73 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "../Renderer/pipeline.h"
+
+class Buffer;
+class CommandBuffer;
+class Image;
+
+// Hierarchical depth of the base pass used for occlusion culling
+// Every texel keeps the farthest depth of the texels it covers, so a box that is behind it at the right level is hidden
+// Levels live one after another in a storage buffer, the first one has half of the depth buffer's resolution
+class HiZBuffer
+{
+public:
+	// Has to match GroupSize in HiZDownsample.comp
+	static constexpr uint32_t GroupSize = 8;
+
+	// Has to match the size of HiZLevels in GPUCulling.comp and GPUMeshletCulling.comp
+	static constexpr uint32_t MaxLevelsCount = 16;
+
+	HiZBuffer(uint32_t Width, uint32_t Height);
+	~HiZBuffer();
+
+	HiZBuffer(const HiZBuffer& Rhs) = delete;
+	HiZBuffer& operator=(const HiZBuffer& Rhs) = delete;
+
+	HiZBuffer(HiZBuffer&& Rhs) = delete;
+	HiZBuffer& operator=(HiZBuffer&& Rhs) = delete;
+
+	// Copies depth and downsamples it into all levels, has to be recorded outside of a render pass
+	// Depth buffer has to be in the depth attachment layout and it's left in it
+	void Build(CommandBuffer* Cb, Image* DepthBuffer);
+
+	// Both halves of Build, the downsample only reads the copy so it can be recorded on another queue once buffers are handed over
+	void CopyDepth(CommandBuffer* Cb, Image* DepthBuffer);
+	void Downsample(CommandBuffer* Cb);
+
+	// Queue ownership transfer of the copy and the pyramid, every release has to be matched by an acquire on the other queue
+	void ReleaseOwnership(CommandBuffer* Cb, int32_t DstQueueIndex);
+	void AcquireOwnership(CommandBuffer* Cb, int32_t SrcQueueIndex);
+
+	// Pyramid keeps depth of a frame that isn't the previous one anymore
+	inline void Invalidate() { mValid = false; }
+	inline bool IsValid() const { return mValid; }
+
+	inline Buffer* GetPyramidBuffer() const { return mPyramidBuffer.get(); }
+	inline Buffer* GetInfoBuffer() const { return mInfoBuffer.get(); }
+	inline uint32_t GetLevelsCount() const { return static_cast<uint32_t>(mLevels.size()); }
+
+private:
+	struct Level
+	{
+		uint32_t Offset = 0; // In texels from the beginning of the pyramid
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+	};
+
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+	bool mValid = false;
+	std::vector<Level> mLevels;
+
+	std::unique_ptr<Buffer> mDepthBuffer; // Copy of the depth attachment
+	std::unique_ptr<Buffer> mPyramidBuffer;
+	std::unique_ptr<Buffer> mInfoBuffer;
+
+	ComputePipeline* mDownsamplePipeline = nullptr; // Owned by the pipeline manager
+	upDescriptorInst mDownsampleDescriptorInst;
+
+};
+
+using upHiZBuffer = std::unique_ptr<HiZBuffer>;
@@ -1,5 +1,6 @@
 #include "image_array_manager.h"
 #include "texture_manager.h"
+#include "../Utilities/assert.h"
 
 ImageArrayManager::ImageArrayManager(DescriptorManager* DM, int32_t SetID)
 {
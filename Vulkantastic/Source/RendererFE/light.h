@@ -0,0 +1,22 @@
+#pragma once
+#include "glm/glm.hpp"
+
+enum class LightType : uint8_t
+{
+	POINT = 0,
+	SPOT
+};
+
+// Local light of the scene, its intensity falls to zero at the radius
+struct Light
+{
+	LightType Type = LightType::POINT;
+	glm::vec3 Position = { 0.0f, 0.0f, 0.0f };
+	glm::vec3 Color = { 1.0f, 1.0f, 1.0f };
+	float Radius = 1.0f;
+
+	// Spot lights only, angles are in radians from the direction
+	glm::vec3 Direction = { 0.0f, 0.0f, -1.0f };
+	float InnerConeAngle = 0.3f;
+	float OuterConeAngle = 0.5f;
+};
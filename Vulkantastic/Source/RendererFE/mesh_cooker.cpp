@@ -0,0 +1,443 @@
+#define NOMINMAX
+#include "mesh_cooker.h"
+#include "../File/file.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	// Resolves 1-based and negative (relative to the end) indices of .obj files, returns -1 for invalid ones
+	int32_t ResolveObjIndex(long Index, size_t Count)
+	{
+		const long Resolved = Index < 0 ? static_cast<long>(Count) + Index : Index - 1;
+		return Resolved >= 0 && Resolved < static_cast<long>(Count) ? static_cast<int32_t>(Resolved) : -1;
+	}
+
+	template<typename T>
+	void AppendData(std::vector<uint8_t>& Data, const T* Source, size_t Count = 1)
+	{
+		const uint8_t* Bytes = reinterpret_cast<const uint8_t*>(Source);
+		Data.insert(Data.end(), Bytes, Bytes + sizeof(T) * Count);
+	}
+}
+
+MeshCooker::MeshCooker(const MeshCookerSettings& Settings /*= MeshCookerSettings()*/)
+	: mSettings(Settings)
+{
+
+}
+
+bool MeshCooker::Cook(const std::string& SourcePath, const std::string& DestinationPath)
+{
+	mReports.clear();
+
+	std::string Source;
+
+	{
+		FileGuard SourceHandle(File::Get().OpenRead(SourcePath));
+
+		if (!SourceHandle.Get()) { return false; }
+
+		SourceHandle->Read(Source);
+	}
+
+	std::vector<Submesh> Submeshes;
+
+	if (!ParseObj(Source, Submeshes) || Submeshes.empty()) { return false; }
+
+	std::vector<std::vector<Submesh>> Lods(Submeshes.size());
+
+	for (size_t i = 0; i < Submeshes.size(); ++i)
+	{
+		mReports.push_back(CookSubmesh(Submeshes[i], Lods[i]));
+	}
+
+	const uint32_t LodsCount = static_cast<uint32_t>(Lods.front().size());
+	const std::vector<float> ScreenSizes = ComputeLodScreenSizes(LodsCount);
+
+	std::vector<uint8_t> Data;
+	AppendData(Data, &StaticMeshFile::Magic);
+	AppendData(Data, &StaticMeshFile::Version);
+	AppendData(Data, &LodsCount);
+	AppendData(Data, ScreenSizes.data(), ScreenSizes.size());
+
+	for (const std::vector<Submesh>& SubmeshLods : Lods)
+	{
+		for (const Submesh& Lod : SubmeshLods)
+		{
+			WriteSubmesh(Lod, Data);
+		}
+	}
+
+	// Files are opened without truncating, so the previous one has to be removed
+	if (File::Get().Exists(DestinationPath))
+	{
+		File::Get().Delete(DestinationPath);
+	}
+
+	FileGuard DestinationHandle(File::Get().OpenWrite(DestinationPath));
+
+	if (!DestinationHandle.Get()) { return false; }
+
+	return DestinationHandle->Write(Data.data(), static_cast<int32_t>(Data.size()));
+}
+
+bool MeshCooker::ParseObj(const std::string& Source, std::vector<Submesh>& Submeshes) const
+{
+	std::vector<glm::vec3> Positions;
+	std::vector<glm::vec2> TexCoords;
+	std::vector<glm::vec3> Normals;
+
+	Submeshes.emplace_back();
+
+	size_t LineBegin = 0;
+
+	while (LineBegin < Source.size())
+	{
+		size_t LineEnd = Source.find('\n', LineBegin);
+		if (LineEnd == std::string::npos) { LineEnd = Source.size(); }
+
+		const std::string Line = Source.substr(LineBegin, LineEnd - LineBegin);
+		LineBegin = LineEnd + 1;
+
+		const char* Cursor = Line.c_str();
+
+		if (std::strncmp(Cursor, "v ", 2) == 0)
+		{
+			glm::vec3 Position;
+			Position.x = std::strtof(Cursor + 2, const_cast<char**>(&Cursor));
+			Position.y = std::strtof(Cursor, const_cast<char**>(&Cursor));
+			Position.z = std::strtof(Cursor, const_cast<char**>(&Cursor));
+			Positions.push_back(Position);
+		}
+		else if (std::strncmp(Cursor, "vt ", 3) == 0)
+		{
+			glm::vec2 TexCoord;
+			TexCoord.x = std::strtof(Cursor + 3, const_cast<char**>(&Cursor));
+			TexCoord.y = std::strtof(Cursor, const_cast<char**>(&Cursor));
+			TexCoords.push_back(TexCoord);
+		}
+		else if (std::strncmp(Cursor, "vn ", 3) == 0)
+		{
+			glm::vec3 Normal;
+			Normal.x = std::strtof(Cursor + 3, const_cast<char**>(&Cursor));
+			Normal.y = std::strtof(Cursor, const_cast<char**>(&Cursor));
+			Normal.z = std::strtof(Cursor, const_cast<char**>(&Cursor));
+			Normals.push_back(Normal);
+		}
+		else if (std::strncmp(Cursor, "usemtl", 6) == 0)
+		{
+			// New material starts a new submesh
+			if (!Submeshes.back().Indices.empty())
+			{
+				Submeshes.emplace_back();
+			}
+		}
+		else if (std::strncmp(Cursor, "f ", 2) == 0)
+		{
+			Submesh& Mesh = Submeshes.back();
+
+			std::vector<StaticMeshFile::UnpackedVertex> Corners;
+			std::vector<bool> HasNormal;
+
+			Cursor += 2;
+
+			while (true)
+			{
+				char* End = nullptr;
+				const long PositionIndex = std::strtol(Cursor, &End, 10);
+
+				if (End == Cursor) { break; }
+				Cursor = End;
+
+				long TexCoordIndex = 0;
+				long NormalIndex = 0;
+
+				if (*Cursor == '/')
+				{
+					++Cursor;
+					TexCoordIndex = std::strtol(Cursor, &End, 10);
+					Cursor = End;
+
+					if (*Cursor == '/')
+					{
+						++Cursor;
+						NormalIndex = std::strtol(Cursor, &End, 10);
+						Cursor = End;
+					}
+				}
+
+				const int32_t Position = ResolveObjIndex(PositionIndex, Positions.size());
+				const int32_t TexCoord = TexCoordIndex != 0 ? ResolveObjIndex(TexCoordIndex, TexCoords.size()) : -1;
+				const int32_t Normal = NormalIndex != 0 ? ResolveObjIndex(NormalIndex, Normals.size()) : -1;
+
+				if (Position < 0) { return false; }
+
+				StaticMeshFile::UnpackedVertex Corner = {};
+				Corner.Position = Positions[Position];
+				Corner.TexCoord = TexCoord >= 0 ? TexCoords[TexCoord] : glm::vec2(0.0f);
+				Corner.Normal = Normal >= 0 ? Normals[Normal] : glm::vec3(0.0f);
+
+				Corners.push_back(Corner);
+				HasNormal.push_back(Normal >= 0);
+			}
+
+			if (Corners.size() < 3) { return false; }
+
+			// Corners without a normal get the face's one
+			const glm::vec3 FaceNormal = glm::cross(Corners[1].Position - Corners[0].Position, Corners[2].Position - Corners[0].Position);
+			const float FaceNormalLength = glm::length(FaceNormal);
+
+			for (size_t i = 0; i < Corners.size(); ++i)
+			{
+				if (!HasNormal[i] && FaceNormalLength > 0.0f)
+				{
+					Corners[i].Normal = FaceNormal / FaceNormalLength;
+				}
+			}
+
+			// Polygons are triangulated as fans, every corner is a separate vertex until welding
+			const uint32_t FirstCorner = static_cast<uint32_t>(Mesh.Vertices.size());
+
+			for (uint32_t i = 1; i + 1 < Corners.size(); ++i)
+			{
+				Mesh.Indices.push_back(FirstCorner);
+				Mesh.Indices.push_back(FirstCorner + i);
+				Mesh.Indices.push_back(FirstCorner + i + 1);
+			}
+
+			Mesh.Vertices.insert(Mesh.Vertices.end(), Corners.begin(), Corners.end());
+		}
+	}
+
+	Submeshes.erase(std::remove_if(Submeshes.begin(), Submeshes.end(), [](const Submesh& Mesh) { return Mesh.Indices.empty(); }), Submeshes.end());
+
+	return true;
+}
+
+CookedSubmeshReport MeshCooker::CookSubmesh(Submesh& Mesh, std::vector<Submesh>& Lods) const
+{
+	CookedSubmeshReport Report = {};
+	Report.CornersCount = static_cast<uint32_t>(Mesh.Vertices.size());
+
+	// Normals are normalized before welding, so corners that differ only by their normals' length are merged
+	for (StaticMeshFile::UnpackedVertex& Vertex : Mesh.Vertices)
+	{
+		const float Length = glm::length(Vertex.Normal);
+		Vertex.Normal = Length > 0.0f ? Vertex.Normal / Length : Vertex.Normal;
+	}
+
+	MeshOptimization::WeldVertices(Mesh.Vertices, Mesh.Indices);
+	RemoveDegenerateTriangles(Mesh);
+	ComputeTangents(Mesh);
+
+	const uint32_t VerticesCount = static_cast<uint32_t>(Mesh.Vertices.size());
+
+	std::vector<glm::vec3> Positions(VerticesCount);
+
+	for (uint32_t i = 0; i < VerticesCount; ++i)
+	{
+		Positions[i] = Mesh.Vertices[i].Position;
+	}
+
+	// Errors are relative to the same bounding sphere the engine computes, around the center of the bounding box
+	glm::vec3 Min = Positions.empty() ? glm::vec3(0.0f) : Positions.front();
+	glm::vec3 Max = Min;
+
+	for (const glm::vec3& Position : Positions)
+	{
+		Min = glm::min(Min, Position);
+		Max = glm::max(Max, Position);
+	}
+
+	float Radius = 0.0f;
+
+	for (const glm::vec3& Position : Positions)
+	{
+		Radius = glm::max(Radius, glm::length(Position - (Min + Max) * 0.5f));
+	}
+
+	// Every level simplifies the previous one, so its error adds to the previous levels' errors
+	const uint32_t LodsCount = glm::clamp(mSettings.LodsCount, 1u, StaticMeshFile::MaxLodsCount);
+	std::vector<uint32_t> LodIndices = Mesh.Indices;
+	float LodError = 0.0f;
+
+	Lods.resize(LodsCount);
+
+	for (uint32_t Lod = 0; Lod < LodsCount; ++Lod)
+	{
+		if (Lod > 0)
+		{
+			const uint32_t TargetIndicesCount = static_cast<uint32_t>(LodIndices.size() / 3 * mSettings.LodReduction) * 3;
+			LodError += MeshOptimization::Simplify(LodIndices, Positions, TargetIndicesCount);
+		}
+
+		Lods[Lod].Vertices = Mesh.Vertices;
+		Lods[Lod].Indices = LodIndices;
+
+		const VertexCacheStats Before = MeshOptimization::AnalyzeVertexCache(Lods[Lod].Indices, VerticesCount);
+
+		OptimizeSubmesh(Lods[Lod], Positions);
+
+		if (Lod == 0)
+		{
+			Report.Before = Before;
+			Report.After = MeshOptimization::AnalyzeVertexCache(Lods[Lod].Indices, static_cast<uint32_t>(Lods[Lod].Vertices.size()));
+			Report.TrianglesCount = static_cast<uint32_t>(Lods[Lod].Indices.size() / 3);
+			Report.VerticesCount = static_cast<uint32_t>(Lods[Lod].Vertices.size());
+			Report.MeshletsCount = static_cast<uint32_t>(Lods[Lod].Meshlets.size());
+		}
+
+		Report.LodTrianglesCount.push_back(static_cast<uint32_t>(Lods[Lod].Indices.size() / 3));
+		Report.LodErrors.push_back(Radius > 0.0f ? LodError / Radius : 0.0f);
+	}
+
+	return Report;
+}
+
+void MeshCooker::OptimizeSubmesh(Submesh& Mesh, const std::vector<glm::vec3>& Positions) const
+{
+	const uint32_t VerticesCount = static_cast<uint32_t>(Mesh.Vertices.size());
+
+	if (mSettings.OptimizeVertexCache)
+	{
+		MeshOptimization::OptimizeVertexCache(Mesh.Indices, VerticesCount);
+	}
+
+	if (mSettings.OptimizeOverdraw)
+	{
+		MeshOptimization::OptimizeOverdraw(Mesh.Indices, Positions, mSettings.OverdrawThreshold);
+	}
+
+	// Meshlets grow from triangles in the optimized order, so the order is roughly kept between them
+	MeshOptimization::BuildMeshlets(Mesh.Indices, Positions, Mesh.Meshlets);
+
+	// Vertices that simplification doesn't use anymore are dropped here
+	MeshOptimization::OptimizeVertexFetch(Mesh.Vertices, Mesh.Indices);
+}
+
+std::vector<float> MeshCooker::ComputeLodScreenSizes(uint32_t LodsCount) const
+{
+	// Level is used once its error covers at most LodPixelError pixels of the reference screen height
+	// Screen size of the bounding sphere is its radius over the distance scaled by the projection, so the error in pixels is RelativeError * ScreenSize * Height / 2
+	std::vector<float> ScreenSizes(LodsCount, 1.0f);
+
+	for (uint32_t Lod = 1; Lod < LodsCount; ++Lod)
+	{
+		float MaxError = 0.0f;
+
+		for (const CookedSubmeshReport& Report : mReports)
+		{
+			MaxError = glm::max(MaxError, Report.LodErrors[Lod]);
+		}
+
+		const float ScreenSize = MaxError > 0.0f ? 2.0f * mSettings.LodPixelError / (MaxError * mSettings.LodReferenceHeight) : 1.0f;
+		ScreenSizes[Lod] = glm::min(ScreenSize, ScreenSizes[Lod - 1]);
+	}
+
+	return ScreenSizes;
+}
+
+void MeshCooker::RemoveDegenerateTriangles(Submesh& Mesh)
+{
+	uint32_t Kept = 0;
+
+	for (uint32_t i = 0; i + 2 < Mesh.Indices.size(); i += 3)
+	{
+		const uint32_t A = Mesh.Indices[i];
+		const uint32_t B = Mesh.Indices[i + 1];
+		const uint32_t C = Mesh.Indices[i + 2];
+
+		if (A == B || B == C || A == C) { continue; }
+
+		Mesh.Indices[Kept++] = A;
+		Mesh.Indices[Kept++] = B;
+		Mesh.Indices[Kept++] = C;
+	}
+
+	Mesh.Indices.resize(Kept);
+}
+
+void MeshCooker::ComputeTangents(Submesh& Mesh)
+{
+	for (StaticMeshFile::UnpackedVertex& Vertex : Mesh.Vertices)
+	{
+		Vertex.Tangent = glm::vec3(0.0f);
+	}
+
+	// Tangents of triangles are summed on their welded vertices, bigger triangles have more weight
+	for (uint32_t i = 0; i + 2 < Mesh.Indices.size(); i += 3)
+	{
+		StaticMeshFile::UnpackedVertex& A = Mesh.Vertices[Mesh.Indices[i]];
+		StaticMeshFile::UnpackedVertex& B = Mesh.Vertices[Mesh.Indices[i + 1]];
+		StaticMeshFile::UnpackedVertex& C = Mesh.Vertices[Mesh.Indices[i + 2]];
+
+		const glm::vec3 Edge1 = B.Position - A.Position;
+		const glm::vec3 Edge2 = C.Position - A.Position;
+		const glm::vec2 DeltaUV1 = B.TexCoord - A.TexCoord;
+		const glm::vec2 DeltaUV2 = C.TexCoord - A.TexCoord;
+
+		const float Determinant = DeltaUV1.x * DeltaUV2.y - DeltaUV1.y * DeltaUV2.x;
+
+		if (glm::abs(Determinant) <= 1e-12f) { continue; }
+
+		const glm::vec3 Tangent = (Edge1 * DeltaUV2.y - Edge2 * DeltaUV1.y) / Determinant;
+
+		A.Tangent += Tangent;
+		B.Tangent += Tangent;
+		C.Tangent += Tangent;
+	}
+
+	for (StaticMeshFile::UnpackedVertex& Vertex : Mesh.Vertices)
+	{
+		// Gram-Schmidt keeps the tangent perpendicular to the normal
+		glm::vec3 Tangent = Vertex.Tangent - Vertex.Normal * glm::dot(Vertex.Normal, Vertex.Tangent);
+
+		if (glm::length(Tangent) <= 1e-6f)
+		{
+			// Any direction perpendicular to the normal for vertices without texture space
+			const glm::vec3 Axis = glm::abs(Vertex.Normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+			Tangent = glm::cross(Vertex.Normal, Axis);
+		}
+
+		const float Length = glm::length(Tangent);
+		Vertex.Tangent = Length > 0.0f ? Tangent / Length : glm::vec3(1.0f, 0.0f, 0.0f);
+	}
+}
+
+void MeshCooker::WriteSubmesh(const Submesh& Mesh, std::vector<uint8_t>& Data)
+{
+	std::vector<VertexDefinition::StaticMesh> PackedVertices;
+	glm::vec3 Scale;
+	glm::vec3 Bias;
+	StaticMeshFile::PackVertices(Mesh.Vertices, PackedVertices, Scale, Bias);
+
+	const uint32_t VerticesCount = static_cast<uint32_t>(PackedVertices.size());
+	const uint32_t IndicesCount = static_cast<uint32_t>(Mesh.Indices.size());
+
+	AppendData(Data, &VerticesCount);
+	AppendData(Data, &Scale);
+	AppendData(Data, &Bias);
+	AppendData(Data, PackedVertices.data(), PackedVertices.size());
+
+	// Same rule as in the geometry pool
+	const uint32_t IndexSize = VerticesCount <= 65536 ? sizeof(uint16_t) : sizeof(uint32_t);
+
+	AppendData(Data, &IndicesCount);
+	AppendData(Data, &IndexSize);
+
+	if (IndexSize == sizeof(uint16_t))
+	{
+		const std::vector<uint16_t> NarrowIndices(Mesh.Indices.begin(), Mesh.Indices.end());
+		AppendData(Data, NarrowIndices.data(), NarrowIndices.size());
+	}
+	else
+	{
+		AppendData(Data, Mesh.Indices.data(), Mesh.Indices.size());
+	}
+
+	const uint32_t MeshletsCount = static_cast<uint32_t>(Mesh.Meshlets.size());
+
+	AppendData(Data, &MeshletsCount);
+	AppendData(Data, Mesh.Meshlets.data(), Mesh.Meshlets.size());
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "mesh_optimization.h"
+#include "static_mesh.h"
+
+struct MeshCookerSettings
+{
+	bool OptimizeVertexCache = true;
+	bool OptimizeOverdraw = true;
+	float OverdrawThreshold = 1.05f; // See MeshOptimization::OptimizeOverdraw
+	uint32_t LodsCount = 4; // Including the original mesh, up to StaticMeshFile::MaxLodsCount
+	float LodReduction = 0.5f; // Triangles of every level relative to the previous one
+	float LodPixelError = 1.0f; // Screen sizes of levels are chosen so their error stays below this many pixels
+	float LodReferenceHeight = 1080.0f;
+};
+
+// Result of cooking one submesh, cache statistics are measured before and after the optimizations
+struct CookedSubmeshReport
+{
+	uint32_t TrianglesCount = 0;
+	uint32_t CornersCount = 0; // Vertices before welding
+	uint32_t VerticesCount = 0;
+	uint32_t MeshletsCount = 0; // Of the first level
+	VertexCacheStats Before; // Of the first level
+	VertexCacheStats After;
+	std::vector<uint32_t> LodTrianglesCount;
+	std::vector<float> LodErrors; // Relative to the radius of the submesh's bounding sphere
+};
+
+// Turns .obj files into packed .sm files, every material starts a new submesh
+// Identical vertices are welded, tangents are averaged over the welded vertices and triangles are reordered for the vertex cache and overdraw
+// Lower levels of detail are simplified from the previous level with quadric error metrics, every submesh has the same number of levels
+// Triangles of every level are grouped into meshlets for cluster culling
+class MeshCooker
+{
+public:
+	explicit MeshCooker(const MeshCookerSettings& Settings = MeshCookerSettings());
+
+	bool Cook(const std::string& SourcePath, const std::string& DestinationPath);
+
+	// Reports of the last cooked file
+	inline const std::vector<CookedSubmeshReport>& GetReports() const { return mReports; }
+
+private:
+	struct Submesh
+	{
+		std::vector<StaticMeshFile::UnpackedVertex> Vertices;
+		std::vector<uint32_t> Indices;
+		std::vector<Meshlet> Meshlets;
+	};
+
+	bool ParseObj(const std::string& Source, std::vector<Submesh>& Submeshes) const;
+	CookedSubmeshReport CookSubmesh(Submesh& Mesh, std::vector<Submesh>& Lods) const;
+	void OptimizeSubmesh(Submesh& Mesh, const std::vector<glm::vec3>& Positions) const;
+
+	// Screen size below which every level can be used, based on the largest error of all submeshes
+	std::vector<float> ComputeLodScreenSizes(uint32_t LodsCount) const;
+
+	static void RemoveDegenerateTriangles(Submesh& Mesh);
+	static void ComputeTangents(Submesh& Mesh);
+	static void WriteSubmesh(const Submesh& Mesh, std::vector<uint8_t>& Data);
+
+	MeshCookerSettings mSettings;
+	std::vector<CookedSubmeshReport> mReports;
+
+};
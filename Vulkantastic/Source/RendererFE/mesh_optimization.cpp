@@ -0,0 +1,871 @@
+#define NOMINMAX
+#include "mesh_optimization.h"
+#include <cstring>
+
+namespace
+{
+	// FIFO cache with a timestamp per vertex, a vertex is cached when it was added during the last CacheSize misses
+	class FIFOCacheSimulation
+	{
+	public:
+		FIFOCacheSimulation(uint32_t VerticesCount, uint32_t CacheSize)
+			: mTimestamps(VerticesCount, 0), mCacheSize(CacheSize), mTimestamp(CacheSize + 1)
+		{
+
+		}
+
+		// Returns number of vertices of the triangle that had to be transformed
+		uint32_t AddTriangle(const uint32_t* Triangle)
+		{
+			uint32_t Misses = 0;
+
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				if (mTimestamp - mTimestamps[Triangle[i]] > mCacheSize)
+				{
+					mTimestamps[Triangle[i]] = mTimestamp++;
+					++Misses;
+				}
+			}
+
+			return Misses;
+		}
+
+		void Flush()
+		{
+			mTimestamp += mCacheSize + 1;
+		}
+
+	private:
+		std::vector<uint32_t> mTimestamps;
+		uint32_t mCacheSize;
+		uint32_t mTimestamp;
+
+	};
+
+	// Constants from Tom Forsyth's paper
+	constexpr uint32_t ForsythCacheSize = 32;
+	constexpr float CacheDecayPower = 1.5f;
+	constexpr float LastTriangleScore = 0.75f;
+	constexpr float ValenceBoostScale = 2.0f;
+	constexpr float ValenceBoostPower = 0.5f;
+
+	float ForsythVertexScore(int32_t CachePosition, uint32_t RemainingTriangles)
+	{
+		if (RemainingTriangles == 0) { return -1.0f; }
+
+		float Score = 0.0f;
+
+		if (CachePosition >= 0)
+		{
+			// Vertices of the last triangle get a fixed score, so the next triangle doesn't have to share its edge
+			if (CachePosition < 3)
+			{
+				Score = LastTriangleScore;
+			}
+			else
+			{
+				const float Scaler = 1.0f / (ForsythCacheSize - 3);
+				Score = glm::pow(1.0f - (CachePosition - 3) * Scaler, CacheDecayPower);
+			}
+		}
+
+		// Vertices with few triangles left are finished first, so they don't have to be transformed again later
+		Score += ValenceBoostScale * glm::pow(static_cast<float>(RemainingTriangles), -ValenceBoostPower);
+
+		return Score;
+	}
+
+	uint64_t HashBytes(const uint8_t* Data, uint32_t Size)
+	{
+		// FNV-1a
+		uint64_t Hash = 14695981039346656037ull;
+
+		for (uint32_t i = 0; i < Size; ++i)
+		{
+			Hash ^= Data[i];
+			Hash *= 1099511628211ull;
+		}
+
+		return Hash;
+	}
+
+	struct TriangleCluster
+	{
+		uint32_t Begin = 0; // In triangles
+		uint32_t End = 0;
+		float SortKey = 0.0f;
+	};
+
+	// Sum of squared distances to planes, stored as the upper half of a symmetric 4x4 matrix
+	// Planes are weighted by areas of their triangles, so the error divided by the weight is a squared distance
+	struct Quadric
+	{
+		double A00 = 0.0, A01 = 0.0, A02 = 0.0, A03 = 0.0;
+		double A11 = 0.0, A12 = 0.0, A13 = 0.0;
+		double A22 = 0.0, A23 = 0.0;
+		double A33 = 0.0;
+		double Weight = 0.0;
+
+		void AddPlane(const glm::vec3& Normal, float Distance, float PlaneWeight)
+		{
+			const double X = Normal.x, Y = Normal.y, Z = Normal.z, W = Distance;
+
+			A00 += X * X * PlaneWeight; A01 += X * Y * PlaneWeight; A02 += X * Z * PlaneWeight; A03 += X * W * PlaneWeight;
+			A11 += Y * Y * PlaneWeight; A12 += Y * Z * PlaneWeight; A13 += Y * W * PlaneWeight;
+			A22 += Z * Z * PlaneWeight; A23 += Z * W * PlaneWeight;
+			A33 += W * W * PlaneWeight;
+			Weight += PlaneWeight;
+		}
+
+		void Add(const Quadric& Rhs)
+		{
+			A00 += Rhs.A00; A01 += Rhs.A01; A02 += Rhs.A02; A03 += Rhs.A03;
+			A11 += Rhs.A11; A12 += Rhs.A12; A13 += Rhs.A13;
+			A22 += Rhs.A22; A23 += Rhs.A23;
+			A33 += Rhs.A33;
+			Weight += Rhs.Weight;
+		}
+
+		// Squared distance of the point to the planes
+		float Evaluate(const glm::vec3& Point) const
+		{
+			const double X = Point.x, Y = Point.y, Z = Point.z;
+
+			const double Error = A00 * X * X + A11 * Y * Y + A22 * Z * Z + A33
+				+ 2.0 * (A01 * X * Y + A02 * X * Z + A12 * Y * Z + A03 * X + A13 * Y + A23 * Z);
+
+			return Weight > 0.0 ? static_cast<float>(glm::abs(Error) / Weight) : 0.0f;
+		}
+	};
+
+	struct EdgeCollapse
+	{
+		uint32_t From = 0;
+		uint32_t To = 0;
+		float Error = 0.0f;
+	};
+
+	glm::vec3 TriangleNormal(const glm::vec3& A, const glm::vec3& B, const glm::vec3& C)
+	{
+		return glm::cross(B - A, C - A);
+	}
+}
+
+VertexCacheStats MeshOptimization::AnalyzeVertexCache(const std::vector<uint32_t>& Indices, uint32_t VerticesCount, uint32_t CacheSize /*= DefaultCacheSize*/)
+{
+	VertexCacheStats Result = {};
+
+	const uint32_t TrianglesCount = static_cast<uint32_t>(Indices.size() / 3);
+
+	if (TrianglesCount == 0) { return Result; }
+
+	FIFOCacheSimulation Cache(VerticesCount, CacheSize);
+	std::vector<bool> Used(VerticesCount, false);
+
+	uint32_t Misses = 0;
+	uint32_t UsedCount = 0;
+
+	for (uint32_t i = 0; i < TrianglesCount; ++i)
+	{
+		Misses += Cache.AddTriangle(&Indices[i * 3]);
+	}
+
+	for (uint32_t Index : Indices)
+	{
+		if (!Used[Index])
+		{
+			Used[Index] = true;
+			++UsedCount;
+		}
+	}
+
+	Result.ACMR = static_cast<float>(Misses) / TrianglesCount;
+	Result.ATVR = static_cast<float>(Misses) / UsedCount;
+
+	return Result;
+}
+
+uint32_t MeshOptimization::BuildWeldRemap(const uint8_t* Vertices, uint32_t VerticesCount, uint32_t Stride, std::vector<uint32_t>& Remap)
+{
+	Remap.resize(VerticesCount);
+
+	// Open addressing table of vertex indices, at most half full
+	uint32_t TableSize = 1;
+	while (TableSize < VerticesCount * 2) { TableSize *= 2; }
+
+	std::vector<uint32_t> Table(TableSize, InvalidIndex);
+
+	uint32_t UniqueCount = 0;
+
+	for (uint32_t i = 0; i < VerticesCount; ++i)
+	{
+		const uint8_t* Vertex = Vertices + static_cast<size_t>(i) * Stride;
+
+		uint32_t Slot = static_cast<uint32_t>(HashBytes(Vertex, Stride)) & (TableSize - 1);
+
+		while (Table[Slot] != InvalidIndex && std::memcmp(Vertices + static_cast<size_t>(Table[Slot]) * Stride, Vertex, Stride) != 0)
+		{
+			Slot = (Slot + 1) & (TableSize - 1);
+		}
+
+		if (Table[Slot] == InvalidIndex)
+		{
+			Table[Slot] = i;
+			++UniqueCount;
+		}
+
+		Remap[i] = Table[Slot];
+	}
+
+	return UniqueCount;
+}
+
+uint32_t MeshOptimization::BuildFetchRemap(const std::vector<uint32_t>& Indices, uint32_t VerticesCount, std::vector<uint32_t>& Remap)
+{
+	Remap.assign(VerticesCount, InvalidIndex);
+
+	uint32_t NextIndex = 0;
+
+	for (uint32_t Index : Indices)
+	{
+		if (Remap[Index] == InvalidIndex)
+		{
+			Remap[Index] = NextIndex++;
+		}
+	}
+
+	return NextIndex;
+}
+
+void MeshOptimization::OptimizeVertexCache(std::vector<uint32_t>& Indices, uint32_t VerticesCount)
+{
+	const uint32_t TrianglesCount = static_cast<uint32_t>(Indices.size() / 3);
+
+	if (TrianglesCount == 0) { return; }
+
+	// Triangles of every vertex, emitted triangles are moved behind the remaining ones
+	std::vector<uint32_t> AdjacencyOffsets(VerticesCount + 1, 0);
+	std::vector<uint32_t> RemainingTriangles(VerticesCount, 0);
+	std::vector<uint32_t> Adjacency(Indices.size());
+
+	for (uint32_t Index : Indices)
+	{
+		++RemainingTriangles[Index];
+	}
+
+	for (uint32_t i = 0; i < VerticesCount; ++i)
+	{
+		AdjacencyOffsets[i + 1] = AdjacencyOffsets[i] + RemainingTriangles[i];
+	}
+
+	std::vector<uint32_t> AdjacencyFill(AdjacencyOffsets.begin(), AdjacencyOffsets.end() - 1);
+
+	for (uint32_t i = 0; i < TrianglesCount; ++i)
+	{
+		for (uint32_t j = 0; j < 3; ++j)
+		{
+			const uint32_t Index = Indices[i * 3 + j];
+			Adjacency[AdjacencyFill[Index]++] = i;
+		}
+	}
+
+	std::vector<int32_t> CachePositions(VerticesCount, -1);
+	std::vector<float> VertexScores(VerticesCount);
+	std::vector<float> TriangleScores(TrianglesCount, 0.0f);
+	std::vector<bool> Emitted(TrianglesCount, false);
+
+	for (uint32_t i = 0; i < VerticesCount; ++i)
+	{
+		VertexScores[i] = ForsythVertexScore(-1, RemainingTriangles[i]);
+	}
+
+	uint32_t BestTriangle = 0;
+
+	for (uint32_t i = 0; i < TrianglesCount; ++i)
+	{
+		TriangleScores[i] = VertexScores[Indices[i * 3]] + VertexScores[Indices[i * 3 + 1]] + VertexScores[Indices[i * 3 + 2]];
+
+		if (TriangleScores[i] > TriangleScores[BestTriangle])
+		{
+			BestTriangle = i;
+		}
+	}
+
+	std::vector<uint32_t> Result;
+	Result.reserve(Indices.size());
+
+	std::vector<uint32_t> Cache;
+	std::vector<uint32_t> NewCache;
+	Cache.reserve(ForsythCacheSize + 3);
+	NewCache.reserve(ForsythCacheSize + 3);
+
+	// Next triangle to take when none of the cached vertices has triangles left
+	uint32_t Cursor = 0;
+
+	for (uint32_t Step = 0; Step < TrianglesCount; ++Step)
+	{
+		if (BestTriangle == InvalidIndex)
+		{
+			while (Emitted[Cursor]) { ++Cursor; }
+			BestTriangle = Cursor;
+		}
+
+		const uint32_t* Triangle = &Indices[BestTriangle * 3];
+
+		Result.insert(Result.end(), Triangle, Triangle + 3);
+		Emitted[BestTriangle] = true;
+
+		NewCache.assign(Triangle, Triangle + 3);
+
+		for (uint32_t j = 0; j < 3; ++j)
+		{
+			const uint32_t Index = Triangle[j];
+
+			// Emitted triangle is swapped behind the remaining ones
+			const uint32_t Begin = AdjacencyOffsets[Index];
+			const uint32_t End = Begin + RemainingTriangles[Index];
+
+			for (uint32_t k = Begin; k < End; ++k)
+			{
+				if (Adjacency[k] == BestTriangle)
+				{
+					std::swap(Adjacency[k], Adjacency[End - 1]);
+					break;
+				}
+			}
+
+			--RemainingTriangles[Index];
+		}
+
+		for (uint32_t Index : Cache)
+		{
+			if (Index != Triangle[0] && Index != Triangle[1] && Index != Triangle[2])
+			{
+				NewCache.push_back(Index);
+			}
+		}
+
+		Cache.swap(NewCache);
+
+		// Vertices pushed out of the cache lose their cache score, their triangles are updated as well
+		for (uint32_t i = 0; i < Cache.size(); ++i)
+		{
+			const uint32_t Index = Cache[i];
+
+			CachePositions[Index] = i < ForsythCacheSize ? static_cast<int32_t>(i) : -1;
+			VertexScores[Index] = ForsythVertexScore(CachePositions[Index], RemainingTriangles[Index]);
+		}
+
+		BestTriangle = InvalidIndex;
+		float BestScore = -1.0f;
+
+		for (uint32_t Index : Cache)
+		{
+			const uint32_t Begin = AdjacencyOffsets[Index];
+			const uint32_t End = Begin + RemainingTriangles[Index];
+
+			for (uint32_t k = Begin; k < End; ++k)
+			{
+				const uint32_t Candidate = Adjacency[k];
+				const uint32_t* CandidateIndices = &Indices[Candidate * 3];
+
+				TriangleScores[Candidate] = VertexScores[CandidateIndices[0]] + VertexScores[CandidateIndices[1]] + VertexScores[CandidateIndices[2]];
+
+				if (TriangleScores[Candidate] > BestScore)
+				{
+					BestScore = TriangleScores[Candidate];
+					BestTriangle = Candidate;
+				}
+			}
+		}
+
+		if (Cache.size() > ForsythCacheSize)
+		{
+			Cache.resize(ForsythCacheSize);
+		}
+	}
+
+	Indices.swap(Result);
+}
+
+void MeshOptimization::OptimizeOverdraw(std::vector<uint32_t>& Indices, const std::vector<glm::vec3>& Positions, float Threshold /*= 1.05f*/)
+{
+	const uint32_t TrianglesCount = static_cast<uint32_t>(Indices.size() / 3);
+	const uint32_t VerticesCount = static_cast<uint32_t>(Positions.size());
+
+	if (TrianglesCount == 0) { return; }
+
+	// Hard boundaries are where the cache optimization had to start over, all vertices of the triangle miss the cache
+	std::vector<uint32_t> HardBoundaries = { 0 };
+
+	{
+		FIFOCacheSimulation Cache(VerticesCount, DefaultCacheSize);
+
+		for (uint32_t i = 0; i < TrianglesCount; ++i)
+		{
+			if (Cache.AddTriangle(&Indices[i * 3]) == 3 && i > 0)
+			{
+				HardBoundaries.push_back(i);
+			}
+		}
+
+		HardBoundaries.push_back(TrianglesCount);
+	}
+
+	// Soft boundaries split the runs further as long as the cache efficiency doesn't get worse than Threshold allows
+	std::vector<TriangleCluster> Clusters;
+
+	for (uint32_t i = 0; i + 1 < HardBoundaries.size(); ++i)
+	{
+		const uint32_t Begin = HardBoundaries[i];
+		const uint32_t End = HardBoundaries[i + 1];
+
+		FIFOCacheSimulation Cache(VerticesCount, DefaultCacheSize);
+
+		uint32_t RunMisses = 0;
+
+		for (uint32_t j = Begin; j < End; ++j)
+		{
+			RunMisses += Cache.AddTriangle(&Indices[j * 3]);
+		}
+
+		const float MissesLimit = Threshold * RunMisses / (End - Begin);
+
+		Cache.Flush();
+
+		uint32_t ClusterBegin = Begin;
+		uint32_t ClusterMisses = 0;
+
+		for (uint32_t j = Begin; j < End; ++j)
+		{
+			ClusterMisses += Cache.AddTriangle(&Indices[j * 3]);
+
+			if (j + 1 == End || ClusterMisses <= MissesLimit * (j + 1 - ClusterBegin))
+			{
+				TriangleCluster Cluster = {};
+				Cluster.Begin = ClusterBegin;
+				Cluster.End = j + 1;
+				Clusters.push_back(Cluster);
+
+				ClusterBegin = j + 1;
+				ClusterMisses = 0;
+				Cache.Flush();
+			}
+		}
+	}
+
+	// Clusters facing away from the mesh's center cover the ones behind them
+	std::vector<glm::vec3> ClusterCentroids(Clusters.size(), glm::vec3(0.0f));
+	std::vector<glm::vec3> ClusterNormals(Clusters.size(), glm::vec3(0.0f));
+
+	glm::vec3 MeshCentroid(0.0f);
+	float MeshArea = 0.0f;
+
+	for (uint32_t i = 0; i < Clusters.size(); ++i)
+	{
+		float ClusterArea = 0.0f;
+
+		for (uint32_t j = Clusters[i].Begin; j < Clusters[i].End; ++j)
+		{
+			const glm::vec3& A = Positions[Indices[j * 3]];
+			const glm::vec3& B = Positions[Indices[j * 3 + 1]];
+			const glm::vec3& C = Positions[Indices[j * 3 + 2]];
+
+			// Length of the cross product is twice the area, so the sum is an area weighted normal
+			const glm::vec3 Normal = glm::cross(B - A, C - A);
+			const float Area = glm::length(Normal);
+
+			ClusterNormals[i] += Normal;
+			ClusterCentroids[i] += (A + B + C) * (Area / 3.0f);
+			ClusterArea += Area;
+		}
+
+		MeshCentroid += ClusterCentroids[i];
+		MeshArea += ClusterArea;
+
+		ClusterCentroids[i] = ClusterArea > 0.0f ? ClusterCentroids[i] / ClusterArea : Positions[Indices[Clusters[i].Begin * 3]];
+	}
+
+	MeshCentroid = MeshArea > 0.0f ? MeshCentroid / MeshArea : glm::vec3(0.0f);
+
+	for (uint32_t i = 0; i < Clusters.size(); ++i)
+	{
+		const float NormalLength = glm::length(ClusterNormals[i]);
+		const glm::vec3 Normal = NormalLength > 0.0f ? ClusterNormals[i] / NormalLength : glm::vec3(0.0f);
+
+		Clusters[i].SortKey = glm::dot(ClusterCentroids[i] - MeshCentroid, Normal);
+	}
+
+	std::stable_sort(Clusters.begin(), Clusters.end(), [](const TriangleCluster& Lhs, const TriangleCluster& Rhs) {
+		return Lhs.SortKey > Rhs.SortKey;
+	});
+
+	std::vector<uint32_t> Result;
+	Result.reserve(Indices.size());
+
+	for (const TriangleCluster& Cluster : Clusters)
+	{
+		Result.insert(Result.end(), Indices.begin() + Cluster.Begin * 3, Indices.begin() + Cluster.End * 3);
+	}
+
+	Indices.swap(Result);
+}
+
+float MeshOptimization::Simplify(std::vector<uint32_t>& Indices, const std::vector<glm::vec3>& Positions, uint32_t TargetIndicesCount)
+{
+	const uint32_t VerticesCount = static_cast<uint32_t>(Positions.size());
+
+	// Vertices with the same position but different attributes are seams, moving only one of them would tear the surface
+	std::vector<uint32_t> PositionRemap;
+	BuildWeldRemap(reinterpret_cast<const uint8_t*>(Positions.data()), VerticesCount, sizeof(glm::vec3), PositionRemap);
+
+	// Locking is decided per position and applied to all vertices that share it
+	std::vector<bool> LockedPositions(VerticesCount, false);
+
+	for (uint32_t i = 0; i < VerticesCount; ++i)
+	{
+		if (PositionRemap[i] != i)
+		{
+			LockedPositions[PositionRemap[i]] = true;
+		}
+	}
+
+	// Vertices of open borders and non-manifold edges are locked as well, their edges are used by other than two triangles
+	std::vector<uint64_t> Edges;
+	Edges.reserve(Indices.size());
+
+	for (uint32_t i = 0; i < Indices.size(); i += 3)
+	{
+		for (uint32_t Corner = 0; Corner < 3; ++Corner)
+		{
+			const uint32_t A = PositionRemap[Indices[i + Corner]];
+			const uint32_t B = PositionRemap[Indices[i + (Corner + 1) % 3]];
+
+			Edges.push_back((static_cast<uint64_t>(glm::min(A, B)) << 32) | glm::max(A, B));
+		}
+	}
+
+	std::sort(Edges.begin(), Edges.end());
+
+	for (size_t Begin = 0; Begin < Edges.size();)
+	{
+		size_t End = Begin + 1;
+		while (End < Edges.size() && Edges[End] == Edges[Begin]) { ++End; }
+
+		if (End - Begin != 2)
+		{
+			LockedPositions[static_cast<uint32_t>(Edges[Begin] >> 32)] = true;
+			LockedPositions[static_cast<uint32_t>(Edges[Begin])] = true;
+		}
+
+		Begin = End;
+	}
+
+	std::vector<bool> Locked(VerticesCount, false);
+
+	for (uint32_t i = 0; i < VerticesCount; ++i)
+	{
+		Locked[i] = LockedPositions[PositionRemap[i]];
+	}
+
+	std::vector<Quadric> Quadrics(VerticesCount);
+
+	for (uint32_t i = 0; i < Indices.size(); i += 3)
+	{
+		const glm::vec3& A = Positions[Indices[i]];
+		const glm::vec3 Normal = TriangleNormal(A, Positions[Indices[i + 1]], Positions[Indices[i + 2]]);
+		const float Length = glm::length(Normal);
+
+		if (Length <= 0.0f) { continue; }
+
+		Quadric Plane;
+		Plane.AddPlane(Normal / Length, -glm::dot(Normal / Length, A), Length * 0.5f);
+
+		for (uint32_t Corner = 0; Corner < 3; ++Corner)
+		{
+			Quadrics[Indices[i + Corner]].Add(Plane);
+		}
+	}
+
+	float ResultError = 0.0f;
+
+	std::vector<uint32_t> TriangleOffsets;
+	std::vector<uint32_t> VertexTriangles;
+	std::vector<EdgeCollapse> Collapses;
+	std::vector<bool> Touched;
+	std::vector<uint32_t> Remap(VerticesCount);
+
+	// Every pass collapses the cheapest edges whose neighbourhoods don't overlap, then the index buffer is rebuilt
+	while (Indices.size() > TargetIndicesCount)
+	{
+		const uint32_t TrianglesCount = static_cast<uint32_t>(Indices.size() / 3);
+
+		// Triangles around every vertex
+		TriangleOffsets.assign(VerticesCount + 1, 0);
+
+		for (uint32_t Index : Indices) { ++TriangleOffsets[Index + 1]; }
+		for (uint32_t i = 0; i < VerticesCount; ++i) { TriangleOffsets[i + 1] += TriangleOffsets[i]; }
+
+		VertexTriangles.resize(Indices.size());
+		std::vector<uint32_t> Fill(TriangleOffsets.begin(), TriangleOffsets.end() - 1);
+
+		for (uint32_t i = 0; i < Indices.size(); ++i)
+		{
+			VertexTriangles[Fill[Indices[i]]++] = i / 3;
+		}
+
+		Collapses.clear();
+
+		for (uint32_t i = 0; i < Indices.size(); i += 3)
+		{
+			for (uint32_t Corner = 0; Corner < 3; ++Corner)
+			{
+				const uint32_t A = Indices[i + Corner];
+				const uint32_t B = Indices[i + (Corner + 1) % 3];
+
+				Quadric Combined = Quadrics[A];
+				Combined.Add(Quadrics[B]);
+
+				// Both directions of the edge, only the unlocked vertex can move
+				if (!Locked[A]) { Collapses.push_back({ A, B, Combined.Evaluate(Positions[B]) }); }
+				if (!Locked[B]) { Collapses.push_back({ B, A, Combined.Evaluate(Positions[A]) }); }
+			}
+		}
+
+		if (Collapses.empty()) { break; }
+
+		std::sort(Collapses.begin(), Collapses.end(), [](const EdgeCollapse& Lhs, const EdgeCollapse& Rhs) { return Lhs.Error < Rhs.Error; });
+
+		// Every collapse removes about two triangles
+		const uint32_t CollapsesLimit = glm::max((TrianglesCount - TargetIndicesCount / 3) / 2, 1u);
+		uint32_t CollapsesCount = 0;
+
+		Touched.assign(VerticesCount, false);
+
+		for (uint32_t i = 0; i < VerticesCount; ++i) { Remap[i] = i; }
+
+		for (const EdgeCollapse& Collapse : Collapses)
+		{
+			if (CollapsesCount >= CollapsesLimit) { break; }
+			if (Touched[Collapse.From] || Touched[Collapse.To]) { continue; }
+
+			// Triangles that stay have to keep their orientation
+			bool Flips = false;
+
+			for (uint32_t j = TriangleOffsets[Collapse.From]; j < TriangleOffsets[Collapse.From + 1] && !Flips; ++j)
+			{
+				const uint32_t* Triangle = &Indices[VertexTriangles[j] * 3];
+
+				if (Triangle[0] == Collapse.To || Triangle[1] == Collapse.To || Triangle[2] == Collapse.To) { continue; }
+
+				glm::vec3 Corners[3];
+
+				for (uint32_t Corner = 0; Corner < 3; ++Corner)
+				{
+					Corners[Corner] = Positions[Triangle[Corner] == Collapse.From ? Collapse.To : Triangle[Corner]];
+				}
+
+				const glm::vec3 Before = TriangleNormal(Positions[Triangle[0]], Positions[Triangle[1]], Positions[Triangle[2]]);
+				const glm::vec3 After = TriangleNormal(Corners[0], Corners[1], Corners[2]);
+
+				Flips = glm::dot(Before, After) <= 0.0f;
+			}
+
+			if (Flips) { continue; }
+
+			// Neighbours can't move in this pass, the flip test above assumed their positions
+			for (uint32_t j = TriangleOffsets[Collapse.From]; j < TriangleOffsets[Collapse.From + 1]; ++j)
+			{
+				const uint32_t* Triangle = &Indices[VertexTriangles[j] * 3];
+
+				Touched[Triangle[0]] = Touched[Triangle[1]] = Touched[Triangle[2]] = true;
+			}
+
+			Remap[Collapse.From] = Collapse.To;
+			Quadrics[Collapse.To].Add(Quadrics[Collapse.From]);
+
+			ResultError = glm::max(ResultError, Collapse.Error);
+			++CollapsesCount;
+		}
+
+		if (CollapsesCount == 0) { break; }
+
+		// Collapsed triangles become degenerate and are dropped
+		uint32_t Kept = 0;
+
+		for (uint32_t i = 0; i < Indices.size(); i += 3)
+		{
+			const uint32_t A = Remap[Indices[i]];
+			const uint32_t B = Remap[Indices[i + 1]];
+			const uint32_t C = Remap[Indices[i + 2]];
+
+			if (A == B || B == C || A == C) { continue; }
+
+			Indices[Kept++] = A;
+			Indices[Kept++] = B;
+			Indices[Kept++] = C;
+		}
+
+		Indices.resize(Kept);
+	}
+
+	return glm::sqrt(ResultError);
+}
+
+void MeshOptimization::BuildMeshlets(std::vector<uint32_t>& Indices, const std::vector<glm::vec3>& Positions, std::vector<Meshlet>& Meshlets,
+	uint32_t MaxVertices /*= MaxMeshletVertices*/, uint32_t MaxTriangles /*= MaxMeshletTriangles*/)
+{
+	Meshlets.clear();
+
+	const uint32_t VerticesCount = static_cast<uint32_t>(Positions.size());
+	const uint32_t TrianglesCount = static_cast<uint32_t>(Indices.size() / 3);
+
+	// Triangles around every vertex
+	std::vector<uint32_t> TriangleOffsets(VerticesCount + 1, 0);
+
+	for (uint32_t Index : Indices) { ++TriangleOffsets[Index + 1]; }
+	for (uint32_t i = 0; i < VerticesCount; ++i) { TriangleOffsets[i + 1] += TriangleOffsets[i]; }
+
+	std::vector<uint32_t> VertexTriangles(Indices.size());
+	std::vector<uint32_t> Fill(TriangleOffsets.begin(), TriangleOffsets.end() - 1);
+
+	for (uint32_t i = 0; i < Indices.size(); ++i)
+	{
+		VertexTriangles[Fill[Indices[i]]++] = i / 3;
+	}
+
+	std::vector<bool> Emitted(TrianglesCount, false);
+	std::vector<uint32_t> MeshletIds(VerticesCount, InvalidIndex); // Meshlet that last used the vertex
+
+	std::vector<uint32_t> Result;
+	Result.reserve(Indices.size());
+
+	std::vector<uint32_t> MeshletVertices;
+	uint32_t Cursor = 0;
+
+	while (true)
+	{
+		while (Cursor < TrianglesCount && Emitted[Cursor]) { ++Cursor; }
+
+		if (Cursor == TrianglesCount) { break; }
+
+		const uint32_t MeshletId = static_cast<uint32_t>(Meshlets.size());
+
+		Meshlet NewMeshlet;
+		NewMeshlet.FirstIndex = static_cast<uint32_t>(Result.size());
+
+		MeshletVertices.clear();
+
+		uint32_t Triangle = Cursor;
+
+		while (Triangle != InvalidIndex)
+		{
+			Emitted[Triangle] = true;
+
+			for (uint32_t Corner = 0; Corner < 3; ++Corner)
+			{
+				const uint32_t Vertex = Indices[Triangle * 3 + Corner];
+
+				if (MeshletIds[Vertex] != MeshletId)
+				{
+					MeshletIds[Vertex] = MeshletId;
+					MeshletVertices.push_back(Vertex);
+				}
+
+				Result.push_back(Vertex);
+			}
+
+			NewMeshlet.IndexCount += 3;
+
+			if (NewMeshlet.IndexCount / 3 >= MaxTriangles) { break; }
+
+			// Neighbour that adds the fewest vertices and still fits, neighbours are triangles that share a vertex with the meshlet
+			Triangle = InvalidIndex;
+			uint32_t BestNewVertices = 4;
+
+			for (uint32_t Vertex : MeshletVertices)
+			{
+				for (uint32_t j = TriangleOffsets[Vertex]; j < TriangleOffsets[Vertex + 1]; ++j)
+				{
+					const uint32_t Candidate = VertexTriangles[j];
+
+					if (Emitted[Candidate]) { continue; }
+
+					uint32_t NewVertices = 0;
+
+					for (uint32_t Corner = 0; Corner < 3; ++Corner)
+					{
+						NewVertices += MeshletIds[Indices[Candidate * 3 + Corner]] != MeshletId ? 1 : 0;
+					}
+
+					if (MeshletVertices.size() + NewVertices > MaxVertices) { continue; }
+
+					if (NewVertices < BestNewVertices)
+					{
+						BestNewVertices = NewVertices;
+						Triangle = Candidate;
+					}
+				}
+
+				if (BestNewVertices == 0) { break; }
+			}
+		}
+
+		// Bounding sphere around the center of the bounding box, like the bounds of submeshes
+		glm::vec3 Min = Positions[MeshletVertices.front()];
+		glm::vec3 Max = Min;
+
+		for (uint32_t Vertex : MeshletVertices)
+		{
+			Min = glm::min(Min, Positions[Vertex]);
+			Max = glm::max(Max, Positions[Vertex]);
+		}
+
+		NewMeshlet.Center = (Min + Max) * 0.5f;
+
+		for (uint32_t Vertex : MeshletVertices)
+		{
+			NewMeshlet.Radius = glm::max(NewMeshlet.Radius, glm::length(Positions[Vertex] - NewMeshlet.Center));
+		}
+
+		// Normal cone, its axis is the average normal and the cutoff covers the normal furthest from it
+		std::vector<glm::vec3> Normals;
+		glm::vec3 Axis(0.0f);
+
+		for (uint32_t i = NewMeshlet.FirstIndex; i < NewMeshlet.FirstIndex + NewMeshlet.IndexCount; i += 3)
+		{
+			const glm::vec3 Normal = TriangleNormal(Positions[Result[i]], Positions[Result[i + 1]], Positions[Result[i + 2]]);
+			const float Length = glm::length(Normal);
+
+			if (Length <= 0.0f) { continue; }
+
+			Normals.push_back(Normal / Length);
+			Axis += Normal / Length;
+		}
+
+		const float AxisLength = glm::length(Axis);
+		NewMeshlet.ConeAxis = AxisLength > 0.0f ? Axis / AxisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+
+		float MinDot = AxisLength > 0.0f ? 1.0f : -1.0f;
+
+		for (const glm::vec3& Normal : Normals)
+		{
+			MinDot = glm::min(MinDot, glm::dot(Normal, NewMeshlet.ConeAxis));
+		}
+
+		// Cones wider than about 84 degrees wouldn't reject anything
+		NewMeshlet.ConeCutoff = MinDot <= 0.1f ? 1.0f : glm::sqrt(1.0f - MinDot * MinDot);
+
+		Meshlets.push_back(NewMeshlet);
+	}
+
+	Indices.swap(Result);
+}
+
+bool MeshOptimization::IsMeshletBackFacing(const Meshlet& Cluster, const glm::vec3& ViewerPosition)
+{
+	// All triangles face away when the viewer is behind the plane of the cone's widest normal, pushed back by the radius
+	const glm::vec3 ToCenter = Cluster.Center - ViewerPosition;
+	return glm::dot(ToCenter, Cluster.ConeAxis) >= Cluster.ConeCutoff * glm::length(ToCenter) + Cluster.Radius;
+}
@@ -0,0 +1,136 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "glm/glm.hpp"
+
+// Post-transform vertex cache efficiency of an index buffer, simulated with a FIFO cache
+struct VertexCacheStats
+{
+	float ACMR = 0.0f; // Average cache miss ratio, transformed vertices per triangle
+	float ATVR = 0.0f; // Average transformed vertex ratio, transformed vertices per used vertex
+};
+
+// Small cluster of neighbouring triangles that can be culled on its own
+// Stored in .sm files as it is, so the layout can't change without a new file version
+struct Meshlet
+{
+	glm::vec3 Center; // Bounding sphere in the mesh's local space
+	float Radius = 0.0f;
+	glm::vec3 ConeAxis; // Average direction of the triangles' normals
+	float ConeCutoff = 1.0f; // Sine of the largest angle between the axis and a normal, 1 when the cone can't be used
+	uint32_t FirstIndex = 0; // Relative to the submesh's first index
+	uint32_t IndexCount = 0;
+};
+static_assert(sizeof(Meshlet) == 40, "Invalid size of Meshlet");
+
+// Reordering of indexed triangle lists, all functions keep the rendered result the same
+namespace MeshOptimization
+{
+	static constexpr uint32_t InvalidIndex = ~0u;
+
+	// Size of the simulated FIFO cache, close to the post-transform caches of current GPUs
+	static constexpr uint32_t DefaultCacheSize = 16;
+
+	// Limits of meshlets, the same that are commonly used by mesh shaders
+	static constexpr uint32_t MaxMeshletVertices = 64;
+	static constexpr uint32_t MaxMeshletTriangles = 124;
+
+	VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& Indices, uint32_t VerticesCount, uint32_t CacheSize = DefaultCacheSize);
+
+	// Remap of every vertex to the first vertex with the same bytes, returns number of unique vertices
+	uint32_t BuildWeldRemap(const uint8_t* Vertices, uint32_t VerticesCount, uint32_t Stride, std::vector<uint32_t>& Remap);
+
+	// Remap of vertices in the order of their first use, unused vertices get InvalidIndex, returns number of used vertices
+	uint32_t BuildFetchRemap(const std::vector<uint32_t>& Indices, uint32_t VerticesCount, std::vector<uint32_t>& Remap);
+
+	// Reorders triangles for the post-transform cache, Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+	void OptimizeVertexCache(std::vector<uint32_t>& Indices, uint32_t VerticesCount);
+
+	// Splits cache optimized triangles into clusters and draws the ones facing outwards first, so they occlude the rest
+	// A cluster ends once its cache miss ratio drops to Threshold times the ratio of the whole run, higher values keep clusters smaller
+	void OptimizeOverdraw(std::vector<uint32_t>& Indices, const std::vector<glm::vec3>& Positions, float Threshold = 1.05f);
+
+	// Collapses edges with the lowest quadric error until the index count drops to the target or no edge can be collapsed
+	// Vertices only move onto their neighbours, so the vertices stay the same, vertices on borders and attribute seams don't move
+	// Returns the largest distance between the original and the simplified surface caused by a collapse
+	float Simplify(std::vector<uint32_t>& Indices, const std::vector<glm::vec3>& Positions, uint32_t TargetIndicesCount);
+
+	// Groups triangles into meshlets, each one grows from a seed triangle over the triangles that add the fewest new vertices
+	// Indices are reordered so triangles of every meshlet are next to each other, seeds are taken in the current order of triangles
+	void BuildMeshlets(std::vector<uint32_t>& Indices, const std::vector<glm::vec3>& Positions, std::vector<Meshlet>& Meshlets,
+		uint32_t MaxVertices = MaxMeshletVertices, uint32_t MaxTriangles = MaxMeshletTriangles);
+
+	// Meshlet is back facing for every viewer at ViewerPosition when this returns true, both have to be in the same space
+	bool IsMeshletBackFacing(const Meshlet& Cluster, const glm::vec3& ViewerPosition);
+
+	// Vertices are compared by their memory, so the type can't contain padding
+	template<typename VertexType>
+	uint32_t WeldVertices(std::vector<VertexType>& Vertices, std::vector<uint32_t>& Indices);
+
+	// Unused vertices are dropped, returns number of vertices that are left
+	template<typename VertexType>
+	uint32_t OptimizeVertexFetch(std::vector<VertexType>& Vertices, std::vector<uint32_t>& Indices);
+
+	template<typename VertexType>
+	void RemapVertices(std::vector<VertexType>& Vertices, std::vector<uint32_t>& Indices, const std::vector<uint32_t>& Remap, uint32_t NewVerticesCount);
+}
+
+template<typename VertexType>
+uint32_t MeshOptimization::WeldVertices(std::vector<VertexType>& Vertices, std::vector<uint32_t>& Indices)
+{
+	std::vector<uint32_t> Remap;
+	const uint32_t UniqueCount = BuildWeldRemap(reinterpret_cast<const uint8_t*>(Vertices.data()), static_cast<uint32_t>(Vertices.size()), sizeof(VertexType), Remap);
+
+	// Unique vertices are numbered in the order of their first occurrence
+	std::vector<uint32_t> Compacted(Vertices.size(), InvalidIndex);
+	uint32_t NextIndex = 0;
+
+	for (uint32_t i = 0; i < Remap.size(); ++i)
+	{
+		if (Remap[i] == i)
+		{
+			Compacted[i] = NextIndex++;
+		}
+	}
+
+	for (uint32_t i = 0; i < Remap.size(); ++i)
+	{
+		Remap[i] = Compacted[Remap[i]];
+	}
+
+	RemapVertices(Vertices, Indices, Remap, UniqueCount);
+
+	return UniqueCount;
+}
+
+template<typename VertexType>
+uint32_t MeshOptimization::OptimizeVertexFetch(std::vector<VertexType>& Vertices, std::vector<uint32_t>& Indices)
+{
+	std::vector<uint32_t> Remap;
+	const uint32_t UsedCount = BuildFetchRemap(Indices, static_cast<uint32_t>(Vertices.size()), Remap);
+
+	RemapVertices(Vertices, Indices, Remap, UsedCount);
+
+	return UsedCount;
+}
+
+template<typename VertexType>
+void MeshOptimization::RemapVertices(std::vector<VertexType>& Vertices, std::vector<uint32_t>& Indices, const std::vector<uint32_t>& Remap, uint32_t NewVerticesCount)
+{
+	std::vector<VertexType> Result(NewVerticesCount);
+
+	for (uint32_t i = 0; i < Vertices.size(); ++i)
+	{
+		if (Remap[i] != InvalidIndex)
+		{
+			Result[Remap[i]] = Vertices[i];
+		}
+	}
+
+	for (uint32_t& Index : Indices)
+	{
+		Index = Remap[Index];
+	}
+
+	Vertices.swap(Result);
+}
@@ -0,0 +1,509 @@
+#define NOMINMAX
+#include "software_occlusion.h"
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+#include "../Utilities/assert.h"
+#if defined(_MSC_VER)
+#define OCCLUSION_TARGET_AVX2
+#else
+#define OCCLUSION_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace
+{
+	// Pixels of one tile, inclusive
+	struct PixelRect
+	{
+		int32_t MinX;
+		int32_t MinY;
+		int32_t MaxX;
+		int32_t MaxY;
+	};
+
+	// Edge functions are evaluated as A * X + (B * Y + C) without fused operations in all paths, so they give the same coverage
+	template<typename TriangleType>
+	void RasterizeScalar(const TriangleType& Tri, const PixelRect& Rect, float* Depth, uint32_t Width)
+	{
+		for (int32_t Y = Rect.MinY; Y <= Rect.MaxY; ++Y)
+		{
+			const float PixelY = Y + 0.5f;
+			const float Row0 = Tri.EdgeB[0] * PixelY + Tri.EdgeC[0];
+			const float Row1 = Tri.EdgeB[1] * PixelY + Tri.EdgeC[1];
+			const float Row2 = Tri.EdgeB[2] * PixelY + Tri.EdgeC[2];
+			const float RowDepth = Tri.DepthB * PixelY + Tri.DepthC;
+
+			float* Line = Depth + Y * Width;
+
+			for (int32_t X = Rect.MinX; X <= Rect.MaxX; ++X)
+			{
+				const float PixelX = X + 0.5f;
+
+				if (Tri.EdgeA[0] * PixelX + Row0 < 0.0f || Tri.EdgeA[1] * PixelX + Row1 < 0.0f || Tri.EdgeA[2] * PixelX + Row2 < 0.0f) { continue; }
+
+				Line[X] = std::min(Line[X], Tri.DepthA * PixelX + RowDepth);
+			}
+		}
+	}
+
+	// Rectangle starts at a multiple of 4 inside of the tile, lanes outside of the triangle's bounds are masked
+	template<typename TriangleType>
+	void RasterizeSSE(const TriangleType& Tri, const PixelRect& Rect, float* Depth, uint32_t Width)
+	{
+		const __m128 EdgeA0 = _mm_set1_ps(Tri.EdgeA[0]);
+		const __m128 EdgeA1 = _mm_set1_ps(Tri.EdgeA[1]);
+		const __m128 EdgeA2 = _mm_set1_ps(Tri.EdgeA[2]);
+		const __m128 DepthA = _mm_set1_ps(Tri.DepthA);
+		const __m128 BoundMin = _mm_set1_ps(Rect.MinX + 0.5f);
+		const __m128 BoundMax = _mm_set1_ps(Rect.MaxX + 0.5f);
+		const __m128 Zero = _mm_setzero_ps();
+		const __m128 Lanes = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+
+		const int32_t StartX = Rect.MinX & ~3;
+
+		for (int32_t Y = Rect.MinY; Y <= Rect.MaxY; ++Y)
+		{
+			const float PixelY = Y + 0.5f;
+			const __m128 Row0 = _mm_set1_ps(Tri.EdgeB[0] * PixelY + Tri.EdgeC[0]);
+			const __m128 Row1 = _mm_set1_ps(Tri.EdgeB[1] * PixelY + Tri.EdgeC[1]);
+			const __m128 Row2 = _mm_set1_ps(Tri.EdgeB[2] * PixelY + Tri.EdgeC[2]);
+			const __m128 RowDepth = _mm_set1_ps(Tri.DepthB * PixelY + Tri.DepthC);
+
+			float* Line = Depth + Y * Width;
+
+			for (int32_t X = StartX; X <= Rect.MaxX; X += 4)
+			{
+				const __m128 PixelX = _mm_add_ps(_mm_set1_ps(static_cast<float>(X)), Lanes);
+
+				__m128 Inside = _mm_and_ps(_mm_cmpge_ps(PixelX, BoundMin), _mm_cmple_ps(PixelX, BoundMax));
+				Inside = _mm_and_ps(Inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(EdgeA0, PixelX), Row0), Zero));
+				Inside = _mm_and_ps(Inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(EdgeA1, PixelX), Row1), Zero));
+				Inside = _mm_and_ps(Inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(EdgeA2, PixelX), Row2), Zero));
+
+				if (_mm_movemask_ps(Inside) == 0) { continue; }
+
+				const __m128 Current = _mm_loadu_ps(Line + X);
+				const __m128 Nearest = _mm_min_ps(Current, _mm_add_ps(_mm_mul_ps(DepthA, PixelX), RowDepth));
+
+				_mm_storeu_ps(Line + X, _mm_or_ps(_mm_and_ps(Inside, Nearest), _mm_andnot_ps(Inside, Current)));
+			}
+		}
+	}
+
+	template<typename TriangleType>
+	OCCLUSION_TARGET_AVX2 void RasterizeAVX2(const TriangleType& Tri, const PixelRect& Rect, float* Depth, uint32_t Width)
+	{
+		const __m256 EdgeA0 = _mm256_set1_ps(Tri.EdgeA[0]);
+		const __m256 EdgeA1 = _mm256_set1_ps(Tri.EdgeA[1]);
+		const __m256 EdgeA2 = _mm256_set1_ps(Tri.EdgeA[2]);
+		const __m256 DepthA = _mm256_set1_ps(Tri.DepthA);
+		const __m256 BoundMin = _mm256_set1_ps(Rect.MinX + 0.5f);
+		const __m256 BoundMax = _mm256_set1_ps(Rect.MaxX + 0.5f);
+		const __m256 Zero = _mm256_setzero_ps();
+		const __m256 Lanes = _mm256_set_ps(7.5f, 6.5f, 5.5f, 4.5f, 3.5f, 2.5f, 1.5f, 0.5f);
+
+		const int32_t StartX = Rect.MinX & ~7;
+
+		for (int32_t Y = Rect.MinY; Y <= Rect.MaxY; ++Y)
+		{
+			const float PixelY = Y + 0.5f;
+			const __m256 Row0 = _mm256_set1_ps(Tri.EdgeB[0] * PixelY + Tri.EdgeC[0]);
+			const __m256 Row1 = _mm256_set1_ps(Tri.EdgeB[1] * PixelY + Tri.EdgeC[1]);
+			const __m256 Row2 = _mm256_set1_ps(Tri.EdgeB[2] * PixelY + Tri.EdgeC[2]);
+			const __m256 RowDepth = _mm256_set1_ps(Tri.DepthB * PixelY + Tri.DepthC);
+
+			float* Line = Depth + Y * Width;
+
+			for (int32_t X = StartX; X <= Rect.MaxX; X += 8)
+			{
+				const __m256 PixelX = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(X)), Lanes);
+
+				__m256 Inside = _mm256_and_ps(_mm256_cmp_ps(PixelX, BoundMin, _CMP_GE_OQ), _mm256_cmp_ps(PixelX, BoundMax, _CMP_LE_OQ));
+				Inside = _mm256_and_ps(Inside, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(EdgeA0, PixelX), Row0), Zero, _CMP_GE_OQ));
+				Inside = _mm256_and_ps(Inside, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(EdgeA1, PixelX), Row1), Zero, _CMP_GE_OQ));
+				Inside = _mm256_and_ps(Inside, _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(EdgeA2, PixelX), Row2), Zero, _CMP_GE_OQ));
+
+				if (_mm256_movemask_ps(Inside) == 0) { continue; }
+
+				const __m256 Current = _mm256_loadu_ps(Line + X);
+				const __m256 Nearest = _mm256_min_ps(Current, _mm256_add_ps(_mm256_mul_ps(DepthA, PixelX), RowDepth));
+
+				_mm256_storeu_ps(Line + X, _mm256_blendv_ps(Current, Nearest, Inside));
+			}
+		}
+	}
+}
+
+SoftwareOcclusionBuffer::SoftwareOcclusionBuffer(uint32_t Width /*= 256*/, uint32_t Height /*= 128*/)
+	: mWidth(Width), mHeight(Height)
+{
+	// Tiles are aligned to the widest SIMD path and blocks, so no path writes outside of its tile
+	static_assert(TileWidth % 8 == 0 && TileWidth % BlockSize == 0 && TileHeight % BlockSize == 0, "Tiles have to be made of whole blocks");
+	Assert(Width > 0 && Height > 0 && Width % TileWidth == 0 && Height % TileHeight == 0);
+
+	mTilesX = Width / TileWidth;
+	mTilesY = Height / TileHeight;
+
+	mDepth.assign(Width * Height, 1.0f);
+	mBlockDepth.assign((Width / BlockSize) * (Height / BlockSize), 1.0f);
+	mTileTriangles.resize(mTilesX * mTilesY);
+}
+
+SoftwareOcclusionBuffer::~SoftwareOcclusionBuffer()
+{
+	{
+		std::lock_guard<std::mutex> Lock(mWorkMutex);
+		mStopWorkers = true;
+	}
+
+	mWorkStart.notify_all();
+
+	for (std::thread& Worker : mWorkers)
+	{
+		Worker.join();
+	}
+}
+
+void SoftwareOcclusionBuffer::Begin(const glm::mat4& ViewProjection)
+{
+	mViewProjection = ViewProjection;
+
+	for (int32_t i = 0; i < 4; ++i)
+	{
+		mRowLengths[i] = glm::length(glm::vec3(ViewProjection[0][i], ViewProjection[1][i], ViewProjection[2][i]));
+	}
+
+	const glm::vec3 Forward = glm::vec3(ViewProjection[0][3], ViewProjection[1][3], ViewProjection[2][3]) / mRowLengths.w;
+	mNearestOffset = ViewProjection * glm::vec4(Forward, 0.0f);
+	mTriangles.clear();
+
+	for (std::vector<uint32_t>& Tile : mTileTriangles)
+	{
+		Tile.clear();
+	}
+}
+
+void SoftwareOcclusionBuffer::AddOccluder(const std::vector<glm::vec3>& Positions, const std::vector<uint32_t>& Indices, const glm::mat4& Transform)
+{
+	Assert(Indices.size() % 3 == 0);
+
+	const glm::mat4 Matrix = mViewProjection * Transform;
+
+	mClipPositions.resize(Positions.size());
+
+	for (size_t i = 0; i < Positions.size(); ++i)
+	{
+		mClipPositions[i] = Matrix * glm::vec4(Positions[i], 1.0f);
+	}
+
+	for (size_t i = 0; i < Indices.size(); i += 3)
+	{
+		glm::vec3 Screen[3];
+		bool Clipped = false;
+
+		for (int32_t j = 0; j < 3; ++j)
+		{
+			const glm::vec4& Clip = mClipPositions[Indices[i + j]];
+
+			// Skipping triangles that cross the near plane only keeps more objects visible
+			if (Clip.w <= 0.0f || Clip.z < 0.0f) { Clipped = true; break; }
+
+			Screen[j] = { (Clip.x / Clip.w * 0.5f + 0.5f) * mWidth, (Clip.y / Clip.w * 0.5f + 0.5f) * mHeight, Clip.z / Clip.w };
+		}
+
+		if (Clipped) { continue; }
+
+		const glm::vec3 Edge1 = Screen[1] - Screen[0];
+		const glm::vec3 Edge2 = Screen[2] - Screen[0];
+		const float Area = Edge1.x * Edge2.y - Edge2.x * Edge1.y;
+
+		if (std::abs(Area) < 1e-6f) { continue; }
+
+		Triangle Tri = {};
+
+		// Both windings are rasterized, edge functions are flipped so the inside is positive
+		const float Sign = Area > 0.0f ? 1.0f : -1.0f;
+
+		for (int32_t j = 0; j < 3; ++j)
+		{
+			const glm::vec3& From = Screen[j];
+			const glm::vec3& To = Screen[(j + 1) % 3];
+
+			Tri.EdgeA[j] = Sign * (From.y - To.y);
+			Tri.EdgeB[j] = Sign * (To.x - From.x);
+			Tri.EdgeC[j] = Sign * (From.x * To.y - To.x * From.y);
+		}
+
+		Tri.DepthA = (Edge1.z * Edge2.y - Edge2.z * Edge1.y) / Area;
+		Tri.DepthB = (Edge1.x * Edge2.z - Edge2.x * Edge1.z) / Area;
+		Tri.DepthC = Screen[0].z - Tri.DepthA * Screen[0].x - Tri.DepthB * Screen[0].y;
+
+		// Pixels whose centers are inside of the triangle's bounds
+		const float MinX = std::min({ Screen[0].x, Screen[1].x, Screen[2].x });
+		const float MaxX = std::max({ Screen[0].x, Screen[1].x, Screen[2].x });
+		const float MinY = std::min({ Screen[0].y, Screen[1].y, Screen[2].y });
+		const float MaxY = std::max({ Screen[0].y, Screen[1].y, Screen[2].y });
+
+		Tri.MinX = std::max(static_cast<int32_t>(std::ceil(MinX - 0.5f)), 0);
+		Tri.MinY = std::max(static_cast<int32_t>(std::ceil(MinY - 0.5f)), 0);
+		Tri.MaxX = std::min(static_cast<int32_t>(std::floor(MaxX - 0.5f)), static_cast<int32_t>(mWidth) - 1);
+		Tri.MaxY = std::min(static_cast<int32_t>(std::floor(MaxY - 0.5f)), static_cast<int32_t>(mHeight) - 1);
+
+		if (Tri.MinX > Tri.MaxX || Tri.MinY > Tri.MaxY) { continue; }
+
+		const uint32_t TriangleIdx = static_cast<uint32_t>(mTriangles.size());
+		mTriangles.push_back(Tri);
+
+		for (int32_t TileY = Tri.MinY / TileHeight; TileY <= Tri.MaxY / static_cast<int32_t>(TileHeight); ++TileY)
+		{
+			for (int32_t TileX = Tri.MinX / TileWidth; TileX <= Tri.MaxX / static_cast<int32_t>(TileWidth); ++TileX)
+			{
+				mTileTriangles[TileY * mTilesX + TileX].push_back(TriangleIdx);
+			}
+		}
+	}
+}
+
+void SoftwareOcclusionBuffer::Rasterize(CullingPath Path, uint32_t ThreadsCount /*= 0*/)
+{
+	if (Path == CullingPath::AVX2 && FrustumCulling::GetSupportedPath() != CullingPath::AVX2)
+	{
+		Path = CullingPath::SSE;
+	}
+
+	const uint32_t TilesCount = mTilesX * mTilesY;
+
+	if (ThreadsCount == 0)
+	{
+		ThreadsCount = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	ThreadsCount = std::min(ThreadsCount, TilesCount);
+
+	// Calling thread rasterizes too, so it needs one worker less
+	const uint32_t WorkersCount = ThreadsCount - 1;
+
+	while (mWorkers.size() < WorkersCount)
+	{
+		mWorkers.emplace_back(&SoftwareOcclusionBuffer::WorkerLoop, this, static_cast<uint32_t>(mWorkers.size()));
+	}
+
+	mNextTile = 0;
+
+	if (WorkersCount > 0)
+	{
+		{
+			std::lock_guard<std::mutex> Lock(mWorkMutex);
+			mWorkPath = Path;
+			mActiveWorkers = WorkersCount;
+			mBusyWorkers = WorkersCount;
+			++mWorkGeneration;
+		}
+
+		mWorkStart.notify_all();
+	}
+
+	RasterizeTiles(Path);
+
+	if (WorkersCount > 0)
+	{
+		std::unique_lock<std::mutex> Lock(mWorkMutex);
+		mWorkDone.wait(Lock, [this]() { return mBusyWorkers == 0; });
+	}
+}
+
+void SoftwareOcclusionBuffer::RasterizeTiles(CullingPath Path)
+{
+	const uint32_t TilesCount = mTilesX * mTilesY;
+
+	// Tiles are taken one by one, so threads that get cheap tiles take more of them
+	for (uint32_t Tile = mNextTile++; Tile < TilesCount; Tile = mNextTile++)
+	{
+		RasterizeTile(Tile, Path);
+	}
+}
+
+void SoftwareOcclusionBuffer::WorkerLoop(uint32_t WorkerIdx)
+{
+	uint64_t DoneGeneration = 0;
+
+	while (true)
+	{
+		CullingPath Path = CullingPath::SCALAR;
+
+		{
+			std::unique_lock<std::mutex> Lock(mWorkMutex);
+			mWorkStart.wait(Lock, [this, DoneGeneration]() { return mStopWorkers || mWorkGeneration != DoneGeneration; });
+
+			if (mStopWorkers) { return; }
+
+			DoneGeneration = mWorkGeneration;
+
+			// Frames rasterized with fewer threads leave the rest of the workers asleep
+			if (WorkerIdx >= mActiveWorkers) { continue; }
+
+			Path = mWorkPath;
+		}
+
+		RasterizeTiles(Path);
+
+		std::lock_guard<std::mutex> Lock(mWorkMutex);
+
+		if (--mBusyWorkers == 0)
+		{
+			mWorkDone.notify_one();
+		}
+	}
+}
+
+void SoftwareOcclusionBuffer::RasterizeReference()
+{
+	std::fill(mDepth.begin(), mDepth.end(), 1.0f);
+
+	for (const Triangle& Tri : mTriangles)
+	{
+		const PixelRect Rect = { Tri.MinX, Tri.MinY, Tri.MaxX, Tri.MaxY };
+		RasterizeScalar(Tri, Rect, mDepth.data(), mWidth);
+	}
+
+	UpdateBlocks(0, 0, mWidth - 1, mHeight - 1);
+}
+
+void SoftwareOcclusionBuffer::RasterizeTile(uint32_t TileIdx, CullingPath Path)
+{
+	const int32_t TileMinX = (TileIdx % mTilesX) * TileWidth;
+	const int32_t TileMinY = (TileIdx / mTilesX) * TileHeight;
+	const int32_t TileMaxX = TileMinX + TileWidth - 1;
+	const int32_t TileMaxY = TileMinY + TileHeight - 1;
+
+	for (int32_t Y = TileMinY; Y <= TileMaxY; ++Y)
+	{
+		std::fill_n(mDepth.begin() + Y * mWidth + TileMinX, TileWidth, 1.0f);
+	}
+
+	for (uint32_t TriangleIdx : mTileTriangles[TileIdx])
+	{
+		const Triangle& Tri = mTriangles[TriangleIdx];
+		const PixelRect Rect = { std::max(Tri.MinX, TileMinX), std::max(Tri.MinY, TileMinY), std::min(Tri.MaxX, TileMaxX), std::min(Tri.MaxY, TileMaxY) };
+
+		switch (Path)
+		{
+		case CullingPath::AVX2:
+			RasterizeAVX2(Tri, Rect, mDepth.data(), mWidth);
+			break;
+		case CullingPath::SSE:
+			RasterizeSSE(Tri, Rect, mDepth.data(), mWidth);
+			break;
+		default:
+			RasterizeScalar(Tri, Rect, mDepth.data(), mWidth);
+			break;
+		}
+	}
+
+	UpdateBlocks(TileMinX, TileMinY, TileMaxX, TileMaxY);
+}
+
+void SoftwareOcclusionBuffer::UpdateBlocks(uint32_t MinX, uint32_t MinY, uint32_t MaxX, uint32_t MaxY)
+{
+	const uint32_t BlocksX = mWidth / BlockSize;
+
+	for (uint32_t BlockY = MinY / BlockSize; BlockY <= MaxY / BlockSize; ++BlockY)
+	{
+		for (uint32_t BlockX = MinX / BlockSize; BlockX <= MaxX / BlockSize; ++BlockX)
+		{
+			float Farthest = 0.0f;
+
+			for (uint32_t Y = BlockY * BlockSize; Y < (BlockY + 1) * BlockSize; ++Y)
+			{
+				const float* Line = mDepth.data() + Y * mWidth + BlockX * BlockSize;
+				Farthest = std::max(Farthest, *std::max_element(Line, Line + BlockSize));
+			}
+
+			mBlockDepth[BlockY * BlocksX + BlockX] = Farthest;
+		}
+	}
+}
+
+bool SoftwareOcclusionBuffer::IsOccluded(const BoundingSphere& Sphere, bool Exact /*= false*/) const
+{
+	// Ranges of the clip space coordinates over the sphere, every one changes at most by the radius times the length of its row
+	const glm::vec4 Clip = mViewProjection * glm::vec4(Sphere.Center, 1.0f);
+	const glm::vec4 Range = Sphere.Radius * mRowLengths;
+
+	const float MinW = Clip.w - Range.w;
+	const float MaxW = Clip.w + Range.w;
+
+	// Spheres crossing the near plane can't be projected
+	if (MinW <= 0.0f || Clip.z - Range.z < 0.0f) { return false; }
+
+	// Bounds of the quotients over both ranges, the screen rectangle contains the sphere's one
+	const float MinNdcX = std::min((Clip.x - Range.x) / MinW, (Clip.x - Range.x) / MaxW);
+	const float MaxNdcX = std::max((Clip.x + Range.x) / MinW, (Clip.x + Range.x) / MaxW);
+	const float MinNdcY = std::min((Clip.y - Range.y) / MinW, (Clip.y - Range.y) / MaxW);
+	const float MaxNdcY = std::max((Clip.y + Range.y) / MinW, (Clip.y + Range.y) / MaxW);
+
+	// Point of the sphere with the smallest w, with a perspective projection depth grows with w so it's the nearest one
+	const glm::vec4 Nearest = Clip - Sphere.Radius * mNearestOffset;
+	const float NearestDepth = Nearest.z / Nearest.w;
+
+	const float MinX = (MinNdcX * 0.5f + 0.5f) * mWidth;
+	const float MaxX = (MaxNdcX * 0.5f + 0.5f) * mWidth;
+	const float MinY = (MinNdcY * 0.5f + 0.5f) * mHeight;
+	const float MaxY = (MaxNdcY * 0.5f + 0.5f) * mHeight;
+
+	if (MinX >= MaxX || MinY >= MaxY) { return false; }
+
+	// Every pixel the rectangle touches, not only the ones with covered centers
+	const int32_t PixelMinX = static_cast<int32_t>(std::max(std::floor(MinX), 0.0f));
+	const int32_t PixelMinY = static_cast<int32_t>(std::max(std::floor(MinY), 0.0f));
+	const int32_t PixelMaxX = static_cast<int32_t>(std::min(std::ceil(MaxX), static_cast<float>(mWidth))) - 1;
+	const int32_t PixelMaxY = static_cast<int32_t>(std::min(std::ceil(MaxY), static_cast<float>(mHeight))) - 1;
+
+	// Outside of the screen, left to the frustum culling
+	if (PixelMinX > PixelMaxX || PixelMinY > PixelMaxY) { return false; }
+
+	if (!Exact && (PixelMaxX - PixelMinX + 1) * (PixelMaxY - PixelMinY + 1) > static_cast<int32_t>(BlockSize * BlockSize))
+	{
+		const uint32_t BlocksX = mWidth / BlockSize;
+
+		for (int32_t BlockY = PixelMinY / BlockSize; BlockY <= PixelMaxY / static_cast<int32_t>(BlockSize); ++BlockY)
+		{
+			for (int32_t BlockX = PixelMinX / BlockSize; BlockX <= PixelMaxX / static_cast<int32_t>(BlockSize); ++BlockX)
+			{
+				if (NearestDepth <= mBlockDepth[BlockY * BlocksX + BlockX]) { return false; }
+			}
+		}
+
+		return true;
+	}
+
+	for (int32_t Y = PixelMinY; Y <= PixelMaxY; ++Y)
+	{
+		for (int32_t X = PixelMinX; X <= PixelMaxX; ++X)
+		{
+			if (NearestDepth <= mDepth[Y * mWidth + X]) { return false; }
+		}
+	}
+
+	return true;
+}
+
+uint32_t SoftwareOcclusionBuffer::Cull(const SphereBoundsList& Spheres, std::vector<uint8_t>& Visible) const
+{
+	Assert(Visible.size() == Spheres.GetCount());
+
+	uint32_t HiddenCount = 0;
+
+	for (uint32_t i = 0; i < Spheres.GetCount(); ++i)
+	{
+		if (!Visible[i]) { continue; }
+
+		if (IsOccluded({ Spheres.GetCenter(i), Spheres.GetRadius(i) }))
+		{
+			Visible[i] = 0;
+			++HiddenCount;
+		}
+	}
+
+	return HiddenCount;
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "bounds.h"
+#include "frustum_culling.h"
+
+// Low resolution depth of a few occluders rasterized on the CPU, bounds of other objects are tested against it before they are drawn
+// Every pixel keeps the nearest depth of the occluders at its center, a sphere is hidden when it's behind all pixels its screen rectangle touches
+// Screen is split into tiles, triangles are binned to the tiles they overlap and every tile is rasterized by one thread
+// Worker threads are owned by the buffer, they are started by the first Rasterize that needs them and wait for the next one between frames
+class SoftwareOcclusionBuffer
+{
+public:
+	static constexpr uint32_t TileWidth = 64;
+	static constexpr uint32_t TileHeight = 32;
+
+	// Blocks keep the farthest depth of their pixels, large rectangles are tested against them
+	static constexpr uint32_t BlockSize = 8;
+
+	// Width has to be a multiple of TileWidth and height a multiple of TileHeight
+	SoftwareOcclusionBuffer(uint32_t Width = 256, uint32_t Height = 128);
+	~SoftwareOcclusionBuffer();
+
+	SoftwareOcclusionBuffer(const SoftwareOcclusionBuffer& Rhs) = delete;
+	SoftwareOcclusionBuffer& operator=(const SoftwareOcclusionBuffer& Rhs) = delete;
+
+	SoftwareOcclusionBuffer(SoftwareOcclusionBuffer&& Rhs) = delete;
+	SoftwareOcclusionBuffer& operator=(SoftwareOcclusionBuffer&& Rhs) = delete;
+
+	// Removes occluders of the previous frame
+	void Begin(const glm::mat4& ViewProjection);
+
+	// Triangles are transformed by Transform and the view projection, the ones crossing the near plane are skipped
+	void AddOccluder(const std::vector<glm::vec3>& Positions, const std::vector<uint32_t>& Indices, const glm::mat4& Transform);
+
+	// Rasterizes all occluders added since Begin, SSE and AVX2 paths test 4 or 8 pixels at once
+	// Zero threads uses all hardware threads
+	void Rasterize(CullingPath Path, uint32_t ThreadsCount = 0);
+
+	// Rasterizes every triangle over its whole bounds on one thread without tiles, writes the same depth as Rasterize
+	void RasterizeReference();
+
+	// Exact test reads every pixel of the rectangle, otherwise large rectangles read the blocks which may keep fewer spheres hidden
+	bool IsOccluded(const BoundingSphere& Sphere, bool Exact = false) const;
+
+	// Clears visibility of the visible spheres that are hidden, returns their number
+	uint32_t Cull(const SphereBoundsList& Spheres, std::vector<uint8_t>& Visible) const;
+
+	inline uint32_t GetWidth() const { return mWidth; }
+	inline uint32_t GetHeight() const { return mHeight; }
+	inline uint32_t GetTrianglesCount() const { return static_cast<uint32_t>(mTriangles.size()); }
+	inline const std::vector<float>& GetDepth() const { return mDepth; }
+
+private:
+	// Edge functions and depth plane in pixels, a pixel center is inside when all edge functions are non-negative
+	struct Triangle
+	{
+		float EdgeA[3];
+		float EdgeB[3];
+		float EdgeC[3];
+		float DepthA;
+		float DepthB;
+		float DepthC;
+		int32_t MinX; // Bounds of pixel centers that may be covered, inclusive and clipped to the screen
+		int32_t MinY;
+		int32_t MaxX;
+		int32_t MaxY;
+	};
+
+	void RasterizeTile(uint32_t TileIdx, CullingPath Path);
+	void RasterizeTiles(CullingPath Path);
+	void WorkerLoop(uint32_t WorkerIdx);
+	void UpdateBlocks(uint32_t MinX, uint32_t MinY, uint32_t MaxX, uint32_t MaxY);
+
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+	uint32_t mTilesX = 0;
+	uint32_t mTilesY = 0;
+
+	glm::mat4 mViewProjection = glm::mat4(1.0f);
+	glm::vec4 mRowLengths = glm::vec4(0.0f); // Lengths of the view projection's rows without the translation
+	glm::vec4 mNearestOffset = glm::vec4(0.0f); // Clip space offset of a unit step along the view direction
+
+	std::vector<float> mDepth;
+	std::vector<float> mBlockDepth;
+	std::vector<Triangle> mTriangles;
+	std::vector<std::vector<uint32_t>> mTileTriangles; // Indices of the triangles overlapping every tile
+	std::vector<glm::vec4> mClipPositions; // Kept between occluders to reuse the memory
+
+	// Every Rasterize bumps the generation and wakes the workers, the ones below mActiveWorkers take tiles until none is left
+	std::vector<std::thread> mWorkers;
+	std::mutex mWorkMutex;
+	std::condition_variable mWorkStart;
+	std::condition_variable mWorkDone;
+	uint64_t mWorkGeneration = 0;
+	uint32_t mActiveWorkers = 0;
+	uint32_t mBusyWorkers = 0; // Active workers that haven't finished the current generation
+	CullingPath mWorkPath = CullingPath::SCALAR;
+	bool mStopWorkers = false;
+	std::atomic<uint32_t> mNextTile{ 0 };
+
+};
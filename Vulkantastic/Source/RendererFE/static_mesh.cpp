@@ -1,9 +1,43 @@
+#define NOMINMAX
 #include "static_mesh.h"
 #include "../File/file.h"
 #include "../Renderer/buffer.h"
 #include "../Utilities/assert.h"
 #include "surface_material.h"
 
+void StaticMeshFile::PackVertices(const std::vector<UnpackedVertex>& Vertices, std::vector<VertexDefinition::StaticMesh>& PackedVertices, glm::vec3& Scale, glm::vec3& Bias)
+{
+	glm::vec3 Min(0.0f);
+	glm::vec3 Max(0.0f);
+
+	if (!Vertices.empty())
+	{
+		Min = Max = Vertices.front().Position;
+	}
+
+	for (const UnpackedVertex& Vertex : Vertices)
+	{
+		Min = glm::min(Min, Vertex.Position);
+		Max = glm::max(Max, Vertex.Position);
+	}
+
+	Scale = Max - Min;
+	Bias = Min;
+
+	PackedVertices.resize(Vertices.size());
+
+	for (size_t i = 0; i < Vertices.size(); ++i)
+	{
+		const UnpackedVertex& Vertex = Vertices[i];
+		VertexDefinition::StaticMesh& Packed = PackedVertices[i];
+
+		Packed.Position = VertexPacking::PackPosition(Vertex.Position, Scale, Bias);
+		Packed.TexCoord = VertexPacking::PackHalf2(Vertex.TexCoord);
+		Packed.Normal = VertexPacking::PackOctahedral(Vertex.Normal);
+		Packed.Tangent = VertexPacking::PackOctahedral(Vertex.Tangent);
+	}
+}
+
 bool StaticMeshManager::Startup()
 {
 	return true;
@@ -31,74 +65,299 @@ StaticMesh* StaticMeshManager::Find(const std::string& Name)
 
 	if (!File::Get().Exists(StaticMeshPath)) { return nullptr; }
 
-	auto* NewEntry = new StaticMesh(StaticMeshPath);
+	auto* NewEntry = new StaticMesh(StaticMeshPath, static_cast<uint32_t>(mStaticMeshList.size()));
 
 	mStaticMeshList[Name] = NewEntry;
 	
 	return NewEntry;
 }
 
-StaticMesh::StaticMesh(const std::string& Name)
-	: mName(Name)
+StaticMesh::StaticMesh(const std::string& Name, uint32_t Id)
+	: mName(Name), mId(Id)
 {
 	int32_t FileSize = static_cast<int32_t>(File::Get().Size(mName));
 
 	FileGuard SourceHandle(File::Get().OpenRead(mName));
 
-	while (FileSize > SourceHandle->ReadBytes())
+	mGeometryPool = GeometryPoolManager::Get().GetPool<VertexDefinition::StaticMesh>();
+
+	static_assert(sizeof(VertexDefinition::StaticMeshPosition) == sizeof(VertexDefinition::StaticMesh::Position), "Position stream has to match StaticMeshPosition");
+
+	// Files without the header start with the first submesh's vertices count
+	uint32_t Header;
+	SourceHandle->Read(reinterpret_cast<uint8_t*>(&Header), 4);
+
+	if (Header == StaticMeshFile::Magic)
+	{
+		uint32_t Version;
+		SourceHandle->Read(reinterpret_cast<uint8_t*>(&Version), 4);
+
+		Assert(Version >= 2 && Version <= StaticMeshFile::Version);
+
+		if (Version >= 3)
+		{
+			SourceHandle->Read(reinterpret_cast<uint8_t*>(&mLodsCount), 4);
+
+			Assert(mLodsCount > 0 && mLodsCount <= StaticMeshFile::MaxLodsCount);
+
+			mLodScreenSizes.resize(mLodsCount);
+			SourceHandle->Read(reinterpret_cast<uint8_t*>(mLodScreenSizes.data()), mLodsCount * sizeof(float));
+		}
+
+		while (FileSize > SourceHandle->ReadBytes())
+		{
+			ReadPackedSubmesh(SourceHandle.Get(), Version);
+		}
+	}
+	else
+	{
+		ReadUnpackedSubmesh(SourceHandle.Get(), Header);
+
+		while (FileSize > SourceHandle->ReadBytes())
+		{
+			uint32_t VerticesCount;
+			SourceHandle->Read(reinterpret_cast<uint8_t*>(&VerticesCount), 4);
+
+			ReadUnpackedSubmesh(SourceHandle.Get(), VerticesCount);
+		}
+	}
+
+	if (mLodScreenSizes.empty())
+	{
+		mLodScreenSizes.push_back(1.0f);
+	}
+
+	Assert(mGeometryRanges.size() % mLodsCount == 0);
+}
+
+void StaticMesh::ReadPackedSubmesh(FileHandle* Source, uint32_t Version)
+{
+	// Vertex attributes
+	uint32_t VerticesCount;
+	Source->Read(reinterpret_cast<uint8_t*>(&VerticesCount), 4);
+
+	glm::vec3 Scale;
+	glm::vec3 Bias;
+	Source->Read(reinterpret_cast<uint8_t*>(&Scale), sizeof(Scale));
+	Source->Read(reinterpret_cast<uint8_t*>(&Bias), sizeof(Bias));
+
+	VerticiesList Verticies(VerticesCount);
+	Source->Read(reinterpret_cast<uint8_t*>(Verticies.data()), VerticesCount * sizeof(VertexDefinition::StaticMesh));
+
+	// Indicies
+	uint32_t IndicesCount;
+	uint32_t IndexSize;
+	Source->Read(reinterpret_cast<uint8_t*>(&IndicesCount), 4);
+	Source->Read(reinterpret_cast<uint8_t*>(&IndexSize), 4);
+
+	IndiciesList Indicies(IndicesCount);
+
+	if (IndexSize == sizeof(uint16_t))
 	{
+		std::vector<uint16_t> NarrowIndicies(IndicesCount);
+		Source->Read(reinterpret_cast<uint8_t*>(NarrowIndicies.data()), IndicesCount * sizeof(uint16_t));
 
-		const uint32_t GraphicsQueueIndex = VulkanCore::Get().GetDevice()->GetQueuesIndicies().GraphicsIndex;
-		std::vector<uint32_t> QueueIndicies = { GraphicsQueueIndex };
+		std::copy(NarrowIndicies.begin(), NarrowIndicies.end(), Indicies.begin());
+	}
+	else
+	{
+		Assert(IndexSize == sizeof(uint32_t));
+		Source->Read(reinterpret_cast<uint8_t*>(Indicies.data()), IndicesCount * sizeof(uint32_t));
+	}
 
-		// Vertex attributes
-		int32_t VertAttribLength;
-		SourceHandle->Read(reinterpret_cast<uint8_t*>(&VertAttribLength), 4);
+	std::vector<Meshlet> Meshlets;
 
-		VerticiesList Verticies(VertAttribLength * sizeof(VertexDefinition::StaticMesh));
-		SourceHandle->Read(reinterpret_cast<uint8_t*>(Verticies.data()), VertAttribLength * sizeof(VertexDefinition::StaticMesh));
+	if (Version >= 4)
+	{
+		uint32_t MeshletsCount;
+		Source->Read(reinterpret_cast<uint8_t*>(&MeshletsCount), 4);
 
-		mVertexBuffers.push_back(std::make_unique<Buffer>(QueueIndicies, BufferUsage::VERTEX | BufferUsage::TRANSFER_DST, true, static_cast<uint32_t>(sizeof(VertexDefinition::StaticMesh) * Verticies.size()), Verticies.data()));
+		Meshlets.resize(MeshletsCount);
+		Source->Read(reinterpret_cast<uint8_t*>(Meshlets.data()), MeshletsCount * sizeof(Meshlet));
+	}
 
-		mVertices.push_back(std::move(Verticies));
+	AddSubmesh(std::move(Verticies), std::move(Indicies), Scale, Bias, std::move(Meshlets));
+}
 
-		// Indicies
-		int32_t IndiciesLength;
-		SourceHandle->Read(reinterpret_cast<uint8_t*>(&IndiciesLength), 4);
+void StaticMesh::ReadUnpackedSubmesh(FileHandle* Source, uint32_t VerticesCount)
+{
+	std::vector<StaticMeshFile::UnpackedVertex> UnpackedVerticies(VerticesCount);
+	Source->Read(reinterpret_cast<uint8_t*>(UnpackedVerticies.data()), VerticesCount * sizeof(StaticMeshFile::UnpackedVertex));
 
-		IndiciesList Indicies(IndiciesLength * sizeof(uint32_t));
-		SourceHandle->Read(reinterpret_cast<uint8_t*>(Indicies.data()), IndiciesLength * 4);
+	uint32_t IndicesCount;
+	Source->Read(reinterpret_cast<uint8_t*>(&IndicesCount), 4);
 
-		mIndexBuffers.push_back(std::make_unique<Buffer>(QueueIndicies, BufferUsage::INDEX | BufferUsage::TRANSFER_DST, true, static_cast<uint32_t>(sizeof(uint32_t) * Indicies.size()), Indicies.data()));
+	IndiciesList Indicies(IndicesCount);
+	Source->Read(reinterpret_cast<uint8_t*>(Indicies.data()), IndicesCount * sizeof(uint32_t));
 
-		mIndicies.push_back(std::move(Indicies));
+	VerticiesList Verticies;
+	glm::vec3 Scale;
+	glm::vec3 Bias;
+	StaticMeshFile::PackVertices(UnpackedVerticies, Verticies, Scale, Bias);
 
+	AddSubmesh(std::move(Verticies), std::move(Indicies), Scale, Bias);
+}
+
+void StaticMesh::AddSubmesh(VerticiesList&& Verticies, IndiciesList&& Indicies, const glm::vec3& Scale, const glm::vec3& Bias, std::vector<Meshlet>&& Meshlets /*= {}*/)
+{
+	// Bounds of the first level are used for all levels
+	if (mGeometryRanges.size() % mLodsCount == 0)
+	{
+		ComputeBounds(Verticies, Scale, Bias);
+	}
+
+	if (Meshlets.empty() && !Indicies.empty())
+	{
+		std::vector<glm::vec3> Positions;
+		Positions.reserve(Verticies.size());
+
+		for (const VertexDefinition::StaticMesh& Vertex : Verticies)
+		{
+			Positions.push_back(VertexPacking::UnpackPosition(Vertex.Position, Scale, Bias));
+		}
+
+		MeshOptimization::BuildMeshlets(Indicies, Positions, Meshlets);
 	}
 
+	mMeshlets.push_back(std::move(Meshlets));
+
+	mPositionScales.push_back(Scale);
+	mPositionBiases.push_back(Bias);
+
+	mGeometryRanges.push_back(mGeometryPool->Add(Verticies.data(), static_cast<uint32_t>(Verticies.size()), Indicies.data(), static_cast<uint32_t>(Indicies.size())));
+
+	mVertices.push_back(std::move(Verticies));
+	mIndicies.push_back(std::move(Indicies));
 }
 
 Buffer* StaticMesh::GetVertexBuffer(int32_t Index /*= 0*/) const
 {
-	Assert(Index < mVertexBuffers.size());
-	return mVertexBuffers[Index].get();
+	Assert(Index < GetVertexBufferCount());
+	return mGeometryPool->GetVertexBuffer();
 }
 
-Buffer* StaticMesh::GetIndexBuffer(int32_t Index /*= 0*/) const
+Buffer* StaticMesh::GetPositionBuffer(int32_t Index /*= 0*/) const
 {
-	Assert(Index < mIndexBuffers.size());
-	return mIndexBuffers[Index].get();
+	Assert(Index < GetVertexBufferCount());
+	return mGeometryPool->GetPositionBuffer();
 }
 
-uint32_t StaticMesh::GetIndiciesSize(int32_t Index /*= 0*/) const
+Buffer* StaticMesh::GetIndexBuffer(int32_t Index /*= 0*/, int32_t Lod /*= 0*/) const
 {
-	Assert(Index < mIndicies.size());
-	return static_cast<uint32_t>(mIndicies[Index].size());
+	return mGeometryPool->GetIndexBuffer(GetGeometryRange(Index, Lod).Type);
 }
 
+uint32_t StaticMesh::GetIndiciesSize(int32_t Index /*= 0*/, int32_t Lod /*= 0*/) const
+{
+	return GetGeometryRange(Index, Lod).IndexCount;
+}
 
-StaticMesh::~StaticMesh()
+const GeometryRange& StaticMesh::GetGeometryRange(int32_t Index /*= 0*/, int32_t Lod /*= 0*/) const
+{
+	Assert(Lod < static_cast<int32_t>(mLodsCount) && GetRangeIndex(Index, Lod) < mGeometryRanges.size());
+	return mGeometryRanges[GetRangeIndex(Index, Lod)];
+}
 
+const glm::vec3& StaticMesh::GetPositionScale(int32_t Index /*= 0*/, int32_t Lod /*= 0*/) const
 {
+	Assert(Lod < static_cast<int32_t>(mLodsCount) && GetRangeIndex(Index, Lod) < mPositionScales.size());
+	return mPositionScales[GetRangeIndex(Index, Lod)];
+}
+
+const glm::vec3& StaticMesh::GetPositionBias(int32_t Index /*= 0*/, int32_t Lod /*= 0*/) const
+{
+	Assert(Lod < static_cast<int32_t>(mLodsCount) && GetRangeIndex(Index, Lod) < mPositionBiases.size());
+	return mPositionBiases[GetRangeIndex(Index, Lod)];
+}
+
+void StaticMesh::GetPositions(std::vector<glm::vec3>& Positions, int32_t Index /*= 0*/, int32_t Lod /*= 0*/) const
+{
+	const uint32_t RangeIdx = GetRangeIndex(Index, Lod);
+	Assert(Lod < static_cast<int32_t>(mLodsCount) && RangeIdx < mVertices.size());
+
+	Positions.clear();
+	Positions.reserve(mVertices[RangeIdx].size());
+
+	for (const VertexDefinition::StaticMesh& Vertex : mVertices[RangeIdx])
+	{
+		Positions.push_back(VertexPacking::UnpackPosition(Vertex.Position, mPositionScales[RangeIdx], mPositionBiases[RangeIdx]));
+	}
+}
+
+const std::vector<uint32_t>& StaticMesh::GetIndices(int32_t Index /*= 0*/, int32_t Lod /*= 0*/) const
+{
+	Assert(Lod < static_cast<int32_t>(mLodsCount) && GetRangeIndex(Index, Lod) < mIndicies.size());
+	return mIndicies[GetRangeIndex(Index, Lod)];
+}
+
+const std::vector<Meshlet>& StaticMesh::GetMeshlets(int32_t Index /*= 0*/, int32_t Lod /*= 0*/) const
+{
+	Assert(Lod < static_cast<int32_t>(mLodsCount) && GetRangeIndex(Index, Lod) < mMeshlets.size());
+	return mMeshlets[GetRangeIndex(Index, Lod)];
+}
+
+float StaticMesh::GetLodScreenSize(int32_t Lod) const
+{
+	Assert(Lod < mLodScreenSizes.size());
+	return mLodScreenSizes[Lod];
+}
+
+const AABB& StaticMesh::GetBoundingBox(int32_t Index /*= 0*/) const
+{
+	Assert(Index < mBoundingBoxes.size());
+	return mBoundingBoxes[Index];
+}
+
+const BoundingSphere& StaticMesh::GetBoundingSphere(int32_t Index /*= 0*/) const
+{
+	Assert(Index < mBoundingSpheres.size());
+	return mBoundingSpheres[Index];
+}
+
+void StaticMesh::ComputeBounds(const VerticiesList& Verticies, const glm::vec3& Scale, const glm::vec3& Bias)
+{
+	// Bounds of the dequantized positions, so they match what the GPU renders
+	std::vector<glm::vec3> Positions;
+	Positions.reserve(Verticies.size());
+
+	for (const VertexDefinition::StaticMesh& Vertex : Verticies)
+	{
+		Positions.push_back(VertexPacking::UnpackPosition(Vertex.Position, Scale, Bias));
+	}
+
+	AABB Box = {};
+
+	if (!Positions.empty())
+	{
+		Box.Min = Box.Max = Positions.front();
+	}
+
+	for (const glm::vec3& Position : Positions)
+	{
+		Box.Min = glm::min(Box.Min, Position);
+		Box.Max = glm::max(Box.Max, Position);
+	}
+
+	// Sphere around the box' center is looser than the minimal one but computing it doesn't depend on vertices' order
+	BoundingSphere Sphere = {};
+	Sphere.Center = Box.GetCenter();
+
+	for (const glm::vec3& Position : Positions)
+	{
+		Sphere.Radius = glm::max(Sphere.Radius, glm::length(Position - Sphere.Center));
+	}
+
+	mBoundingBoxes.push_back(Box);
+	mBoundingSpheres.push_back(Sphere);
+}
+
+
+StaticMesh::~StaticMesh()
+{
+	for (const GeometryRange& Range : mGeometryRanges)
+	{
+		mGeometryPool->Remove(Range);
+	}
 }
 
 StaticMeshHandle::StaticMeshHandle(const std::string& Name)
@@ -109,10 +368,14 @@ StaticMeshHandle::StaticMeshHandle(const std::string& Name)
 
 	const int32_t SubMeshesCount = mStaticMesh->GetVertexBufferCount();
 
+	const bool UseObjectBuffer = DeferredRenderer::Get().IsObjectBufferEnabled();
+	const std::string VertexShader = UseObjectBuffer ? "StaticBasePassSSBO.vert" : "StaticBasePass.vert";
+	const std::string FragmentShader = UseObjectBuffer ? "StaticBasePassSSBO.frag" : "StaticBasePass.frag";
+
 	mMaterials.reserve(SubMeshesCount);
 	for (int32_t i = 0; i < SubMeshesCount; ++i)
 	{
-		mMaterials.emplace_back("StaticBasePass.vert", "StaticBasePass.frag");
+		mMaterials.emplace_back(VertexShader, FragmentShader);
 	}
 }
 
@@ -133,3 +396,27 @@ StaticSurfaceMaterial* StaticMeshHandle::GetMaterial(int32_t Id)
 
 	return &mMaterials[Id];
 }
+
+void StaticMeshHandle::SetForcedLod(int32_t Lod)
+{
+	mForcedLod = Lod < 0 ? -1 : glm::min(Lod, GetLodsCount() - 1);
+}
+
+int32_t StaticMeshHandle::UpdateLod(float ScreenSize, float Hysteresis)
+{
+	const int32_t LodsCount = GetLodsCount();
+
+	mCurrentLod = glm::min(mCurrentLod, LodsCount - 1);
+
+	while (mCurrentLod + 1 < LodsCount && ScreenSize < mStaticMesh->GetLodScreenSize(mCurrentLod + 1) * (1.0f - Hysteresis))
+	{
+		++mCurrentLod;
+	}
+
+	while (mCurrentLod > 0 && ScreenSize > mStaticMesh->GetLodScreenSize(mCurrentLod) * (1.0f + Hysteresis))
+	{
+		--mCurrentLod;
+	}
+
+	return GetCurrentLod();
+}
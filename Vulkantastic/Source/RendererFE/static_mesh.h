@@ -3,12 +3,42 @@
 #include "../Renderer/vertex_definitions.h"
 #include <memory>
 #include "surface_material.h"
+#include "bounds.h"
+#include "geometry_pool.h"
+#include "mesh_optimization.h"
+
+class FileHandle;
+
+// Layout of .sm files
+// Packed files start with the magic, version, uint32 levels of detail count and float screen size of every level
+// Every submesh stores all of its levels one after another, every level as:
+// uint32 vertices count, vec3 position scale, vec3 position bias, packed vertices, uint32 indices count, uint32 index size (2 or 4), indices,
+// uint32 meshlets count, meshlets (Meshlet)
+// Version 2 files don't have the levels of detail count and screen sizes, they have one level
+// Files before version 4 don't have meshlets, they are built while loading
+// Files without the header store full float vertices (UnpackedVertex) and 32-bit indices, they are packed while loading
+namespace StaticMeshFile
+{
+	constexpr uint32_t Magic = 0x48534D53; // "SMSH"
+	constexpr uint32_t Version = 4;
+	constexpr uint32_t MaxLodsCount = 8;
+
+	struct UnpackedVertex
+	{
+		glm::vec3 Position;
+		glm::vec2 TexCoord;
+		glm::vec3 Normal;
+		glm::vec3 Tangent;
+	};
 
+	// Quantizes positions to the bounds of the vertices which are returned as scale and bias
+	void PackVertices(const std::vector<UnpackedVertex>& Vertices, std::vector<VertexDefinition::StaticMesh>& PackedVertices, glm::vec3& Scale, glm::vec3& Bias);
+}
 
 class StaticMesh
 {
 public:
-	StaticMesh(const std::string& Name);
+	StaticMesh(const std::string& Name, uint32_t Id = 0);
 	~StaticMesh();
 
 	StaticMesh(const StaticMesh& Rhs) = delete;
@@ -17,24 +47,71 @@ public:
 	StaticMesh(StaticMesh&& Rhs) = delete;
 	StaticMesh& operator=(StaticMesh&& Rhs) = delete;
 
+	// Buffers of the geometry pool shared by all static meshes, submeshes are drawn with their ranges' offsets
+	// Every level of detail of a submesh has its own range
 	Buffer* GetVertexBuffer(int32_t Index = 0) const;
-	Buffer* GetIndexBuffer(int32_t Index = 0) const;
-	uint32_t GetIndiciesSize(int32_t Index = 0) const;
+	Buffer* GetPositionBuffer(int32_t Index = 0) const; // Vertex offsets are the same as in the vertex buffer
+	Buffer* GetIndexBuffer(int32_t Index = 0, int32_t Lod = 0) const;
+	uint32_t GetIndiciesSize(int32_t Index = 0, int32_t Lod = 0) const;
+	const GeometryRange& GetGeometryRange(int32_t Index = 0, int32_t Lod = 0) const;
+
+	// Dequantization of the submesh's packed positions, Position = Packed * Scale + Bias
+	const glm::vec3& GetPositionScale(int32_t Index = 0, int32_t Lod = 0) const;
+	const glm::vec3& GetPositionBias(int32_t Index = 0, int32_t Lod = 0) const;
+
+	// Dequantized positions and indices of a level kept on the CPU, used to rasterize occluders
+	void GetPositions(std::vector<glm::vec3>& Positions, int32_t Index = 0, int32_t Lod = 0) const;
+	const std::vector<uint32_t>& GetIndices(int32_t Index = 0, int32_t Lod = 0) const;
+
+	// Clusters of the level's triangles with their bounds and normal cones, first indices are relative to the level's geometry range
+	const std::vector<Meshlet>& GetMeshlets(int32_t Index = 0, int32_t Lod = 0) const;
 
-	int32_t GetVertexBufferCount() const { return static_cast<int32_t>(mVertexBuffers.size()); }
+	// Bounds of a submesh in the mesh's local space, the same for all levels of detail
+	const AABB& GetBoundingBox(int32_t Index = 0) const;
+	const BoundingSphere& GetBoundingSphere(int32_t Index = 0) const;
+
+	int32_t GetVertexBufferCount() const { return static_cast<int32_t>(mGeometryRanges.size() / mLodsCount); }
+
+	// Levels of detail are shared by all submeshes, level N is used when the mesh's screen size is below GetLodScreenSize(N)
+	inline int32_t GetLodsCount() const { return static_cast<int32_t>(mLodsCount); }
+	float GetLodScreenSize(int32_t Lod) const;
+
+	// Index of the mesh in the order of loading
+	inline uint32_t GetId() const { return mId; }
 
 private:
 	std::string mName;
+	uint32_t mId = 0;
 
 	using VerticiesList = std::vector<VertexDefinition::StaticMesh>;
 	using IndiciesList = std::vector<uint32_t>;
-	using BufferList = std::unique_ptr<Buffer>;
 
 	std::vector<VerticiesList> mVertices;
 	std::vector<IndiciesList> mIndicies;
 
-	std::vector<BufferList> mVertexBuffers;
-	std::vector<BufferList> mIndexBuffers;
+	GeometryPool* mGeometryPool = nullptr;
+	std::vector<GeometryRange> mGeometryRanges; // Levels of detail of one submesh are next to each other
+
+	uint32_t mLodsCount = 1;
+	std::vector<float> mLodScreenSizes;
+
+	std::vector<std::vector<Meshlet>> mMeshlets; // Parallel to mGeometryRanges
+
+	std::vector<glm::vec3> mPositionScales;
+	std::vector<glm::vec3> mPositionBiases;
+
+	std::vector<AABB> mBoundingBoxes;
+	std::vector<BoundingSphere> mBoundingSpheres;
+
+	void ReadPackedSubmesh(FileHandle* Source, uint32_t Version);
+	void ReadUnpackedSubmesh(FileHandle* Source, uint32_t VerticesCount);
+
+	// Meshlets are built when the list is empty, which reorders the indices
+	void AddSubmesh(VerticiesList&& Verticies, IndiciesList&& Indicies, const glm::vec3& Scale, const glm::vec3& Bias, std::vector<Meshlet>&& Meshlets = {});
+
+	inline uint32_t GetRangeIndex(int32_t Index, int32_t Lod) const { return Index * mLodsCount + Lod; }
+
+	void ComputeBounds(const VerticiesList& Verticies, const glm::vec3& Scale, const glm::vec3& Bias);
 
 };
 
@@ -53,12 +130,27 @@ public:
 	inline const StaticMesh* GetStaticMesh() const { return mStaticMesh; }
 	inline std::string GetStaticMeshName() const { return mName; }
 
+	// Level of detail the handle is drawn with, chosen by the renderer every frame unless it's forced
+	inline int32_t GetLodsCount() const { return mStaticMesh->GetLodsCount(); }
+	inline int32_t GetCurrentLod() const { return mForcedLod >= 0 ? mForcedLod : mCurrentLod; }
+
+	// Negative value lets the renderer choose again
+	void SetForcedLod(int32_t Lod);
+	inline int32_t GetForcedLod() const { return mForcedLod; }
+
+	// Moves to a coarser level only when the screen size is below its threshold by the hysteresis fraction
+	// and to a finer one only when it's above the current level's threshold by the same fraction, so levels don't flicker on the boundaries
+	int32_t UpdateLod(float ScreenSize, float Hysteresis);
+
 private:
 	using MaterialList = std::vector<StaticSurfaceMaterial>;
 
 	StaticMesh* mStaticMesh = nullptr;
 	std::string mName;
 
+	int32_t mCurrentLod = 0;
+	int32_t mForcedLod = -1;
+
 	MaterialList mMaterials;
 };
 
@@ -1,3 +1,4 @@
+#define NOMINMAX
 #include "static_mesh_component.h"
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/quaternion.hpp>
@@ -8,6 +8,20 @@
 #include "texture_manager.h"
 #include "../Renderer/shader_parameters.h"
 
+struct MaterialImageParam
+{
+	std::string ImageName;
+	UniformHandle Handle; // Member of the texture parameters that receives the image's index
+	ShaderType Stage = ShaderType::FRAGMENT; // Stage of the texture parameters
+};
+
+struct MaterialSamplerParam
+{
+	SamplerSettings Settings;
+	UniformHandle Handle; // Member of the texture parameters that receives the sampler's index
+	ShaderType Stage = ShaderType::FRAGMENT; // Stage of the texture parameters
+};
+
 template<typename ...T>
 class SurfaceMaterial
 {
@@ -21,17 +35,24 @@ public:
 	SurfaceMaterial(SurfaceMaterial&& Rhs) noexcept;
 	SurfaceMaterial& operator=(SurfaceMaterial&& Rhs) noexcept;
 
-	SurfaceMaterial(const std::string& VertexShader, const std::string& FragmentShader);
+	// State picks a variant of the shaders' pipeline, e.g. double-sided or translucent
+	SurfaceMaterial(const std::string& VertexShader, const std::string& FragmentShader, const PipelineState& State = {});
 
 	SurfaceMaterial& SetMVP(const glm::mat4x4& MVP);
 	SurfaceMaterial& SetMV(const glm::mat4x4& MV);
+	SurfaceMaterial& SetPositionDequantization(const glm::vec3& Scale, const glm::vec3& Bias);
 	SurfaceMaterial& SetCustomColor(const glm::vec3& CustomColor); 
 	SurfaceMaterial& SetAlbedoTexture(const std::string& Name);
 
 	inline ShaderParameters* GetShaderParameters() const { return mShaderParams.get(); }
 
-	std::map<std::string, std::string> GetUsedImages() const { return mImages; }
-	std::map<std::string, SamplerSettings> GetUsedSamplers() const { return mSamplers; }
+	inline const std::map<std::string, MaterialImageParam>& GetUsedImages() const { return mImages; }
+	inline const std::map<std::string, MaterialSamplerParam>& GetUsedSamplers() const { return mSamplers; }
+
+	// Per-object data lives in the object buffer's element when shaders use one, otherwise in uniform buffers and push constants
+	UniformRawData* GetTransformParameters() const;
+	UniformRawData* GetColorParameters() const;
+	UniformRawData* GetTextureParameters(ShaderType Stage = ShaderType::FRAGMENT) const;
 
 	IGraphicsPipeline* GetPipeline() const;
 
@@ -41,8 +62,17 @@ private:
 
 	upShaderParameters mShaderParams;
 
-	std::map<std::string, std::string> mImages;  // PushConstantName -> ImageName
-	std::map<std::string, SamplerSettings> mSamplers;  // PushConstantName -> SamplerSettings
+	std::map<std::string, MaterialImageParam> mImages;  // PushConstantName -> ImageName
+	std::map<std::string, MaterialSamplerParam> mSamplers;  // PushConstantName -> SamplerSettings
+
+	UniformHandle mMVPHandle;
+	UniformHandle mMVHandle;
+	UniformHandle mPositionScaleHandle;
+	UniformHandle mPositionBiasHandle;
+	UniformHandle mCustomColorHandle;
+
+	// Searches push constants of fragment and vertex shaders, the stage that declares the name is returned in Stage
+	UniformHandle GetTextureHandle(const std::string& Name, ShaderType& Stage) const;
 
 	std::string mVertexShader;
 	std::string mFragmentShader;
@@ -72,6 +102,13 @@ SurfaceMaterial<T...>& SurfaceMaterial<T...>::operator=(const SurfaceMaterial& R
 	}
 
 	mImages = Rhs.mImages;
+	mSamplers = Rhs.mSamplers;
+
+	mMVPHandle = Rhs.mMVPHandle;
+	mMVHandle = Rhs.mMVHandle;
+	mPositionScaleHandle = Rhs.mPositionScaleHandle;
+	mPositionBiasHandle = Rhs.mPositionBiasHandle;
+	mCustomColorHandle = Rhs.mCustomColorHandle;
 
 	return *this;
 }
@@ -91,6 +128,13 @@ SurfaceMaterial<T...>& SurfaceMaterial<T...>::operator=(SurfaceMaterial<T...>&&
 	mShaderParams = std::move(Rhs.mShaderParams);
 
 	mImages = std::move(Rhs.mImages);
+	mSamplers = std::move(Rhs.mSamplers);
+
+	mMVPHandle = Rhs.mMVPHandle;
+	mMVHandle = Rhs.mMVHandle;
+	mPositionScaleHandle = Rhs.mPositionScaleHandle;
+	mPositionBiasHandle = Rhs.mPositionBiasHandle;
+	mCustomColorHandle = Rhs.mCustomColorHandle;
 
 	return *this;
 }
@@ -108,7 +152,7 @@ IGraphicsPipeline* SurfaceMaterial<T...>::GetPipeline() const
 }
 
 template<typename ...T>
-SurfaceMaterial<T...>::SurfaceMaterial(const std::string& VertexShaderName, const std::string& FragmentShaderName)
+SurfaceMaterial<T...>::SurfaceMaterial(const std::string& VertexShaderName, const std::string& FragmentShaderName, const PipelineState& State /*= {}*/)
 	: mVertexShader(VertexShaderName), mFragmentShader(FragmentShaderName)
 {
 	Shader* VertexShader = ShaderManager::Get().Find(VertexShaderName);
@@ -120,23 +164,47 @@ SurfaceMaterial<T...>::SurfaceMaterial(const std::string& VertexShaderName, cons
 
 	RenderPass* Rp = DeferredRenderer::Get().GetBasePassRenderPass();
 
-	mShaderParams = PipelineManager::Get().GetShaderParametersInstance<T...>(*Rp, Shaders, 1); // Set 1 should contain uniform buffer
+	mShaderParams = PipelineManager::Get().GetShaderParametersInstance<T...>(*Rp, Shaders, 1, State); // Set 1 should contain uniform buffer
+
+	// Resolve uniform members once so per frame setters don't have to look them up by name
+	if (const UniformRawData* Transform = GetTransformParameters())
+	{
+		mMVPHandle = Transform->GetHandle("MVP2");
+		mMVHandle = Transform->GetHandle("MV2");
+		mPositionScaleHandle = Transform->GetHandle("PositionScale");
+		mPositionBiasHandle = Transform->GetHandle("PositionBias");
+	}
+
+	if (const UniformRawData* Color = GetColorParameters())
+	{
+		mCustomColorHandle = Color->GetHandle("CustomColor2");
+	}
 
 	// Define default images used by material
-	mImages["AlbedoIdx"] = "test";
+	MaterialImageParam& Albedo = mImages["AlbedoIdx"];
+	Albedo.ImageName = "test";
+	Albedo.Handle = GetTextureHandle("AlbedoIdx", Albedo.Stage);
 
 	// Define default samplers used by material
-	mSamplers["WrapIdx"] = WrapSampler;
-	mSamplers["RepeatIdx"] = RepeatSampler;
+	MaterialSamplerParam& Wrap = mSamplers["WrapIdx"];
+	Wrap.Settings = WrapSampler;
+	Wrap.Handle = GetTextureHandle("WrapIdx", Wrap.Stage);
+
+	MaterialSamplerParam& Repeat = mSamplers["RepeatIdx"];
+	Repeat.Settings = RepeatSampler;
+	Repeat.Handle = GetTextureHandle("RepeatIdx", Repeat.Stage);
 
 }
 
 template<typename ...T>
 SurfaceMaterial<T...>& SurfaceMaterial<T...>::SetMVP(const glm::mat4x4& MVP)
 {
+	UniformRawData* RawData = GetTransformParameters();
 
-	UniformRawData* RawData = mShaderParams->GetUniformBufferByBinding(0); // Vertex shader's uniform buffer
-	RawData->Set("MVP2", MVP);
+	if (RawData)
+	{
+		RawData->Set(mMVPHandle, MVP);
+	}
 
 	return *this;
 }
@@ -145,9 +213,27 @@ SurfaceMaterial<T...>& SurfaceMaterial<T...>::SetMVP(const glm::mat4x4& MVP)
 template<typename ...T>
 SurfaceMaterial<T...>& SurfaceMaterial<T...>::SetMV(const glm::mat4x4& MV)
 {
+	UniformRawData* RawData = GetTransformParameters();
+
+	if (RawData)
+	{
+		RawData->Set(mMVHandle, MV);
+	}
+
+	return *this;
+}
+
+
+template<typename ...T>
+SurfaceMaterial<T...>& SurfaceMaterial<T...>::SetPositionDequantization(const glm::vec3& Scale, const glm::vec3& Bias)
+{
+	UniformRawData* RawData = GetTransformParameters();
 
-	UniformRawData* RawData = mShaderParams->GetUniformBufferByBinding(0); // Vertex shader's uniform buffer
-	RawData->Set("MV2", MV);
+	if (RawData)
+	{
+		RawData->Set(mPositionScaleHandle, glm::vec4(Scale, 0.0f));
+		RawData->Set(mPositionBiasHandle, glm::vec4(Bias, 0.0f));
+	}
 
 	return *this;
 }
@@ -159,8 +245,12 @@ SurfaceMaterial<T...>& SurfaceMaterial<T...>::SetCustomColor(const glm::vec3& Cu
 	//auto PCFragPtr = mShaderParams->GetPushConstantBuffer(ShaderType::FRAGMENT);
 	//PCFragPtr->Set("CustomColor", CustomColor);
 
-	UniformRawData* RawData = mShaderParams->GetUniformBufferByBinding(1); // Fragment shader's uniform buffer
-	RawData->Set("CustomColor2", CustomColor);
+	UniformRawData* RawData = GetColorParameters();
+
+	if (RawData)
+	{
+		RawData->Set(mCustomColorHandle, CustomColor);
+	}
 
 	return *this;
 }
@@ -168,9 +258,49 @@ SurfaceMaterial<T...>& SurfaceMaterial<T...>::SetCustomColor(const glm::vec3& Cu
 template<typename ...T>
 SurfaceMaterial<T...>& SurfaceMaterial<T...>::SetAlbedoTexture(const std::string& Name)
 {
-	mImages["AlbedoIdx"] = Name;
+	mImages["AlbedoIdx"].ImageName = Name;
 	
 	return *this;
 }
 
+template<typename ...T>
+UniformRawData* SurfaceMaterial<T...>::GetTransformParameters() const
+{
+	UniformRawData* ObjectData = mShaderParams->GetObjectData();
+	return ObjectData ? ObjectData : mShaderParams->GetUniformBufferByBinding(0); // Vertex shader's uniform buffer
+}
+
+template<typename ...T>
+UniformRawData* SurfaceMaterial<T...>::GetColorParameters() const
+{
+	UniformRawData* ObjectData = mShaderParams->GetObjectData();
+	return ObjectData ? ObjectData : mShaderParams->GetUniformBufferByBinding(1); // Fragment shader's uniform buffer
+}
+
+template<typename ...T>
+UniformRawData* SurfaceMaterial<T...>::GetTextureParameters(ShaderType Stage /*= ShaderType::FRAGMENT*/) const
+{
+	UniformRawData* ObjectData = mShaderParams->GetObjectData();
+	return ObjectData ? ObjectData : mShaderParams->GetPushConstantBuffer(Stage);
+}
+
+template<typename ...T>
+UniformHandle SurfaceMaterial<T...>::GetTextureHandle(const std::string& Name, ShaderType& Stage) const
+{
+	for (ShaderType CurrentStage : { ShaderType::FRAGMENT, ShaderType::VERTEX })
+	{
+		const UniformRawData* RawData = GetTextureParameters(CurrentStage);
+		const UniformHandle Handle = RawData ? RawData->GetHandle(Name) : UniformHandle();
+
+		if (Handle.IsValid())
+		{
+			Stage = CurrentStage;
+			return Handle;
+		}
+	}
+
+	Assert(false); // Shaders of the material don't declare the texture parameter
+	return UniformHandle();
+}
+
 
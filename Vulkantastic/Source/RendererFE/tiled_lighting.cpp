@@ -0,0 +1,136 @@
+#define NOMINMAX
+#include "tiled_lighting.h"
+#include "../Renderer/buffer.h"
+#include "../Renderer/core.h"
+#include "../Renderer/device.h"
+#include "../Renderer/image_view.h"
+#include "../Renderer/pipeline_manager.h"
+#include "../Renderer/renderer_commands.h"
+#include "../Renderer/sampler.h"
+#include "../Renderer/shader_structs.h"
+#include "../Utilities/assert.h"
+
+namespace
+{
+	// Bindings of LightCulling.comp
+	constexpr int32_t CullingDepthBinding = 0;
+	constexpr int32_t CullingLightBinding = 1;
+	constexpr int32_t CullingTileBinding = 2;
+	constexpr int32_t CullingOverflowBinding = 3;
+}
+
+TiledLighting::TiledLighting(uint32_t Width, uint32_t Height)
+	: mWidth(Width), mHeight(Height)
+{
+	Assert(Width > 0 && Height > 0);
+
+	Shader* CullingShader = ShaderManager::Get().Find("LightCulling.comp");
+	Assert(CullingShader);
+
+	mCullingPipeline = PipelineManager::Get().GetComputePipeline(CullingShader);
+	Assert(mCullingPipeline->GetWorkgroupSize().X == TileSize && mCullingPipeline->GetWorkgroupSize().Y == TileSize);
+
+	mCullingDescriptorInst = mCullingPipeline->GetDescriptorManager()->GetDescriptorInstance(0);
+
+	mTilesX = (Width + TileSize - 1) / TileSize;
+	mTilesY = (Height + TileSize - 1) / TileSize;
+
+	const uint32_t GraphicsQueueIndex = VulkanCore::Get().GetDevice()->GetQueuesIndicies().GraphicsIndex;
+	const std::vector<uint32_t> Queues = { GraphicsQueueIndex };
+
+	mTileBuffer = std::make_unique<Buffer>(Queues, BufferUsage::STORAGE, true, static_cast<uint32_t>(sizeof(uint32_t) * (MaxLightsPerTile + 1) * mTilesX * mTilesY));
+
+	const ShaderStructs::LightCullingComp::OverflowBuffer Overflow = {};
+	mOverflowBuffer = std::make_unique<Buffer>(Queues, BufferUsage::STORAGE | BufferUsage::TRANSFER_DST, false, static_cast<uint32_t>(sizeof(Overflow)), &Overflow);
+}
+
+TiledLighting::~TiledLighting()
+{
+
+}
+
+uint32_t TiledLighting::UploadLights(const std::vector<Light>& Lights, const glm::mat4& View, const Frustum& ViewFrustum)
+{
+	// Previous frame has finished before this one started recording, so its counters can be read
+	mOverflowStats = LightOverflowStats();
+
+	if (mOverflowPending)
+	{
+		ShaderStructs::LightCullingComp::OverflowBuffer Overflow = {};
+		mOverflowBuffer->ReadData(&Overflow, sizeof(Overflow));
+
+		mOverflowStats.TilesOverflowed = Overflow.TilesOverflowed;
+		mOverflowStats.LightsDropped = Overflow.LightsDropped;
+		mOverflowPending = false;
+	}
+
+	mLights.clear();
+
+	for (const Light& CurrentLight : Lights)
+	{
+		if (!ViewFrustum.Intersects({ CurrentLight.Position, CurrentLight.Radius })) { continue; }
+
+		LightData Data = {};
+		Data.Position = glm::vec3(View * glm::vec4(CurrentLight.Position, 1.0f));
+		Data.Radius = CurrentLight.Radius;
+		Data.Color = CurrentLight.Color;
+		Data.Type = static_cast<uint32_t>(CurrentLight.Type);
+		Data.Direction = glm::normalize(glm::vec3(View * glm::vec4(CurrentLight.Direction, 0.0f)));
+		Data.CosOuterCone = glm::cos(CurrentLight.OuterConeAngle);
+		Data.CosInnerCone = glm::cos(CurrentLight.InnerConeAngle);
+
+		mLights.push_back(Data);
+	}
+
+	// Buffer grows to the next power of two, an empty buffer can't be bound
+	const uint32_t RequiredCapacity = std::max(static_cast<uint32_t>(mLights.size()), 1u);
+
+	if (RequiredCapacity > mLightsCapacity)
+	{
+		while (mLightsCapacity < RequiredCapacity)
+		{
+			mLightsCapacity = std::max(mLightsCapacity * 2, 64u);
+		}
+
+		const uint32_t GraphicsQueueIndex = VulkanCore::Get().GetDevice()->GetQueuesIndicies().GraphicsIndex;
+		mLightBuffer = std::make_unique<Buffer>(std::vector<uint32_t>{ GraphicsQueueIndex }, BufferUsage::STORAGE, false, static_cast<uint32_t>(sizeof(LightData) * mLightsCapacity));
+	}
+
+	if (!mLights.empty())
+	{
+		mLightBuffer->UploadData(mLights.data(), static_cast<uint32_t>(sizeof(LightData) * mLights.size()));
+	}
+
+	return GetLightsCount();
+}
+
+void TiledLighting::Cull(CommandBuffer* Cb, ImageView* DepthView, Sampler* DepthSampler, const glm::mat4& InverseProjection)
+{
+	Assert(mLightBuffer);
+
+	mCullingDescriptorInst->SetImage(CullingDepthBinding, DepthView, DepthSampler);
+	mCullingDescriptorInst->SetBuffer(CullingLightBinding, mLightBuffer.get(), VK_WHOLE_SIZE);
+	mCullingDescriptorInst->SetBuffer(CullingTileBinding, mTileBuffer.get(), VK_WHOLE_SIZE);
+	mCullingDescriptorInst->SetBuffer(CullingOverflowBinding, mOverflowBuffer.get(), VK_WHOLE_SIZE);
+	mCullingDescriptorInst->Update();
+
+	Cmd::FillBuffer(Cb, mOverflowBuffer.get(), 0);
+	Cmd::BufferBarrier(Cb, mOverflowBuffer.get(), PipelineStage::TRANSER, VK_ACCESS_TRANSFER_WRITE_BIT, PipelineStage::COMPUTE, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+	Cmd::BindComputePipeline(Cb, mCullingPipeline);
+	Cmd::UpdateDescriptorData(Cb, mCullingDescriptorInst.get(), mCullingPipeline);
+
+	ShaderStructs::LightCullingComp::CullingInfo Info = {};
+	Info.InverseProjection = InverseProjection;
+	Info.ScreenWidth = mWidth;
+	Info.ScreenHeight = mHeight;
+	Info.LightsCount = GetLightsCount();
+
+	Cmd::PushConstants(Cb, mCullingPipeline, Info);
+	Cmd::Dispatch(Cb, mTilesX, mTilesY);
+
+	Cmd::BufferBarrier(Cb, mTileBuffer.get(), PipelineStage::COMPUTE, VK_ACCESS_SHADER_WRITE_BIT, PipelineStage::FRAGMENT, VK_ACCESS_SHADER_READ_BIT);
+	Cmd::BufferBarrier(Cb, mOverflowBuffer.get(), PipelineStage::COMPUTE, VK_ACCESS_SHADER_WRITE_BIT, PipelineStage::HOST, VK_ACCESS_HOST_READ_BIT);
+
+	mOverflowPending = true;
+}
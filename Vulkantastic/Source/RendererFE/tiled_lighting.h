@@ -0,0 +1,93 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "../Renderer/pipeline.h"
+#include "bounds.h"
+#include "light.h"
+
+class Buffer;
+class CommandBuffer;
+class ImageView;
+class Sampler;
+
+// Lights that didn't fit into their tiles' lists, read back one frame later
+struct LightOverflowStats
+{
+	uint32_t TilesOverflowed = 0; // Tiles that found more than MaxLightsPerTile lights
+	uint32_t LightsDropped = 0; // Sum over those tiles of the lights past MaxLightsPerTile
+};
+
+// Bins local lights into screen tiles on the GPU, the light pass then evaluates only the lights of every pixel's tile
+// Tiles are bounded by the depth range of their pixels, tiles without any geometry get no lights
+class TiledLighting
+{
+public:
+	// Has to match TileSize in LightCulling.comp and TiledLightPass.frag
+	static constexpr uint32_t TileSize = 16;
+
+	// Has to match MaxLightsPerTile in LightCulling.comp and TiledLightPass.frag, further lights of a tile are dropped and counted in LightOverflowStats
+	static constexpr uint32_t MaxLightsPerTile = 255;
+
+	// Mirror of the structure in LightCulling.comp and TiledLightPass.frag, in view space
+	struct LightData
+	{
+		glm::vec3 Position;
+		float Radius;
+		glm::vec3 Color;
+		uint32_t Type;
+		glm::vec3 Direction;
+		float CosOuterCone;
+		float CosInnerCone;
+		uint32_t Padding0;
+		uint32_t Padding1;
+		uint32_t Padding2;
+	};
+	static_assert(sizeof(LightData) == 64, "Invalid size of LightData");
+
+	TiledLighting(uint32_t Width, uint32_t Height);
+	~TiledLighting();
+
+	TiledLighting(const TiledLighting& Rhs) = delete;
+	TiledLighting& operator=(const TiledLighting& Rhs) = delete;
+
+	TiledLighting(TiledLighting&& Rhs) = delete;
+	TiledLighting& operator=(TiledLighting&& Rhs) = delete;
+
+	// Lights outside of the frustum are dropped, the rest is moved to view space and uploaded
+	// Returns the number of lights left, overflow of the previous frame's culling is read back as well
+	uint32_t UploadLights(const std::vector<Light>& Lights, const glm::mat4& View, const Frustum& ViewFrustum);
+
+	// Fills the tiles' light lists and makes them visible to fragment shaders, has to be recorded outside of a render pass
+	// Depth view has to be sampleable and in the read only depth stencil layout
+	void Cull(CommandBuffer* Cb, ImageView* DepthView, Sampler* DepthSampler, const glm::mat4& InverseProjection);
+
+	inline Buffer* GetLightBuffer() const { return mLightBuffer.get(); }
+	inline Buffer* GetTileBuffer() const { return mTileBuffer.get(); }
+	inline uint32_t GetTilesX() const { return mTilesX; }
+	inline uint32_t GetTilesY() const { return mTilesY; }
+	inline uint32_t GetLightsCount() const { return static_cast<uint32_t>(mLights.size()); }
+	inline const std::vector<LightData>& GetLights() const { return mLights; }
+	inline const LightOverflowStats& GetOverflowStats() const { return mOverflowStats; }
+
+private:
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
+	uint32_t mTilesX = 0;
+	uint32_t mTilesY = 0;
+	uint32_t mLightsCapacity = 0;
+
+	std::vector<LightData> mLights;
+
+	std::unique_ptr<Buffer> mLightBuffer;
+	std::unique_ptr<Buffer> mTileBuffer; // Every tile keeps its lights count followed by MaxLightsPerTile indices
+	std::unique_ptr<Buffer> mOverflowBuffer; // Host visible counters of LightCulling.comp
+
+	LightOverflowStats mOverflowStats;
+	bool mOverflowPending = false; // Culling was recorded in the previous frame and its counters weren't read yet
+
+	ComputePipeline* mCullingPipeline = nullptr; // Owned by the pipeline manager
+	upDescriptorInst mCullingDescriptorInst;
+
+};
+
+using upTiledLighting = std::unique_ptr<TiledLighting>;
@@ -0,0 +1,7 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Depth only, nothing is written to color attachments
+void main()
+{
+}
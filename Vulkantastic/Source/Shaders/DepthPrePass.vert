@@ -0,0 +1,33 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Reads only the position stream of the geometry pool
+layout(location=0) in vec4 Position; // Quantized to the submesh's bounds
+
+// Has to produce the same depth as the base pass shaders for their equal depth test
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+invariant gl_Position;
+
+// Has to match DeferredRenderer::DepthObjectData, one entry per draw packet indexed by the instance index
+struct DepthObjectData
+{
+    mat4 MVP;
+    vec4 PositionScale;
+    vec4 PositionBias;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer DepthObjectBuffer {
+    DepthObjectData Objects[];
+};
+
+void main()
+{
+	DepthObjectData Object = Objects[gl_InstanceIndex];
+
+	vec3 LocalPosition = Position.xyz * Object.PositionScale.xyz + Object.PositionBias.xyz;
+
+	gl_Position = Object.MVP * vec4(LocalPosition, 1.0f);
+}
@@ -7,18 +7,48 @@ layout(location=1) in vec2 fTexCoord;
 
 layout(binding=0) uniform sampler2D ColorTex;
 layout(binding=1) uniform sampler2D NormalTex;
-layout(binding=2) uniform sampler2D PositionTex;
+layout(binding=2) uniform sampler2D DepthTex;
 
 layout(push_constant) uniform LightInfo
 {
 	layout(offset = 0) vec3 Direction;
     vec3 LightColor;
+    mat4 InverseProjection; // From the base pass' normalized device coordinates to view space
 };
 
+// Has to match EncodeOctahedral in the base pass shaders
+vec3 DecodeOctahedral(vec2 Encoded)
+{
+    vec3 Direction = vec3(Encoded, 1.0f - abs(Encoded.x) - abs(Encoded.y));
+    float Fold = max(-Direction.z, 0.0f);
+    Direction.x += Direction.x >= 0.0f ? -Fold : Fold;
+    Direction.y += Direction.y >= 0.0f ? -Fold : Fold;
+    return normalize(Direction);
+}
+
+vec3 ReconstructPosition(vec2 TexCoord, float Depth)
+{
+    vec4 Position = InverseProjection * vec4(TexCoord * 2.0f - 1.0f, Depth, 1.0f);
+    return Position.xyz / Position.w;
+}
+
 void main()
 {
+    float Depth = texture(DepthTex,fTexCoord).r;
+
+    // Nothing was drawn by the base pass
+    if (Depth >= 1.0f)
+    {
+        Color = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        return;
+    }
+
     vec3 LocalColor = texture(ColorTex,fTexCoord).rgb;
-    vec3 LocalNormal = texture(NormalTex,fTexCoord).rgb;
+    vec3 LocalNormal = DecodeOctahedral(texture(NormalTex,fTexCoord).rg * 2.0f - 1.0f);
+    vec3 LocalPosition = ReconstructPosition(fTexCoord, Depth);
+
+    // Normals of surfaces facing away from the camera are flipped towards it
+    LocalNormal = faceforward(LocalNormal, LocalPosition, LocalNormal);
 
     vec3 Diffuse = LocalColor * LightColor * max(dot(-Direction, LocalNormal), 0.0f);
     Color = vec4(Diffuse, 1.0f);
@@ -0,0 +1,17 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location=1) out vec2 fTexCoord;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+// Single triangle covering the whole screen, drawn without a vertex buffer
+void main()
+{
+	vec2 TexCoord = vec2(gl_VertexIndex & 2, (gl_VertexIndex << 1) & 2);
+
+	gl_Position = vec4(TexCoord * 2.0f - 1.0f, 0.0f, 1.0f);
+	fTexCoord = TexCoord;
+}
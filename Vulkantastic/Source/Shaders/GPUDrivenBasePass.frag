@@ -0,0 +1,39 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+#define MaxImages 1024
+#define MaxSamplers 2
+
+layout(location=0) out vec4 Color;
+layout(location=1) out vec4 Normal;
+
+layout(location=0) in vec2 fTexCoord;
+layout(location=1) in vec3 fNormal;
+layout(location=3) flat in vec3 fColor;
+layout(location=4) flat in int fAlbedoIdx;
+layout(location=5) flat in int fSamplerIdx;
+
+layout(set = 0, binding = 0) uniform sampler SamplersArray[MaxSamplers];
+layout(set = 0, binding = 1) uniform texture2D ImagesArray[MaxImages];
+
+// Has to match DecodeOctahedral in DirectionalLightPass.frag
+vec2 EncodeOctahedral(vec3 Direction)
+{
+    Direction /= abs(Direction.x) + abs(Direction.y) + abs(Direction.z);
+    vec2 Encoded = Direction.xy;
+
+    if (Direction.z < 0.0f)
+    {
+        Encoded = (1.0f - abs(Direction.yx)) * vec2(Direction.x >= 0.0f ? 1.0f : -1.0f, Direction.y >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    return Encoded;
+}
+
+void main()
+{
+    vec4 TexColor = texture(sampler2D(ImagesArray[fAlbedoIdx], SamplersArray[fSamplerIdx]), fTexCoord);
+
+    Color = vec4(fColor, 1.0f) * TexColor;
+    Normal = vec4(EncodeOctahedral(normalize(fNormal)) * 0.5f + 0.5f, 0.0f, 1.0f); // Unsigned normalized targets
+}
@@ -0,0 +1,103 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location=0) in vec4 Position; // Quantized to the submesh's bounds
+layout(location=1) in vec2 TexCoord;
+layout(location=2) in vec2 Normal; // Octahedral encoded
+layout(location=3) in vec2 Tangent;
+
+layout(location=0) out vec2 fTexCoord;
+layout(location=1) out vec3 fNormal;
+layout(location=3) flat out vec3 fColor;
+layout(location=4) flat out int fAlbedoIdx;
+layout(location=5) flat out int fSamplerIdx;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+struct InstanceData
+{
+    mat4 Model;
+    vec4 Color;
+    uint DrawGroup;
+    uint Padding0;
+    uint Padding1;
+    uint Padding2;
+};
+
+struct DrawGroupData
+{
+    vec4 BoundingSphere;
+    int AlbedoIdx;
+    int SamplerIdx;
+    uint FirstVisible;
+    uint MeshletsCount;
+    vec4 PositionScale; // Dequantization of the submesh's positions
+    vec4 PositionBias;
+    uint FirstMeshlet;
+    uint DrawRun; // Groups with the same index type drawn by one call
+    uint DrawRunBegin;
+    uint LodsCount; // Groups of the other levels of detail follow the first one
+    vec4 LodScreenSizes[2]; // Level N is used when the projected size is below LodScreenSizes[N / 4][N % 4]
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer InstanceBuffer {
+    InstanceData Instances[];
+};
+
+layout(std430, set = 1, binding = 1) readonly buffer DrawGroupBuffer {
+    DrawGroupData DrawGroups[];
+};
+
+layout(std430, set = 1, binding = 2) readonly buffer VisibleInstanceBuffer {
+    uint VisibleInstances[];
+};
+
+layout(std430, set = 1, binding = 3) readonly buffer FrameBuffer {
+    mat4 ViewProjection;
+    mat4 View;
+    vec4 FrustumPlanes[6];
+    vec4 CameraPosition;
+    uint InstancesCount;
+    uint MeshletCommandsCapacity16; // Commands for meshlets with 16-bit indices, the ones with 32-bit indices follow them
+    uint MeshletCommandsCapacity32;
+    float LodScale; // Projected size of a sphere is its radius over the distance times LodScale, zero when levels aren't selected
+};
+
+// FirstVisible is zero when indirect draws start at their group's first visible instance
+// Draws of meshlets start at the instance itself and set DirectInstance
+layout(push_constant) uniform DrawInfo {
+    uint FirstVisible;
+    uint DirectInstance;
+};
+
+// Has to match GPUScene::LodShift, the level of detail is kept above it
+#define LodShift 28u
+
+// Has to match VertexPacking::UnpackOctahedral
+vec3 DecodeOctahedral(vec2 Encoded)
+{
+    vec3 Direction = vec3(Encoded, 1.0f - abs(Encoded.x) - abs(Encoded.y));
+    float Fold = max(-Direction.z, 0.0f);
+    Direction.x += Direction.x >= 0.0f ? -Fold : Fold;
+    Direction.y += Direction.y >= 0.0f ? -Fold : Fold;
+    return normalize(Direction);
+}
+
+void main()
+{
+    uint Entry = DirectInstance != 0u ? uint(gl_InstanceIndex) : VisibleInstances[FirstVisible + uint(gl_InstanceIndex)];
+    InstanceData Instance = Instances[Entry & ((1u << LodShift) - 1u)];
+    DrawGroupData Group = DrawGroups[Instance.DrawGroup + (Entry >> LodShift)];
+
+    mat4 MV = View * Instance.Model;
+    vec3 LocalPosition = Position.xyz * Group.PositionScale.xyz + Group.PositionBias.xyz;
+
+    gl_Position = ViewProjection * Instance.Model * vec4(LocalPosition, 1.0f);
+    fTexCoord = TexCoord;
+    fNormal = mat3(transpose(inverse(MV))) * DecodeOctahedral(Normal);
+    fColor = Instance.Color.rgb;
+    fAlbedoIdx = Group.AlbedoIdx;
+    fSamplerIdx = Group.SamplerIdx;
+}
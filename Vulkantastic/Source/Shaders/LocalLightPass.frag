@@ -0,0 +1,81 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+#define SpotLight 1u
+
+layout(location=0) out vec4 Color;
+
+layout(location=1) in vec2 fTexCoord;
+
+layout(binding=0) uniform sampler2D ColorTex;
+layout(binding=1) uniform sampler2D NormalTex;
+layout(binding=2) uniform sampler2D DepthTex;
+
+// One light drawn over the whole screen and added to the scene, in view space
+layout(push_constant) uniform LocalLightInfo
+{
+	layout(offset = 0) mat4 InverseProjection; // From the base pass' normalized device coordinates to view space
+    vec3 Position;
+    float Radius;
+    vec3 LightColor;
+    uint Type;
+    vec3 Direction;
+    float CosOuterCone;
+    float CosInnerCone;
+};
+
+// Has to match EncodeOctahedral in the base pass shaders
+vec3 DecodeOctahedral(vec2 Encoded)
+{
+    vec3 Direction = vec3(Encoded, 1.0f - abs(Encoded.x) - abs(Encoded.y));
+    float Fold = max(-Direction.z, 0.0f);
+    Direction.x += Direction.x >= 0.0f ? -Fold : Fold;
+    Direction.y += Direction.y >= 0.0f ? -Fold : Fold;
+    return normalize(Direction);
+}
+
+vec3 ReconstructPosition(vec2 TexCoord, float Depth)
+{
+    vec4 Position = InverseProjection * vec4(TexCoord * 2.0f - 1.0f, Depth, 1.0f);
+    return Position.xyz / Position.w;
+}
+
+// Has to match EvaluateLight in TiledLightPass.frag
+vec3 EvaluateLight(vec3 LocalPosition, vec3 Normal, vec3 Albedo)
+{
+    vec3 ToLight = Position - LocalPosition;
+    float Distance = length(ToLight);
+
+    if (Distance >= Radius) { return vec3(0.0f); }
+
+    vec3 LightDirection = ToLight / Distance;
+    float Attenuation = 1.0f - Distance / Radius;
+    Attenuation *= Attenuation;
+
+    if (Type == SpotLight)
+    {
+        Attenuation *= smoothstep(CosOuterCone, CosInnerCone, dot(-LightDirection, Direction));
+    }
+
+    return Albedo * LightColor * max(dot(LightDirection, Normal), 0.0f) * Attenuation;
+}
+
+void main()
+{
+    float Depth = texture(DepthTex,fTexCoord).r;
+
+    // Nothing was drawn by the base pass
+    if (Depth >= 1.0f)
+    {
+        Color = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        return;
+    }
+
+    vec3 LocalColor = texture(ColorTex,fTexCoord).rgb;
+    vec3 LocalNormal = DecodeOctahedral(texture(NormalTex,fTexCoord).rg * 2.0f - 1.0f);
+    vec3 LocalPosition = ReconstructPosition(fTexCoord, Depth);
+
+    LocalNormal = faceforward(LocalNormal, LocalPosition, LocalNormal);
+
+    Color = vec4(EvaluateLight(LocalPosition, LocalNormal, LocalColor), 1.0f);
+}
\ No newline at end of file
@@ -6,11 +6,9 @@
 
 layout(location=0) out vec4 Color;
 layout(location=1) out vec4 Normal;
-layout(location=2) out vec4 Position;
 
 layout(location=0) in vec2 fTexCoord;
 layout(location=1) in vec3 fNormal;
-layout(location=2) in vec4 fPosition;
 
 layout(set = 0, binding = 0) uniform sampler SamplersArray[MaxSamplers];
 layout(set = 0, binding = 1) uniform texture2D ImagesArray[MaxImages];
@@ -26,11 +24,24 @@ layout(set = 1, binding = 1) uniform UBO2 {
     vec3 CustomColor2;
 };
 
+// Has to match DecodeOctahedral in DirectionalLightPass.frag
+vec2 EncodeOctahedral(vec3 Direction)
+{
+    Direction /= abs(Direction.x) + abs(Direction.y) + abs(Direction.z);
+    vec2 Encoded = Direction.xy;
+
+    if (Direction.z < 0.0f)
+    {
+        Encoded = (1.0f - abs(Direction.yx)) * vec2(Direction.x >= 0.0f ? 1.0f : -1.0f, Direction.y >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    return Encoded;
+}
+
 void main()
 {
     vec4 TexColor = texture(sampler2D(ImagesArray[AlbedoIdx], SamplersArray[RepeatIdx]), fTexCoord);
 
     Color = vec4(CustomColor2, 1.0f) * TexColor;
-    Normal = vec4(fNormal,1.0f);
-    Position = fPosition;
+    Normal = vec4(EncodeOctahedral(normalize(fNormal)) * 0.5f + 0.5f, 0.0f, 1.0f); // Unsigned normalized targets
 }
\ No newline at end of file
@@ -1,28 +1,43 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(location=0) in vec3 Position;
+layout(location=0) in vec4 Position; // Quantized to the submesh's bounds
 layout(location=1) in vec2 TexCoord;
-layout(location=2) in vec3 Normal;
-layout(location=3) in vec3 Tangent;
+layout(location=2) in vec2 Normal; // Octahedral encoded
+layout(location=3) in vec2 Tangent;
 
 layout(location=0) out vec2 fTexCoord;
 layout(location=1) out vec3 fNormal;
-layout(location=2) out vec4 fPosition;
 
 out gl_PerVertex {
     vec4 gl_Position;
 };
 
+// Has to match the depth of DepthPrePass.vert for the equal depth test after the pre-pass
+invariant gl_Position;
+
 layout(set = 1, binding = 0) uniform UBO {
     mat4 MVP2;
 	mat4 MV2;
+	vec4 PositionScale;
+	vec4 PositionBias;
 };
 
+// Has to match VertexPacking::UnpackOctahedral
+vec3 DecodeOctahedral(vec2 Encoded)
+{
+    vec3 Direction = vec3(Encoded, 1.0f - abs(Encoded.x) - abs(Encoded.y));
+    float Fold = max(-Direction.z, 0.0f);
+    Direction.x += Direction.x >= 0.0f ? -Fold : Fold;
+    Direction.y += Direction.y >= 0.0f ? -Fold : Fold;
+    return normalize(Direction);
+}
+
 void main()
 {
-	gl_Position  = MVP2 * vec4(Position, 1.0f);
+	vec3 LocalPosition = Position.xyz * PositionScale.xyz + PositionBias.xyz;
+
+	gl_Position  = MVP2 * vec4(LocalPosition, 1.0f);
 	fTexCoord = TexCoord;
-	fNormal = mat3(transpose(inverse(MV2))) * Normal;
-	fPosition = MV2 * vec4(Position, 1.0f);
+	fNormal = mat3(transpose(inverse(MV2))) * DecodeOctahedral(Normal);
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+#define MaxImages 1024
+#define MaxSamplers 2
+
+layout(location=0) out vec4 Color;
+layout(location=1) out vec4 Normal;
+
+layout(location=0) in vec2 fTexCoord;
+layout(location=1) in vec3 fNormal;
+layout(location=3) flat in int fObjectIdx;
+
+layout(set = 0, binding = 0) uniform sampler SamplersArray[MaxSamplers];
+layout(set = 0, binding = 1) uniform texture2D ImagesArray[MaxImages];
+
+struct ObjectData
+{
+    mat4 MVP2;
+    mat4 MV2;
+    vec3 CustomColor2;
+    int WrapIdx;
+    int RepeatIdx;
+    int AlbedoIdx;
+    vec4 PositionScale;
+    vec4 PositionBias;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer ObjectBuffer {
+    ObjectData Objects[];
+};
+
+// Has to match DecodeOctahedral in DirectionalLightPass.frag
+vec2 EncodeOctahedral(vec3 Direction)
+{
+    Direction /= abs(Direction.x) + abs(Direction.y) + abs(Direction.z);
+    vec2 Encoded = Direction.xy;
+
+    if (Direction.z < 0.0f)
+    {
+        Encoded = (1.0f - abs(Direction.yx)) * vec2(Direction.x >= 0.0f ? 1.0f : -1.0f, Direction.y >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    return Encoded;
+}
+
+void main()
+{
+    ObjectData Object = Objects[fObjectIdx];
+
+    vec4 TexColor = texture(sampler2D(ImagesArray[Object.AlbedoIdx], SamplersArray[Object.RepeatIdx]), fTexCoord);
+
+    Color = vec4(Object.CustomColor2, 1.0f) * TexColor;
+    Normal = vec4(EncodeOctahedral(normalize(fNormal)) * 0.5f + 0.5f, 0.0f, 1.0f); // Unsigned normalized targets
+}
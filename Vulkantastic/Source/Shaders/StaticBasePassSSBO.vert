@@ -0,0 +1,56 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location=0) in vec4 Position; // Quantized to the submesh's bounds
+layout(location=1) in vec2 TexCoord;
+layout(location=2) in vec2 Normal; // Octahedral encoded
+layout(location=3) in vec2 Tangent;
+
+layout(location=0) out vec2 fTexCoord;
+layout(location=1) out vec3 fNormal;
+layout(location=3) flat out int fObjectIdx;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+// Has to match the depth of DepthPrePass.vert for the equal depth test after the pre-pass
+invariant gl_Position;
+
+struct ObjectData
+{
+    mat4 MVP2;
+    mat4 MV2;
+    vec3 CustomColor2;
+    int WrapIdx;
+    int RepeatIdx;
+    int AlbedoIdx;
+    vec4 PositionScale;
+    vec4 PositionBias;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer ObjectBuffer {
+    ObjectData Objects[];
+};
+
+// Has to match VertexPacking::UnpackOctahedral
+vec3 DecodeOctahedral(vec2 Encoded)
+{
+    vec3 Direction = vec3(Encoded, 1.0f - abs(Encoded.x) - abs(Encoded.y));
+    float Fold = max(-Direction.z, 0.0f);
+    Direction.x += Direction.x >= 0.0f ? -Fold : Fold;
+    Direction.y += Direction.y >= 0.0f ? -Fold : Fold;
+    return normalize(Direction);
+}
+
+void main()
+{
+	ObjectData Object = Objects[gl_InstanceIndex];
+
+	vec3 LocalPosition = Position.xyz * Object.PositionScale.xyz + Object.PositionBias.xyz;
+
+	gl_Position  = Object.MVP2 * vec4(LocalPosition, 1.0f);
+	fTexCoord = TexCoord;
+	fNormal = mat3(transpose(inverse(Object.MV2))) * DecodeOctahedral(Normal);
+	fObjectIdx = gl_InstanceIndex;
+}
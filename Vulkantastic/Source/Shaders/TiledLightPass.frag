@@ -0,0 +1,116 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Has to match TiledLighting::TileSize and TiledLighting::MaxLightsPerTile
+#define TileSize 16
+#define MaxLightsPerTile 255
+
+#define SpotLight 1u
+
+layout(location=0) out vec4 Color;
+
+layout(location=1) in vec2 fTexCoord;
+
+// In view space
+struct LightData
+{
+    vec3 Position;
+    float Radius;
+    vec3 Color;
+    uint Type;
+    vec3 Direction;
+    float CosOuterCone;
+    float CosInnerCone;
+    uint Padding0;
+    uint Padding1;
+    uint Padding2;
+};
+
+layout(set = 0, binding = 0) uniform sampler2D ColorTex;
+layout(set = 0, binding = 1) uniform sampler2D NormalTex;
+layout(set = 0, binding = 2) uniform sampler2D DepthTex;
+
+layout(std430, set = 0, binding = 3) readonly buffer LightBuffer {
+    LightData Lights[];
+};
+
+// Filled by LightCulling.comp
+layout(std430, set = 0, binding = 4) readonly buffer TileBuffer {
+    uint TileLights[];
+};
+
+layout(push_constant) uniform TiledLightInfo
+{
+	layout(offset = 0) vec3 Direction;
+    vec3 LightColor;
+    mat4 InverseProjection; // From the base pass' normalized device coordinates to view space
+    uint TilesX;
+};
+
+// Has to match EncodeOctahedral in the base pass shaders
+vec3 DecodeOctahedral(vec2 Encoded)
+{
+    vec3 Direction = vec3(Encoded, 1.0f - abs(Encoded.x) - abs(Encoded.y));
+    float Fold = max(-Direction.z, 0.0f);
+    Direction.x += Direction.x >= 0.0f ? -Fold : Fold;
+    Direction.y += Direction.y >= 0.0f ? -Fold : Fold;
+    return normalize(Direction);
+}
+
+vec3 ReconstructPosition(vec2 TexCoord, float Depth)
+{
+    vec4 Position = InverseProjection * vec4(TexCoord * 2.0f - 1.0f, Depth, 1.0f);
+    return Position.xyz / Position.w;
+}
+
+// Has to match EvaluateLight in LocalLightPass.frag
+vec3 EvaluateLight(LightData Light, vec3 Position, vec3 Normal, vec3 Albedo)
+{
+    vec3 ToLight = Light.Position - Position;
+    float Distance = length(ToLight);
+
+    if (Distance >= Light.Radius) { return vec3(0.0f); }
+
+    vec3 LightDirection = ToLight / Distance;
+    float Attenuation = 1.0f - Distance / Light.Radius;
+    Attenuation *= Attenuation;
+
+    if (Light.Type == SpotLight)
+    {
+        Attenuation *= smoothstep(Light.CosOuterCone, Light.CosInnerCone, dot(-LightDirection, Light.Direction));
+    }
+
+    return Albedo * Light.Color * max(dot(LightDirection, Normal), 0.0f) * Attenuation;
+}
+
+void main()
+{
+    float Depth = texture(DepthTex,fTexCoord).r;
+
+    // Nothing was drawn by the base pass
+    if (Depth >= 1.0f)
+    {
+        Color = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        return;
+    }
+
+    vec3 LocalColor = texture(ColorTex,fTexCoord).rgb;
+    vec3 LocalNormal = DecodeOctahedral(texture(NormalTex,fTexCoord).rg * 2.0f - 1.0f);
+    vec3 LocalPosition = ReconstructPosition(fTexCoord, Depth);
+
+    // Normals of surfaces facing away from the camera are flipped towards it
+    LocalNormal = faceforward(LocalNormal, LocalPosition, LocalNormal);
+
+    vec3 Result = LocalColor * LightColor * max(dot(-Direction, LocalNormal), 0.0f);
+
+    uvec2 Tile = uvec2(gl_FragCoord.xy) / uint(TileSize);
+    uint TileOffset = (Tile.y * TilesX + Tile.x) * (uint(MaxLightsPerTile) + 1u);
+    uint Count = TileLights[TileOffset];
+
+    for (uint i = 0u; i < Count; ++i)
+    {
+        Result += EvaluateLight(Lights[TileLights[TileOffset + 1u + i]], LocalPosition, LocalNormal, LocalColor);
+    }
+
+    Color = vec4(Result, 1.0f);
+}
\ No newline at end of file
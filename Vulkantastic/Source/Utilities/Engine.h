@@ -19,9 +19,9 @@
 #include "../Renderer/sampler.h"
 #include "../Renderer/pipeline.h"
 #include "../Renderer/framebuffer.h"
-#include "../Renderer/uniform_buffer.h"
 #include "../Renderer/uniform_raw_data.h"
 #include "../Renderer/synchronization.h"
+#include "../RendererFE/geometry_pool.h"
 #include "../RendererFE/static_mesh.h"
 #include "../Renderer/pipeline_manager.h"
 #include "../RendererFE/deferred_renderer.h"
@@ -43,6 +43,7 @@ namespace Engine
 #endif
 		Assert(MemoryManager::Get().Startup());
 		Assert(ShaderManager::Get().Startup());
+		Assert(GeometryPoolManager::Get().Startup());
 		Assert(StaticMeshManager::Get().Startup());
 		Assert(PipelineManager::Get().Startup());
 		Assert(TextureManager::Get().Startup());
@@ -57,6 +58,7 @@ namespace Engine
 		Assert(TextureManager::Get().Shutdown());
 		Assert(PipelineManager::Get().Shutdown());
 		Assert(StaticMeshManager::Get().Shutdown());
+		Assert(GeometryPoolManager::Get().Shutdown());
 		Assert(ShaderManager::Get().Shutdown());
 		Assert(MemoryManager::Get().Shutdown());
 		Assert(VulkanCore::Get().Shutdown());
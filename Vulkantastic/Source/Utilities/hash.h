@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+
+namespace Hash
+{
+	constexpr uint64_t Seed = 14695981039346656037ull;
+
+	// FNV-1a, data hashed in parts gives the same result as hashed at once when the previous result is passed as the seed
+	inline uint64_t Bytes(const void* Data, size_t Size, uint64_t Seed = Hash::Seed)
+	{
+		const uint8_t* Input = static_cast<const uint8_t*>(Data);
+		uint64_t Result = Seed;
+
+		for (size_t i = 0; i < Size; ++i)
+		{
+			Result ^= Input[i];
+			Result *= 1099511628211ull;
+		}
+
+		return Result;
+	}
+}
@@ -1,11 +1,572 @@
 #include "Utilities/Engine.h"
 #include <array>
 #include "RendererFE/dds_image.h"
+#include <cstdio>
+#include <chrono>
+#include <random>
+#include "RendererFE/frustum_culling.h"
+#include "RendererFE/software_occlusion.h"
+#include "RendererFE/draw_packet.h"
+#include "RendererFE/mesh_cooker.h"
+
+// Culls 1M random spheres with every path supported by the CPU, doesn't need Vulkan
+void RunCullingBenchmark()
+{
+	const uint32_t ObjectsCount = 1000000;
+	const int32_t Iterations = 20;
+
+	std::mt19937 Generator(1234);
+	std::uniform_real_distribution<float> PositionDist(-150.0f, 150.0f);
+	std::uniform_real_distribution<float> RadiusDist(0.1f, 5.0f);
+
+	SphereBoundsList Spheres;
+	Spheres.Reserve(ObjectsCount);
+
+	for (uint32_t i = 0; i < ObjectsCount; ++i)
+	{
+		BoundingSphere Sphere;
+		Sphere.Center = { PositionDist(Generator), PositionDist(Generator), PositionDist(Generator) };
+		Sphere.Radius = RadiusDist(Generator);
+
+		Spheres.Add(Sphere);
+	}
+
+	const glm::mat4 Projection = glm::perspective(3.14f / 4.0f, 16.0f / 9.0f, 1.0f, 100.0f);
+	const glm::mat4 Correction = glm::mat4(glm::vec4(1, 0, 0, 0), glm::vec4(0, -1, 0, 0), glm::vec4(0, 0, 1.0f / 2.0f, 1.0f / 2.0f), glm::vec4(0, 0, 0, 1));
+	const glm::mat4 Camera = glm::lookAt(glm::vec3(0, 0, 0), glm::vec3(1, 0, 1), glm::vec3(0, 1, 0));
+	const Frustum ViewFrustum(Correction * Projection * Camera);
+
+	const char* PathNames[] = { "scalar", "SSE", "AVX2" };
+	const CullingPath SupportedPath = FrustumCulling::GetSupportedPath();
+
+	std::vector<uint8_t> Reference;
+	std::vector<uint8_t> Visible;
+	Spheres.Cull(ViewFrustum, Reference, CullingPath::SCALAR);
+
+	for (uint8_t Path = 0; Path <= static_cast<uint8_t>(SupportedPath); ++Path)
+	{
+		uint32_t VisibleCount = 0;
+
+		const auto Start = std::chrono::high_resolution_clock::now();
+
+		for (int32_t i = 0; i < Iterations; ++i)
+		{
+			VisibleCount = Spheres.Cull(ViewFrustum, Visible, static_cast<CullingPath>(Path));
+		}
+
+		const auto End = std::chrono::high_resolution_clock::now();
+		const float Time = std::chrono::duration<float, std::milli>(End - Start).count() / Iterations;
+
+		char Message[256];
+		snprintf(Message, sizeof(Message), "Culling %u spheres (%s): %.3f ms, visible: %u, matches scalar: %s\n", ObjectsCount, PathNames[Path], Time, VisibleCount, Visible == Reference ? "yes" : "no");
+		OutputDebugString(Message);
+	}
+}
+
+// Rasterizes walls of boxes into the software occlusion buffer with every path and tests 100k random spheres against it, doesn't need Vulkan
+// Tiled result is compared with the reference rasterization and hidden spheres with the exact test of every pixel on the reference depth
+void RunSoftwareOcclusionBenchmark()
+{
+	const uint32_t SpheresCount = 100000;
+	const int32_t Iterations = 20;
+
+	const std::vector<glm::vec3> BoxPositions = { { -1, -1, -1 }, { 1, -1, -1 }, { 1, 1, -1 }, { -1, 1, -1 }, { -1, -1, 1 }, { 1, -1, 1 }, { 1, 1, 1 }, { -1, 1, 1 } };
+	const std::vector<uint32_t> BoxIndices = { 0, 1, 2, 0, 2, 3, 4, 6, 5, 4, 7, 6, 0, 4, 5, 0, 5, 1, 3, 2, 6, 3, 6, 7, 0, 3, 7, 0, 7, 4, 1, 5, 6, 1, 6, 2 };
+
+	std::mt19937 Generator(1234);
+	std::uniform_real_distribution<float> PositionDist(5.0f, 95.0f);
+	std::uniform_real_distribution<float> HeightDist(-10.0f, 10.0f);
+	std::uniform_real_distribution<float> RadiusDist(0.1f, 2.0f);
+
+	const glm::mat4 Projection = glm::perspective(3.14f / 4.0f, 16.0f / 9.0f, 1.0f, 100.0f);
+	const glm::mat4 Correction = glm::mat4(glm::vec4(1, 0, 0, 0), glm::vec4(0, -1, 0, 0), glm::vec4(0, 0, 1.0f / 2.0f, 1.0f / 2.0f), glm::vec4(0, 0, 0, 1));
+	const glm::mat4 Camera = glm::lookAt(glm::vec3(0, 0, 0), glm::vec3(1, 0, 1), glm::vec3(0, 1, 0));
+	const glm::mat4 ViewProjection = Correction * Projection * Camera;
+
+	SoftwareOcclusionBuffer Occlusion;
+	Occlusion.Begin(ViewProjection);
+
+	// Walls across the view with gaps between them
+	for (int32_t i = 0; i < 16; ++i)
+	{
+		const glm::vec3 Position = { 10.0f + (i % 4) * 12.0f, (i / 4) * 3.0f - 4.0f, 30.0f - (i % 4) * 12.0f };
+		const glm::mat4 Transform = glm::scale(glm::translate(glm::mat4(1.0f), Position), glm::vec3(4.0f, 1.2f, 4.0f));
+
+		Occlusion.AddOccluder(BoxPositions, BoxIndices, Transform);
+	}
+
+	SphereBoundsList Spheres;
+	Spheres.Reserve(SpheresCount);
+
+	for (uint32_t i = 0; i < SpheresCount; ++i)
+	{
+		BoundingSphere Sphere;
+		Sphere.Center = { PositionDist(Generator), HeightDist(Generator), PositionDist(Generator) };
+		Sphere.Radius = RadiusDist(Generator);
+
+		Spheres.Add(Sphere);
+	}
+
+	std::vector<uint8_t> FrustumVisible;
+	const uint32_t FrustumVisibleCount = Spheres.Cull(Frustum(ViewProjection), FrustumVisible, FrustumCulling::GetSupportedPath());
+
+	Occlusion.RasterizeReference();
+	const std::vector<float> ReferenceDepth = Occlusion.GetDepth();
+
+	std::vector<uint8_t> ReferenceHidden(SpheresCount, 0);
+	uint32_t ReferenceHiddenCount = 0;
+
+	for (uint32_t i = 0; i < SpheresCount; ++i)
+	{
+		ReferenceHidden[i] = FrustumVisible[i] && Occlusion.IsOccluded({ Spheres.GetCenter(i), Spheres.GetRadius(i) }, true);
+		ReferenceHiddenCount += ReferenceHidden[i];
+	}
+
+	const char* PathNames[] = { "scalar", "SSE", "AVX2" };
+	const CullingPath SupportedPath = FrustumCulling::GetSupportedPath();
+	const uint32_t ThreadsCounts[] = { 1, 0 };
+
+	char Message[256];
+
+	for (uint8_t Path = 0; Path <= static_cast<uint8_t>(SupportedPath); ++Path)
+	{
+		for (uint32_t ThreadsCount : ThreadsCounts)
+		{
+			const auto Start = std::chrono::high_resolution_clock::now();
+
+			for (int32_t i = 0; i < Iterations; ++i)
+			{
+				Occlusion.Rasterize(static_cast<CullingPath>(Path), ThreadsCount);
+			}
+
+			const auto End = std::chrono::high_resolution_clock::now();
+			const float Time = std::chrono::duration<float, std::milli>(End - Start).count() / Iterations;
+
+			uint32_t MismatchedPixels = 0;
+
+			for (size_t i = 0; i < ReferenceDepth.size(); ++i)
+			{
+				MismatchedPixels += Occlusion.GetDepth()[i] != ReferenceDepth[i];
+			}
+
+			snprintf(Message, sizeof(Message), "Rasterizing %u triangles into %ux%u (%s, %s): %.3f ms, pixels different from reference: %u\n", Occlusion.GetTrianglesCount(), Occlusion.GetWidth(), Occlusion.GetHeight(),
+				PathNames[Path], ThreadsCount == 1 ? "1 thread" : "all threads", Time, MismatchedPixels);
+			OutputDebugString(Message);
+		}
+	}
+
+	std::vector<uint8_t> Visible;
+	uint32_t HiddenCount = 0;
+
+	const auto Start = std::chrono::high_resolution_clock::now();
+
+	for (int32_t i = 0; i < Iterations; ++i)
+	{
+		Visible = FrustumVisible;
+		HiddenCount = Occlusion.Cull(Spheres, Visible);
+	}
+
+	const auto End = std::chrono::high_resolution_clock::now();
+	const float Time = std::chrono::duration<float, std::milli>(End - Start).count() / Iterations;
+
+	// Block tests may keep more spheres visible, hiding a sphere the exact test keeps visible would be an error
+	uint32_t WronglyHidden = 0;
+	uint32_t Missed = 0;
+
+	for (uint32_t i = 0; i < SpheresCount; ++i)
+	{
+		const bool Hidden = FrustumVisible[i] && !Visible[i];
+
+		WronglyHidden += Hidden && !ReferenceHidden[i];
+		Missed += !Hidden && ReferenceHidden[i];
+	}
+
+	snprintf(Message, sizeof(Message), "Testing %u spheres in the frustum: %.3f ms, hidden: %u, hidden by exact test: %u, wrongly hidden: %u, missed: %u\n", FrustumVisibleCount, Time, HiddenCount, ReferenceHiddenCount, WronglyHidden, Missed);
+	OutputDebugString(Message);
+}
+
+// Compares partitioning of 100k draws into a map keyed by pipeline names with the radix sort of draw packets, doesn't need Vulkan
+void RunDrawSortBenchmark()
+{
+	const uint32_t PacketsCount = 100000;
+	const int32_t Iterations = 20;
+
+	const std::vector<std::string> PipelineKeys = { "StaticBasePass.vertStaticBasePass.frag", "StaticBasePassSSBO.vertStaticBasePassSSBO.frag", 
+		"GPUDrivenBasePass.vertGPUDrivenBasePass.frag", "DirectionalLightPass.vertDirectionalLightPass.frag" };
+
+	std::mt19937 Generator(1234);
+	std::uniform_int_distribution<uint32_t> PipelineDist(0, static_cast<uint32_t>(PipelineKeys.size()) - 1);
+	std::uniform_int_distribution<uint32_t> IdDist(0, 63);
+	std::uniform_real_distribution<float> DepthDist(0.0f, 1.0f);
+
+	std::vector<DrawPacket> Packets(PacketsCount);
+
+	for (uint32_t i = 0; i < PacketsCount; ++i)
+	{
+		Packets[i].SortKey = DrawKey::Make(PipelineDist(Generator), IdDist(Generator), IdDist(Generator), IdDist(Generator) % 4, IdDist(Generator) % 4, DepthDist(Generator));
+		Packets[i].RenderableIdx = i;
+	}
+
+	float MapTime = 0.0f;
+	float SortTime = 0.0f;
+
+	for (int32_t i = 0; i < Iterations; ++i)
+	{
+		const auto MapStart = std::chrono::high_resolution_clock::now();
+
+		std::map<std::string, std::vector<DrawPacket>> Partitioned;
+
+		for (const DrawPacket& Packet : Packets)
+		{
+			const std::string Key = PipelineKeys[DrawKey::GetPipeline(Packet.SortKey)];
+			Partitioned[Key].push_back(Packet);
+		}
+
+		const auto MapEnd = std::chrono::high_resolution_clock::now();
+
+		std::vector<DrawPacket> Sorted = Packets;
+		std::vector<DrawPacket> Scratch;
+
+		const auto SortStart = std::chrono::high_resolution_clock::now();
+
+		SortDrawPackets(Sorted, Scratch);
+
+		const auto SortEnd = std::chrono::high_resolution_clock::now();
+
+		MapTime += std::chrono::duration<float, std::milli>(MapEnd - MapStart).count() / Iterations;
+		SortTime += std::chrono::duration<float, std::milli>(SortEnd - SortStart).count() / Iterations;
+	}
+
+	char Message[256];
+	snprintf(Message, sizeof(Message), "Partitioning %u draws: std::map %.3f ms, radix sort %.3f ms\n", PacketsCount, MapTime, SortTime);
+	OutputDebugString(Message);
+}
+
+// Sets 100k members of a uniform block by their names and through handles resolved once, doesn't need Vulkan
+void RunUniformSetterBenchmark()
+{
+	const uint32_t SetsCount = 100000;
+	const int32_t Iterations = 20;
+
+	// Same members as the transform block of the base pass
+	Uniform Block;
+	Block.Format = VariableType::STRUCTURE;
+	Block.Name = "Transform";
+
+	const char* MemberNames[] = { "MVP2", "MV2", "PositionScale", "PositionBias" };
+	const VariableType MemberFormats[] = { VariableType::MAT4x4, VariableType::MAT4x4, VariableType::FLOAT4, VariableType::FLOAT4 };
+	uint32_t Offset = 0;
+
+	for (int32_t i = 0; i < 4; ++i)
+	{
+		UniformMember Member;
+		Member.Name = MemberNames[i];
+		Member.Format = MemberFormats[i];
+		Member.Offset = Offset;
+
+		Block.Members.push_back(Member);
+		Offset += ShaderReflection::GetSizeForFormat(Member.Format);
+	}
+
+	UniformRawData Data(Block);
+
+	const UniformHandle MVPHandle = Data.GetHandle("MVP2");
+	const UniformHandle ScaleHandle = Data.GetHandle("PositionScale");
+
+	float NameTime = 0.0f;
+	float HandleTime = 0.0f;
+	uint32_t Written = 0;
+
+	for (int32_t i = 0; i < Iterations; ++i)
+	{
+		const auto NameStart = std::chrono::high_resolution_clock::now();
+
+		// Values change on every call, so every set writes the data
+		for (uint32_t Idx = 0; Idx < SetsCount; Idx += 2)
+		{
+			Written += Data.Set("MVP2", glm::mat4(static_cast<float>(Idx)));
+			Written += Data.Set("PositionScale", glm::vec4(static_cast<float>(Idx)));
+		}
+
+		const auto HandleStart = std::chrono::high_resolution_clock::now();
+
+		for (uint32_t Idx = 0; Idx < SetsCount; Idx += 2)
+		{
+			Written += Data.Set(MVPHandle, glm::mat4(static_cast<float>(Idx)));
+			Written += Data.Set(ScaleHandle, glm::vec4(static_cast<float>(Idx)));
+		}
+
+		const auto HandleEnd = std::chrono::high_resolution_clock::now();
+
+		NameTime += std::chrono::duration<float, std::milli>(HandleStart - NameStart).count() / Iterations;
+		HandleTime += std::chrono::duration<float, std::milli>(HandleEnd - HandleStart).count() / Iterations;
+	}
+
+	Assert(Written == SetsCount * 2 * Iterations);
+
+	char Message[256];
+	snprintf(Message, sizeof(Message), "Setting %u uniform members: by name %.3f ms, by handle %.3f ms\n", SetsCount, NameTime, HandleTime);
+	OutputDebugString(Message);
+}
+
+// Cooks every .obj from Source/Meshes into Meshes/*.sm and reports the vertex cache efficiency, doesn't need Vulkan
+void RunMeshCooker(bool OverdrawSort)
+{
+	const std::string SourceDirectory = File::Get().CurrentDirectory() + "/Source/Meshes/";
+	const std::string DestinationDirectory = File::Get().CurrentDirectory() + "/Meshes/";
+
+	std::vector<std::string> Files;
+	File::Get().GetFiles(Files, SourceDirectory);
+
+	MeshCookerSettings Settings;
+	Settings.OptimizeOverdraw = OverdrawSort;
+
+	MeshCooker Cooker(Settings);
+
+	for (const std::string& FileName : Files)
+	{
+		const size_t Extension = FileName.rfind(".obj");
+		if (Extension == std::string::npos || Extension + 4 != FileName.size()) { continue; }
+
+		const std::string Name = FileName.substr(0, Extension);
+		char Message[256];
+
+		if (!Cooker.Cook(SourceDirectory + FileName, DestinationDirectory + Name + ".sm"))
+		{
+			snprintf(Message, sizeof(Message), "Cooking %s failed\n", FileName.c_str());
+			OutputDebugString(Message);
+			continue;
+		}
+
+		const std::vector<CookedSubmeshReport>& Reports = Cooker.GetReports();
+
+		for (size_t i = 0; i < Reports.size(); ++i)
+		{
+			const CookedSubmeshReport& Report = Reports[i];
+
+			snprintf(Message, sizeof(Message), "%s[%zu]: %u triangles, %u -> %u vertices, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", Name.c_str(), i, Report.TrianglesCount,
+				Report.CornersCount, Report.VerticesCount, Report.Before.ACMR, Report.After.ACMR, Report.Before.ATVR, Report.After.ATVR);
+			OutputDebugString(Message);
+
+			for (size_t Lod = 1; Lod < Report.LodTrianglesCount.size(); ++Lod)
+			{
+				snprintf(Message, sizeof(Message), "%s[%zu] LOD %zu: %u triangles, relative error %.5f\n", Name.c_str(), i, Lod, Report.LodTrianglesCount[Lod], Report.LodErrors[Lod]);
+				OutputDebugString(Message);
+			}
+		}
+	}
+}
+
+// Writes the base pass' image and sampler arrays through the binding slot table and through a linear search of the write entries by binding
+// Linear search writes every entry on every update, as descriptor sets were written before the slot table, the engine has to be started
+void RunDescriptorSetterBenchmark()
+{
+	const int32_t Iterations = 100;
+	const uint32_t SetIdx = 0; // Samplers and images arrays
+
+	Shader* VertexShader = ShaderManager::Get().Find("StaticBasePass.vert");
+	Shader* FragmentShader = ShaderManager::Get().Find("StaticBasePass.frag");
+
+	Assert(VertexShader && FragmentShader);
+
+	IGraphicsPipeline* Pipeline = PipelineManager::Get().GetGraphicsPipeline<VertexDefinition::StaticMesh>(*DeferredRenderer::Get().GetBasePassRenderPass(), { VertexShader, FragmentShader });
+	DescriptorManager* Manager = Pipeline->GetDescriptorManager();
+
+	upDescriptorInst SlotInst = Manager->GetDescriptorInstance(SetIdx);
+	upDescriptorInst LinearInst = Manager->GetDescriptorInstance(SetIdx);
+
+	uint32_t ImageBinding = 0;
+	uint32_t ImagesCount = 0;
+	uint32_t SamplerBinding = 0;
+	uint32_t SamplersCount = 0;
+
+	using LinearWrite = std::pair<VkWriteDescriptorSet, std::vector<VkDescriptorImageInfo>>;
+	std::vector<LinearWrite> LinearWrites;
+
+	for (const Uniform& Template : Manager->GetUniforms(SetIdx))
+	{
+		Assert(Template.Format == VariableType::IMAGE || Template.Format == VariableType::SAMPLER);
+
+		if (Template.Format == VariableType::IMAGE)
+		{
+			ImageBinding = Template.Binding;
+			ImagesCount = Template.Size;
+		}
+		else
+		{
+			SamplerBinding = Template.Binding;
+			SamplersCount = Template.Size;
+		}
+
+		LinearWrites.push_back({});
+
+		VkWriteDescriptorSet& Write = LinearWrites.back().first;
+		Write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		Write.dstSet = LinearInst->GetSet();
+		Write.dstBinding = Template.Binding;
+		Write.descriptorType = Template.Format == VariableType::IMAGE ? VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLER;
+		Write.descriptorCount = Template.Size;
+
+		LinearWrites.back().second.resize(Template.Size);
+	}
+
+	for (LinearWrite& Write : LinearWrites)
+	{
+		Write.first.pImageInfo = Write.second.data();
+	}
+
+	auto LinearSet = [&LinearWrites](uint32_t Binding, uint32_t Index, const VkDescriptorImageInfo& Info) {
+		auto It = std::find_if(LinearWrites.begin(), LinearWrites.end(), [Binding](const LinearWrite& Elem) {
+			return Elem.first.dstBinding == Binding;
+		});
+
+		if (It != LinearWrites.end())
+		{
+			Assert(Index < It->second.size());
+			It->second[Index] = Info;
+		}
+	};
+
+	auto LinearUpdate = [&LinearWrites]() {
+		std::vector<VkWriteDescriptorSet> Sets;
+		Sets.reserve(LinearWrites.size());
+
+		for (const LinearWrite& Write : LinearWrites)
+		{
+			Sets.push_back(Write.first);
+		}
+
+		vkUpdateDescriptorSets(VulkanCore::Get().GetDevice()->GetDevice(), static_cast<uint32_t>(Sets.size()), Sets.data(), 0, nullptr);
+	};
+
+	const ImageView* Views[] = { TextureManager::Get().GetImageView("error"), TextureManager::Get().GetImageView("test") };
+	const Sampler* Samplers[] = { TextureManager::Get().GetSampler(RepeatSampler), TextureManager::Get().GetSampler(WrapSampler) };
+
+	// Every image of the array changes between iterations, then only one of them does
+	for (uint32_t ChangedImages : { ImagesCount, 1u })
+	{
+		float SlotTime = 0.0f;
+		float LinearTime = 0.0f;
+
+		for (int32_t i = 0; i < Iterations; ++i)
+		{
+			const ImageView* View = Views[i % 2];
+			const Sampler* ImageSampler = Samplers[i % 2];
+
+			const auto SlotStart = std::chrono::high_resolution_clock::now();
+
+			for (uint32_t Idx = 0; Idx < ChangedImages; ++Idx)
+			{
+				SlotInst->SetImage(ImageBinding, View, Idx);
+			}
+
+			for (uint32_t Idx = 0; Idx < SamplersCount; ++Idx)
+			{
+				SlotInst->SetSampler(SamplerBinding, ImageSampler, Idx);
+			}
+
+			SlotInst->Update();
+
+			const auto LinearStart = std::chrono::high_resolution_clock::now();
+
+			VkDescriptorImageInfo ImageInfo = {};
+			ImageInfo.imageLayout = static_cast<VkImageLayout>(View->GetCurrentImageLayout());
+			ImageInfo.imageView = View->GetView();
+
+			for (uint32_t Idx = 0; Idx < ChangedImages; ++Idx)
+			{
+				LinearSet(ImageBinding, Idx, ImageInfo);
+			}
+
+			VkDescriptorImageInfo SamplerInfo = {};
+			SamplerInfo.sampler = ImageSampler->GetSampler();
+
+			for (uint32_t Idx = 0; Idx < SamplersCount; ++Idx)
+			{
+				LinearSet(SamplerBinding, Idx, SamplerInfo);
+			}
+
+			LinearUpdate();
+
+			const auto LinearEnd = std::chrono::high_resolution_clock::now();
+
+			SlotTime += std::chrono::duration<float, std::milli>(LinearStart - SlotStart).count() / Iterations;
+			LinearTime += std::chrono::duration<float, std::milli>(LinearEnd - LinearStart).count() / Iterations;
+		}
+
+		char Message[256];
+		snprintf(Message, sizeof(Message), "Descriptor setters, %u of %u images changed: slot table %.3f ms, linear search %.3f ms\n", ChangedImages, ImagesCount, SlotTime, LinearTime);
+		OutputDebugString(Message);
+	}
+}
 
 int32_t CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow)
 {
+	// "-culling_benchmark" measures the CPU frustum culling and exits
+	if (strstr(lpCmdLine, "-culling_benchmark") != nullptr)
+	{
+		RunCullingBenchmark();
+		return 0;
+	}
+
+	// "-software_occlusion_benchmark" measures and validates the CPU occlusion culling and exits
+	if (strstr(lpCmdLine, "-software_occlusion_benchmark") != nullptr)
+	{
+		RunSoftwareOcclusionBenchmark();
+		return 0;
+	}
+
+	// "-draw_sort_benchmark" measures sorting of draw packets and exits
+	if (strstr(lpCmdLine, "-draw_sort_benchmark") != nullptr)
+	{
+		RunDrawSortBenchmark();
+		return 0;
+	}
+
+	// "-uniform_setter_benchmark" measures setting members of uniform blocks and exits
+	if (strstr(lpCmdLine, "-uniform_setter_benchmark") != nullptr)
+	{
+		RunUniformSetterBenchmark();
+		return 0;
+	}
+
+	// "-cook_meshes" optimizes and packs meshes from Source/Meshes and exits, "-no_overdraw_sort" keeps the cache optimized order of triangles
+	if (strstr(lpCmdLine, "-cook_meshes") != nullptr)
+	{
+		RunMeshCooker(strstr(lpCmdLine, "-no_overdraw_sort") == nullptr);
+		return 0;
+	}
+
 	Engine::Startup();
 
+	// "-descriptor_setter_benchmark" measures writes of a 1024 entry image array and exits
+	if (strstr(lpCmdLine, "-descriptor_setter_benchmark") != nullptr)
+	{
+		RunDescriptorSetterBenchmark();
+		Engine::Shutdown();
+		return 0;
+	}
+
+	// "-instancing_benchmark" renders 10k copies of test2 and reports draw calls and CPU frame time, "-no_instancing" turns merging of draws off
+	const bool InstancingBenchmark = strstr(lpCmdLine, "-instancing_benchmark") != nullptr;
+
+	if (InstancingBenchmark)
+	{
+		DeferredRenderer::Get().SetObjectBufferEnabled(true);
+		DeferredRenderer::Get().SetInstancingEnabled(strstr(lpCmdLine, "-no_instancing") == nullptr);
+	}
+
+	// "-lod_benchmark" renders 10k copies of the dense mesh and reports triangles submitted with and without levels of detail, switching every 100 frames
+	const bool LodBenchmark = strstr(lpCmdLine, "-lod_benchmark") != nullptr;
+
+	// "-depth_prepass_benchmark" looks along the same 10k copies and reports the measured overdraw and GPU time of the base pass, depth pre-pass switches between disabled, enabled and auto every 100 frames
+	const bool DepthPrePassBenchmark = strstr(lpCmdLine, "-depth_prepass_benchmark") != nullptr;
+
+	if (DepthPrePassBenchmark)
+	{
+		DeferredRenderer::Get().SetDepthPrePassMode(DepthPrePassMode::DISABLED);
+	}
+
 	auto Device = VulkanCore::Get().GetDevice()->GetDevice();
 	VkExtent2D Extend = VulkanCore::Get().GetExtend();
 
@@ -31,12 +592,276 @@ int32_t CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpC
 	DataToRender.StaticMeshComponents.push_back(&MeshComp);
 	DataToRender.StaticMeshComponents.push_back(&MeshComp2);
 
+	std::vector<std::unique_ptr<StaticMeshComponent>> BenchmarkComponents;
+
+	// "-meshlet_benchmark" puts 100k copies of the dense mesh into the GPU scene and reports triangles left after culling and triangle throughput, meshlet culling switches every 100 frames
+	const bool MeshletBenchmark = strstr(lpCmdLine, "-meshlet_benchmark") != nullptr;
+
+	// test2 is a cube with a single level of detail and meshlet, the dense mesh is cooked from Source/Meshes/dense.obj with a full chain of levels of detail and meshlets
+	std::unique_ptr<StaticMeshComponent> DenseComp;
+
+	if (LodBenchmark || MeshletBenchmark)
+	{
+		DenseComp = std::make_unique<StaticMeshComponent>("dense");
+		DenseComp->GetMeshHandle()->GetMaterial(0)->SetCustomColor(glm::vec3(1, 1, 1));
+		DenseComp->GetMeshHandle()->GetMaterial(0)->SetAlbedoTexture("test");
+	}
+
+	if (InstancingBenchmark || LodBenchmark || DepthPrePassBenchmark)
+	{
+		const int32_t GridSize = 100;
+
+		for (int32_t i = 0; i < GridSize * GridSize; ++i)
+		{
+			auto Copy = std::make_unique<StaticMeshComponent>(LodBenchmark ? *DenseComp : MeshComp);
+			Copy->SetPosition({ (i % GridSize) * 3.0f, 0.0f, (i / GridSize) * 3.0f });
+
+			DataToRender.StaticMeshComponents.push_back(Copy.get());
+			BenchmarkComponents.push_back(std::move(Copy));
+		}
+
+		DataToRender.CameraPosition = glm::vec3(-10, 20, -10);
+		DataToRender.CameraForward = glm::normalize(glm::vec3(1, -0.5f, 1));
+	}
+
+	if (DepthPrePassBenchmark)
+	{
+		// Low above the grid, so copies behind each other cover the same pixels
+		DataToRender.CameraPosition = glm::vec3(-5, 2, -5);
+		DataToRender.CameraForward = glm::normalize(glm::vec3(1, -0.1f, 1));
+	}
+
+	// "-gpu_driven_stress" puts 100k copies of test2 into the GPU scene, they are culled and drawn without per-instance CPU work
+	// Works on software implementations as well (e.g. lavapipe or SwiftShader selected with VK_ICD_FILENAMES)
+	const bool GPUDrivenStress = strstr(lpCmdLine, "-gpu_driven_stress") != nullptr;
+
+	// "-occlusion_benchmark" adds walls across the same GPU scene and reports instances hidden by them, occlusion culling switches every 100 frames
+	const bool OcclusionBenchmark = strstr(lpCmdLine, "-occlusion_benchmark") != nullptr;
+
+	// "-async_compute_benchmark" renders the occlusion scene and reports GPU times of the passes and how much of the Hi-Z build overlaps the light pass, async compute switches every 100 frames
+	const bool AsyncComputeBenchmark = strstr(lpCmdLine, "-async_compute_benchmark") != nullptr;
+
+	if (GPUDrivenStress || MeshletBenchmark || OcclusionBenchmark || AsyncComputeBenchmark)
+	{
+		GPUScene* Scene = DeferredRenderer::Get().GetGPUScene();
+
+		const int32_t GridWidth = 400;
+		const int32_t GridDepth = 250;
+
+		for (int32_t i = 0; i < GridWidth * GridDepth; ++i)
+		{
+			const glm::vec3 Position = { (i % GridWidth) * 3.0f, 0.0f, (i / GridWidth) * 3.0f };
+
+			Scene->AddObject((MeshletBenchmark ? *DenseComp : MeshComp).GetMeshHandle(), glm::translate(glm::mat4(1.0f), Position));
+		}
+
+		DataToRender.CameraPosition = glm::vec3(-10, 20, -10);
+		DataToRender.CameraForward = glm::normalize(glm::vec3(1, -0.5f, 1));
+	}
+
+	if (OcclusionBenchmark || AsyncComputeBenchmark)
+	{
+		// Walls are drawn in the first phase and hide most of the grid behind them
+		const int32_t WallsCount = 4;
+
+		for (int32_t i = 0; i < WallsCount; ++i)
+		{
+			auto Wall = std::make_unique<StaticMeshComponent>(MeshComp);
+			Wall->SetPosition({ 600.0f, 10.0f, 60.0f + i * 180.0f });
+			Wall->SetScale({ 600.0f, 20.0f, 1.0f });
+
+			DataToRender.StaticMeshComponents.push_back(Wall.get());
+			BenchmarkComponents.push_back(std::move(Wall));
+		}
+
+		DeferredRenderer::Get().SetOcclusionCullingEnabled(true);
+	}
+
+	// "-present_direct" and "-present_blit" replace the screen pass, to compare the cost of the extra copy
+	if (strstr(lpCmdLine, "-present_direct"))
+	{
+		DeferredRenderer::Get().SetPresentMode(PresentMode::DIRECT);
+	}
+	else if (strstr(lpCmdLine, "-present_blit"))
+	{
+		DeferredRenderer::Get().SetPresentMode(PresentMode::BLIT);
+	}
+
+	// "-async_compute" builds the Hi-Z pyramid on the async compute queue, the async compute benchmark starts with it as well
+	if (strstr(lpCmdLine, "-async_compute"))
+	{
+		DeferredRenderer::Get().SetAsyncComputeEnabled(true);
+	}
+
+	// "-light_benchmark" sweeps 1 to 4096 lights around the meshes and reports frame time of tiled lighting and of a full-screen pass per light, 100 frames each
+	const bool LightBenchmark = strstr(lpCmdLine, "-light_benchmark") != nullptr;
+
+	const uint32_t MaxBenchmarkLights = 4096;
+	std::vector<Light> BenchmarkLights;
+
+	if (LightBenchmark)
+	{
+		std::mt19937 Generator(7);
+		std::uniform_real_distribution<float> PositionDist(-3.0f, 3.0f);
+		std::uniform_real_distribution<float> RadiusDist(0.5f, 1.5f);
+		std::uniform_real_distribution<float> ColorDist(0.0f, 0.2f);
+
+		for (uint32_t i = 0; i < MaxBenchmarkLights; ++i)
+		{
+			Light NewLight;
+			NewLight.Type = (i % 2) == 0 ? LightType::POINT : LightType::SPOT;
+			NewLight.Position = { PositionDist(Generator), PositionDist(Generator), PositionDist(Generator) };
+			NewLight.Direction = glm::normalize(-NewLight.Position);
+			NewLight.Radius = RadiusDist(Generator);
+			NewLight.Color = { ColorDist(Generator), ColorDist(Generator), ColorDist(Generator) };
+
+			BenchmarkLights.push_back(NewLight);
+		}
+
+		DataToRender.Lights.assign(BenchmarkLights.begin(), BenchmarkLights.begin() + 1);
+	}
+
+	int32_t FrameIndex = 0;
+	auto BenchmarkStart = std::chrono::high_resolution_clock::now();
+
 	while (!Window::Get().ShouldWindowClose())
 	{
 		Window::Get().Update();
 
 		DeferredRenderer::Get().Render(DataToRender);
 
+		if (InstancingBenchmark && (++FrameIndex % 100) == 0)
+		{
+			const RendererStats& Stats = DeferredRenderer::Get().GetFrameStats();
+
+			char Message[256];
+			snprintf(Message, sizeof(Message), "Draw calls: %u, instances: %u, culled: %u, CPU frame time: %.3f ms\n", Stats.DrawCalls, Stats.InstancesDrawn, Stats.RenderablesCulled, Stats.CPUFrameTime);
+			OutputDebugString(Message);
+
+			const CommandRecorderStats& Commands = Stats.BasePassCommands;
+
+			snprintf(Message, sizeof(Message), "Skipped pipelines: %u, descriptor sets: %u, vertex buffers: %u, index buffers: %u, viewports: %u, push constants: %u\n",
+				Commands.PipelineBindsSkipped, Commands.DescriptorSetBindsSkipped, Commands.VertexBufferBindsSkipped, Commands.IndexBufferBindsSkipped, Commands.ViewportSetsSkipped, Commands.PushConstantsSkipped);
+			OutputDebugString(Message);
+		}
+
+		if (LodBenchmark && (++FrameIndex % 100) == 0)
+		{
+			const RendererStats& Stats = DeferredRenderer::Get().GetFrameStats();
+
+			char Message[256];
+			snprintf(Message, sizeof(Message), "Levels of detail %s: triangles submitted: %llu, draw calls: %u, CPU frame time: %.3f ms\n", DeferredRenderer::Get().IsLodEnabled() ? "on" : "off", 
+				Stats.TrianglesSubmitted, Stats.DrawCalls, Stats.CPUFrameTime);
+			OutputDebugString(Message);
+
+			DeferredRenderer::Get().SetLodEnabled(!DeferredRenderer::Get().IsLodEnabled());
+		}
+
+		if (GPUDrivenStress && (++FrameIndex % 100) == 0)
+		{
+			const RendererStats& Stats = DeferredRenderer::Get().GetFrameStats();
+
+			char Message[256];
+			snprintf(Message, sizeof(Message), "GPU scene instances: %u, indirect draws: %u, uploaded: %llu B, CPU frame time: %.3f ms\n", Stats.GPUSceneInstances, Stats.IndirectDrawCalls, Stats.GPUSceneBytesUploaded, Stats.CPUFrameTime);
+			OutputDebugString(Message);
+		}
+
+		if (MeshletBenchmark && (++FrameIndex % 100) == 0)
+		{
+			const RendererStats& Stats = DeferredRenderer::Get().GetFrameStats();
+			GPUScene* Scene = DeferredRenderer::Get().GetGPUScene();
+
+			const auto BenchmarkEnd = std::chrono::high_resolution_clock::now();
+			const float FrameTime = std::chrono::duration<float, std::milli>(BenchmarkEnd - BenchmarkStart).count() / 100.0f;
+			BenchmarkStart = BenchmarkEnd;
+
+			// Without meshlet culling every triangle of a visible instance is drawn, only the total is known on the CPU
+			const uint64_t TrianglesDrawn = Scene->IsMeshletCullingEnabled() ? Stats.GPUSceneMeshlets.TrianglesVisible : Stats.GPUSceneMeshlets.TrianglesTotal;
+
+			char Message[256];
+			snprintf(Message, sizeof(Message), "Meshlet culling %s: triangles %llu -> %llu, visible meshlets: %u, frame time: %.3f ms, %.1f Mtri/s\n", Scene->IsMeshletCullingEnabled() ? "on" : "off",
+				Stats.GPUSceneMeshlets.TrianglesTotal, TrianglesDrawn, Stats.GPUSceneMeshlets.MeshletsVisible, FrameTime, TrianglesDrawn / (FrameTime * 1000.0f));
+			OutputDebugString(Message);
+
+			Scene->SetMeshletCullingEnabled(!Scene->IsMeshletCullingEnabled() && Scene->IsMeshletCullingSupported());
+		}
+
+		if (OcclusionBenchmark && (++FrameIndex % 100) == 0)
+		{
+			const RendererStats& Stats = DeferredRenderer::Get().GetFrameStats();
+
+			const auto BenchmarkEnd = std::chrono::high_resolution_clock::now();
+			const float FrameTime = std::chrono::duration<float, std::milli>(BenchmarkEnd - BenchmarkStart).count() / 100.0f;
+			BenchmarkStart = BenchmarkEnd;
+
+			char Message[256];
+			snprintf(Message, sizeof(Message), "Occlusion culling %s: instances: %u, occluded: %u, disoccluded: %u, frame time: %.3f ms\n", DeferredRenderer::Get().IsOcclusionCullingEnabled() ? "on" : "off",
+				Stats.GPUSceneInstances, Stats.GPUSceneOcclusion.Occluded, Stats.GPUSceneOcclusion.Disoccluded, FrameTime);
+			OutputDebugString(Message);
+
+			DeferredRenderer::Get().SetOcclusionCullingEnabled(!DeferredRenderer::Get().IsOcclusionCullingEnabled());
+		}
+
+		if (AsyncComputeBenchmark && (++FrameIndex % 100) == 0)
+		{
+			const RendererStats& Stats = DeferredRenderer::Get().GetFrameStats();
+
+			char Message[256];
+			snprintf(Message, sizeof(Message), "Async compute %s: GPU base pass: %.3f ms, light pass: %.3f ms, async compute: %.3f ms, overlapped: %.3f ms\n", DeferredRenderer::Get().IsAsyncComputeEnabled() ? "on" : "off",
+				Stats.GPUBasePassTime, Stats.GPULightPassTime, Stats.GPUAsyncComputeTime, Stats.GPUAsyncComputeOverlap);
+			OutputDebugString(Message);
+
+			DeferredRenderer::Get().SetAsyncComputeEnabled(!DeferredRenderer::Get().IsAsyncComputeEnabled());
+		}
+
+		if (DepthPrePassBenchmark && (++FrameIndex % 100) == 0)
+		{
+			const RendererStats& Stats = DeferredRenderer::Get().GetFrameStats();
+			const DepthPrePassMode Mode = DeferredRenderer::Get().GetDepthPrePassMode();
+			const char* ModeNames[] = { "disabled", "enabled", "auto" };
+
+			char Message[256];
+			snprintf(Message, sizeof(Message), "Depth pre-pass %s (%s): overdraw: %.2f, draw calls: %u + %u, GPU base pass: %.3f ms, CPU frame time: %.3f ms\n", ModeNames[static_cast<uint8_t>(Mode)],
+				Stats.DepthPrePass ? "drawn" : "skipped", Stats.Overdraw, Stats.DepthPrePassDrawCalls, Stats.DrawCalls, Stats.GPUBasePassTime, Stats.CPUFrameTime);
+			OutputDebugString(Message);
+
+			DeferredRenderer::Get().SetDepthPrePassMode(static_cast<DepthPrePassMode>((static_cast<uint8_t>(Mode) + 1) % 3));
+		}
+
+		if (LightBenchmark && (++FrameIndex % 100) == 0)
+		{
+			const RendererStats& Stats = DeferredRenderer::Get().GetFrameStats();
+			const bool Tiled = DeferredRenderer::Get().GetLightingMode() == LightingMode::TILED;
+
+			const auto BenchmarkEnd = std::chrono::high_resolution_clock::now();
+			const float FrameTime = std::chrono::duration<float, std::milli>(BenchmarkEnd - BenchmarkStart).count() / 100.0f;
+			BenchmarkStart = BenchmarkEnd;
+
+			char Message[256];
+			snprintf(Message, sizeof(Message), "%s lighting: lights: %zu, visible: %u, frame time: %.3f ms\n", Tiled ? "Tiled" : "Per light", DataToRender.Lights.size(), Stats.LightsVisible, FrameTime);
+			OutputDebugString(Message);
+
+			// Counted in the previous frame, which used the same mode and lights
+			if (Tiled && Stats.LightOverflow.TilesOverflowed > 0)
+			{
+				snprintf(Message, sizeof(Message), "Tiled lighting overflow: tiles: %u, lights dropped: %u\n", Stats.LightOverflow.TilesOverflowed, Stats.LightOverflow.LightsDropped);
+				OutputDebugString(Message);
+			}
+
+			// Both modes are measured with the same lights before their number doubles
+			if (Tiled)
+			{
+				DeferredRenderer::Get().SetLightingMode(LightingMode::PER_LIGHT);
+			}
+			else
+			{
+				const size_t LightsCount = DataToRender.Lights.size() < MaxBenchmarkLights ? DataToRender.Lights.size() * 2 : 1;
+				DataToRender.Lights.assign(BenchmarkLights.begin(), BenchmarkLights.begin() + LightsCount);
+
+				DeferredRenderer::Get().SetLightingMode(LightingMode::TILED);
+			}
+		}
+
 		VulkanCore::Get().ProgessImageIndex();
 	}
 